@@ -54,6 +54,14 @@
 	#define configINCLUDE_QUERY_HEAP_COMMAND 0
 #endif
 
+#ifndef configINCLUDE_SCHED_STATS_COMMAND
+	#define configINCLUDE_SCHED_STATS_COMMAND 0
+#endif
+
+#if( configINCLUDE_SCHED_STATS_COMMAND == 1 )
+	#include "SchedStats.h"
+#endif
+
 /*
  * The function that registers the commands that are defined within this file.
  */
@@ -88,6 +96,13 @@ static BaseType_t prvParameterEchoCommand( char *pcWriteBuffer, size_t xWriteBuf
 	static BaseType_t prvQueryHeapCommand( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString );
 #endif
 
+/*
+ * Implements the "sched-stats" command.
+ */
+#if( configINCLUDE_SCHED_STATS_COMMAND == 1 )
+	static BaseType_t prvSchedStatsCommand( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString );
+#endif
+
 /*
  * Implements the "trace start" and "trace stop" commands;
  */
@@ -150,6 +165,18 @@ static const CLI_Command_Definition_t xParameterEcho =
 	};
 #endif /* configQUERY_HEAP_COMMAND */
 
+#if( configINCLUDE_SCHED_STATS_COMMAND == 1 )
+	/* Structure that defines the "sched-stats" command line command.  This
+	displays the statistics gathered by the trace macros in SchedStats.c. */
+	static const CLI_Command_Definition_t xSchedStats =
+	{
+		"sched-stats",
+		"\r\nsched-stats [reset]:\r\n Displays the CPU load, task loads, wake up latencies and tick statistics, or clears the latency and tick statistics\r\n",
+		prvSchedStatsCommand, /* The function to run. */
+		-1 /* The reset parameter is optional. */
+	};
+#endif /* configINCLUDE_SCHED_STATS_COMMAND */
+
 #if configINCLUDE_TRACE_RELATED_CLI_COMMANDS == 1
 	/* Structure that defines the "trace" command line command.  This takes a single
 	parameter, which can be either "start" or "stop". */
@@ -183,6 +210,12 @@ void vRegisterSampleCLICommands( void )
 	}
 	#endif
 
+	#if( configINCLUDE_SCHED_STATS_COMMAND == 1 )
+	{
+		FreeRTOS_CLIRegisterCommand( &xSchedStats );
+	}
+	#endif
+
 	#if( configINCLUDE_TRACE_RELATED_CLI_COMMANDS == 1 )
 	{
 		FreeRTOS_CLIRegisterCommand( &xStartStopTrace );
@@ -249,6 +282,48 @@ BaseType_t xSpacePadding;
 #endif /* configINCLUDE_QUERY_HEAP */
 /*-----------------------------------------------------------*/
 
+#if( configINCLUDE_SCHED_STATS_COMMAND == 1 )
+
+	static BaseType_t prvSchedStatsCommand( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString )
+	{
+	const char *pcParameter;
+	BaseType_t xParameterStringLength, xReturn = pdTRUE;
+	static uint32_t ulLine = 0;
+
+		configASSERT( pcWriteBuffer );
+
+		if( ulLine == 0 )
+		{
+			pcParameter = FreeRTOS_CLIGetParameter( pcCommandString, 1, &xParameterStringLength );
+
+			if( ( pcParameter != NULL ) && ( xParameterStringLength == 5 ) && ( strncmp( pcParameter, "reset", 5 ) == 0 ) )
+			{
+				vSchedStatsReset();
+				sprintf( pcWriteBuffer, "Latency and tick statistics cleared.\r\n" );
+				return pdFALSE;
+			}
+		}
+
+		/* One line of the report is returned each time the command is
+		called. */
+		if( ulSchedStatsFormatLine( ulLine, pcWriteBuffer, xWriteBufferLen ) == 0 )
+		{
+			/* That was the last line.  Start over the next time this command
+			is executed. */
+			ulLine = 0;
+			xReturn = pdFALSE;
+		}
+		else
+		{
+			ulLine++;
+		}
+
+		return xReturn;
+	}
+
+#endif /* configINCLUDE_SCHED_STATS_COMMAND */
+/*-----------------------------------------------------------*/
+
 #if( configGENERATE_RUN_TIME_STATS == 1 )
 	
 	static BaseType_t prvRunTimeStatsCommand( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString )
@@ -0,0 +1,610 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * Continuous scheduler statistics gathered through the kernel trace macros.
+ * See SchedStats.h for the configuration and the API.
+ *
+ * The trace macros are always called by the kernel from within a critical
+ * section, from the tick interrupt or from the context switch, so the
+ * functions called by the macros do not need any further mutual exclusion.
+ * The functions called by the application take a copy of the data they need
+ * from within a critical section.  Each event costs one read of the run time
+ * counter plus, on a context switch, a search of the fixed size task table.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Demo includes. */
+#include "SchedStats.h"
+
+#if( configGENERATE_RUN_TIME_STATS != 1 )
+	#error SchedStats.c requires configGENERATE_RUN_TIME_STATS to be set to 1
+#endif
+
+/* The length of the window over which the task loads are calculated. */
+#ifndef configSCHED_STATS_WINDOW_TICKS
+	#define configSCHED_STATS_WINDOW_TICKS	( ( uint32_t ) configTICK_RATE_HZ )
+#endif
+
+#define schedstatsNOW()		( ( uint32_t ) portGET_RUN_TIME_COUNTER_VALUE() )
+
+/* Per task data.  A slot is free when pvTask is NULL. */
+typedef struct xSCHED_STATS_TASK
+{
+	void *pvTask;
+	char cTaskName[ schedstatsMAX_NAME_LEN ];
+	uint32_t ulPriority;
+	uint32_t ulReadyTime;			/* When the task was last moved to the Ready state. */
+	uint32_t ulSwitchedInTime;		/* When the task last started running. */
+	uint32_t ulRunTime;				/* Run time within the current window. */
+	uint32_t ulLastWindowRunTime;	/* Run time within the last complete window. */
+	uint8_t ucWaitingToRun;			/* Set when ulReadyTime is valid. */
+	uint8_t ucIsIdleTask;
+} SchedStatsTask_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Returns the slot used by pvTask, or NULL if the task is not tracked.
+ */
+static SchedStatsTask_t *prvFindTask( const void *pvTask );
+
+/*
+ * Returns the histogram bucket for a latency of ulValue.
+ */
+static uint32_t prvBucket( uint32_t ulValue );
+
+/*
+ * Returns the largest latency that is counted in bucket ulBucket.
+ */
+static uint32_t prvBucketUpperBound( uint32_t ulBucket );
+
+/*
+ * Ends the current window, making the run time of each task within the window
+ * available to ulSchedStatsGetTaskLoads().
+ */
+static void prvEndWindow( uint32_t ulNow );
+
+/*
+ * Converts a run time within the last complete window to parts per thousand.
+ */
+static uint32_t prvPermille( uint32_t ulRunTime );
+
+/*-----------------------------------------------------------*/
+
+static SchedStatsTask_t xTasks[ configSCHED_STATS_MAX_TASKS ];
+
+/* The slot of the task that is running, if it is tracked. */
+static SchedStatsTask_t *pxRunningTask = NULL;
+
+/* Window state. */
+static uint32_t ulWindowStartTime = 0UL;
+static uint32_t ulLastWindowLength = 0UL;
+static uint32_t ulWindowTicks = 0UL;
+
+/* Wake up to run latency histograms, and the largest latency seen, for each
+priority. */
+static uint32_t ulLatencyHistogram[ configMAX_PRIORITIES ][ schedstatsHISTOGRAM_BUCKETS ];
+static uint32_t ulLatencyMax[ configMAX_PRIORITIES ];
+
+/* Tick handler state. */
+static uint32_t ulTickStartTime = 0UL;
+static uint32_t ulLastTickStartTime = 0UL;
+static uint32_t ulTickDurationTotal = 0UL;
+static uint32_t ulTickDurationMax = 0UL;
+static uint32_t ulTickIntervalMin = 0xffffffffUL;
+static uint32_t ulTickIntervalMax = 0UL;
+static uint32_t ulTickCount = 0UL;
+
+/* Number of tasks that were not tracked because the table was full. */
+static uint32_t ulUntrackedTasks = 0UL;
+
+/*-----------------------------------------------------------*/
+
+void vSchedStatsTaskCreated( void *pvTask, const char *pcTaskName )
+{
+SchedStatsTask_t *pxTask;
+
+	pxTask = prvFindTask( NULL );
+
+	if( pxTask != NULL )
+	{
+		memset( pxTask, 0x00, sizeof( *pxTask ) );
+		pxTask->pvTask = pvTask;
+		strncpy( pxTask->cTaskName, pcTaskName, sizeof( pxTask->cTaskName ) - 1 );
+
+		if( strcmp( pxTask->cTaskName, configIDLE_TASK_NAME ) == 0 )
+		{
+			pxTask->ucIsIdleTask = pdTRUE;
+		}
+	}
+	else
+	{
+		ulUntrackedTasks++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vSchedStatsTaskDeleted( void *pvTask )
+{
+SchedStatsTask_t *pxTask;
+
+	pxTask = prvFindTask( pvTask );
+
+	if( pxTask != NULL )
+	{
+		pxTask->pvTask = NULL;
+
+		if( pxTask == pxRunningTask )
+		{
+			pxRunningTask = NULL;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vSchedStatsTaskReady( void *pvTask )
+{
+SchedStatsTask_t *pxTask;
+
+	pxTask = prvFindTask( pvTask );
+
+	/* The running task is re-added to the Ready list when its priority
+	changes, which is not a wake up. */
+	if( ( pxTask != NULL ) && ( pxTask != pxRunningTask ) && ( pxTask->ucWaitingToRun == pdFALSE ) )
+	{
+		pxTask->ulReadyTime = schedstatsNOW();
+		pxTask->ucWaitingToRun = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vSchedStatsSwitchedIn( void *pvTask, uint32_t ulPriority )
+{
+SchedStatsTask_t *pxTask;
+uint32_t ulNow, ulLatency;
+
+	ulNow = schedstatsNOW();
+
+	if( ( pxRunningTask != NULL ) && ( pxRunningTask->pvTask == pvTask ) )
+	{
+		/* The same task was selected again, and has been running since it was
+		switched out. */
+		return;
+	}
+
+	pxTask = prvFindTask( pvTask );
+	pxRunningTask = pxTask;
+
+	if( pxTask != NULL )
+	{
+		pxTask->ulSwitchedInTime = ulNow;
+		pxTask->ulPriority = ulPriority;
+
+		if( pxTask->ucWaitingToRun != pdFALSE )
+		{
+			pxTask->ucWaitingToRun = pdFALSE;
+			ulLatency = ulNow - pxTask->ulReadyTime;
+
+			if( ulPriority >= ( uint32_t ) configMAX_PRIORITIES )
+			{
+				ulPriority = ( uint32_t ) configMAX_PRIORITIES - 1UL;
+			}
+
+			ulLatencyHistogram[ ulPriority ][ prvBucket( ulLatency ) ]++;
+
+			if( ulLatency > ulLatencyMax[ ulPriority ] )
+			{
+				ulLatencyMax[ ulPriority ] = ulLatency;
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vSchedStatsSwitchedOut( void )
+{
+	/* If the same task is selected to run again vSchedStatsSwitchedIn()
+	leaves the updated switched in time as it is. */
+	if( pxRunningTask != NULL )
+	{
+	uint32_t ulNow = schedstatsNOW();
+
+		pxRunningTask->ulRunTime += ulNow - pxRunningTask->ulSwitchedInTime;
+		pxRunningTask->ulSwitchedInTime = ulNow;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vSchedStatsTickStart( void )
+{
+uint32_t ulNow, ulInterval;
+
+	ulNow = schedstatsNOW();
+	ulTickStartTime = ulNow;
+
+	if( ulTickCount != 0UL )
+	{
+		ulInterval = ulNow - ulLastTickStartTime;
+
+		if( ulInterval < ulTickIntervalMin )
+		{
+			ulTickIntervalMin = ulInterval;
+		}
+
+		if( ulInterval > ulTickIntervalMax )
+		{
+			ulTickIntervalMax = ulInterval;
+		}
+	}
+
+	ulLastTickStartTime = ulNow;
+
+	ulWindowTicks++;
+	if( ulWindowTicks >= configSCHED_STATS_WINDOW_TICKS )
+	{
+		prvEndWindow( ulNow );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vSchedStatsTickHook( void )
+{
+uint32_t ulDuration;
+
+	ulDuration = schedstatsNOW() - ulTickStartTime;
+	ulTickDurationTotal += ulDuration;
+	ulTickCount++;
+
+	if( ulDuration > ulTickDurationMax )
+	{
+		ulTickDurationMax = ulDuration;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvEndWindow( uint32_t ulNow )
+{
+UBaseType_t x;
+
+	/* Charge the running task for the part of its time slice that falls
+	within this window. */
+	if( pxRunningTask != NULL )
+	{
+		pxRunningTask->ulRunTime += ulNow - pxRunningTask->ulSwitchedInTime;
+		pxRunningTask->ulSwitchedInTime = ulNow;
+	}
+
+	for( x = 0; x < ( UBaseType_t ) configSCHED_STATS_MAX_TASKS; x++ )
+	{
+		xTasks[ x ].ulLastWindowRunTime = xTasks[ x ].ulRunTime;
+		xTasks[ x ].ulRunTime = 0UL;
+	}
+
+	ulLastWindowLength = ulNow - ulWindowStartTime;
+	ulWindowStartTime = ulNow;
+	ulWindowTicks = 0UL;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulSchedStatsGetCPULoad( void )
+{
+uint32_t ulIdleRunTime = 0UL, ulReturn = 0UL;
+UBaseType_t x;
+
+	taskENTER_CRITICAL();
+	{
+		for( x = 0; x < ( UBaseType_t ) configSCHED_STATS_MAX_TASKS; x++ )
+		{
+			if( ( xTasks[ x ].pvTask != NULL ) && ( xTasks[ x ].ucIsIdleTask != pdFALSE ) )
+			{
+				ulIdleRunTime = xTasks[ x ].ulLastWindowRunTime;
+				break;
+			}
+		}
+
+		if( ulLastWindowLength != 0UL )
+		{
+			ulReturn = 1000UL - prvPermille( ulIdleRunTime );
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulSchedStatsGetTaskLoads( SchedStatsTaskLoad_t *pxLoads, uint32_t ulMaxTasks )
+{
+uint32_t ulCount = 0UL;
+UBaseType_t x;
+
+	taskENTER_CRITICAL();
+	{
+		for( x = 0; ( x < ( UBaseType_t ) configSCHED_STATS_MAX_TASKS ) && ( ulCount < ulMaxTasks ); x++ )
+		{
+			if( xTasks[ x ].pvTask != NULL )
+			{
+				memcpy( pxLoads[ ulCount ].cTaskName, xTasks[ x ].cTaskName, sizeof( pxLoads[ ulCount ].cTaskName ) );
+				pxLoads[ ulCount ].ulPriority = xTasks[ x ].ulPriority;
+				pxLoads[ ulCount ].ulPermille = prvPermille( xTasks[ x ].ulLastWindowRunTime );
+				ulCount++;
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return ulCount;
+}
+/*-----------------------------------------------------------*/
+
+void vSchedStatsGetLatency( uint32_t ulPriority, SchedStatsLatency_t *pxLatency )
+{
+uint32_t ulHistogram[ schedstatsHISTOGRAM_BUCKETS ];
+uint32_t ulBucket, ulSeen = 0UL;
+
+	memset( pxLatency, 0x00, sizeof( *pxLatency ) );
+
+	if( ulPriority < ( uint32_t ) configMAX_PRIORITIES )
+	{
+		taskENTER_CRITICAL();
+		{
+			memcpy( ulHistogram, ulLatencyHistogram[ ulPriority ], sizeof( ulHistogram ) );
+			pxLatency->ulMax = ulLatencyMax[ ulPriority ];
+		}
+		taskEXIT_CRITICAL();
+
+		for( ulBucket = 0; ulBucket < schedstatsHISTOGRAM_BUCKETS; ulBucket++ )
+		{
+			pxLatency->ulSamples += ulHistogram[ ulBucket ];
+		}
+
+		for( ulBucket = 0; ulBucket < schedstatsHISTOGRAM_BUCKETS; ulBucket++ )
+		{
+			ulSeen += ulHistogram[ ulBucket ];
+
+			if( ( pxLatency->ulP50 == 0UL ) && ( ( ( uint64_t ) ulSeen * 2ULL ) >= pxLatency->ulSamples ) && ( ulSeen != 0UL ) )
+			{
+				pxLatency->ulP50 = prvBucketUpperBound( ulBucket );
+			}
+
+			if( ( ( ( uint64_t ) ulSeen * 100ULL ) >= ( ( uint64_t ) pxLatency->ulSamples * 99ULL ) ) && ( ulSeen != 0UL ) )
+			{
+				pxLatency->ulP99 = prvBucketUpperBound( ulBucket );
+				break;
+			}
+		}
+
+		/* The bucket bounds are coarse, don't report more than was seen. */
+		if( pxLatency->ulP50 > pxLatency->ulMax )
+		{
+			pxLatency->ulP50 = pxLatency->ulMax;
+		}
+
+		if( pxLatency->ulP99 > pxLatency->ulMax )
+		{
+			pxLatency->ulP99 = pxLatency->ulMax;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vSchedStatsGetTickStats( SchedStatsTick_t *pxTick )
+{
+	taskENTER_CRITICAL();
+	{
+		pxTick->ulTicks = ulTickCount;
+		pxTick->ulDurationMax = ulTickDurationMax;
+		pxTick->ulDurationAverage = ( ulTickCount != 0UL ) ? ( ulTickDurationTotal / ulTickCount ) : 0UL;
+		pxTick->ulIntervalMin = ( ulTickCount > 1UL ) ? ulTickIntervalMin : 0UL;
+		pxTick->ulIntervalMax = ulTickIntervalMax;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vSchedStatsReset( void )
+{
+	taskENTER_CRITICAL();
+	{
+		memset( ulLatencyHistogram, 0x00, sizeof( ulLatencyHistogram ) );
+		memset( ulLatencyMax, 0x00, sizeof( ulLatencyMax ) );
+		ulTickDurationTotal = 0UL;
+		ulTickDurationMax = 0UL;
+		ulTickIntervalMin = 0xffffffffUL;
+		ulTickIntervalMax = 0UL;
+		ulTickCount = 0UL;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulSchedStatsFormatLine( uint32_t ulLine, char *pcBuffer, size_t xBufferLength )
+{
+SchedStatsTaskLoad_t xLoad;
+SchedStatsLatency_t xLatency;
+SchedStatsTick_t xTick;
+uint32_t ulIndex, ulLoad;
+BaseType_t xFound = pdFALSE;
+UBaseType_t x;
+
+	/* Line 0 is the CPU load, followed by one line per tracked task, one line
+	per priority and finally the tick statistics.  Tasks can be created and
+	deleted between calls, so the task for each line is looked up again each
+	time. */
+	if( ulLine == 0UL )
+	{
+		ulLoad = ulSchedStatsGetCPULoad();
+		snprintf( pcBuffer, xBufferLength, "CPU load %u.%u%%, %u untracked tasks\r\n", ( unsigned ) ( ulLoad / 10UL ), ( unsigned ) ( ulLoad % 10UL ), ( unsigned ) ulUntrackedTasks );
+		return pdTRUE;
+	}
+
+	ulIndex = ulLine - 1UL;
+
+	taskENTER_CRITICAL();
+	{
+		for( x = 0; x < ( UBaseType_t ) configSCHED_STATS_MAX_TASKS; x++ )
+		{
+			if( xTasks[ x ].pvTask != NULL )
+			{
+				if( ulIndex == 0UL )
+				{
+					memcpy( xLoad.cTaskName, xTasks[ x ].cTaskName, sizeof( xLoad.cTaskName ) );
+					xLoad.ulPriority = xTasks[ x ].ulPriority;
+					xLoad.ulPermille = prvPermille( xTasks[ x ].ulLastWindowRunTime );
+					xFound = pdTRUE;
+					break;
+				}
+
+				ulIndex--;
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	if( xFound != pdFALSE )
+	{
+		snprintf( pcBuffer, xBufferLength, "Task %-*s prio %2u  %3u.%u%%\r\n", ( int ) schedstatsMAX_NAME_LEN, xLoad.cTaskName, ( unsigned ) xLoad.ulPriority, ( unsigned ) ( xLoad.ulPermille / 10UL ), ( unsigned ) ( xLoad.ulPermille % 10UL ) );
+		return pdTRUE;
+	}
+
+	if( ulIndex < ( uint32_t ) configMAX_PRIORITIES )
+	{
+		vSchedStatsGetLatency( ulIndex, &xLatency );
+		snprintf( pcBuffer, xBufferLength, "Prio %2u wake latency: %u samples, p50 %u, p99 %u, max %u\r\n", ( unsigned ) ulIndex, ( unsigned ) xLatency.ulSamples, ( unsigned ) xLatency.ulP50, ( unsigned ) xLatency.ulP99, ( unsigned ) xLatency.ulMax );
+		return pdTRUE;
+	}
+
+	vSchedStatsGetTickStats( &xTick );
+	snprintf( pcBuffer, xBufferLength, "Tick: %u ticks, duration avg %u max %u, interval min %u max %u\r\n", ( unsigned ) xTick.ulTicks, ( unsigned ) xTick.ulDurationAverage, ( unsigned ) xTick.ulDurationMax, ( unsigned ) xTick.ulIntervalMin, ( unsigned ) xTick.ulIntervalMax );
+
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static SchedStatsTask_t *prvFindTask( const void *pvTask )
+{
+SchedStatsTask_t *pxReturn = NULL;
+UBaseType_t x;
+
+	for( x = 0; x < ( UBaseType_t ) configSCHED_STATS_MAX_TASKS; x++ )
+	{
+		if( xTasks[ x ].pvTask == pvTask )
+		{
+			pxReturn = &( xTasks[ x ] );
+			break;
+		}
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvBucket( uint32_t ulValue )
+{
+uint32_t ulBucket = 0UL;
+
+	/* The bucket is the number of significant bits in ulValue. */
+	if( ulValue >= 0x10000UL )
+	{
+		ulBucket += 16UL;
+		ulValue >>= 16;
+	}
+
+	if( ulValue >= 0x100UL )
+	{
+		ulBucket += 8UL;
+		ulValue >>= 8;
+	}
+
+	if( ulValue >= 0x10UL )
+	{
+		ulBucket += 4UL;
+		ulValue >>= 4;
+	}
+
+	if( ulValue >= 0x4UL )
+	{
+		ulBucket += 2UL;
+		ulValue >>= 2;
+	}
+
+	if( ulValue >= 0x2UL )
+	{
+		ulBucket += 1UL;
+		ulValue >>= 1;
+	}
+
+	return ulBucket + ulValue;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvBucketUpperBound( uint32_t ulBucket )
+{
+uint32_t ulReturn;
+
+	if( ulBucket >= 32UL )
+	{
+		ulReturn = 0xffffffffUL;
+	}
+	else
+	{
+		ulReturn = ( 1UL << ulBucket ) - 1UL;
+	}
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvPermille( uint32_t ulRunTime )
+{
+uint32_t ulWindow, ulReturn = 0UL;
+
+	/* As in vTaskGetRunTimeStats(), divide the total rather than multiply
+	the run time so the calculation cannot overflow. */
+	ulWindow = ulLastWindowLength / 1000UL;
+
+	if( ulWindow != 0UL )
+	{
+		ulReturn = ulRunTime / ulWindow;
+
+		if( ulReturn > 1000UL )
+		{
+			ulReturn = 1000UL;
+		}
+	}
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
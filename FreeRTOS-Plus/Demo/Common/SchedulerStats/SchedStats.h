@@ -0,0 +1,150 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * This file, along with SchedStats.c, uses the kernel trace macros to keep
+ * continuous scheduler statistics in statically allocated memory:
+ *
+ * + The share of the CPU used by each task, and so the CPU load, over the last
+ *   complete measurement window of configSCHED_STATS_WINDOW_TICKS ticks.
+ * + A histogram per priority of the time from a task being moved to the Ready
+ *   state until it next runs.
+ * + The duration of the tick handler and the jitter of the tick period.
+ *
+ * All times are in units of the run time stats counter, so
+ * configGENERATE_RUN_TIME_STATS must be 1.  Include this file at the bottom of
+ * FreeRTOSConfig.h (it cannot be used together with another trace recorder),
+ * add SchedStats.c to the build, and call vSchedStatsTickHook() from
+ * vApplicationTickHook().  The statistics can be viewed with the "sched-stats"
+ * command line command.
+ */
+
+#ifndef SCHED_STATS_H
+#define SCHED_STATS_H
+
+/* The maximum number of tasks that are tracked at any one time.  Tasks created
+while the table is full are not included in the statistics. */
+#ifndef configSCHED_STATS_MAX_TASKS
+	#define configSCHED_STATS_MAX_TASKS		16
+#endif
+
+#ifdef configMAX_TASK_NAME_LEN
+	#define schedstatsMAX_NAME_LEN			configMAX_TASK_NAME_LEN
+#else
+	#define schedstatsMAX_NAME_LEN			16
+#endif
+
+/* Latency bucket n counts wake up latencies in the range [2^(n-1), 2^n), with
+bucket 0 counting latencies of 0. */
+#define schedstatsHISTOGRAM_BUCKETS			33
+
+/* The share of the CPU a task used in the last complete window. */
+typedef struct xSCHED_STATS_TASK_LOAD
+{
+	char cTaskName[ schedstatsMAX_NAME_LEN ];
+	uint32_t ulPriority;	/* The priority the task last ran at. */
+	uint32_t ulPermille;	/* Parts per thousand of the window. */
+} SchedStatsTaskLoad_t;
+
+/* Summary of the wake up to run latency histogram for one priority. */
+typedef struct xSCHED_STATS_LATENCY
+{
+	uint32_t ulSamples;
+	uint32_t ulP50;			/* Upper bound of the bucket holding the median. */
+	uint32_t ulP99;			/* Upper bound of the bucket holding the 99th percentile. */
+	uint32_t ulMax;
+} SchedStatsLatency_t;
+
+/* Tick handler statistics. */
+typedef struct xSCHED_STATS_TICK
+{
+	uint32_t ulTicks;
+	uint32_t ulDurationAverage;
+	uint32_t ulDurationMax;
+	uint32_t ulIntervalMin;
+	uint32_t ulIntervalMax;
+} SchedStatsTick_t;
+
+/*
+ * Returns the CPU load, in parts per thousand, over the last complete window.
+ * This is the share of the window not used by the idle task.
+ */
+uint32_t ulSchedStatsGetCPULoad( void );
+
+/*
+ * Copies the load of up to ulMaxTasks tracked tasks into pxLoads, returning
+ * the number of entries written.
+ */
+uint32_t ulSchedStatsGetTaskLoads( SchedStatsTaskLoad_t *pxLoads, uint32_t ulMaxTasks );
+
+/*
+ * Summarises the wake up to run latency histogram of tasks that ran at
+ * priority ulPriority.
+ */
+void vSchedStatsGetLatency( uint32_t ulPriority, SchedStatsLatency_t *pxLatency );
+
+/*
+ * Obtains the tick handler duration and tick interval statistics.
+ */
+void vSchedStatsGetTickStats( SchedStatsTick_t *pxTick );
+
+/*
+ * Clears the latency histograms and the tick statistics.  Task loads are
+ * recalculated at the end of every window so are not affected.
+ */
+void vSchedStatsReset( void );
+
+/*
+ * Writes line ulLine of a human readable report into pcBuffer.  Returns 0 when
+ * the line written is the last line of the report, otherwise non-zero.
+ */
+uint32_t ulSchedStatsFormatLine( uint32_t ulLine, char *pcBuffer, size_t xBufferLength );
+
+/*
+ * Must be called from vApplicationTickHook() to mark the end of the tick
+ * handler.
+ */
+void vSchedStatsTickHook( void );
+
+/* Functions called by the trace macros.  Not for use by the application. */
+void vSchedStatsTaskCreated( void *pvTask, const char *pcTaskName );
+void vSchedStatsTaskDeleted( void *pvTask );
+void vSchedStatsTaskReady( void *pvTask );
+void vSchedStatsSwitchedIn( void *pvTask, uint32_t ulPriority );
+void vSchedStatsSwitchedOut( void );
+void vSchedStatsTickStart( void );
+
+/* The trace macro definitions themselves.  These are only used within tasks.c,
+where pxCurrentTCB and the TCB members are visible. */
+#define traceTASK_CREATE( pxNewTCB )				vSchedStatsTaskCreated( ( void * ) ( pxNewTCB ), ( pxNewTCB )->pcTaskName )
+#define traceTASK_DELETE( pxTCB )					vSchedStatsTaskDeleted( ( void * ) ( pxTCB ) )
+#define traceMOVED_TASK_TO_READY_STATE( pxTCB )		vSchedStatsTaskReady( ( void * ) ( pxTCB ) )
+#define traceTASK_SWITCHED_IN()						vSchedStatsSwitchedIn( ( void * ) pxCurrentTCB, ( uint32_t ) pxCurrentTCB->uxPriority )
+#define traceTASK_SWITCHED_OUT()					vSchedStatsSwitchedOut()
+#define traceTASK_INCREMENT_TICK( xTickCount )		vSchedStatsTickStart()
+
+#endif /* SCHED_STATS_H */
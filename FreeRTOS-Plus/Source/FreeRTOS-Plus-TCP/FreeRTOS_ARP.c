@@ -45,6 +45,9 @@
 #endif /* ipconfigUSE_LLMNR */
 #include "NetworkBufferManagement.h"
 #include "NetworkInterface.h"
+#if( ipconfigMULTI_INTERFACE == 1 )
+	#include "FreeRTOS_Routing.h"
+#endif
 
 
 /* When the age of an entry in the ARP table reaches this value (it counts down
@@ -64,11 +67,28 @@ entry is still valid and can therefore be refreshed. */
  */
 static eARPLookupResult_t prvCacheLookup( uint32_t ulAddressToLookup, MACAddress_t * const pxMACAddress );
 
+#if( ipconfigARP_PENDING_PACKETS > 0 )
+	/*
+	 * The ARP reply for ulIPAddress has arrived: send the packets that were
+	 * held for it, and let connecting TCP sockets try again.
+	 */
+	static void prvARPSendPending( uint32_t ulIPAddress );
+
+	/*
+	 * Send or release the held packets whose ARP request has been answered or
+	 * has expired.  With xReleaseAll, release all held packets.
+	 */
+	static void prvARPCheckPending( BaseType_t xReleaseAll );
+#endif
+
 /*-----------------------------------------------------------*/
 
 /* The ARP cache. */
 static ARPCacheRow_t xARPCache[ ipconfigARP_CACHE_ENTRIES ];
 
+/* See FreeRTOS_ARP.h. */
+uint32_t ulARPGeneration = 0U;
+
 /* The time at which the last gratuitous ARP was sent.  Gratuitous ARPs are used
 to ensure ARP tables are up to date and to detect IP address conflicts. */
 static TickType_t xLastGratuitousARPTime = ( TickType_t ) 0;
@@ -85,6 +105,18 @@ static TickType_t xLastGratuitousARPTime = ( TickType_t ) 0;
 	MACAddress_t xARPClashMacAddress;
 #endif /* ipconfigARP_USE_CLASH_DETECTION */
 
+#if( ipconfigARP_PENDING_PACKETS > 0 )
+	typedef struct xARP_PENDING_PACKET
+	{
+		NetworkBufferDescriptor_t *pxNetworkBuffer;
+		uint32_t ulIPAddress;	/* The address that is being resolved: the destination or the gateway. */
+	} ARPPendingPacket_t;
+
+	/* The held packets, oldest first. */
+	static ARPPendingPacket_t xARPPendingPackets[ ipconfigARP_PENDING_PACKETS ];
+	static UBaseType_t uxARPPendingCount = 0U;
+#endif /* ipconfigARP_PENDING_PACKETS */
+
 /*-----------------------------------------------------------*/
 
 eFrameProcessingResult_t eARPProcessPacket( ARPPacket_t * const pxARPFrame )
@@ -92,6 +124,9 @@ eFrameProcessingResult_t eARPProcessPacket( ARPPacket_t * const pxARPFrame )
 eFrameProcessingResult_t eReturn = eReleaseBuffer;
 ARPHeader_t *pxARPHeader;
 uint32_t ulTargetProtocolAddress, ulSenderProtocolAddress;
+#if( ipconfigMULTI_INTERFACE == 1 )
+	NetworkEndPoint_t *pxEndPoint;
+#endif
 
 	pxARPHeader = &( pxARPFrame->xARPHeader );
 
@@ -111,7 +146,12 @@ uint32_t ulTargetProtocolAddress, ulSenderProtocolAddress;
 			case ipARP_REQUEST	:
 				/* The packet contained an ARP request.  Was it for the IP
 				address of the node running this code? */
+			#if( ipconfigMULTI_INTERFACE == 1 )
+				pxEndPoint = FreeRTOS_FindEndPointOnIP( ulTargetProtocolAddress );
+				if( pxEndPoint != NULL )
+			#else
 				if( ulTargetProtocolAddress == *ipLOCAL_IP_ADDRESS_POINTER )
+			#endif
 				{
 					iptraceSENDING_ARP_REPLY( ulSenderProtocolAddress );
 
@@ -135,8 +175,19 @@ uint32_t ulTargetProtocolAddress, ulSenderProtocolAddress;
 						( void ) memcpy( pxARPHeader->xTargetHardwareAddress.ucBytes, pxARPHeader->xSenderHardwareAddress.ucBytes, sizeof( MACAddress_t ) );
 						pxARPHeader->ulTargetProtocolAddress = ulSenderProtocolAddress;
 					}
-					( void ) memcpy( pxARPHeader->xSenderHardwareAddress.ucBytes, ipLOCAL_MAC_ADDRESS, sizeof( MACAddress_t ) );
-					( void ) memcpy( pxARPHeader->ucSenderProtocolAddress, ipLOCAL_IP_ADDRESS_POINTER, sizeof( pxARPHeader->ucSenderProtocolAddress ) );
+				#if( ipconfigMULTI_INTERFACE == 1 )
+					{
+						/* Answer with the MAC address of the interface that
+						owns the requested address. */
+						( void ) memcpy( pxARPHeader->xSenderHardwareAddress.ucBytes, pxEndPoint->pxNetworkInterface->xMACAddress.ucBytes, sizeof( MACAddress_t ) );
+						( void ) memcpy( pxARPHeader->ucSenderProtocolAddress, &( ulTargetProtocolAddress ), sizeof( pxARPHeader->ucSenderProtocolAddress ) );
+					}
+				#else
+					{
+						( void ) memcpy( pxARPHeader->xSenderHardwareAddress.ucBytes, ipLOCAL_MAC_ADDRESS, sizeof( MACAddress_t ) );
+						( void ) memcpy( pxARPHeader->ucSenderProtocolAddress, ipLOCAL_IP_ADDRESS_POINTER, sizeof( pxARPHeader->ucSenderProtocolAddress ) );
+					}
+				#endif /* ipconfigMULTI_INTERFACE */
 
 					eReturn = eReturnEthernetFrame;
 				}
@@ -182,6 +233,7 @@ uint32_t ulTargetProtocolAddress, ulSenderProtocolAddress;
 			{
 				lResult = xARPCache[ x ].ulIPAddress;
 				( void ) memset( &xARPCache[ x ], 0, sizeof( xARPCache[ x ] ) );
+				ulARPGeneration++;
 				break;
 			}
 		}
@@ -199,12 +251,19 @@ BaseType_t xIpEntry = -1;
 BaseType_t xMacEntry = -1;
 BaseType_t xUseEntry = 0;
 uint8_t ucMinAgeFound = 0U;
+#if( ipconfigARP_PENDING_PACKETS > 0 )
+	BaseType_t xWasPending;
+#endif
 
 #if( ipconfigARP_STORES_REMOTE_ADDRESSES == 0 )
 	/* Only process the IP address if it is on the local network.
 	Unless: when '*ipLOCAL_IP_ADDRESS_POINTER' equals zero, the IP-address
 	and netmask are still unknown. */
 	if( ( ( ulIPAddress & xNetworkAddressing.ulNetMask ) == ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) ) ||
+	#if( ipconfigMULTI_INTERFACE == 1 )
+		/* Or on the network of one of the other end-points. */
+		( FreeRTOS_FindEndPointOnNetMask( ulIPAddress ) != NULL ) ||
+	#endif
 		( *ipLOCAL_IP_ADDRESS_POINTER == 0UL ) )
 #else
 		/* If ipconfigARP_STORES_REMOTE_ADDRESSES is non-zero, IP addresses with
@@ -260,8 +319,22 @@ uint8_t ucMinAgeFound = 0U;
 					As this is by far the most common path the coding standard
 					is relaxed in this case and a return is permitted as an
 					optimisation. */
+				uint8_t ucWasValid = xARPCache[ x ].ucValid;
+
 					xARPCache[ x ].ucAge = ( uint8_t ) ipconfigMAX_ARP_AGE;
 					xARPCache[ x ].ucValid = ( uint8_t ) pdTRUE;
+
+					if( ucWasValid == ( uint8_t ) pdFALSE )
+					{
+						/* An outstanding request has been answered. */
+						ulARPGeneration++;
+
+						#if( ipconfigARP_PENDING_PACKETS > 0 )
+						{
+							prvARPSendPending( ulIPAddress );
+						}
+						#endif
+					}
 					return;
 				}
 
@@ -309,6 +382,13 @@ uint8_t ucMinAgeFound = 0U;
 			}
 		}
 
+		#if( ipconfigARP_PENDING_PACKETS > 0 )
+		{
+			/* Remember whether an ARP request for this address is answered. */
+			xWasPending = ( ( pxMACAddress != NULL ) && ( xIpEntry >= 0 ) && ( xARPCache[ xIpEntry ].ucValid == ( uint8_t ) pdFALSE ) ) ? pdTRUE : pdFALSE;
+		}
+		#endif
+
 		if( xMacEntry >= 0 )
 		{
 			xUseEntry = xMacEntry;
@@ -331,6 +411,13 @@ uint8_t ucMinAgeFound = 0U;
 			/* No matching entry found. */
 		}
 
+		if( ( pxMACAddress != NULL ) || ( xARPCache[ xUseEntry ].ucValid != ( uint8_t ) pdFALSE ) )
+		{
+			/* A mapping is added or changed, or a valid entry is re-used:
+			next-hop MAC addresses cached by sockets must be looked up again. */
+			ulARPGeneration++;
+		}
+
 		/* If the entry was not found, we use the oldest entry and set the IPaddress */
 		xARPCache[ xUseEntry ].ulIPAddress = ulIPAddress;
 
@@ -342,6 +429,15 @@ uint8_t ucMinAgeFound = 0U;
 			/* And this entry does not need immediate attention */
 			xARPCache[ xUseEntry ].ucAge = ( uint8_t ) ipconfigMAX_ARP_AGE;
 			xARPCache[ xUseEntry ].ucValid = ( uint8_t ) pdTRUE;
+
+			#if( ipconfigARP_PENDING_PACKETS > 0 )
+			{
+				if( xWasPending != pdFALSE )
+				{
+					prvARPSendPending( ulIPAddress );
+				}
+			}
+			#endif /* ipconfigARP_PENDING_PACKETS */
 		}
 		else if( xIpEntry < 0 )
 		{
@@ -404,7 +500,11 @@ ulAddressToLookup = *pulIPAddress;
 		eReturn = eARPCacheHit;
 	}
 	else if( ( *pulIPAddress == ipBROADCAST_IP_ADDRESS ) ||	/* Is it the general broadcast address 255.255.255.255? */
-		( *pulIPAddress == xNetworkAddressing.ulBroadcastAddress ) )/* Or a local broadcast address, eg 192.168.1.255? */
+		( *pulIPAddress == xNetworkAddressing.ulBroadcastAddress ) /* Or a local broadcast address, eg 192.168.1.255? */
+	#if( ipconfigMULTI_INTERFACE == 1 )
+		|| ( FreeRTOS_FindEndPointOnBroadcast( *pulIPAddress ) != NULL ) /* Or the broadcast address of another end-point? */
+	#endif
+		)
 	{
 		/* This is a broadcast so it uses the broadcast MAC address. */
 		( void ) memcpy( pxMACAddress->ucBytes, xBroadcastMACAddress.ucBytes, sizeof( MACAddress_t ) );
@@ -420,7 +520,11 @@ ulAddressToLookup = *pulIPAddress;
 	{
 		eReturn = eARPCacheMiss;
 
+	#if( ipconfigMULTI_INTERFACE == 1 )
+		if( FreeRTOS_FindEndPointOnNetMask( *pulIPAddress ) == NULL )
+	#else
 		if( ( *pulIPAddress & xNetworkAddressing.ulNetMask ) != ( ( *ipLOCAL_IP_ADDRESS_POINTER ) & xNetworkAddressing.ulNetMask ) )
+	#endif
 		{
 			/* No matching end-point is found, look for a gateway. */
 #if( ipconfigARP_STORES_REMOTE_ADDRESSES == 1 )
@@ -437,9 +541,15 @@ ulAddressToLookup = *pulIPAddress;
 			{
 				/* The IP address is off the local network, so look up the
 				hardware address of the router, if any. */
-				if( xNetworkAddressing.ulGatewayAddress != ( uint32_t ) 0U )
+			#if( ipconfigMULTI_INTERFACE == 1 )
+				uint32_t ulGatewayAddress = FreeRTOS_FindEndPointForRoute( *pulIPAddress )->ulGatewayAddress;
+			#else
+				uint32_t ulGatewayAddress = xNetworkAddressing.ulGatewayAddress;
+			#endif
+
+				if( ulGatewayAddress != ( uint32_t ) 0U )
 				{
-					ulAddressToLookup = xNetworkAddressing.ulGatewayAddress;
+					ulAddressToLookup = ulGatewayAddress;
 				}
 				else
 				{
@@ -470,9 +580,11 @@ ulAddressToLookup = *pulIPAddress;
 			{
 				eReturn = prvCacheLookup( ulAddressToLookup, pxMACAddress );
 
-				if( eReturn == eARPCacheMiss )
+				if( eReturn != eARPCacheHit )
 				{
-					/* It might be that the ARP has to go to the gateway. */
+					/* It might be that the ARP has to go to the gateway.  Also
+					when an ARP request is outstanding, tell the caller which
+					address is being resolved. */
 					*pulIPAddress = ulAddressToLookup;
 				}
 			}
@@ -554,10 +666,18 @@ TickType_t xTimeNow;
 				/* The entry is no longer valid.  Wipe it out. */
 				iptraceARP_TABLE_ENTRY_EXPIRED( xARPCache[ x ].ulIPAddress );
 				xARPCache[ x ].ulIPAddress = 0UL;
+				ulARPGeneration++;
 			}
 		}
 	}
 
+	#if( ipconfigARP_PENDING_PACKETS > 0 )
+	{
+		/* Entries that were waiting for a reply may have been wiped out. */
+		prvARPCheckPending( pdFALSE );
+	}
+	#endif /* ipconfigARP_PENDING_PACKETS */
+
 	xTimeNow = xTaskGetTickCount ();
 
 	if( ( xLastGratuitousARPTime == ( TickType_t ) 0 ) || ( ( xTimeNow - xLastGratuitousARPTime ) > ( TickType_t ) arpGRATUITOUS_ARP_PERIOD ) )
@@ -610,7 +730,7 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 		if( xIsCallingFromIPTask() != 0 )
 		{
 			/* Only the IP-task is allowed to call this function directly. */
-			( void ) xNetworkInterfaceOutput( pxNetworkBuffer, pdTRUE );
+			( void ) ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, pdTRUE );
 		}
 		else
 		{
@@ -685,9 +805,139 @@ ARPPacket_t *pxARPPacket;
 void FreeRTOS_ClearARP( void )
 {
 	( void ) memset( xARPCache, 0, sizeof( xARPCache ) );
+	ulARPGeneration++;
+
+	#if( ipconfigARP_PENDING_PACKETS > 0 )
+	{
+		prvARPCheckPending( pdTRUE );
+	}
+	#endif /* ipconfigARP_PENDING_PACKETS */
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigARP_PENDING_PACKETS > 0 )
+
+	BaseType_t xARPHoldPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer, uint32_t ulIPAddress )
+	{
+	BaseType_t xReturn = pdFALSE;
+	UBaseType_t uxIndex, uxSameAddress = 0U;
+	MACAddress_t xMACAddress;
+
+		/* Only hold the packet when an ARP request is outstanding, otherwise
+		nothing would ever send or release it. */
+		if( ( uxARPPendingCount < ( UBaseType_t ) ipconfigARP_PENDING_PACKETS ) &&
+			( prvCacheLookup( ulIPAddress, &( xMACAddress ) ) == eCantSendPacket ) &&
+			( ( ipconfigUSE_BUFFER_QUOTAS == 0 ) || ( uxGetNumberOfFreeNetworkBuffers() > ( size_t ) ipconfigBUFFER_RESERVE ) ) )
+		{
+			for( uxIndex = 0U; uxIndex < uxARPPendingCount; uxIndex++ )
+			{
+				if( xARPPendingPackets[ uxIndex ].ulIPAddress == ulIPAddress )
+				{
+					uxSameAddress++;
+				}
+			}
+
+			if( uxSameAddress < ( UBaseType_t ) ipconfigARP_PENDING_PACKETS_PER_ADDRESS )
+			{
+				xARPPendingPackets[ uxARPPendingCount ].pxNetworkBuffer = pxNetworkBuffer;
+				xARPPendingPackets[ uxARPPendingCount ].ulIPAddress = ulIPAddress;
+				uxARPPendingCount++;
+				xReturn = pdTRUE;
+			}
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	UBaseType_t uxARPPendingPacketCount( void )
+	{
+		return uxARPPendingCount;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvARPSendPending( uint32_t ulIPAddress )
+	{
+	NetworkBufferDescriptor_t *pxToSend[ ipconfigARP_PENDING_PACKETS_PER_ADDRESS ];
+	UBaseType_t uxIndex = 0U, uxCount = 0U, uxSend;
+
+		/* Take the packets out of the list first: sending them may hold new
+		packets. */
+		while( uxIndex < uxARPPendingCount )
+		{
+			if( ( xARPPendingPackets[ uxIndex ].ulIPAddress == ulIPAddress ) &&
+				( uxCount < ( UBaseType_t ) ipconfigARP_PENDING_PACKETS_PER_ADDRESS ) )
+			{
+				pxToSend[ uxCount ] = xARPPendingPackets[ uxIndex ].pxNetworkBuffer;
+				uxCount++;
+				uxARPPendingCount--;
+				( void ) memmove( &( xARPPendingPackets[ uxIndex ] ), &( xARPPendingPackets[ uxIndex + 1U ] ),
+					( uxARPPendingCount - uxIndex ) * sizeof( xARPPendingPackets[ 0 ] ) );
+			}
+			else
+			{
+				uxIndex++;
+			}
+		}
+
+		/* The packets were created by vProcessGeneratedUDPPacket(), which now
+		finds the address in the cache. */
+		for( uxSend = 0U; uxSend < uxCount; uxSend++ )
+		{
+			vProcessGeneratedUDPPacket( pxToSend[ uxSend ] );
+		}
+
+		#if( ipconfigUSE_TCP == 1 )
+		{
+			vSocketWakeUpConnecting();
+		}
+		#endif
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvARPCheckPending( BaseType_t xReleaseAll )
+	{
+	UBaseType_t uxIndex = 0U;
+	eARPLookupResult_t eResult;
+	MACAddress_t xMACAddress;
+
+		while( uxIndex < uxARPPendingCount )
+		{
+			if( xReleaseAll != pdFALSE )
+			{
+				eResult = eARPCacheMiss;
+			}
+			else
+			{
+				eResult = prvCacheLookup( xARPPendingPackets[ uxIndex ].ulIPAddress, &( xMACAddress ) );
+			}
+
+			if( eResult == eCantSendPacket )
+			{
+				/* Still waiting for the reply. */
+				uxIndex++;
+			}
+			else if( eResult == eARPCacheHit )
+			{
+				/* Resolved, but not seen by vARPRefreshCacheEntry(). */
+				prvARPSendPending( xARPPendingPackets[ uxIndex ].ulIPAddress );
+				uxIndex = 0U;
+			}
+			else
+			{
+				/* The ARP request has expired, or its entry was re-used. */
+				FreeRTOS_debug_printf( ( "ARP: dropping packet held for %lxip\n", FreeRTOS_ntohl( xARPPendingPackets[ uxIndex ].ulIPAddress ) ) );
+				vReleaseNetworkBufferAndDescriptor( xARPPendingPackets[ uxIndex ].pxNetworkBuffer );
+				uxARPPendingCount--;
+				( void ) memmove( &( xARPPendingPackets[ uxIndex ] ), &( xARPPendingPackets[ uxIndex + 1U ] ),
+					( uxARPPendingCount - uxIndex ) * sizeof( xARPPendingPackets[ 0 ] ) );
+			}
+		}
+	}
+
+#endif /* ipconfigARP_PENDING_PACKETS */
+/*-----------------------------------------------------------*/
+
 #if 1
 BaseType_t xCheckLoopback( NetworkBufferDescriptor_t * const pxDescriptor, BaseType_t bReleaseAfterSend )
 {
@@ -570,6 +570,12 @@ TickType_t xTimeoutTime = ( TickType_t ) 0;
 		xDHCPSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
 		if( xDHCPSocket != FREERTOS_INVALID_SOCKET )
 		{
+			#if( ipconfigUSE_BUFFER_QUOTAS == 1 )
+			{
+				/* DHCP may use the reserved network buffers. */
+				vSocketSetControl( xDHCPSocket );
+			}
+			#endif
 
 			/* Ensure the Rx and Tx timeouts are zero as the DHCP executes in the
 			context of the IP task. */
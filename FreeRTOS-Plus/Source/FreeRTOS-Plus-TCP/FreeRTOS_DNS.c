@@ -1620,6 +1620,13 @@ BaseType_t xReturn;
 	}
 	else
 	{
+		#if( ipconfigUSE_BUFFER_QUOTAS == 1 )
+		{
+			/* DNS may use the reserved network buffers. */
+			vSocketSetControl( xSocket );
+		}
+		#endif
+
 		/* Auto bind the port. */
 		xAddress.sin_port = 0U;
 		xReturn = FreeRTOS_bind( xSocket, &xAddress, sizeof( xAddress ) );
@@ -44,6 +44,9 @@
 #include "NetworkInterface.h"
 #include "NetworkBufferManagement.h"
 #include "FreeRTOS_DNS.h"
+#if( ipconfigMULTI_INTERFACE == 1 )
+	#include "FreeRTOS_Routing.h"
+#endif
 
 
 /* Used to ensure the structure packing is having the desired effect.  The
@@ -62,6 +65,16 @@ a constant. */
 /* ICMP protocol definitions. */
 #define ipICMP_ECHO_REQUEST				( ( uint8_t ) 8 )
 #define ipICMP_ECHO_REPLY				( ( uint8_t ) 0 )
+#define ipICMP_DESTINATION_UNREACHABLE	( ( uint8_t ) 3 )
+#define ipICMP_FRAGMENTATION_NEEDED		( ( uint8_t ) 4 )	/* A code of ipICMP_DESTINATION_UNREACHABLE. */
+
+/* ICMP packets are inspected for pings, and for the "fragmentation needed"
+messages used by path MTU discovery. */
+#if( ( ipconfigREPLY_TO_INCOMING_PINGS == 1 ) || ( ipconfigSUPPORT_OUTGOING_PINGS == 1 ) || ( ( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_PATH_MTU_DISCOVERY != 0 ) ) )
+	#define ipPROCESS_ICMP_PACKETS			1
+#else
+	#define ipPROCESS_ICMP_PACKETS			0
+#endif
 
 /* IPv4 multi-cast addresses range from 224.0.0.0.0 to 240.0.0.0. */
 #define	ipFIRST_MULTI_CAST_IPv4		0xE0000000UL
@@ -177,12 +190,12 @@ static void prvProcessEthernetPacket( NetworkBufferDescriptor_t * const pxNetwor
  */
 static eFrameProcessingResult_t prvProcessIPPacket( IPPacket_t * pxIPPacket, NetworkBufferDescriptor_t * const pxNetworkBuffer );
 
-#if ( ipconfigREPLY_TO_INCOMING_PINGS == 1 ) || ( ipconfigSUPPORT_OUTGOING_PINGS == 1 )
+#if( ipPROCESS_ICMP_PACKETS != 0 )
 	/*
 	 * Process incoming ICMP packets.
 	 */
-	static eFrameProcessingResult_t prvProcessICMPPacket( ICMPPacket_t * const pxICMPPacket );
-#endif /* ( ipconfigREPLY_TO_INCOMING_PINGS == 1 ) || ( ipconfigSUPPORT_OUTGOING_PINGS == 1 ) */
+	static eFrameProcessingResult_t prvProcessICMPPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer );
+#endif /* ipPROCESS_ICMP_PACKETS */
 
 /*
  * Turns around an incoming ping request to convert it into a ping reply.
@@ -230,6 +243,29 @@ static void prvIPTimerStart( IPTimer_t *pxTimer, TickType_t xTime );
 static BaseType_t prvIPTimerCheck( IPTimer_t *pxTimer );
 static void prvIPTimerReload( IPTimer_t *pxTimer, TickType_t xTime );
 
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_WORK_LIST == 1 )
+	/* Make the timer expire within xTime, unless it expires earlier already.
+	Returns pdTRUE when the timer was changed. */
+	static BaseType_t prvIPTimerShorten( IPTimer_t *pxTimer, TickType_t xTime );
+
+	/* Send the data that FreeRTOS_send() has added to the sockets in the TCP
+	work list. */
+	static BaseType_t prvTCPTxWorkEvent( void );
+#endif
+
+/* Bind the socket on behalf of FreeRTOS_bind() and wake up the user. */
+static void prvSocketBindEvent( FreeRTOS_Socket_t *pxSocket );
+
+#if( ipconfigUSE_STACK_LOCK != 0 )
+	/* Take and give the stack lock. */
+	static void prvStackLockTake( void );
+	static void prvStackLockGive( void );
+
+	/* Handle an event from a user task in that task, when the event can be
+	handled to completion without the IP-task. */
+	static BaseType_t prvRunToCompletion( const IPStackEvent_t *pxEvent );
+#endif
+
 /* The function 'prvAllowIPPacket()' checks if a packets should be processed. */
 static eFrameProcessingResult_t prvAllowIPPacket( const IPPacket_t * const pxIPPacket,
 												  const NetworkBufferDescriptor_t * const pxNetworkBuffer,
@@ -312,6 +348,23 @@ static BaseType_t xIPTaskInitialised = pdFALSE;
 	static UBaseType_t uxQueueMinimumSpace = ipconfigEVENT_QUEUE_LENGTH;
 #endif
 
+#if( ipconfigUSE_STACK_LOCK != 0 )
+	#if( configUSE_MUTEXES != 1 )
+		#error ipconfigUSE_STACK_LOCK requires configUSE_MUTEXES
+	#endif
+
+	/* The mutex that protects the stack, and the task that holds it.  The
+	IP-task holds it, except while it waits for events. */
+	static SemaphoreHandle_t xIPStackLock = NULL;
+	static TaskHandle_t xIPStackLockHolder = NULL;
+
+	#define ipSTACK_LOCK_TAKE()		prvStackLockTake()
+	#define ipSTACK_LOCK_GIVE()		prvStackLockGive()
+#else
+	#define ipSTACK_LOCK_TAKE()
+	#define ipSTACK_LOCK_GIVE()
+#endif
+
 /*-----------------------------------------------------------*/
 
 /* Coverity want to make pvParameters const, which would make it incompatible. */
@@ -320,8 +373,6 @@ static void prvIPTask( void *pvParameters )
 {
 IPStackEvent_t xReceivedEvent;
 TickType_t xNextIPSleep;
-FreeRTOS_Socket_t *pxSocket;
-struct freertos_sockaddr xAddress;
 
 	/* Just to prevent compiler warnings about unused parameters. */
 	( void ) pvParameters;
@@ -352,6 +403,8 @@ struct freertos_sockaddr xAddress;
 	{
 		ipconfigWATCHDOG_TIMER();
 
+		ipSTACK_LOCK_TAKE();
+
 		/* Check the ARP, DHCP and TCP timers to see if there is any periodic
 		or timeout processing to perform. */
 		prvCheckNetworkTimers();
@@ -361,12 +414,16 @@ struct freertos_sockaddr xAddress;
 
 		/* Wait until there is something to do. If the following call exits
 		 * due to a time out rather than a message being received, set a
-		 * 'NoEvent' value. */
+		 * 'NoEvent' value.  User tasks may use the stack in the mean time. */
+		ipSTACK_LOCK_GIVE();
+
 		if ( xQueueReceive( xNetworkEventQueue, ipPOINTER_CAST( void *, &xReceivedEvent ), xNextIPSleep ) == pdFALSE ) 
 		{
 			xReceivedEvent.eEventType = eNoEvent;
 		}
 
+		ipSTACK_LOCK_TAKE();
+
 		#if( ipconfigCHECK_IP_QUEUE_SPACE != 0 )
 		{
 			if( xReceivedEvent.eEventType != eNoEvent )
@@ -402,7 +459,7 @@ struct freertos_sockaddr xAddress;
 			case eNetworkTxEvent:
 				/* Send a network packet. The ownership will  be transferred to
 				the driver, which will release it after delivery. */
-				( void ) xNetworkInterfaceOutput( ipPOINTER_CAST( NetworkBufferDescriptor_t *, xReceivedEvent.pvData ), pdTRUE );
+				( void ) ipNETWORK_INTERFACE_OUTPUT( ipPOINTER_CAST( NetworkBufferDescriptor_t *, xReceivedEvent.pvData ), pdTRUE );
 				break;
 
 			case eARPTimerEvent :
@@ -416,17 +473,7 @@ struct freertos_sockaddr xAddress;
 				usLocalPort. vSocketBind() will actually bind the socket and the
 				API will unblock as soon as the eSOCKET_BOUND event is
 				triggered. */
-				pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, xReceivedEvent.pvData );
-				xAddress.sin_addr = 0U;	/* For the moment. */
-				xAddress.sin_port = FreeRTOS_ntohs( pxSocket->usLocalPort );
-				pxSocket->usLocalPort = 0U;
-				( void ) vSocketBind( pxSocket, &xAddress, sizeof( xAddress ), pdFALSE );
-
-				/* Before 'eSocketBindEvent' was sent it was tested that
-				( xEventGroup != NULL ) so it can be used now to wake up the
-				user. */
-				pxSocket->xEventBits |= ( EventBits_t ) eSOCKET_BOUND;
-				vSocketWakeUpUser( pxSocket );
+				prvSocketBindEvent( ipPOINTER_CAST( FreeRTOS_Socket_t *, xReceivedEvent.pvData ) );
 				break;
 
 			case eSocketCloseEvent :
@@ -480,6 +527,16 @@ struct freertos_sockaddr xAddress;
 				{
 					/* Some task wants to signal the user of this socket in
 					order to interrupt a call to recv() or a call to select(). */
+					#if( ipconfigUSE_STACK_LOCK != 0 )
+					{
+					FreeRTOS_Socket_t *pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, xReceivedEvent.pvData );
+
+						/* Incremented by FreeRTOS_SignalSocketFromISR(). */
+						taskENTER_CRITICAL();
+						pxSocket->uxSignalsPending--;
+						taskEXIT_CRITICAL();
+					}
+					#endif /* ipconfigUSE_STACK_LOCK */
 					( void ) FreeRTOS_SignalSocket( ipPOINTER_CAST( Socket_t, xReceivedEvent.pvData ) );
 				}
 				#endif /* ipconfigSUPPORT_SIGNALS */
@@ -495,13 +552,27 @@ struct freertos_sockaddr xAddress;
 				#endif /* ipconfigUSE_TCP */
 				break;
 
+			case eTCPTxEvent :
+				#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_WORK_LIST == 1 )
+				{
+					/* FreeRTOS_send() has added data to one or more sockets. */
+					( void ) prvTCPTxWorkEvent();
+				}
+				#endif /* ipconfigTCP_TX_WORK_LIST */
+				break;
+
+			case eNetworkTxDoneEvent:
+				/* The driver has sent frames, vIPTxQueueProcess() below will
+				give it the next ones. */
+				break;
+
 			case eTCPAcceptEvent:
 				/* The API FreeRTOS_accept() was called, the IP-task will now
 				check if the listening socket (communicated in pvData) actually
 				received a new connection. */
 				#if( ipconfigUSE_TCP == 1 )
 				{
-					pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, xReceivedEvent.pvData );
+				FreeRTOS_Socket_t *pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, xReceivedEvent.pvData );
 
 					if( xTCPCheckNewClient( pxSocket ) != pdFALSE )
 					{
@@ -539,18 +610,194 @@ struct freertos_sockaddr xAddress;
 			calling prvProcessNetworkDownEvent(). */
 			prvProcessNetworkDownEvent();
 		}
+
+		#if( ipconfigUSE_TX_PRIORITY_QUEUES != 0 )
+		{
+			/* Frames may be waiting for the driver. */
+			vIPTxQueueProcess();
+		}
+		#endif
+
+		ipSTACK_LOCK_GIVE();
 	}
 }
 /*-----------------------------------------------------------*/
 
+static void prvSocketBindEvent( FreeRTOS_Socket_t *pxSocket )
+{
+struct freertos_sockaddr xAddress;
+
+	/* FreeRTOS_bind (a user API) wants the IP-task to bind a socket to a
+	port. The port number is communicated in the socket field usLocalPort.
+	vSocketBind() will actually bind the socket and the API will unblock as
+	soon as the eSOCKET_BOUND event is triggered. */
+	xAddress.sin_addr = 0U;	/* For the moment. */
+	xAddress.sin_port = FreeRTOS_ntohs( pxSocket->usLocalPort );
+	pxSocket->usLocalPort = 0U;
+	( void ) vSocketBind( pxSocket, &xAddress, sizeof( xAddress ), pdFALSE );
+
+	/* Before 'eSocketBindEvent' was sent it was tested that
+	( xEventGroup != NULL ) so it can be used now to wake up the
+	user. */
+	pxSocket->xEventBits |= ( EventBits_t ) eSOCKET_BOUND;
+	vSocketWakeUpUser( pxSocket );
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_WORK_LIST == 1 )
+
+	static BaseType_t prvTCPTxWorkEvent( void )
+	{
+	TickType_t xNextTime;
+	BaseType_t xShortened = pdFALSE;
+
+		/* Only the sockets in the work list are checked, and the TCP timer is
+		brought forward if one of them needs attention before it expires. */
+		xNextTime = xTCPTxWorkListProcess();
+
+		if( xNextTime != portMAX_DELAY )
+		{
+			xShortened = prvIPTimerShorten( &xTCPTimer, xNextTime );
+		}
+
+		return xShortened;
+	}
+
+#endif /* ipconfigTCP_TX_WORK_LIST */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_STACK_LOCK != 0 )
+
+	static void prvStackLockTake( void )
+	{
+		( void ) xSemaphoreTake( xIPStackLock, portMAX_DELAY );
+		xIPStackLockHolder = xTaskGetCurrentTaskHandle();
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvStackLockGive( void )
+	{
+		xIPStackLockHolder = NULL;
+		( void ) xSemaphoreGive( xIPStackLock );
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvRunToCompletion( const IPStackEvent_t *pxEvent )
+	{
+	BaseType_t xReturn;
+	BaseType_t xWakeIPTask = pdFALSE;
+
+		switch( pxEvent->eEventType )
+		{
+			case eStackTxEvent:
+			case eSocketBindEvent:
+			case eSocketCloseEvent:
+				xReturn = pdTRUE;
+				break;
+
+			case eTCPTxEvent:
+				#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_WORK_LIST == 1 )
+				{
+					xReturn = pdTRUE;
+				}
+				#else
+				{
+					xReturn = pdFALSE;
+				}
+				#endif
+				break;
+
+			default:
+				/* Timers, reception and the other events stay with the
+				IP-task. */
+				xReturn = pdFALSE;
+				break;
+		}
+
+		if( xReturn != pdFALSE )
+		{
+			prvStackLockTake();
+
+			switch( pxEvent->eEventType )
+			{
+				case eStackTxEvent:
+					/* Resolve the address and give the packet to the driver
+					in the task that called FreeRTOS_sendto(). */
+					vProcessGeneratedUDPPacket( ipPOINTER_CAST( NetworkBufferDescriptor_t *, pxEvent->pvData ) );
+					break;
+
+				case eSocketBindEvent:
+					prvSocketBindEvent( ipPOINTER_CAST( FreeRTOS_Socket_t *, pxEvent->pvData ) );
+					break;
+
+				case eSocketCloseEvent:
+					#if( ipconfigSUPPORT_SIGNALS != 0 )
+					if( ipPOINTER_CAST( FreeRTOS_Socket_t *, pxEvent->pvData )->uxSignalsPending != 0U )
+					{
+						/* FreeRTOS_SignalSocketFromISR() has queued events
+						that refer to the socket.  The close is queued behind
+						them, so the IP-task handles them before the socket is
+						freed. */
+						xReturn = pdFALSE;
+					}
+					else
+					#endif /* ipconfigSUPPORT_SIGNALS */
+					{
+						( void ) vSocketClose( ipPOINTER_CAST( FreeRTOS_Socket_t *, pxEvent->pvData ) );
+					}
+					break;
+
+				default:
+					#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_WORK_LIST == 1 )
+					{
+						/* eTCPTxEvent.  When the TCP timer was brought
+						forward, the IP-task must calculate its sleep time
+						again. */
+						xWakeIPTask = prvTCPTxWorkEvent();
+					}
+					#endif
+					break;
+			}
+
+			#if( ipconfigUSE_TX_PRIORITY_QUEUES != 0 )
+			{
+				vIPTxQueueProcess();
+			}
+			#endif
+
+			prvStackLockGive();
+
+			if( ( xWakeIPTask != pdFALSE ) && ( uxQueueMessagesWaiting( xNetworkEventQueue ) == 0U ) )
+			{
+			IPStackEvent_t xWakeEvent = { eNoEvent, NULL };
+
+				( void ) xQueueSendToBack( xNetworkEventQueue, &xWakeEvent, 0U );
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_STACK_LOCK */
+/*-----------------------------------------------------------*/
+
 BaseType_t xIsCallingFromIPTask( void )
 {
 BaseType_t xReturn;
+TaskHandle_t xCurrentTask = xTaskGetCurrentTaskHandle();
 
-	if( xTaskGetCurrentTaskHandle() == xIPTaskHandle )
+	if( xCurrentTask == xIPTaskHandle )
+	{
+		xReturn = pdTRUE;
+	}
+	#if( ipconfigUSE_STACK_LOCK != 0 )
+	else if( xCurrentTask == xIPStackLockHolder )
 	{
+		/* A user task that holds the stack lock does the work of the
+		IP-task, and it may not block on it either. */
 		xReturn = pdTRUE;
 	}
+	#endif
 	else
 	{
 		xReturn = pdFALSE;
@@ -743,6 +990,34 @@ static void prvIPTimerReload( IPTimer_t *pxTimer, TickType_t xTime )
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_WORK_LIST == 1 )
+
+	static BaseType_t prvIPTimerShorten( IPTimer_t *pxTimer, TickType_t xTime )
+	{
+	TimeOut_t xTimeOut = pxTimer->xTimeOut;
+	TickType_t xRemainingTime = pxTimer->ulRemainingTime;
+	BaseType_t xReturn = pdFALSE;
+
+		if( ( pxTimer->bActive != pdFALSE_UNSIGNED ) && ( pxTimer->bExpired == pdFALSE_UNSIGNED ) )
+		{
+			/* Work on copies, so the timer itself is only changed if it must
+			expire earlier. */
+			if( xTaskCheckForTimeOut( &xTimeOut, &xRemainingTime ) == pdFALSE )
+			{
+				if( xTime < xRemainingTime )
+				{
+					prvIPTimerStart( pxTimer, xTime );
+					xReturn = pdTRUE;
+				}
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigTCP_TX_WORK_LIST */
+/*-----------------------------------------------------------*/
+
 static BaseType_t prvIPTimerCheck( IPTimer_t *pxTimer )
 {
 BaseType_t xReturn;
@@ -873,6 +1148,11 @@ NetworkBufferDescriptor_t * pxNewBuffer;
 		pxNewBuffer->ulIPAddress = pxNetworkBuffer->ulIPAddress;
 		pxNewBuffer->usPort = pxNetworkBuffer->usPort;
 		pxNewBuffer->usBoundPort = pxNetworkBuffer->usBoundPort;
+		#if( ipconfigMULTI_INTERFACE == 1 )
+		{
+			pxNewBuffer->pxEndPoint = pxNetworkBuffer->pxEndPoint;
+		}
+		#endif
 		( void ) memcpy( pxNewBuffer->pucEthernetBuffer, pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength );
 	}
 
@@ -1039,6 +1319,13 @@ BaseType_t xReturn = pdFALSE;
 			/* Prepare the sockets interface. */
 			vNetworkSocketsInit();
 
+			#if( ipconfigUSE_STACK_LOCK != 0 )
+			{
+				xIPStackLock = xSemaphoreCreateMutex();
+				configASSERT( xIPStackLock != NULL );
+			}
+			#endif
+
 			/* Create the task that processes Ethernet and stack events. */
 			xReturn = xTaskCreate( prvIPTask,
 								   "IP-task",
@@ -1116,6 +1403,9 @@ void FreeRTOS_SetAddressConfiguration( const uint32_t *pulIPAddress,
 		xNetworkAddressing.ulGatewayAddress = *pulGatewayAddress;
 	}
 
+	/* The next hop of a destination may have changed. */
+	ulARPGeneration++;
+
 	if( pulDNSServerAddress != NULL )
 	{
 		xNetworkAddressing.ulDNSServerAddress = *pulDNSServerAddress;
@@ -1176,6 +1466,11 @@ void FreeRTOS_SetAddressConfiguration( const uint32_t *pulIPAddress,
 				/* The message is complete, IP and checksum's are handled by
 				vProcessGeneratedUDPPacket */
 				pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ] = FREERTOS_SO_UDPCKSUM_OUT;
+				#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+				{
+					pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_TOS_OFFSET ] = 0U;
+				}
+				#endif
 				pxNetworkBuffer->ulIPAddress = ulIPAddress;
 				pxNetworkBuffer->usPort = ipPACKET_CONTAINS_ICMP_DATA;
 				/* xDataLength is the size of the total packet, including the Ethernet header. */
@@ -1253,6 +1548,19 @@ TickType_t uxUseTimeout = uxTimeout;
 		}
 		#endif /* ipconfigUSE_TCP */
 
+		#if( ipconfigUSE_STACK_LOCK != 0 )
+		{
+			if( ( xSendMessage != pdFALSE ) && ( xIsCallingFromIPTask() == pdFALSE ) )
+			{
+				if( prvRunToCompletion( pxEvent ) != pdFALSE )
+				{
+					/* The calling task has done the work itself. */
+					xSendMessage = pdFALSE;
+				}
+			}
+		}
+		#endif /* ipconfigUSE_STACK_LOCK */
+
 		if( xSendMessage != pdFALSE )
 		{
 			/* The IP task cannot block itself while waiting for itself to
@@ -1302,6 +1610,14 @@ const EthernetHeader_t *pxEthernetHeader;
 		eReturn = eProcessBuffer;
 	}
 	else
+#if( ipconfigMULTI_INTERFACE == 1 )
+	if( FreeRTOS_FindInterfaceOnMAC( &( pxEthernetHeader->xDestinationAddress ) ) != NULL )
+	{
+		/* The packet was directed to one of the other interfaces. */
+		eReturn = eProcessBuffer;
+	}
+	else
+#endif /* ipconfigMULTI_INTERFACE */
 #if( ipconfigUSE_LLMNR == 1 )
 	if( memcmp( xLLMNR_MacAdress.ucBytes, pxEthernetHeader->xDestinationAddress.ucBytes, sizeof( MACAddress_t ) ) == 0 )
 	{
@@ -1363,6 +1679,13 @@ static void prvProcessNetworkDownEvent( void )
 	interface. */
 	FreeRTOS_ClearARP( );
 
+	#if( ipconfigUSE_TX_PRIORITY_QUEUES != 0 )
+	{
+		/* Frames that wait for the driver will not be sent any more. */
+		vIPTxQueueFlush();
+	}
+	#endif
+
 	/* The network has been disconnected (or is being initialised for the first
 	time).  Perform whatever hardware processing is necessary to bring it up
 	again, or wait for it to be available again.  This is hardware dependent. */
@@ -1397,6 +1720,9 @@ void vIPNetworkUpCalls( void )
 {
 	xNetworkUp = pdTRUE;
 
+	/* DHCP may have changed the netmask or the gateway. */
+	ulARPGeneration++;
+
 	#if( ipconfigUSE_NETWORK_EVENT_HOOK == 1 )
 	{
 		vApplicationIPNetworkEventHook( eNetworkUp );
@@ -1576,6 +1902,12 @@ eFrameProcessingResult_t eReturn = eProcessBuffer;
 			#if( ipconfigUSE_LLMNR == 1 )
 				/* Is it the LLMNR multicast address? */
 				( ulDestinationIPAddress != ipLLMNR_IP_ADDR ) &&
+			#endif
+			#if( ipconfigMULTI_INTERFACE == 1 )
+				/* Is it the address, or the broadcast address, of another
+				end-point? */
+				( FreeRTOS_FindEndPointOnIP( ulDestinationIPAddress ) == NULL ) &&
+				( FreeRTOS_FindEndPointOnBroadcast( ulDestinationIPAddress ) == NULL ) &&
 			#endif
 				/* Or (during DHCP negotiation) we have no IP-address yet? */
 				( *ipLOCAL_IP_ADDRESS_POINTER != 0UL ) )
@@ -1736,6 +2068,15 @@ uint8_t ucProtocol;
 
 			if( eReturn != eReleaseBuffer )
 			{
+				#if( ipconfigMULTI_INTERFACE == 1 )
+				{
+					/* Remember the end-point that received the packet, a reply
+					or a connection that is accepted from it leaves through the
+					same end-point.  NULL for broadcast and multicast packets. */
+					pxNetworkBuffer->pxEndPoint = FreeRTOS_FindEndPointOnIP( pxIPHeader->ulDestinationIPAddress );
+				}
+				#endif /* ipconfigMULTI_INTERFACE */
+
 				/* Add the IP and MAC addresses to the ARP table if they are not
 				already there - otherwise refresh the age of the existing
 				entry. */
@@ -1756,16 +2097,17 @@ uint8_t ucProtocol;
 						also be returned, and the source of the ping will know something
 						went wrong because it will not be able to validate what it
 						receives. */
-						#if ( ipconfigREPLY_TO_INCOMING_PINGS == 1 ) || ( ipconfigSUPPORT_OUTGOING_PINGS == 1 )
+						#if( ipPROCESS_ICMP_PACKETS != 0 )
 						{
 							if( pxNetworkBuffer->xDataLength >= sizeof( ICMPPacket_t ) )
 							{
-								/* Map the buffer onto a ICMP-Packet struct to easily access the
-								 * fields of ICMP packet. */
-								ICMPPacket_t *pxICMPPacket = ipPOINTER_CAST( ICMPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
-								if( pxIPHeader->ulDestinationIPAddress == *ipLOCAL_IP_ADDRESS_POINTER )
+								#if( ipconfigMULTI_INTERFACE == 1 )
+									if( pxNetworkBuffer->pxEndPoint != NULL )
+								#else
+									if( pxIPHeader->ulDestinationIPAddress == *ipLOCAL_IP_ADDRESS_POINTER )
+								#endif
 								{
-									eReturn = prvProcessICMPPacket( pxICMPPacket );
+									eReturn = prvProcessICMPPacket( pxNetworkBuffer );
 								}
 							}
 							else
@@ -1773,7 +2115,7 @@ uint8_t ucProtocol;
 								eReturn = eReleaseBuffer;
 							}
 						}
-						#endif /* ( ipconfigREPLY_TO_INCOMING_PINGS == 1 ) || ( ipconfigSUPPORT_OUTGOING_PINGS == 1 ) */
+						#endif /* ipPROCESS_ICMP_PACKETS */
 						break;
 
 					case ipPROTOCOL_UDP :
@@ -1910,6 +2252,12 @@ uint8_t ucProtocol;
 	ICMPHeader_t *pxICMPHeader;
 	IPHeader_t *pxIPHeader;
 	uint16_t usRequest;
+	#if( ipconfigMULTI_INTERFACE == 1 )
+		/* Reply from the end-point that was pinged. */
+		uint32_t ulReplyAddress = pxICMPPacket->xIPHeader.ulDestinationIPAddress;
+	#else
+		uint32_t ulReplyAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+	#endif
 
 		pxICMPHeader = &( pxICMPPacket->xICMPHeader );
 		pxIPHeader = &( pxICMPPacket->xIPHeader );
@@ -1923,7 +2271,7 @@ uint8_t ucProtocol;
 		invalid data. */
 		pxICMPHeader->ucTypeOfMessage = ( uint8_t ) ipICMP_ECHO_REPLY;
 		pxIPHeader->ulDestinationIPAddress = pxIPHeader->ulSourceIPAddress;
-		pxIPHeader->ulSourceIPAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+		pxIPHeader->ulSourceIPAddress = ulReplyAddress;
 
 		/* Update the checksum because the ucTypeOfMessage member in the header
 		has been changed to ipICMP_ECHO_REPLY.  This is faster than calling
@@ -1947,11 +2295,14 @@ uint8_t ucProtocol;
 #endif /* ipconfigREPLY_TO_INCOMING_PINGS == 1 */
 /*-----------------------------------------------------------*/
 
-#if ( ipconfigREPLY_TO_INCOMING_PINGS == 1 ) || ( ipconfigSUPPORT_OUTGOING_PINGS == 1 )
+#if( ipPROCESS_ICMP_PACKETS != 0 )
 
-	static eFrameProcessingResult_t prvProcessICMPPacket( ICMPPacket_t * const pxICMPPacket )
+	static eFrameProcessingResult_t prvProcessICMPPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer )
 	{
 	eFrameProcessingResult_t eReturn = eReleaseBuffer;
+	/* Map the buffer onto a ICMP-Packet struct to easily access the
+	 * fields of ICMP packet. */
+	ICMPPacket_t *pxICMPPacket = ipPOINTER_CAST( ICMPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
 
 		iptraceICMP_PACKET_RECEIVED();
 		switch( pxICMPPacket->xICMPHeader.ucTypeOfMessage )
@@ -1972,15 +2323,27 @@ uint8_t ucProtocol;
 				#endif /* ipconfigSUPPORT_OUTGOING_PINGS */
 				break;
 
+			case ipICMP_DESTINATION_UNREACHABLE :
+				#if( ( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_PATH_MTU_DISCOVERY != 0 ) )
+				{
+					if( pxICMPPacket->xICMPHeader.ucTypeOfService == ipICMP_FRAGMENTATION_NEEDED )
+					{
+						vTCPFragmentationNeeded( pxNetworkBuffer );
+					}
+				}
+				#endif /* ipconfigUSE_PATH_MTU_DISCOVERY */
+				break;
+
 			default	:
-				/* Only ICMP echo packets are handled. */
+				/* Only ICMP echo packets and "fragmentation needed" messages
+				are handled. */
 				break;
 		}
 
 		return eReturn;
 	}
 
-#endif /* ( ipconfigREPLY_TO_INCOMING_PINGS == 1 ) || ( ipconfigSUPPORT_OUTGOING_PINGS == 1 ) */
+#endif /* ipPROCESS_ICMP_PACKETS */
 /*-----------------------------------------------------------*/
 
 #if( ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM == 1 )
@@ -2537,6 +2900,19 @@ size_t uxDataLengthBytes = uxByteCount;
 }
 /*-----------------------------------------------------------*/
 
+uint16_t usFoldChecksum( uint32_t ulSum )
+{
+uint32_t ulResult = ulSum;
+
+	while( ( ulResult >> 16 ) != 0UL )
+	{
+		ulResult = ( ulResult & 0xffffUL ) + ( ulResult >> 16 );
+	}
+
+	return ( uint16_t ) ulResult;
+}
+/*-----------------------------------------------------------*/
+
 /* This function is used in other files, has external linkage e.g. in
  * FreeRTOS_DNS.c. Not to be made static. */
 void vReturnEthernetFrame( NetworkBufferDescriptor_t * pxNetworkBuffer, BaseType_t xReleaseAfterSend )
@@ -2585,7 +2961,7 @@ EthernetHeader_t *pxEthernetHeader;
 		( void ) memcpy( &( pxEthernetHeader->xSourceAddress) , ipLOCAL_MAC_ADDRESS, ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
 
 		/* Send! */
-		( void ) xNetworkInterfaceOutput( pxNetworkBuffer, xReleaseAfterSend );
+		( void ) ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend );
 	}
 }
 /*-----------------------------------------------------------*/
@@ -2719,12 +3095,14 @@ const uint8_t * FreeRTOS_GetMACAddress( void )
 void FreeRTOS_SetNetmask ( uint32_t ulNetmask )
 {
 	xNetworkAddressing.ulNetMask = ulNetmask;
+	ulARPGeneration++;
 }
 /*-----------------------------------------------------------*/
 
 void FreeRTOS_SetGatewayAddress ( uint32_t ulGatewayAddress )
 {
 	xNetworkAddressing.ulGatewayAddress = ulGatewayAddress;
+	ulARPGeneration++;
 }
 /*-----------------------------------------------------------*/
 
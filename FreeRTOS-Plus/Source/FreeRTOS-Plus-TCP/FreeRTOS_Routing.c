@@ -0,0 +1,480 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_Routing.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+#if( ipconfigMULTI_INTERFACE == 1 )
+
+/*
+ * Refresh the primary end-point from the addresses that FreeRTOS_IPInit() and
+ * DHCP store in xNetworkAddressing, and return it.
+ */
+static NetworkEndPoint_t *prvPrimaryEndPoint( void );
+
+/*
+ * Find the end-point through which a packet to ulIPAddress must be sent, for
+ * packets that do not carry an end-point.
+ */
+static NetworkEndPoint_t *prvEndPointForDestination( uint32_t ulIPAddress );
+
+/*
+ * Give an outgoing IP packet a different source address, and update its
+ * checksums.
+ */
+static void prvSetSourceAddress( NetworkBufferDescriptor_t * const pxNetworkBuffer, uint32_t ulIPAddress );
+
+/*-----------------------------------------------------------*/
+
+/* The interfaces in the order in which they were added. */
+static NetworkInterface_t *pxNetworkInterfaces = NULL;
+
+/* The end-points added with FreeRTOS_AddEndPoint(). */
+static NetworkEndPoint_t *pxEndPoints = NULL;
+
+/* The end-point of the addresses passed to FreeRTOS_IPInit(), or obtained by
+DHCP.  It lives on the first interface. */
+static NetworkEndPoint_t xPrimaryEndPoint;
+
+/*-----------------------------------------------------------*/
+
+NetworkInterface_t *FreeRTOS_AddNetworkInterface( NetworkInterface_t *pxInterface )
+{
+NetworkInterface_t **ppxLast = &( pxNetworkInterfaces );
+
+	configASSERT( pxInterface != NULL );
+	configASSERT( pxInterface->pfInitialise != NULL );
+	configASSERT( pxInterface->pfOutput != NULL );
+
+	while( *ppxLast != NULL )
+	{
+		ppxLast = &( ( *ppxLast )->pxNext );
+	}
+
+	pxInterface->xIsUp = pdFALSE;
+	pxInterface->pxNext = NULL;
+	*ppxLast = pxInterface;
+
+	return pxInterface;
+}
+/*-----------------------------------------------------------*/
+
+NetworkEndPoint_t *FreeRTOS_AddEndPoint( NetworkInterface_t *pxInterface,
+										 NetworkEndPoint_t *pxEndPoint,
+										 const uint8_t ucIPAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+										 const uint8_t ucNetMask[ ipIP_ADDRESS_LENGTH_BYTES ],
+										 const uint8_t ucGatewayAddress[ ipIP_ADDRESS_LENGTH_BYTES ] )
+{
+NetworkEndPoint_t **ppxLast = &( pxEndPoints );
+
+	configASSERT( pxInterface != NULL );
+	configASSERT( pxEndPoint != NULL );
+
+	( void ) memset( pxEndPoint, 0, sizeof( *pxEndPoint ) );
+	pxEndPoint->ulIPAddress = FreeRTOS_inet_addr_quick( ucIPAddress[ 0 ], ucIPAddress[ 1 ], ucIPAddress[ 2 ], ucIPAddress[ 3 ] );
+	pxEndPoint->ulNetMask = FreeRTOS_inet_addr_quick( ucNetMask[ 0 ], ucNetMask[ 1 ], ucNetMask[ 2 ], ucNetMask[ 3 ] );
+	pxEndPoint->ulBroadcastAddress = ( pxEndPoint->ulIPAddress & pxEndPoint->ulNetMask ) | ~pxEndPoint->ulNetMask;
+	pxEndPoint->pxNetworkInterface = pxInterface;
+
+	if( ucGatewayAddress != NULL )
+	{
+		pxEndPoint->ulGatewayAddress = FreeRTOS_inet_addr_quick( ucGatewayAddress[ 0 ], ucGatewayAddress[ 1 ], ucGatewayAddress[ 2 ], ucGatewayAddress[ 3 ] );
+
+		/* Just like for the primary end-point, the gateway must be on the
+		network of the end-point. */
+		if( pxEndPoint->ulGatewayAddress != 0UL )
+		{
+			configASSERT( ( pxEndPoint->ulIPAddress & pxEndPoint->ulNetMask ) == ( pxEndPoint->ulGatewayAddress & pxEndPoint->ulNetMask ) );
+		}
+	}
+
+	while( *ppxLast != NULL )
+	{
+		ppxLast = &( ( *ppxLast )->pxNext );
+	}
+
+	*ppxLast = pxEndPoint;
+
+	return pxEndPoint;
+}
+/*-----------------------------------------------------------*/
+
+NetworkInterface_t *FreeRTOS_FirstNetworkInterface( void )
+{
+	return pxNetworkInterfaces;
+}
+/*-----------------------------------------------------------*/
+
+NetworkInterface_t *FreeRTOS_NextNetworkInterface( const NetworkInterface_t *pxInterface )
+{
+NetworkInterface_t *pxReturn = NULL;
+
+	if( pxInterface != NULL )
+	{
+		pxReturn = pxInterface->pxNext;
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+static NetworkEndPoint_t *prvPrimaryEndPoint( void )
+{
+	xPrimaryEndPoint.ulIPAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+	xPrimaryEndPoint.ulNetMask = xNetworkAddressing.ulNetMask;
+	xPrimaryEndPoint.ulGatewayAddress = xNetworkAddressing.ulGatewayAddress;
+	xPrimaryEndPoint.ulBroadcastAddress = xNetworkAddressing.ulBroadcastAddress;
+	xPrimaryEndPoint.pxNetworkInterface = pxNetworkInterfaces;
+	xPrimaryEndPoint.pxNext = pxEndPoints;
+
+	return &( xPrimaryEndPoint );
+}
+/*-----------------------------------------------------------*/
+
+NetworkEndPoint_t *FreeRTOS_FirstEndPoint( void )
+{
+	return prvPrimaryEndPoint();
+}
+/*-----------------------------------------------------------*/
+
+NetworkEndPoint_t *FreeRTOS_NextEndPoint( const NetworkEndPoint_t *pxEndPoint )
+{
+NetworkEndPoint_t *pxReturn = NULL;
+
+	if( pxEndPoint != NULL )
+	{
+		pxReturn = pxEndPoint->pxNext;
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+NetworkEndPoint_t *FreeRTOS_FindEndPointOnIP( uint32_t ulIPAddress )
+{
+NetworkEndPoint_t *pxEndPoint;
+
+	for( pxEndPoint = prvPrimaryEndPoint(); pxEndPoint != NULL; pxEndPoint = pxEndPoint->pxNext )
+	{
+		if( ( pxEndPoint->ulIPAddress == ulIPAddress ) && ( ulIPAddress != 0UL ) )
+		{
+			break;
+		}
+	}
+
+	return pxEndPoint;
+}
+/*-----------------------------------------------------------*/
+
+NetworkEndPoint_t *FreeRTOS_FindEndPointOnBroadcast( uint32_t ulIPAddress )
+{
+NetworkEndPoint_t *pxEndPoint;
+
+	for( pxEndPoint = prvPrimaryEndPoint(); pxEndPoint != NULL; pxEndPoint = pxEndPoint->pxNext )
+	{
+		if( ( pxEndPoint->ulIPAddress != 0UL ) && ( pxEndPoint->ulBroadcastAddress == ulIPAddress ) )
+		{
+			break;
+		}
+	}
+
+	return pxEndPoint;
+}
+/*-----------------------------------------------------------*/
+
+NetworkEndPoint_t *FreeRTOS_FindEndPointOnNetMask( uint32_t ulIPAddress )
+{
+NetworkEndPoint_t *pxEndPoint;
+
+	for( pxEndPoint = prvPrimaryEndPoint(); pxEndPoint != NULL; pxEndPoint = pxEndPoint->pxNext )
+	{
+		/* An end-point without an address (waiting for DHCP) has no
+		network yet. */
+		if( ( pxEndPoint->ulIPAddress != 0UL ) &&
+			( ( ( ulIPAddress ^ pxEndPoint->ulIPAddress ) & pxEndPoint->ulNetMask ) == 0UL ) )
+		{
+			break;
+		}
+	}
+
+	return pxEndPoint;
+}
+/*-----------------------------------------------------------*/
+
+NetworkEndPoint_t *FreeRTOS_FindEndPointForRoute( uint32_t ulIPAddress )
+{
+NetworkEndPoint_t *pxEndPoint;
+
+	pxEndPoint = FreeRTOS_FindEndPointOnNetMask( ulIPAddress );
+
+	if( pxEndPoint == NULL )
+	{
+		/* Not on any of the networks, use the first gateway. */
+		for( pxEndPoint = prvPrimaryEndPoint(); pxEndPoint != NULL; pxEndPoint = pxEndPoint->pxNext )
+		{
+			if( pxEndPoint->ulGatewayAddress != 0UL )
+			{
+				break;
+			}
+		}
+	}
+
+	if( pxEndPoint == NULL )
+	{
+		pxEndPoint = prvPrimaryEndPoint();
+	}
+
+	return pxEndPoint;
+}
+/*-----------------------------------------------------------*/
+
+NetworkInterface_t *FreeRTOS_FindInterfaceOnMAC( const MACAddress_t *pxMACAddress )
+{
+NetworkInterface_t *pxInterface;
+
+	for( pxInterface = pxNetworkInterfaces; pxInterface != NULL; pxInterface = pxInterface->pxNext )
+	{
+		if( memcmp( pxInterface->xMACAddress.ucBytes, pxMACAddress->ucBytes, sizeof( MACAddress_t ) ) == 0 )
+		{
+			break;
+		}
+	}
+
+	return pxInterface;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceInitialise( void )
+{
+NetworkInterface_t *pxInterface;
+BaseType_t xReturn = pdFAIL;
+
+	/* The first interface carries the MAC address that was passed to
+	FreeRTOS_IPInit(), or set with FreeRTOS_UpdateMACAddress(). */
+	if( pxNetworkInterfaces != NULL )
+	{
+		( void ) memcpy( pxNetworkInterfaces->xMACAddress.ucBytes, ipLOCAL_MAC_ADDRESS, sizeof( MACAddress_t ) );
+	}
+
+	/* The network-down event does not tell which interface went down, so all
+	of them are initialised again.  Only the first interface must be up for the
+	stack to continue. */
+	for( pxInterface = pxNetworkInterfaces; pxInterface != NULL; pxInterface = pxInterface->pxNext )
+	{
+		pxInterface->xIsUp = ( pxInterface->pfInitialise( pxInterface ) == pdPASS ) ? pdTRUE : pdFALSE;
+
+		if( pxInterface->xIsUp == pdFALSE )
+		{
+			FreeRTOS_debug_printf( ( "xNetworkInterfaceInitialise: %s failed\n", pxInterface->pcName ) );
+		}
+	}
+
+	if( ( pxNetworkInterfaces != NULL ) && ( pxNetworkInterfaces->xIsUp != pdFALSE ) )
+	{
+		xReturn = pdPASS;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xGetPhyLinkStatus( void )
+{
+NetworkInterface_t *pxInterface;
+BaseType_t xReturn = pdFALSE;
+
+	for( pxInterface = pxNetworkInterfaces; pxInterface != NULL; pxInterface = pxInterface->pxNext )
+	{
+		if( pxInterface->pfGetPhyLinkStatus != NULL )
+		{
+			xReturn = pxInterface->pfGetPhyLinkStatus( pxInterface );
+		}
+		else
+		{
+			xReturn = pxInterface->xIsUp;
+		}
+
+		if( xReturn != pdFALSE )
+		{
+			break;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static NetworkEndPoint_t *prvEndPointForDestination( uint32_t ulIPAddress )
+{
+NetworkEndPoint_t *pxEndPoint;
+
+	if( ( ulIPAddress == ipBROADCAST_IP_ADDRESS ) || ( xIsIPv4Multicast( ulIPAddress ) != pdFALSE ) )
+	{
+		/* DHCP, LLMNR and the like are only used on the primary
+		end-point. */
+		pxEndPoint = prvPrimaryEndPoint();
+	}
+	else
+	{
+		pxEndPoint = FreeRTOS_FindEndPointOnBroadcast( ulIPAddress );
+
+		if( pxEndPoint == NULL )
+		{
+			pxEndPoint = FreeRTOS_FindEndPointForRoute( ulIPAddress );
+		}
+	}
+
+	return pxEndPoint;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetSourceAddress( NetworkBufferDescriptor_t * const pxNetworkBuffer, uint32_t ulIPAddress )
+{
+IPPacket_t *pxIPPacket = ipPOINTER_CAST( IPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+IPHeader_t *pxIPHeader = &( pxIPPacket->xIPHeader );
+
+	pxIPHeader->ulSourceIPAddress = ulIPAddress;
+
+	#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
+	{
+	size_t uxHeaderLength = ( size_t ) ( ( pxIPHeader->ucVersionHeaderLength & 0x0FU ) << 2 );
+
+		pxIPHeader->usHeaderChecksum = 0x00U;
+		pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0U, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), uxHeaderLength );
+		pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+
+		/* The source address is part of the pseudo header of TCP and UDP. */
+		( void ) usGenerateProtocolChecksum( pxNetworkBuffer->pucEthernetBuffer, pxNetworkBuffer->xDataLength, pdTRUE );
+	}
+	#endif /* ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM */
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend )
+{
+EthernetHeader_t *pxEthernetHeader = ipPOINTER_CAST( EthernetHeader_t *, pxNetworkBuffer->pucEthernetBuffer );
+NetworkEndPoint_t *pxEndPoint = NULL;
+NetworkInterface_t *pxInterface = NULL;
+BaseType_t xReturn = pdFAIL;
+
+	if( pxNetworkBuffer->pxEndPoint != NULL )
+	{
+		/* The packet belongs to a TCP connection, or answers a packet that
+		was received by this end-point.  It leaves through that end-point,
+		with its source address. */
+		pxEndPoint = pxNetworkBuffer->pxEndPoint;
+
+		if( pxEndPoint == &( xPrimaryEndPoint ) )
+		{
+			/* DHCP may have changed the primary address. */
+			( void ) prvPrimaryEndPoint();
+		}
+
+		if( pxEthernetHeader->usFrameType == ipIPv4_FRAME_TYPE )
+		{
+		IPPacket_t *pxIPPacket = ipPOINTER_CAST( IPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+
+			if( ( pxEndPoint->ulIPAddress != 0UL ) &&
+				( pxEndPoint->ulIPAddress != pxIPPacket->xIPHeader.ulSourceIPAddress ) )
+			{
+				prvSetSourceAddress( pxNetworkBuffer, pxEndPoint->ulIPAddress );
+			}
+		}
+	}
+	/* Other packets are filled in with the addresses of the primary end-point.
+	Route them on the destination address, and replace the source addresses
+	when the packet leaves through another end-point. */
+	else if( pxEthernetHeader->usFrameType == ipARP_FRAME_TYPE )
+	{
+	ARPPacket_t *pxARPPacket = ipPOINTER_CAST( ARPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+	uint32_t ulSenderAddress;
+
+		pxEndPoint = prvEndPointForDestination( pxARPPacket->xARPHeader.ulTargetProtocolAddress );
+
+		/* The field ucSenderProtocolAddress is badly aligned. */
+		( void ) memcpy( &( ulSenderAddress ), pxARPPacket->xARPHeader.ucSenderProtocolAddress, sizeof( ulSenderAddress ) );
+
+		if( ( pxEndPoint != NULL ) && ( pxEndPoint->pxNetworkInterface != NULL ) &&
+			( ulSenderAddress == *ipLOCAL_IP_ADDRESS_POINTER ) && ( pxEndPoint->ulIPAddress != ulSenderAddress ) )
+		{
+			( void ) memcpy( pxARPPacket->xARPHeader.ucSenderProtocolAddress, &( pxEndPoint->ulIPAddress ), sizeof( pxARPPacket->xARPHeader.ucSenderProtocolAddress ) );
+			( void ) memcpy( pxARPPacket->xARPHeader.xSenderHardwareAddress.ucBytes, pxEndPoint->pxNetworkInterface->xMACAddress.ucBytes, sizeof( MACAddress_t ) );
+		}
+	}
+	else if( pxEthernetHeader->usFrameType == ipIPv4_FRAME_TYPE )
+	{
+	IPPacket_t *pxIPPacket = ipPOINTER_CAST( IPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+
+		pxEndPoint = prvEndPointForDestination( pxIPPacket->xIPHeader.ulDestinationIPAddress );
+
+		if( ( pxEndPoint != NULL ) && ( pxEndPoint->ulIPAddress != 0UL ) &&
+			( pxIPPacket->xIPHeader.ulSourceIPAddress == *ipLOCAL_IP_ADDRESS_POINTER ) &&
+			( pxEndPoint->ulIPAddress != pxIPPacket->xIPHeader.ulSourceIPAddress ) )
+		{
+			prvSetSourceAddress( pxNetworkBuffer, pxEndPoint->ulIPAddress );
+		}
+	}
+	else
+	{
+		/* Other frame types are sent through the primary end-point. */
+		pxEndPoint = prvPrimaryEndPoint();
+	}
+
+	if( pxEndPoint != NULL )
+	{
+		pxInterface = pxEndPoint->pxNetworkInterface;
+	}
+
+	if( ( pxInterface != NULL ) && ( pxInterface->xIsUp != pdFALSE ) )
+	{
+		( void ) memcpy( pxEthernetHeader->xSourceAddress.ucBytes, pxInterface->xMACAddress.ucBytes, sizeof( MACAddress_t ) );
+		xReturn = pxInterface->pfOutput( pxInterface, pxNetworkBuffer, xReleaseAfterSend );
+	}
+	else if( xReleaseAfterSend != pdFALSE )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+	else
+	{
+		/* The caller still owns the buffer. */
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigMULTI_INTERFACE */
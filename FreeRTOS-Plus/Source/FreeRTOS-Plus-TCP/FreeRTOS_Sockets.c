@@ -39,6 +39,7 @@
 #include "FreeRTOS_Sockets.h"
 #include "FreeRTOS_IP_Private.h"
 #include "FreeRTOS_DNS.h"
+#include "FreeRTOS_ARP.h"
 #include "NetworkBufferManagement.h"
 
 /* A tool to measure RAM usage. By default, it is disabled
@@ -87,6 +88,82 @@ range 1024-65535" excluding those already in use (inbound or outbound). */
 #define sock80_PERCENT						80U
 #define sock100_PERCENT						100U
 
+/* The space taken by the event group of a socket, for iptraceMEM_STATS_CREATE(). */
+#if( ipconfigSOCKET_USE_TASK_NOTIFICATIONS == 1 )
+	#define sockEVENT_GROUP_SIZE				0U
+#else
+	#define sockEVENT_GROUP_SIZE				sizeof( StaticEventGroup_t )
+#endif
+
+/* The value of the field 'LENGTH' of a stream buffer that can hold at least
+uxLength bytes: one extra byte, rounded up to a multiple of sizeof( size_t ). */
+#define sockSTREAM_LENGTH( uxLength ) \
+	( ( ( size_t ) ( uxLength ) + sizeof( size_t ) ) & ~( sizeof( size_t ) - 1U ) )
+
+/* The number of bytes to allocate for a stream buffer of uxLength bytes. */
+#define sockSTREAM_BUFFER_SIZE( uxLength ) \
+	( ( sizeof( StreamBuffer_t ) - sizeof( size_t ) ) + sockSTREAM_LENGTH( uxLength ) )
+
+#if( ipconfigUSE_SOCKET_POOLS == 1 )
+	#define sockSTREAM_MALLOC( uxSize )		prvStreamBufferAllocate( uxSize )
+	#define sockSTREAM_FREE( pxBuffer )		prvStreamBufferFree( pxBuffer )
+#else
+	#define sockSTREAM_MALLOC( uxSize )		pvPortMallocLarge( uxSize )
+	#define sockSTREAM_FREE( pxBuffer )		vPortFreeLarge( pxBuffer )
+#endif
+
+#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+	/* An API call that is copying data from or to a stream counts itself in
+	uxRxStreamUsers or uxTxStreamUsers.  The IP-task only moves or releases a
+	stream while the scheduler is suspended and the stream has no users. */
+	#define sockSTREAM_USE_BEGIN( uxUsers ) \
+		do { taskENTER_CRITICAL(); ( uxUsers )++; taskEXIT_CRITICAL(); } while( ipFALSE_BOOL )
+	#define sockSTREAM_USE_END( uxUsers ) \
+		do { taskENTER_CRITICAL(); ( uxUsers )--; taskEXIT_CRITICAL(); } while( ipFALSE_BOOL )
+
+	/* A quick look at the markers of a stream is protected by suspending the
+	scheduler. */
+	#define sockSTREAM_READ_BEGIN()		vTaskSuspendAll()
+	#define sockSTREAM_READ_END()		( void ) xTaskResumeAll()
+#else
+	#define sockSTREAM_USE_BEGIN( uxUsers )
+	#define sockSTREAM_USE_END( uxUsers )
+	#define sockSTREAM_READ_BEGIN()
+	#define sockSTREAM_READ_END()
+#endif /* ipconfigTCP_ELASTIC_STREAMS */
+
+#if( ipconfigUSE_SOCKET_POOLS == 1 )
+
+	#if( ipconfigSOCKET_USE_TASK_NOTIFICATIONS == 0 ) && ( configSUPPORT_STATIC_ALLOCATION != 1 )
+		#error ipconfigUSE_SOCKET_POOLS requires configSUPPORT_STATIC_ALLOCATION to be 1
+	#endif
+
+	#define sockNUMBER_OF_POOLS				3
+
+	/* A pool of equally sized blocks in a statically allocated array.  The free
+	blocks are linked through their first bytes. */
+	typedef struct xSOCKET_POOL
+	{
+		uint8_t *pucStart;			/* The first byte of the first block. */
+		uint8_t *pucEnd;			/* The first byte after the last block. */
+		size_t uxBlockSize;
+		void *pvFreeList;
+		UBaseType_t uxFree;
+		UBaseType_t uxMinimumFree;	/* The lowest value of uxFree so far. */
+	} SocketPool_t;
+
+	/* A socket and the space for its event group form one block of the socket
+	pool.  Every block has the size of a TCP socket. */
+	typedef struct xSOCKET_POOL_BLOCK
+	{
+		FreeRTOS_Socket_t xSocket;	/* Must be the first member. */
+		#if( ipconfigSOCKET_USE_TASK_NOTIFICATIONS == 0 )
+			StaticEventGroup_t xEventGroupBuffer;
+		#endif
+	} SocketPoolBlock_t;
+
+#endif /* ipconfigUSE_SOCKET_POOLS */
+
 
 /*-----------------------------------------------------------*/
 
@@ -128,6 +205,14 @@ static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType,
 	static StreamBuffer_t *prvTCPCreateStream (FreeRTOS_Socket_t *pxSocket, BaseType_t xIsInputStream );
 #endif /* ipconfigUSE_TCP == 1 */
 
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_ELASTIC_STREAMS == 1 )
+	/*
+	 * Called by the IP-task: release the empty streams of a connection that
+	 * has been idle for ipconfigTCP_STREAM_IDLE_RELEASE_MS.
+	 */
+	static void prvTCPStreamsRelease( FreeRTOS_Socket_t *pxSocket, TickType_t xNow );
+#endif /* ipconfigTCP_ELASTIC_STREAMS */
+
 #if( ipconfigUSE_TCP == 1 )
 	/*
 	 * Called from FreeRTOS_send(): some checks which will be done before
@@ -159,6 +244,78 @@ static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType,
 	static BaseType_t bMayConnect( FreeRTOS_Socket_t const * pxSocket );
 #endif /* ipconfigUSE_TCP */
 
+#if( ipconfigUSE_TCP == 1 )
+	/*
+	 * Called from FreeRTOS_connect(): wait until a connection started by
+	 * prvTCPConnectStart() succeeds, fails, or times out.
+	 */
+	static BaseType_t prvTCPConnectWait( FreeRTOS_Socket_t * pxSocket );
+#endif /* ipconfigUSE_TCP */
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_FAST_OPEN == 1 )
+	/*
+	 * Called from FreeRTOS_sendto() with the FREERTOS_MSG_FASTOPEN flag: queue
+	 * the data and connect, the data will be sent along with the SYN.
+	 */
+	static int32_t prvTCPFastOpenConnect( FreeRTOS_Socket_t *pxSocket, const void *pvBuffer, size_t uxDataLength,
+		BaseType_t xFlags, const struct freertos_sockaddr *pxAddress );
+#endif /* ipconfigUSE_TCP_FAST_OPEN */
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_WORK_LIST == 1 )
+	/*
+	 * Called from FreeRTOS_send(): add the socket to the TX work list, and wake
+	 * up the IP-task if the list was empty.
+	 */
+	static void prvTCPTxWorkListAdd( FreeRTOS_Socket_t *pxSocket );
+#endif /* ipconfigTCP_TX_WORK_LIST */
+
+#if( ipconfigUSE_SOCKET_POOLS == 1 )
+	/*
+	 * Divide the uxCount * uxBlockSize bytes at pvMemory into blocks, and put
+	 * all blocks in the free list of the pool.
+	 */
+	static void prvPoolInit( SocketPool_t *pxPool, void *pvMemory, size_t uxBlockSize, UBaseType_t uxCount );
+
+	/*
+	 * Take a block from a pool, or return NULL if the pool is empty.
+	 */
+	static void *prvPoolTake( SocketPool_t *pxPool );
+
+	/*
+	 * Return a block to the pool it came from.  Returns pdFALSE, and does
+	 * nothing, if the block does not belong to the pool.
+	 */
+	static BaseType_t prvPoolGive( SocketPool_t *pxPool, void *pvBlock );
+#endif /* ipconfigUSE_SOCKET_POOLS */
+
+#if( ipconfigUSE_SOCKET_POOLS == 1 ) && ( ipconfigUSE_TCP == 1 )
+	/*
+	 * Allocate uxSize bytes for a stream buffer from the smallest stream pool
+	 * that fits, or from the heap when neither pool fits.
+	 */
+	static void *prvStreamBufferAllocate( size_t uxSize );
+
+	/*
+	 * Free a stream buffer allocated by prvStreamBufferAllocate().
+	 */
+	static void prvStreamBufferFree( StreamBuffer_t *pxBuffer );
+#endif /* ipconfigUSE_SOCKET_POOLS */
+
+#if( ipconfigUSE_BUFFER_QUOTAS == 1 )
+	/*
+	 * Count a packet that was dropped, or not sent, by a socket because of the
+	 * quotas.
+	 */
+	static void prvBufferQuotaDrop( FreeRTOS_Socket_t *pxSocket, uint32_t *pulCounter );
+
+	/*
+	 * Obtain a network buffer for FreeRTOS_sendto() on an application socket,
+	 * without taking one of the reserved buffers.  Waits until the timeout for
+	 * a buffer above the reserve.
+	 */
+	static NetworkBufferDescriptor_t *prvBufferQuotaGetTxBuffer( FreeRTOS_Socket_t *pxSocket, size_t uxRequestedSizeBytes, TimeOut_t *pxTimeOut, TickType_t *pxTicksToWait );
+#endif /* ipconfigUSE_BUFFER_QUOTAS */
+
 #if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
 
 	/* Executed by the IP-task, it will check all sockets belonging to a set */
@@ -175,6 +332,38 @@ static List_t xBoundUDPSocketsList;
 	List_t xBoundTCPSocketsList;
 #endif /* ipconfigUSE_TCP == 1 */
 
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_WORK_LIST == 1 )
+	/* The TCP sockets to which FreeRTOS_send() has added data that the IP-task
+	has not looked at yet.  The list is accessed by the API and the IP-task, so
+	all accesses are protected by critical sections. */
+	static List_t xTCPTxWorkList;
+#endif /* ipconfigTCP_TX_WORK_LIST */
+
+#if( ipconfigUSE_SOCKET_POOLS == 1 )
+	/* The pools, indexed by the FREERTOS_POOL_ values, and the memory they
+	hand out.  size_t is used to give the stream buffers the alignment of a
+	StreamBuffer_t. */
+	static SocketPool_t xSocketPools[ sockNUMBER_OF_POOLS ];
+	static SocketPoolBlock_t xSocketPoolBlocks[ ipconfigSOCKET_POOL_COUNT ];
+
+	#if( ipconfigUSE_TCP == 1 )
+		static size_t uxStreamPool0Memory[ ( ipconfigSTREAM_POOL_0_COUNT * sockSTREAM_BUFFER_SIZE( ipconfigSTREAM_POOL_0_LENGTH ) ) / sizeof( size_t ) ];
+		static size_t uxStreamPool1Memory[ ( ipconfigSTREAM_POOL_1_COUNT * sockSTREAM_BUFFER_SIZE( ipconfigSTREAM_POOL_1_LENGTH ) ) / sizeof( size_t ) ];
+	#endif
+#endif /* ipconfigUSE_SOCKET_POOLS */
+
+#if( ipconfigUSE_BUFFER_QUOTAS == 1 )
+	/* The network buffers in the reception lists of the application's UDP
+	sockets and of the stack's own sockets, the number of application sockets
+	that hold at least one, and the packets dropped because of the quotas.
+	Accessed by the API and the IP-task, so protected by critical sections. */
+	static UBaseType_t uxQuotaHeld = 0U;
+	static UBaseType_t uxQuotaControlHeld = 0U;
+	static UBaseType_t uxQuotaHolders = 0U;
+	static uint32_t ulQuotaDrops = 0UL;
+	static uint32_t ulReserveDrops = 0UL;
+#endif /* ipconfigUSE_BUFFER_QUOTAS */
+
 /*-----------------------------------------------------------*/
 
 static BaseType_t prvValidSocket( const FreeRTOS_Socket_t *pxSocket, BaseType_t xProtocol, BaseType_t xIsBound )
@@ -211,11 +400,358 @@ void vNetworkSocketsInit( void )
 	#if( ipconfigUSE_TCP == 1 )
 	{
 		vListInitialise( &xBoundTCPSocketsList );
+
+		#if( ipconfigTCP_TX_WORK_LIST == 1 )
+		{
+			vListInitialise( &xTCPTxWorkList );
+		}
+		#endif
 	}
 	#endif  /* ipconfigUSE_TCP == 1 */
+
+	#if( ipconfigUSE_SOCKET_POOLS == 1 )
+	{
+		prvPoolInit( &( xSocketPools[ FREERTOS_POOL_SOCKETS ] ), xSocketPoolBlocks, sizeof( xSocketPoolBlocks[ 0 ] ), ( UBaseType_t ) ipconfigSOCKET_POOL_COUNT );
+
+		#if( ipconfigUSE_TCP == 1 )
+		{
+			prvPoolInit( &( xSocketPools[ FREERTOS_POOL_STREAM_0 ] ), uxStreamPool0Memory, sockSTREAM_BUFFER_SIZE( ipconfigSTREAM_POOL_0_LENGTH ), ( UBaseType_t ) ipconfigSTREAM_POOL_0_COUNT );
+			prvPoolInit( &( xSocketPools[ FREERTOS_POOL_STREAM_1 ] ), uxStreamPool1Memory, sockSTREAM_BUFFER_SIZE( ipconfigSTREAM_POOL_1_LENGTH ), ( UBaseType_t ) ipconfigSTREAM_POOL_1_COUNT );
+		}
+		#endif
+	}
+	#endif /* ipconfigUSE_SOCKET_POOLS */
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_SOCKET_POOLS == 1 )
+
+	static void prvPoolInit( SocketPool_t *pxPool, void *pvMemory, size_t uxBlockSize, UBaseType_t uxCount )
+	{
+	UBaseType_t uxIndex;
+	void **ppvBlock;
+
+		pxPool->pucStart = ipPOINTER_CAST( uint8_t *, pvMemory );
+		pxPool->pucEnd = &( pxPool->pucStart[ uxBlockSize * uxCount ] );
+		pxPool->uxBlockSize = uxBlockSize;
+		pxPool->pvFreeList = NULL;
+		pxPool->uxFree = uxCount;
+		pxPool->uxMinimumFree = uxCount;
+
+		/* Link the blocks starting with the last one, so the first block ends
+		up at the head of the free list. */
+		for( uxIndex = uxCount; uxIndex > 0U; uxIndex-- )
+		{
+			ppvBlock = ipPOINTER_CAST( void **, &( pxPool->pucStart[ uxBlockSize * ( uxIndex - 1U ) ] ) );
+			*ppvBlock = pxPool->pvFreeList;
+			pxPool->pvFreeList = ipPOINTER_CAST( void *, ppvBlock );
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void *prvPoolTake( SocketPool_t *pxPool )
+	{
+	void *pvReturn;
+
+		/* Sockets are created by the API and by the IP-task (for the children
+		of a listening socket), so the pool is protected by a critical
+		section. */
+		taskENTER_CRITICAL();
+		{
+			pvReturn = pxPool->pvFreeList;
+
+			if( pvReturn != NULL )
+			{
+				pxPool->pvFreeList = *( ipPOINTER_CAST( void **, pvReturn ) );
+				pxPool->uxFree--;
+
+				if( pxPool->uxMinimumFree > pxPool->uxFree )
+				{
+					pxPool->uxMinimumFree = pxPool->uxFree;
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		return pvReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvPoolGive( SocketPool_t *pxPool, void *pvBlock )
+	{
+	uint8_t *pucBlock = ipPOINTER_CAST( uint8_t *, pvBlock );
+	BaseType_t xReturn = pdFALSE;
+
+		if( ( pucBlock >= pxPool->pucStart ) && ( pucBlock < pxPool->pucEnd ) )
+		{
+			configASSERT( ( ( size_t ) ( pucBlock - pxPool->pucStart ) % pxPool->uxBlockSize ) == 0U );
+
+			taskENTER_CRITICAL();
+			{
+				*( ipPOINTER_CAST( void **, pvBlock ) ) = pxPool->pvFreeList;
+				pxPool->pvFreeList = pvBlock;
+				pxPool->uxFree++;
+			}
+			taskEXIT_CRITICAL();
+
+			xReturn = pdTRUE;
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t FreeRTOS_GetPoolStats( BaseType_t xPool, UBaseType_t *puxFree, UBaseType_t *puxMinimumFree )
+	{
+	BaseType_t xReturn = pdFAIL;
+
+		/* The stream pools are not created when TCP is not used. */
+		if( ( xPool >= 0 ) && ( xPool < sockNUMBER_OF_POOLS ) && ( xSocketPools[ xPool ].pucStart != NULL ) )
+		{
+			taskENTER_CRITICAL();
+			{
+				*puxFree = xSocketPools[ xPool ].uxFree;
+				*puxMinimumFree = xSocketPools[ xPool ].uxMinimumFree;
+			}
+			taskEXIT_CRITICAL();
+
+			xReturn = pdPASS;
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_SOCKET_POOLS */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_SOCKET_POOLS == 1 ) && ( ipconfigUSE_TCP == 1 )
+
+	static void *prvStreamBufferAllocate( size_t uxSize )
+	{
+	SocketPool_t *pxPool = NULL;
+	BaseType_t xIndex;
+	void *pvReturn;
+
+		/* Find the smallest pool with blocks that are large enough. */
+		for( xIndex = FREERTOS_POOL_STREAM_0; xIndex <= FREERTOS_POOL_STREAM_1; xIndex++ )
+		{
+			if( ( uxSize <= xSocketPools[ xIndex ].uxBlockSize ) &&
+				( ( pxPool == NULL ) || ( xSocketPools[ xIndex ].uxBlockSize < pxPool->uxBlockSize ) ) )
+			{
+				pxPool = &( xSocketPools[ xIndex ] );
+			}
+		}
+
+		if( pxPool != NULL )
+		{
+			/* An empty pool is reported as a failed allocation. */
+			pvReturn = prvPoolTake( pxPool );
+		}
+		else
+		{
+			pvReturn = pvPortMallocLarge( uxSize );
+		}
+
+		return pvReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvStreamBufferFree( StreamBuffer_t *pxBuffer )
+	{
+		if( ( prvPoolGive( &( xSocketPools[ FREERTOS_POOL_STREAM_0 ] ), pxBuffer ) == pdFALSE ) &&
+			( prvPoolGive( &( xSocketPools[ FREERTOS_POOL_STREAM_1 ] ), pxBuffer ) == pdFALSE ) )
+		{
+			vPortFreeLarge( pxBuffer );
+		}
+	}
+
+#endif /* ipconfigUSE_SOCKET_POOLS && ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_BUFFER_QUOTAS == 1 )
+
+	static void prvBufferQuotaDrop( FreeRTOS_Socket_t *pxSocket, uint32_t *pulCounter )
+	{
+		taskENTER_CRITICAL();
+		{
+			( *pulCounter )++;
+			pxSocket->u.xUDP.ulBufferDrops++;
+		}
+		taskEXIT_CRITICAL();
+	}
+	/*-----------------------------------------------------------*/
+
+	static NetworkBufferDescriptor_t *prvBufferQuotaGetTxBuffer( FreeRTOS_Socket_t *pxSocket, size_t uxRequestedSizeBytes, TimeOut_t *pxTimeOut, TickType_t *pxTicksToWait )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer = NULL;
+	BaseType_t xTimedOut = pdFALSE;
+
+		while( ( pxNetworkBuffer == NULL ) && ( xTimedOut == pdFALSE ) )
+		{
+			if( uxGetNumberOfFreeNetworkBuffers() > ( size_t ) ipconfigBUFFER_RESERVE )
+			{
+				pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( uxRequestedSizeBytes, *pxTicksToWait );
+
+				if( ( pxNetworkBuffer != NULL ) &&
+					( uxGetNumberOfFreeNetworkBuffers() < ( size_t ) ipconfigBUFFER_RESERVE ) )
+				{
+					/* Another task took the last buffer above the reserve
+					first. */
+					vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+					pxNetworkBuffer = NULL;
+				}
+			}
+
+			if( pxNetworkBuffer == NULL )
+			{
+				if( xTaskCheckForTimeOut( pxTimeOut, pxTicksToWait ) != pdFALSE )
+				{
+					xTimedOut = pdTRUE;
+				}
+				else
+				{
+					/* Nothing signals when the number of free buffers rises
+					above the reserve, so look again after a tick. */
+					vTaskDelay( ( TickType_t ) 1U );
+				}
+			}
+		}
+
+		if( pxNetworkBuffer == NULL )
+		{
+			/* The last buffers are kept for the protocols that keep the
+			network running. */
+			prvBufferQuotaDrop( pxSocket, &( ulReserveDrops ) );
+		}
+
+		return pxNetworkBuffer;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xSocketBufferQuotaCheck( FreeRTOS_Socket_t *pxSocket )
+	{
+	BaseType_t xReturn = pdPASS;
+	UBaseType_t uxHeld, uxFree, uxFair, uxQuota = ( UBaseType_t ) ipconfigSOCKET_BUFFER_QUOTA;
+
+		if( pxSocket->u.xUDP.xControl == pdFALSE )
+		{
+			uxHeld = listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) );
+			uxFree = ( UBaseType_t ) uxGetNumberOfFreeNetworkBuffers();
+
+			if( uxFree <= ( UBaseType_t ) ipconfigBUFFER_RESERVE )
+			{
+				/* The last buffers are kept for the protocols that keep the
+				network running. */
+				prvBufferQuotaDrop( pxSocket, &( ulReserveDrops ) );
+				xReturn = pdFAIL;
+			}
+			else
+			{
+				if( ( uxFree <= ( UBaseType_t ) ipconfigBUFFER_PRESSURE ) && ( uxQuotaHolders != 0U ) )
+				{
+					/* A socket may hold no more than the average, rounded
+					up, of the sockets that hold buffers.  The sockets that
+					hold the most lose packets first. */
+					uxFair = ( uxQuotaHeld + uxQuotaHolders - 1U ) / uxQuotaHolders;
+
+					if( uxFair < uxQuota )
+					{
+						uxQuota = uxFair;
+					}
+				}
+
+				if( uxHeld >= uxQuota )
+				{
+					prvBufferQuotaDrop( pxSocket, &( ulQuotaDrops ) );
+					xReturn = pdFAIL;
+				}
+			}
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	void vSocketBufferQuotaUpdate( const FreeRTOS_Socket_t *pxSocket, BaseType_t xAdded )
+	{
+	UBaseType_t uxHeld = listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) );
+
+		taskENTER_CRITICAL();
+		{
+			if( pxSocket->u.xUDP.xControl != pdFALSE )
+			{
+				if( xAdded != pdFALSE )
+				{
+					uxQuotaControlHeld++;
+				}
+				else
+				{
+					uxQuotaControlHeld--;
+				}
+			}
+			else if( xAdded != pdFALSE )
+			{
+				uxQuotaHeld++;
+
+				if( uxHeld == 1U )
+				{
+					uxQuotaHolders++;
+				}
+			}
+			else
+			{
+				uxQuotaHeld--;
+
+				if( uxHeld == 0U )
+				{
+					uxQuotaHolders--;
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+	/*-----------------------------------------------------------*/
+
+	void vSocketSetControl( Socket_t xSocket )
+	{
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
+
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_UDP, pdFALSE ) == pdTRUE )
+		{
+			/* The socket is new, it holds no buffers yet. */
+			pxSocket->u.xUDP.xControl = pdTRUE;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	void FreeRTOS_GetBufferStats( BufferStats_t *pxStats )
+	{
+		pxStats->uxFree = ( UBaseType_t ) uxGetNumberOfFreeNetworkBuffers();
+		pxStats->uxMinimumFree = ( UBaseType_t ) uxGetMinimumFreeNetworkBuffers();
+
+		taskENTER_CRITICAL();
+		{
+			pxStats->uxUDPHeld = uxQuotaHeld;
+			pxStats->uxControlHeld = uxQuotaControlHeld;
+			pxStats->ulQuotaDrops = ulQuotaDrops;
+			pxStats->ulReserveDrops = ulReserveDrops;
+		}
+		taskEXIT_CRITICAL();
+
+		#if( ipconfigARP_PENDING_PACKETS > 0 )
+		{
+			pxStats->uxARPHeld = uxARPPendingPacketCount();
+		}
+		#else
+		{
+			pxStats->uxARPHeld = 0U;
+		}
+		#endif
+	}
+
+#endif /* ipconfigUSE_BUFFER_QUOTAS */
+/*-----------------------------------------------------------*/
+
 static BaseType_t prvDetermineSocketSize( BaseType_t xDomain, BaseType_t xType, BaseType_t xProtocol, size_t *pxSocketSize )
 {
 BaseType_t xReturn = pdPASS;
@@ -283,6 +819,9 @@ FreeRTOS_Socket_t *pxSocket;
 size_t uxSocketSize;
 EventGroupHandle_t xEventGroup;
 Socket_t xReturn;
+#if( ipconfigUSE_SOCKET_POOLS == 1 )
+	SocketPoolBlock_t *pxBlock;
+#endif
 
 	if( prvDetermineSocketSize( xDomain, xType, xProtocol, &uxSocketSize ) == pdFAIL )
 	{
@@ -293,8 +832,19 @@ Socket_t xReturn;
 		/* Allocate the structure that will hold the socket information.  The
 		size depends on the type of socket: UDP sockets need less space.  A
 		define 'pvPortMallocSocket' will used to allocate the necessary space.
-		By default it points to the FreeRTOS function 'pvPortMalloc()'. */
-		pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, pvPortMallocSocket( uxSocketSize ) );
+		By default it points to the FreeRTOS function 'pvPortMalloc()'.  When
+		socket pools are used, the socket is taken from the socket pool
+		together with the space for its event group. */
+		#if( ipconfigUSE_SOCKET_POOLS == 1 )
+		{
+			pxBlock = ipPOINTER_CAST( SocketPoolBlock_t *, prvPoolTake( &( xSocketPools[ FREERTOS_POOL_SOCKETS ] ) ) );
+			pxSocket = ( pxBlock != NULL ) ? &( pxBlock->xSocket ) : NULL;
+		}
+		#else
+		{
+			pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, pvPortMallocSocket( uxSocketSize ) );
+		}
+		#endif
 
 		if( pxSocket == NULL )
 		{
@@ -303,10 +853,33 @@ Socket_t xReturn;
 		}
 		else
 		{
-			xEventGroup = xEventGroupCreate();
-			if( xEventGroup == NULL )
+			#if( ipconfigSOCKET_USE_TASK_NOTIFICATIONS == 1 )
+			{
+				/* The user of the socket is woken up with a task notification,
+				an event group is not needed. */
+				xEventGroup = NULL;
+			}
+			#elif( ipconfigUSE_SOCKET_POOLS == 1 )
+			{
+				xEventGroup = xEventGroupCreateStatic( &( pxBlock->xEventGroupBuffer ) );
+			}
+			#else
+			{
+				xEventGroup = xEventGroupCreate();
+			}
+			#endif
+
+			if( ( ipconfigSOCKET_USE_TASK_NOTIFICATIONS == 0 ) && ( xEventGroup == NULL ) )
 			{
-				vPortFreeSocket( pxSocket );
+				#if( ipconfigUSE_SOCKET_POOLS == 1 )
+				{
+					( void ) prvPoolGive( &( xSocketPools[ FREERTOS_POOL_SOCKETS ] ), pxBlock );
+				}
+				#else
+				{
+					vPortFreeSocket( pxSocket );
+				}
+				#endif
 				xReturn = FREERTOS_INVALID_SOCKET;
 				iptraceFAILED_TO_CREATE_EVENT_GROUP();
 			}
@@ -314,18 +887,22 @@ Socket_t xReturn;
 			{
 				if( xProtocol == FREERTOS_IPPROTO_UDP )
 				{
-					iptraceMEM_STATS_CREATE( tcpSOCKET_UDP, pxSocket, uxSocketSize + sizeof( StaticEventGroup_t ) );
+					iptraceMEM_STATS_CREATE( tcpSOCKET_UDP, pxSocket, uxSocketSize + sockEVENT_GROUP_SIZE );
 				}	
 				else
 				{
 					/* Lint wants at least a comment, in case the macro is empty. */
-					iptraceMEM_STATS_CREATE( tcpSOCKET_TCP, pxSocket, uxSocketSize + sizeof( StaticEventGroup_t ) );
+					iptraceMEM_STATS_CREATE( tcpSOCKET_TCP, pxSocket, uxSocketSize + sockEVENT_GROUP_SIZE );
 				}
 
 				/* Clear the entire space to avoid nulling individual entries. */
 				( void ) memset( pxSocket, 0, uxSocketSize );
 
-				pxSocket->xEventGroup = xEventGroup;
+				#if( ipconfigSOCKET_USE_TASK_NOTIFICATIONS == 0 )
+				{
+					pxSocket->xEventGroup = xEventGroup;
+				}
+				#endif
 
 				/* Initialise the socket's members.  The semaphore will be created
 				if the socket is bound to an address, for now the pointer to the
@@ -374,6 +951,13 @@ Socket_t xReturn;
 						/* The above values are just defaults, and can be overridden by
 						calling FreeRTOS_setsockopt().  No buffers will be allocated until a
 						socket is connected and data is exchanged. */
+
+						#if( ipconfigTCP_TX_WORK_LIST == 1 )
+						{
+							vListInitialiseItem( &( pxSocket->u.xTCP.xTxWorkListItem ) );
+							listSET_LIST_ITEM_OWNER( &( pxSocket->u.xTCP.xTxWorkListItem ), ipPOINTER_CAST( void *, pxSocket ) );
+						}
+						#endif
 					}
 				}
 				#endif  /* ipconfigUSE_TCP == 1 */
@@ -639,7 +1223,7 @@ int32_t FreeRTOS_recvfrom( Socket_t xSocket, void *pvBuffer, size_t uxBufferLeng
 {
 BaseType_t lPacketCount;
 NetworkBufferDescriptor_t *pxNetworkBuffer;
-FreeRTOS_Socket_t const * pxSocket = xSocket;
+FreeRTOS_Socket_t * pxSocket = xSocket;
 TickType_t xRemainingTime = ( TickType_t ) 0; /* Obsolete assignment, but some compilers output a warning if its not done. */
 BaseType_t xTimed = pdFALSE;
 TimeOut_t xTimeOut;
@@ -670,8 +1254,7 @@ EventBits_t xEventBits = ( EventBits_t ) 0;
 				#if( ipconfigSUPPORT_SIGNALS != 0 )
 				{
 					/* Just check for the interrupt flag. */
-					xEventBits = xEventGroupWaitBits( pxSocket->xEventGroup, ( EventBits_t ) eSOCKET_INTR,
-						pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, socketDONT_BLOCK );
+					xEventBits = xSocketWaitEvents( pxSocket, ( EventBits_t ) eSOCKET_INTR, socketDONT_BLOCK );
 				}
 				#endif /* ipconfigSUPPORT_SIGNALS */
 				break;
@@ -690,10 +1273,9 @@ EventBits_t xEventBits = ( EventBits_t ) 0;
 		}
 
 		/* Wait for arrival of data.  While waiting, the IP-task may set the
-		'eSOCKET_RECEIVE' bit in 'xEventGroup', if it receives data for this
+		'eSOCKET_RECEIVE' event of the socket, if it receives data for this
 		socket, thus unblocking this API call. */
-		xEventBits = xEventGroupWaitBits( pxSocket->xEventGroup, ( ( EventBits_t ) eSOCKET_RECEIVE ) | ( ( EventBits_t ) eSOCKET_INTR ),
-			pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xRemainingTime );
+		xEventBits = xSocketWaitEvents( pxSocket, ( ( EventBits_t ) eSOCKET_RECEIVE ) | ( ( EventBits_t ) eSOCKET_INTR ), xRemainingTime );
 
 		#if( ipconfigSUPPORT_SIGNALS != 0 )
 		{
@@ -702,7 +1284,7 @@ EventBits_t xEventBits = ( EventBits_t ) 0;
 				if( ( xEventBits & ( EventBits_t ) eSOCKET_RECEIVE ) != 0U )
 				{
 					/* Shouldn't have cleared the eSOCKET_RECEIVE flag. */
-					( void ) xEventGroupSetBits( pxSocket->xEventGroup, ( EventBits_t ) eSOCKET_RECEIVE );
+					vSocketSetEvents( pxSocket, ( EventBits_t ) eSOCKET_RECEIVE );
 				}
 				break;
 			}
@@ -739,6 +1321,12 @@ EventBits_t xEventBits = ( EventBits_t ) 0;
 				/* Remove the network buffer from the list of buffers waiting to
 				be processed by the socket. */
 				( void ) uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+
+				#if( ipconfigUSE_BUFFER_QUOTAS == 1 )
+				{
+					vSocketBufferQuotaUpdate( pxSocket, pdFALSE );
+				}
+				#endif
 			}
 		}
 		taskEXIT_CRITICAL();
@@ -823,6 +1411,14 @@ const size_t uxPayloadOffset = ( size_t ) ipUDP_PAYLOAD_OFFSET_IPv4;
 	( void ) xDestinationAddressLength;
 	configASSERT( pvBuffer != NULL );
 
+	#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_FAST_OPEN == 1 )
+	if( ( ( UBaseType_t ) xFlags & ( UBaseType_t ) FREERTOS_MSG_FASTOPEN ) != 0U )
+	{
+		/* A TCP socket connects, and the data goes along with the SYN. */
+		lReturn = prvTCPFastOpenConnect( ( FreeRTOS_Socket_t * ) xSocket, pvBuffer, uxTotalDataLength, xFlags, pxDestinationAddress );
+	}
+	else
+	#endif /* ipconfigUSE_TCP_FAST_OPEN */
 	if( uxTotalDataLength <= ( size_t ) uxMaxPayloadLength )
 	{
 		/* If the socket is not already bound to an address, bind it now.
@@ -856,9 +1452,20 @@ const size_t uxPayloadOffset = ( size_t ) ipUDP_PAYLOAD_OFFSET_IPv4;
 				which the payload will be copied. */
 				vTaskSetTimeOutState( &xTimeOut );
 
-				/* Block until a buffer becomes available, or until a
-				timeout has been reached */
-				pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( uxPayloadOffset + uxTotalDataLength, xTicksToWait );
+				#if( ipconfigUSE_BUFFER_QUOTAS == 1 )
+				if( pxSocket->u.xUDP.xControl == pdFALSE )
+				{
+					/* Block until a buffer above the reserve becomes
+					available, or until a timeout has been reached. */
+					pxNetworkBuffer = prvBufferQuotaGetTxBuffer( ipPOINTER_CAST( FreeRTOS_Socket_t *, xSocket ), uxPayloadOffset + uxTotalDataLength, &( xTimeOut ), &( xTicksToWait ) );
+				}
+				else
+				#endif /* ipconfigUSE_BUFFER_QUOTAS */
+				{
+					/* Block until a buffer becomes available, or until a
+					timeout has been reached */
+					pxNetworkBuffer = pxGetNetworkBufferWithDescriptor( uxPayloadOffset + uxTotalDataLength, xTicksToWait );
+				}
 
 				if( pxNetworkBuffer != NULL )
 				{
@@ -890,6 +1497,11 @@ const size_t uxPayloadOffset = ( size_t ) ipUDP_PAYLOAD_OFFSET_IPv4;
 				/* The socket options are passed to the IP layer in the
 				space that will eventually get used by the Ethernet header. */
 				pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ] = pxSocket->ucSocketOptions;
+				#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+				{
+					pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_TOS_OFFSET ] = pxSocket->ucTypeOfService;
+				}
+				#endif
 
 				/* Tell the networking task that the packet needs sending. */
 				xStackTxEvent.pvData = pxNetworkBuffer;
@@ -1002,7 +1614,7 @@ BaseType_t xReturn = 0;
 		{
 			/* The IP-task will set the 'eSOCKET_BOUND' bit when it has done its
 			job. */
-			( void ) xEventGroupWaitBits( pxSocket->xEventGroup, ( EventBits_t ) eSOCKET_BOUND, pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, portMAX_DELAY );
+			( void ) xSocketWaitEvents( pxSocket, ( EventBits_t ) eSOCKET_BOUND, portMAX_DELAY );
 			if( !socketSOCKET_IS_BOUND( pxSocket ) )
 			{
 				xReturn = -pdFREERTOS_ERRNO_EINVAL;
@@ -1224,18 +1836,33 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 			if( pxSocket->u.xTCP.rxStream != NULL )
 			{
 				iptraceMEM_STATS_DELETE( pxSocket->u.xTCP.rxStream );
-				vPortFreeLarge( pxSocket->u.xTCP.rxStream );
+				sockSTREAM_FREE( pxSocket->u.xTCP.rxStream );
 			}
 
 			if( pxSocket->u.xTCP.txStream != NULL )
 			{
 				iptraceMEM_STATS_DELETE( pxSocket->u.xTCP.txStream );
-				vPortFreeLarge( pxSocket->u.xTCP.txStream );
+				sockSTREAM_FREE( pxSocket->u.xTCP.txStream );
 			}
 
 			/* In case this is a child socket, make sure the child-count of the
 			parent socket is decreased. */
 			prvTCPSetSocketCount( pxSocket );
+
+			#if( ipconfigTCP_TX_WORK_LIST == 1 )
+			{
+				/* The socket may have been closed before the IP-task had a
+				chance to check it. */
+				taskENTER_CRITICAL();
+				{
+					if( listIS_CONTAINED_WITHIN( &xTCPTxWorkList, &( pxSocket->u.xTCP.xTxWorkListItem ) ) != pdFALSE )
+					{
+						( void ) uxListRemove( &( pxSocket->u.xTCP.xTxWorkListItem ) );
+					}
+				}
+				taskEXIT_CRITICAL();
+			}
+			#endif /* ipconfigTCP_TX_WORK_LIST */
 		}
 	}
 	#endif  /* ipconfigUSE_TCP == 1 */
@@ -1270,14 +1897,23 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 		{
 			pxNetworkBuffer = ipPOINTER_CAST( NetworkBufferDescriptor_t *, listGET_OWNER_OF_HEAD_ENTRY( &( pxSocket->u.xUDP.xWaitingPacketsList ) ) );
 			( void ) uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+			#if( ipconfigUSE_BUFFER_QUOTAS == 1 )
+			{
+				vSocketBufferQuotaUpdate( pxSocket, pdFALSE );
+			}
+			#endif
 			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
 		}
 	}
 
-	if( pxSocket->xEventGroup != NULL )
+	#if( ipconfigSOCKET_USE_TASK_NOTIFICATIONS == 0 )
 	{
-		vEventGroupDelete( pxSocket->xEventGroup );
+		if( pxSocket->xEventGroup != NULL )
+		{
+			vEventGroupDelete( pxSocket->xEventGroup );
+		}
 	}
+	#endif
 
 	#if( ipconfigUSE_TCP == 1 ) && ( ipconfigHAS_DEBUG_PRINTF != 0 )
 	{
@@ -1295,7 +1931,16 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 
 	/* Anf finally, after all resources have been freed, free the socket space */
 	iptraceMEM_STATS_DELETE( pxSocket );
-	vPortFreeSocket( pxSocket );
+	#if( ipconfigUSE_SOCKET_POOLS == 1 )
+	{
+		/* The socket is the first member of its pool block. */
+		( void ) prvPoolGive( &( xSocketPools[ FREERTOS_POOL_SOCKETS ] ), pxSocket );
+	}
+	#else
+	{
+		vPortFreeSocket( pxSocket );
+	}
+	#endif
 
 	return NULL;
 } /* Tested */
@@ -1521,6 +2166,17 @@ FreeRTOS_Socket_t *pxSocket;
 					break;
 		#endif /* ipconfigUSE_CALLBACKS */
 
+		#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+			case FREERTOS_SO_IP_TOS:	/* Set the DSCP field of the packets sent, parameter is pointer to uint8_t */
+				{
+					/* The two lowest bits are used for ECN, and are not set
+					by the user. */
+					pxSocket->ucTypeOfService = ( uint8_t ) ( *( ipPOINTER_CAST( const uint8_t *, pvOptionValue ) ) & 0xFCU );
+				}
+				xReturn = 0;
+				break;
+		#endif /* ipconfigSOCKET_HAS_TYPE_OF_SERVICE */
+
 		#if( ipconfigUSE_TCP != 0 )
 			#if( ipconfigSOCKET_HAS_USER_SEMAPHORE != 0 )
 				/* Each socket has a semaphore on which the using task normally
@@ -1718,6 +2374,46 @@ FreeRTOS_Socket_t *pxSocket;
 				xReturn = 0;
 				break;
 
+			#if( ipconfigTCP_PACING == 1 )
+				case FREERTOS_SO_TCP_PACING_RATE:	/* Limit the transmission rate */
+					{
+						if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+						{
+							break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+						}
+
+						pxSocket->u.xTCP.ulPacingRate = *( ipPOINTER_CAST( const uint32_t *, pvOptionValue ) );
+
+						if( pxSocket->u.xTCP.ucTCPState >= ( uint8_t ) eESTABLISHED )
+						{
+							/* Let the IP-task send data that may have been
+							held back by the previous rate. */
+							pxSocket->u.xTCP.usTimeout = 1U;
+							( void ) xSendEventToIPTask( eTCPTimerEvent );
+						}
+					}
+					xReturn = 0;
+					break;
+			#endif /* ipconfigTCP_PACING */
+
+			#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+				case FREERTOS_SO_TCP_FASTOPEN:	/* Hand out and accept Fast Open cookies, or use them when connecting */
+					if( pxSocket->ucProtocol != ( uint8_t ) FREERTOS_IPPROTO_TCP )
+					{
+						break;	/* will return -pdFREERTOS_ERRNO_EINVAL */
+					}
+					if( *( ipPOINTER_CAST( const BaseType_t *, pvOptionValue ) ) != 0 )
+					{
+						pxSocket->u.xTCP.bits.bFastOpen = pdTRUE_UNSIGNED;
+					}
+					else
+					{
+						pxSocket->u.xTCP.bits.bFastOpen = pdFALSE_UNSIGNED;
+					}
+					xReturn = 0;
+					break;
+			#endif /* ipconfigUSE_TCP_FAST_OPEN */
+
 		#endif  /* ipconfigUSE_TCP == 1 */
 
 		default :
@@ -2125,13 +2821,100 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	}
 	#endif /* ipconfigSUPPORT_SELECT_FUNCTION */
 
-	if( ( pxSocket->xEventGroup != NULL ) && ( pxSocket->xEventBits != 0U ) )
+	if( pxSocket->xEventBits != 0U )
 	{
-		( void ) xEventGroupSetBits( pxSocket->xEventGroup, pxSocket->xEventBits );
+		vSocketSetEvents( pxSocket, pxSocket->xEventBits );
 	}
 
 	pxSocket->xEventBits = 0UL;
 }
+/*-----------------------------------------------------------*/
+
+#if( ipconfigSOCKET_USE_TASK_NOTIFICATIONS == 1 )
+
+	void vSocketSetEvents( FreeRTOS_Socket_t *pxSocket, EventBits_t xBitsToSet )
+	{
+		/* Like the kernel's stream buffers, suspend the scheduler rather than
+		disabling interrupts while notifying the waiting task.  The events are
+		only set from tasks. */
+		vTaskSuspendAll();
+		{
+			pxSocket->xSocketEvents |= xBitsToSet;
+
+			if( pxSocket->xWaitingTask != NULL )
+			{
+				( void ) xTaskNotify( pxSocket->xWaitingTask, 0U, eNoAction );
+			}
+		}
+		( void ) xTaskResumeAll();
+	}
+	/*-----------------------------------------------------------*/
+
+	EventBits_t xSocketWaitEvents( FreeRTOS_Socket_t *pxSocket, EventBits_t xBitsToWaitFor, TickType_t xTicksToWait )
+	{
+	TaskHandle_t xCurrentTask = xTaskGetCurrentTaskHandle();
+	TimeOut_t xTimeOut;
+	EventBits_t xReturn;
+	BaseType_t xMustBlock;
+
+		vTaskSetTimeOutState( &xTimeOut );
+
+		for( ;; )
+		{
+			vTaskSuspendAll();
+			{
+				/* Only a single task can block on a socket. */
+				configASSERT( ( pxSocket->xWaitingTask == NULL ) || ( pxSocket->xWaitingTask == xCurrentTask ) );
+
+				xReturn = pxSocket->xSocketEvents;
+
+				if( ( xReturn & xBitsToWaitFor ) != 0U )
+				{
+					pxSocket->xSocketEvents &= ~xBitsToWaitFor;
+					xMustBlock = pdFALSE;
+				}
+				else
+				{
+					xMustBlock = ( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE ) ? pdTRUE : pdFALSE;
+				}
+
+				/* Register before blocking, so an event that is set between
+				resuming the scheduler and blocking leaves the notification
+				pending. */
+				pxSocket->xWaitingTask = ( xMustBlock != pdFALSE ) ? xCurrentTask : NULL;
+			}
+			( void ) xTaskResumeAll();
+
+			if( xMustBlock == pdFALSE )
+			{
+				break;
+			}
+
+			/* Any notification ends the wait, the events are checked again in
+			the next iteration. */
+			( void ) xTaskNotifyWait( 0U, 0U, NULL, xTicksToWait );
+		}
+
+		return xReturn;
+	}
+
+#else /* ipconfigSOCKET_USE_TASK_NOTIFICATIONS */
+
+	void vSocketSetEvents( FreeRTOS_Socket_t *pxSocket, EventBits_t xBitsToSet )
+	{
+		if( pxSocket->xEventGroup != NULL )
+		{
+			( void ) xEventGroupSetBits( pxSocket->xEventGroup, xBitsToSet );
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	EventBits_t xSocketWaitEvents( FreeRTOS_Socket_t *pxSocket, EventBits_t xBitsToWaitFor, TickType_t xTicksToWait )
+	{
+		return xEventGroupWaitBits( pxSocket->xEventGroup, xBitsToWaitFor, pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xTicksToWait );
+	}
+
+#endif /* ipconfigSOCKET_USE_TASK_NOTIFICATIONS */
 
 /*-----------------------------------------------------------*/
 
@@ -2278,10 +3061,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	BaseType_t FreeRTOS_connect( Socket_t xClientSocket, struct freertos_sockaddr *pxAddress, socklen_t xAddressLength )
 	{
 	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t* ) xClientSocket;
-	TickType_t xRemainingTime;
-	BaseType_t xTimed = pdFALSE;
 	BaseType_t xResult = -pdFREERTOS_ERRNO_EINVAL;
-	TimeOut_t xTimeOut;
 
 		( void ) xAddressLength;
 
@@ -2290,53 +3070,69 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		if( xResult == 0 )
 		{
 			/* And wait for the result */
-			for( ;; )
-			{
-				if( xTimed == pdFALSE )
-				{
-					/* Only in the first round, check for non-blocking */
-					xRemainingTime = pxSocket->xReceiveBlockTime;
-					if( xRemainingTime == ( TickType_t )0 )
-					{
-						/* Not yet connected, correct state, non-blocking. */
-						xResult = -pdFREERTOS_ERRNO_EWOULDBLOCK;
-						break;
-					}
+			xResult = prvTCPConnectWait( pxSocket );
+		}
 
-					/* Don't get here a second time. */
-					xTimed = pdTRUE;
+		return xResult;
+	}
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
 
-					/* Fetch the current time */
-					vTaskSetTimeOutState( &xTimeOut );
-				}
+#if( ipconfigUSE_TCP == 1 )
 
-				/* Did it get connected while sleeping ? */
-				xResult = FreeRTOS_issocketconnected( pxSocket );
+	static BaseType_t prvTCPConnectWait( FreeRTOS_Socket_t * pxSocket )
+	{
+	TickType_t xRemainingTime;
+	BaseType_t xTimed = pdFALSE;
+	BaseType_t xResult;
+	TimeOut_t xTimeOut;
 
-				/* Returns positive when connected, negative means an error */
-				if( xResult < 0 )
+		for( ;; )
+		{
+			if( xTimed == pdFALSE )
+			{
+				/* Only in the first round, check for non-blocking */
+				xRemainingTime = pxSocket->xReceiveBlockTime;
+				if( xRemainingTime == ( TickType_t )0 )
 				{
-					/* Return the error */
+					/* Not yet connected, correct state, non-blocking. */
+					xResult = -pdFREERTOS_ERRNO_EWOULDBLOCK;
 					break;
 				}
 
-				if( xResult > 0 )
-				{
-					/* Socket now connected, return a zero */
-					xResult = 0;
-					break;
-				}
+				/* Don't get here a second time. */
+				xTimed = pdTRUE;
 
-				/* Is it allowed to sleep more? */
-				if( xTaskCheckForTimeOut( &xTimeOut, &xRemainingTime ) != pdFALSE )
-				{
-					xResult = -pdFREERTOS_ERRNO_ETIMEDOUT;
-					break;
-				}
+				/* Fetch the current time */
+				vTaskSetTimeOutState( &xTimeOut );
+			}
 
-				/* Go sleeping until we get any down-stream event */
-				( void ) xEventGroupWaitBits( pxSocket->xEventGroup, ( EventBits_t ) eSOCKET_CONNECT, pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xRemainingTime );
+			/* Did it get connected while sleeping ? */
+			xResult = FreeRTOS_issocketconnected( pxSocket );
+
+			/* Returns positive when connected, negative means an error */
+			if( xResult < 0 )
+			{
+				/* Return the error */
+				break;
+			}
+
+			if( xResult > 0 )
+			{
+				/* Socket now connected, return a zero */
+				xResult = 0;
+				break;
+			}
+
+			/* Is it allowed to sleep more? */
+			if( xTaskCheckForTimeOut( &xTimeOut, &xRemainingTime ) != pdFALSE )
+			{
+				xResult = -pdFREERTOS_ERRNO_ETIMEDOUT;
+				break;
 			}
+
+			/* Go sleeping until we get any down-stream event */
+			( void ) xSocketWaitEvents( pxSocket, ( EventBits_t ) eSOCKET_CONNECT, xRemainingTime );
 		}
 
 		return xResult;
@@ -2344,6 +3140,66 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigUSE_TCP_FAST_OPEN == 1 )
+
+	static int32_t prvTCPFastOpenConnect( FreeRTOS_Socket_t *pxSocket, const void *pvBuffer, size_t uxDataLength,
+		BaseType_t xFlags, const struct freertos_sockaddr *pxAddress )
+	{
+	int32_t lResult;
+	size_t uxQueued = 0U;
+
+		if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdFALSE ) == pdFALSE )
+		{
+			lResult = -pdFREERTOS_ERRNO_EBADF;
+		}
+		else
+		{
+			/* -EINPROGRESS, -EAGAIN, or 0 when the socket may connect. */
+			lResult = ( int32_t ) bMayConnect( pxSocket );
+		}
+
+		if( ( lResult == 0 ) && ( pxSocket->u.xTCP.txStream == NULL ) && ( prvTCPCreateStream( pxSocket, pdFALSE ) == NULL ) )
+		{
+			lResult = -pdFREERTOS_ERRNO_ENOMEM;
+		}
+
+		if( lResult == 0 )
+		{
+			/* The data must be in the stream before the IP-task sends the
+			SYN.  As long as the socket is not connected, the IP-task does not
+			touch the stream. */
+			uxQueued = uxStreamBufferAdd( pxSocket->u.xTCP.txStream, 0U, ipPOINTER_CAST( const uint8_t *, pvBuffer ), uxDataLength );
+			pxSocket->u.xTCP.bits.bFastOpen = pdTRUE_UNSIGNED;
+
+			lResult = ( int32_t ) prvTCPConnectStart( pxSocket, pxAddress );
+
+			if( lResult != 0 )
+			{
+				vStreamBufferClear( pxSocket->u.xTCP.txStream );
+			}
+			else if( ( ( UBaseType_t ) xFlags & ( UBaseType_t ) FREERTOS_MSG_DONTWAIT ) == 0U )
+			{
+				lResult = ( int32_t ) prvTCPConnectWait( pxSocket );
+			}
+			else
+			{
+				/* Return without waiting for the connection. */
+			}
+
+			if( ( lResult == 0 ) || ( lResult == -pdFREERTOS_ERRNO_EWOULDBLOCK ) )
+			{
+				/* The data has been queued, it will be sent in the SYN if the
+				server's cookie is known, or else right after connecting. */
+				lResult = ( int32_t ) uxQueued;
+			}
+		}
+
+		return lResult;
+	}
+
+#endif /* ipconfigUSE_TCP_FAST_OPEN */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 
 	/*
@@ -2463,7 +3319,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				}
 
 				/* Go sleeping until we get any down-stream event */
-				( void ) xEventGroupWaitBits( pxSocket->xEventGroup, ( EventBits_t ) eSOCKET_ACCEPT, pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xRemainingTime );
+				( void ) xSocketWaitEvents( pxSocket, ( EventBits_t ) eSOCKET_ACCEPT, xRemainingTime );
 			}
 		}
 
@@ -2501,6 +3357,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		}
 		else
 		{
+			sockSTREAM_READ_BEGIN();
 			if( pxSocket->u.xTCP.rxStream != NULL )
 			{
 				xByteCount = ( BaseType_t )uxStreamBufferGetSize ( pxSocket->u.xTCP.rxStream );
@@ -2509,6 +3366,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			{
 				xByteCount = 0;
 			}
+			sockSTREAM_READ_END();
 
 			while( xByteCount == 0 )
 			{
@@ -2557,8 +3415,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 						#if( ipconfigSUPPORT_SIGNALS != 0 )
 						{
 							/* Just check for the interrupt flag. */
-							xEventBits = xEventGroupWaitBits( pxSocket->xEventGroup, ( EventBits_t ) eSOCKET_INTR,
-								pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, socketDONT_BLOCK );
+							xEventBits = xSocketWaitEvents( pxSocket, ( EventBits_t ) eSOCKET_INTR, socketDONT_BLOCK );
 						}
 						#endif /* ipconfigSUPPORT_SIGNALS */
 						break;
@@ -2583,9 +3440,8 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				}
 
 				/* Block until there is a down-stream event. */
-				xEventBits = xEventGroupWaitBits( pxSocket->xEventGroup,
-					( EventBits_t ) eSOCKET_RECEIVE | ( EventBits_t ) eSOCKET_CLOSED | ( EventBits_t ) eSOCKET_INTR,
-					pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xRemainingTime );
+				xEventBits = xSocketWaitEvents( pxSocket,
+					( EventBits_t ) eSOCKET_RECEIVE | ( EventBits_t ) eSOCKET_CLOSED | ( EventBits_t ) eSOCKET_INTR, xRemainingTime );
 				#if( ipconfigSUPPORT_SIGNALS != 0 )
 				{
 					if( ( xEventBits & ( EventBits_t ) eSOCKET_INTR ) != 0U )
@@ -2599,6 +3455,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				}
 				#endif /* ipconfigSUPPORT_SIGNALS */
 
+				sockSTREAM_READ_BEGIN();
 				if( pxSocket->u.xTCP.rxStream != NULL )
 				{
 					xByteCount = ( BaseType_t ) uxStreamBufferGetSize ( pxSocket->u.xTCP.rxStream );
@@ -2607,6 +3464,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				{
 					xByteCount = 0;
 				}
+				sockSTREAM_READ_END();
 			}
 
 		#if( ipconfigSUPPORT_SIGNALS != 0 )
@@ -2616,7 +3474,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				{
 					/* Shouldn't have cleared other flags. */
 					xEventBits &= ~( ( EventBits_t ) eSOCKET_INTR );
-					( void ) xEventGroupSetBits( pxSocket->xEventGroup, xEventBits );
+					vSocketSetEvents( pxSocket, xEventBits );
 				}
 				xByteCount = -pdFREERTOS_ERRNO_EINTR;
 			}
@@ -2624,6 +3482,9 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		#endif /* ipconfigSUPPORT_SIGNALS */
 			if( xByteCount > 0 )
 			{
+				/* While copying, the IP-task will not move the rxStream. */
+				sockSTREAM_USE_BEGIN( pxSocket->u.xTCP.uxRxStreamUsers );
+
 				if( ( ( uint32_t ) xFlags & ( uint32_t ) FREERTOS_ZERO_COPY ) == 0U )
 				{
 				BaseType_t xIsPeek = ( ( ( uint32_t ) xFlags & ( uint32_t ) FREERTOS_MSG_PEEK ) != 0U ) ? 1L : 0L;
@@ -2638,7 +3499,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 					{
 						/* We had reached the low-water mark, now see if the flag
 						can be cleared */
-						size_t uxFrontSpace = uxStreamBufferFrontSpace( pxSocket->u.xTCP.rxStream );
+						size_t uxFrontSpace = uxTCPRxSpace( pxSocket, pdTRUE );
 
 						if( uxFrontSpace >= pxSocket->u.xTCP.uxEnoughSpace )
 						{
@@ -2651,9 +3512,21 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				}
 				else
 				{
+					#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+					{
+						/* The user will access the rxStream directly, it may not
+						be moved or released any more. */
+						taskENTER_CRITICAL();
+						pxSocket->u.xTCP.bits.bStreamsPinned = pdTRUE_UNSIGNED;
+						taskEXIT_CRITICAL();
+					}
+					#endif
+
 					/* Zero-copy reception of data: pvBuffer is a pointer to a pointer. */
 					xByteCount = ( BaseType_t ) uxStreamBufferGetPtr( pxSocket->u.xTCP.rxStream, ipPOINTER_CAST( uint8_t **, pvBuffer ) );
 				}
+
+				sockSTREAM_USE_END( pxSocket->u.xTCP.uxRxStreamUsers );
 			}
 			else
 			{
@@ -2728,7 +3601,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	uint8_t *FreeRTOS_get_tx_head( Socket_t xSocket, BaseType_t *pxLength )
 	{
     uint8_t *pucReturn = NULL;
-	const FreeRTOS_Socket_t *pxSocket = ( const FreeRTOS_Socket_t * ) xSocket;
+	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
 	StreamBuffer_t *pxBuffer = NULL;
 
         *pxLength = 0;
@@ -2737,6 +3610,16 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
         member pointers. */
         if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdFALSE ) == pdTRUE )
         {
+			#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+			{
+				/* The user will write to the txStream directly, it may not be
+				released any more. */
+				taskENTER_CRITICAL();
+				pxSocket->u.xTCP.bits.bStreamsPinned = pdTRUE_UNSIGNED;
+				taskEXIT_CRITICAL();
+			}
+			#endif
+
             pxBuffer = pxSocket->u.xTCP.txStream;
 			if( pxBuffer != NULL )
 			{
@@ -2769,6 +3652,9 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	TimeOut_t xTimeOut;
 	BaseType_t xCloseAfterSend;
 	const uint8_t *pucSource = ipPOINTER_CAST( const uint8_t *, pvBuffer );
+	#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+		BaseType_t xStreamUsed = pdFALSE;
+	#endif
 
 		/* Prevent compiler warnings about unused parameters.  The parameter
 		may be used in future versions. */
@@ -2776,6 +3662,18 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		
 		if( pvBuffer != NULL )
 		{
+			#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+			{
+				/* The IP-task may not release the txStream as long as this
+				function is using it, also not while it is blocking. */
+				if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdTRUE ) != pdFALSE )
+				{
+					sockSTREAM_USE_BEGIN( pxSocket->u.xTCP.uxTxStreamUsers );
+					xStreamUsed = pdTRUE;
+				}
+			}
+			#endif
+
 			xByteCount = ( BaseType_t ) prvTCPSendCheck( pxSocket, uxDataLength );
 		}
 
@@ -2838,13 +3736,25 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 
 					/* Send a message to the IP-task so it can work on this
 					socket.  Data is sent, let the IP-task work on it. */
-					pxSocket->u.xTCP.usTimeout = 1U;
-
 					if( xIsCallingFromIPTask() == pdFALSE )
 					{
-						/* Only send a TCP timer event when not called from the
-						IP-task. */
-						( void ) xSendEventToIPTask( eTCPTimerEvent );
+						/* Only send an event when not called from the IP-task. */
+						#if( ipconfigTCP_TX_WORK_LIST == 1 )
+						{
+							prvTCPTxWorkListAdd( pxSocket );
+						}
+						#else
+						{
+							pxSocket->u.xTCP.usTimeout = 1U;
+							( void ) xSendEventToIPTask( eTCPTimerEvent );
+						}
+						#endif
+					}
+					else
+					{
+						/* The IP-task will check the socket the next time
+						xTCPTimerCheck() is called. */
+						pxSocket->u.xTCP.usTimeout = 1U;
 					}
 
 					xBytesLeft -= xByteCount;
@@ -2905,8 +3815,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				}
 
 				/* Go sleeping until down-stream events are received. */
-				( void ) xEventGroupWaitBits( pxSocket->xEventGroup, ( EventBits_t ) eSOCKET_SEND | ( EventBits_t ) eSOCKET_CLOSED,
-					pdTRUE /*xClearOnExit*/, pdFALSE /*xWaitAllBits*/, xRemainingTime );
+				( void ) xSocketWaitEvents( pxSocket, ( EventBits_t ) eSOCKET_SEND | ( EventBits_t ) eSOCKET_CLOSED, xRemainingTime );
 
 				xByteCount = ( BaseType_t ) uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream );
 			}
@@ -2935,6 +3844,15 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			}
 		}
 
+		#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+		{
+			if( xStreamUsed != pdFALSE )
+			{
+				sockSTREAM_USE_END( pxSocket->u.xTCP.uxTxStreamUsers );
+			}
+		}
+		#endif
+
 		return xByteCount;
 	}
 
@@ -3057,8 +3975,19 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 	static TickType_t xLastTime = 0U;
 	TickType_t xDelta = xNow - xLastTime;
 	const ListItem_t* pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &xBoundTCPSocketsList ) );
-	const ListItem_t *pxIterator = ( const ListItem_t * ) listGET_HEAD_ENTRY( &xBoundTCPSocketsList );
+	const ListItem_t *pxIterator;
+
+		#if( ipconfigTCP_TX_WORK_LIST == 1 )
+		{
+			/* Normally the work list is emptied when the eTCPTxEvent is
+			handled, but the event can get lost when the event queue is full. */
+			( void ) xTCPTxWorkListProcess();
+		}
+		#endif
 
+		/* The sockets in the work list may have been closed, so only start
+		iterating now. */
+		pxIterator = ( const ListItem_t * ) listGET_HEAD_ENTRY( &xBoundTCPSocketsList );
 		xLastTime = xNow;
 
 		if( xDelta == 0U )
@@ -3071,6 +4000,12 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
 			pxIterator = ( ListItem_t * ) listGET_NEXT( pxIterator );
 
+			#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+			{
+				prvTCPStreamsRelease( pxSocket, xNow );
+			}
+			#endif
+
 			/* Sockets with 'tmout == 0' do not need any regular attention. */
 			if( pxSocket->u.xTCP.usTimeout == 0U )
 			{
@@ -3128,6 +4063,132 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigARP_PENDING_PACKETS > 0 )
+
+	void vSocketWakeUpConnecting( void )
+	{
+	FreeRTOS_Socket_t *pxSocket;
+	BaseType_t xFound = pdFALSE;
+	const ListItem_t *pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &xBoundTCPSocketsList ) );
+	const ListItem_t *pxIterator;
+
+		for( pxIterator  = listGET_NEXT( pxEnd );
+			 pxIterator != pxEnd;
+			 pxIterator  = listGET_NEXT( pxIterator ) )
+		{
+			pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
+
+			/* A socket that has not sent its SYN yet would otherwise poll
+			the ARP cache every 500 ms. */
+			if( ( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eCONNECT_SYN ) &&
+				( pxSocket->u.xTCP.bits.bConnPrepared == pdFALSE_UNSIGNED ) )
+			{
+				pxSocket->u.xTCP.usTimeout = 1U;
+				xFound = pdTRUE;
+			}
+		}
+
+		if( xFound != pdFALSE )
+		{
+			( void ) xSendEventToIPTask( eTCPTimerEvent );
+		}
+	}
+
+#endif /* ( ipconfigUSE_TCP == 1 ) && ( ipconfigARP_PENDING_PACKETS > 0 ) */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_TX_WORK_LIST == 1 )
+
+	static void prvTCPTxWorkListAdd( FreeRTOS_Socket_t *pxSocket )
+	{
+	BaseType_t xWakeIPTask = pdFALSE;
+
+		taskENTER_CRITICAL();
+		{
+			/* A socket is only added once, no matter how often send() is
+			called before the IP-task gets to it. */
+			if( listIS_CONTAINED_WITHIN( NULL, &( pxSocket->u.xTCP.xTxWorkListItem ) ) != pdFALSE )
+			{
+				/* The IP-task empties the whole list each time it receives an
+				eTCPTxEvent, so an event is only needed when the list was
+				empty. */
+				if( listLIST_IS_EMPTY( &xTCPTxWorkList ) != pdFALSE )
+				{
+					xWakeIPTask = pdTRUE;
+				}
+
+				vListInsertEnd( &xTCPTxWorkList, &( pxSocket->u.xTCP.xTxWorkListItem ) );
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		if( xWakeIPTask != pdFALSE )
+		{
+			if( xSendEventToIPTask( eTCPTxEvent ) != pdPASS )
+			{
+				/* The event queue is full.  Expire the TCP timer instead,
+				xTCPTimerCheck() also processes the work list. */
+				( void ) xSendEventToIPTask( eTCPTimerEvent );
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	TickType_t xTCPTxWorkListProcess( void )
+	{
+	FreeRTOS_Socket_t *pxSocket;
+	TickType_t xShortest = portMAX_DELAY;
+
+		for( ;; )
+		{
+			/* Take one socket at a time, so the API is not held up while the
+			IP-task sends the data. */
+			taskENTER_CRITICAL();
+			{
+				if( listLIST_IS_EMPTY( &xTCPTxWorkList ) != pdFALSE )
+				{
+					pxSocket = NULL;
+				}
+				else
+				{
+					pxSocket = ipPOINTER_CAST( FreeRTOS_Socket_t *, listGET_OWNER_OF_HEAD_ENTRY( &xTCPTxWorkList ) );
+					( void ) uxListRemove( &( pxSocket->u.xTCP.xTxWorkListItem ) );
+				}
+			}
+			taskEXIT_CRITICAL();
+
+			if( pxSocket == NULL )
+			{
+				break;
+			}
+
+			/* Pass the new data to the sliding window and send what it allows,
+			as xTCPTimerCheck() would do after the socket's time-out. */
+			pxSocket->u.xTCP.usTimeout = 0U;
+
+			if( xTCPSocketCheck( pxSocket ) < 0 )
+			{
+				/* The socket was deleted. */
+				continue;
+			}
+
+			if( pxSocket->xEventBits != 0U )
+			{
+				vSocketWakeUpUser( pxSocket );
+			}
+
+			if( ( pxSocket->u.xTCP.usTimeout != 0U ) && ( xShortest > ( TickType_t ) pxSocket->u.xTCP.usTimeout ) )
+			{
+				xShortest = ( TickType_t ) pxSocket->u.xTCP.usTimeout;
+			}
+		}
+
+		return xShortest;
+	}
+
+#endif /* ipconfigTCP_TX_WORK_LIST */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 
 	/*
@@ -3189,13 +4250,23 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 
 	const struct xSTREAM_BUFFER *FreeRTOS_get_rx_buf( Socket_t xSocket )
 	{
-	FreeRTOS_Socket_t const * pxSocket = ( FreeRTOS_Socket_t const * )xSocket;
+	FreeRTOS_Socket_t * pxSocket = ( FreeRTOS_Socket_t * )xSocket;
     const struct xSTREAM_BUFFER *pxReturn = NULL;
 
         /* Confirm that this is a TCP socket before dereferencing structure
         member pointers. */
         if( prvValidSocket( pxSocket, FREERTOS_IPPROTO_TCP, pdFALSE ) == pdTRUE )
         {
+			#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+			{
+				/* The user will read the rxStream directly, it may not be
+				moved or released any more. */
+				taskENTER_CRITICAL();
+				pxSocket->u.xTCP.bits.bStreamsPinned = pdTRUE_UNSIGNED;
+				taskEXIT_CRITICAL();
+			}
+			#endif
+
             pxReturn = pxSocket->u.xTCP.rxStream;
         }
 
@@ -3234,15 +4305,25 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			uxLength = pxSocket->u.xTCP.uxTxStreamSize;
 		}
 
-		/* Add an extra 4 (or 8) bytes. */
-		uxLength += sizeof( size_t );
+		#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+		{
+			/* The rxStream starts small, vTCPRxStreamReserve() lets it grow
+			when needed. */
+			if( ( xIsInputStream != pdFALSE ) && ( uxLength > ( size_t ) ipconfigTCP_STREAM_INITIAL_LENGTH ) )
+			{
+				uxLength = ( size_t ) ipconfigTCP_STREAM_INITIAL_LENGTH;
+			}
+			pxSocket->u.xTCP.xStreamLastUse = xTaskGetTickCount();
+		}
+		#endif
 
-		/* And make the length a multiple of sizeof( size_t ). */
-		uxLength &= ~( sizeof( size_t ) - 1U );
+		/* Add an extra 4 (or 8) bytes and make the length a multiple of
+		sizeof( size_t ). */
+		uxLength = sockSTREAM_LENGTH( uxLength );
 
 		uxSize = ( sizeof( *pxBuffer )  + uxLength ) - sizeof( pxBuffer->ucArray );
 
-		pxBuffer = ipPOINTER_CAST( StreamBuffer_t *, pvPortMallocLarge( uxSize ) );
+		pxBuffer = ipPOINTER_CAST( StreamBuffer_t *, sockSTREAM_MALLOC( uxSize ) );
 
 		if( pxBuffer == NULL )
 		{
@@ -3279,6 +4360,207 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 #endif /* ipconfigUSE_TCP */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP == 1 )
+
+	size_t uxTCPRxSpace( const FreeRTOS_Socket_t *pxSocket, BaseType_t xFromFront )
+	{
+	const StreamBuffer_t *pxStream = pxSocket->u.xTCP.rxStream;
+	size_t uxSpace;
+
+		if( pxStream == NULL )
+		{
+			/* No RX stream has been created, the full stream size is
+			available. */
+			uxSpace = pxSocket->u.xTCP.uxRxStreamSize;
+		}
+		#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+		else if( pxSocket->u.xTCP.bits.bStreamsPinned == pdFALSE_UNSIGNED )
+		{
+		size_t uxCapacity = sockSTREAM_LENGTH( pxSocket->u.xTCP.uxRxStreamSize ) - 1U;
+		size_t uxUsed = uxStreamBufferDistance( pxStream, pxStream->uxTail, ( xFromFront != pdFALSE ) ? pxStream->uxFront : pxStream->uxHead );
+
+			/* The stream will grow when needed, so the space is counted as if
+			it had its full length already. */
+			uxSpace = ( uxCapacity > uxUsed ) ? ( uxCapacity - uxUsed ) : 0U;
+		}
+		#endif /* ipconfigTCP_ELASTIC_STREAMS */
+		else if( xFromFront != pdFALSE )
+		{
+			uxSpace = uxStreamBufferFrontSpace( pxStream );
+		}
+		else
+		{
+			uxSpace = uxStreamBufferGetSpace( pxStream );
+		}
+
+		return uxSpace;
+	}
+
+#endif /* ipconfigUSE_TCP */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_ELASTIC_STREAMS == 1 )
+
+	void vTCPRxStreamReserve( FreeRTOS_Socket_t *pxSocket, size_t uxOffset, size_t uxCount )
+	{
+	StreamBuffer_t *pxStream = pxSocket->u.xTCP.rxStream;
+	StreamBuffer_t *pxNewStream;
+	size_t uxFullLength = sockSTREAM_LENGTH( pxSocket->u.xTCP.uxRxStreamSize );
+	size_t uxNeeded, uxLength, uxSize, uxUsed, uxFirst;
+
+		pxSocket->u.xTCP.xStreamLastUse = xTaskGetTickCount();
+
+		if( pxStream == NULL )
+		{
+			pxStream = prvTCPCreateStream( pxSocket, pdTRUE );
+		}
+
+		if( ( pxStream != NULL ) && ( pxStream->LENGTH < uxFullLength ) )
+		{
+			/* The bytes waiting to be read, plus the new data at its offset
+			from the head. */
+			uxNeeded = uxStreamBufferGetSize( pxStream ) + uxOffset + uxCount;
+
+			if( uxNeeded >= pxStream->LENGTH )
+			{
+				/* Grow at least by a factor two, to limit the number of
+				copies. */
+				if( uxNeeded < ( 2U * pxStream->LENGTH ) )
+				{
+					uxNeeded = 2U * pxStream->LENGTH;
+				}
+
+				uxLength = sockSTREAM_LENGTH( uxNeeded );
+
+				if( uxLength > uxFullLength )
+				{
+					uxLength = uxFullLength;
+				}
+
+				uxSize = ( sizeof( *pxNewStream ) + uxLength ) - sizeof( pxNewStream->ucArray );
+				pxNewStream = ipPOINTER_CAST( StreamBuffer_t *, sockSTREAM_MALLOC( uxSize ) );
+
+				if( pxNewStream != NULL )
+				{
+					/* The user may be copying from the stream, or may have a
+					pointer to it.  In that case the data will be dropped, and
+					the peer will send it again. */
+					vTaskSuspendAll();
+					{
+						if( ( pxSocket->u.xTCP.uxRxStreamUsers == 0U ) &&
+							( pxSocket->u.xTCP.bits.bStreamsPinned == pdFALSE_UNSIGNED ) )
+						{
+							/* Copy everything from the tail up to the front,
+							including out-of-order data, to the start of the new
+							stream. */
+							uxUsed = uxStreamBufferDistance( pxStream, pxStream->uxTail, pxStream->uxFront );
+							uxFirst = FreeRTOS_min_uint32( pxStream->LENGTH - pxStream->uxTail, uxUsed );
+
+							( void ) memset( pxNewStream, 0, sizeof( *pxNewStream ) - sizeof( pxNewStream->ucArray ) );
+							pxNewStream->LENGTH = uxLength;
+							( void ) memcpy( pxNewStream->ucArray, &( pxStream->ucArray[ pxStream->uxTail ] ), uxFirst );
+							( void ) memcpy( &( pxNewStream->ucArray[ uxFirst ] ), pxStream->ucArray, uxUsed - uxFirst );
+							pxNewStream->uxHead = uxStreamBufferGetSize( pxStream );
+							pxNewStream->uxFront = uxUsed;
+
+							pxSocket->u.xTCP.rxStream = pxNewStream;
+
+							/* Now free the old stream. */
+							pxNewStream = pxStream;
+						}
+					}
+					( void ) xTaskResumeAll();
+
+					if( pxNewStream == pxStream )
+					{
+						iptraceMEM_STATS_DELETE( pxStream );
+						iptraceMEM_STATS_CREATE( tcpRX_STREAM_BUFFER, pxSocket->u.xTCP.rxStream, uxSize );
+
+						if( xTCPWindowLoggingLevel != 0 )
+						{
+							FreeRTOS_debug_printf( ( "vTCPRxStreamReserve: rxStream grown from %u to %u bytes\n", pxStream->LENGTH, uxLength ) );
+						}
+					}
+					else
+					{
+						FreeRTOS_debug_printf( ( "vTCPRxStreamReserve: rxStream in use\n" ) );
+					}
+
+					sockSTREAM_FREE( pxNewStream );
+				}
+			}
+		}
+	}
+
+#endif /* ipconfigTCP_ELASTIC_STREAMS */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP == 1 ) && ( ipconfigTCP_ELASTIC_STREAMS == 1 )
+
+	static void prvTCPStreamsRelease( FreeRTOS_Socket_t *pxSocket, TickType_t xNow )
+	{
+	StreamBuffer_t *pxRxStream = NULL;
+	StreamBuffer_t *pxTxStream = NULL;
+	const StreamBuffer_t *pxStream;
+
+		if( ( ( pxSocket->u.xTCP.rxStream != NULL ) || ( pxSocket->u.xTCP.txStream != NULL ) ) &&
+			( ( xNow - pxSocket->u.xTCP.xStreamLastUse ) >= pdMS_TO_TICKS( ipconfigTCP_STREAM_IDLE_RELEASE_MS ) ) )
+		{
+			vTaskSuspendAll();
+			{
+				if( pxSocket->u.xTCP.bits.bStreamsPinned == pdFALSE_UNSIGNED )
+				{
+					/* The rxStream may be released when it holds no data, not
+					even out-of-order data. */
+					pxStream = pxSocket->u.xTCP.rxStream;
+
+					if( ( pxStream != NULL ) &&
+						( pxSocket->u.xTCP.uxRxStreamUsers == 0U ) &&
+						( pxStream->uxTail == pxStream->uxHead ) &&
+						( pxStream->uxHead == pxStream->uxFront ) )
+					{
+						pxRxStream = pxSocket->u.xTCP.rxStream;
+						pxSocket->u.xTCP.rxStream = NULL;
+					}
+
+					/* The txStream may be released when all of its data has
+					been acknowledged.  The segments of the sliding window refer
+					to positions in the txStream, so it will not be resized, it
+					will be created again by the next FreeRTOS_send(). */
+					pxStream = pxSocket->u.xTCP.txStream;
+
+					if( ( pxStream != NULL ) &&
+						( pxSocket->u.xTCP.uxTxStreamUsers == 0U ) &&
+						( pxStream->uxTail == pxStream->uxHead ) &&
+						( xTCPWindowTxDone( &( pxSocket->u.xTCP.xTCPWindow ) ) != pdFALSE ) )
+					{
+						pxTxStream = pxSocket->u.xTCP.txStream;
+						pxSocket->u.xTCP.txStream = NULL;
+					}
+				}
+			}
+			( void ) xTaskResumeAll();
+
+			if( pxRxStream != NULL )
+			{
+				iptraceMEM_STATS_DELETE( pxRxStream );
+				sockSTREAM_FREE( pxRxStream );
+			}
+
+			if( pxTxStream != NULL )
+			{
+				iptraceMEM_STATS_DELETE( pxTxStream );
+				sockSTREAM_FREE( pxTxStream );
+			}
+
+			/* Check again after another idle period. */
+			pxSocket->u.xTCP.xStreamLastUse = xNow;
+		}
+	}
+
+#endif /* ipconfigTCP_ELASTIC_STREAMS */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP == 1 )
 
 	/*
@@ -3375,7 +4657,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				/* See if running out of space. */
 				if( pxSocket->u.xTCP.bits.bLowWater == pdFALSE_UNSIGNED )
 				{
-					size_t uxFrontSpace = uxStreamBufferFrontSpace( pxSocket->u.xTCP.rxStream );
+					size_t uxFrontSpace = uxTCPRxSpace( pxSocket, pdTRUE );
 					if( uxFrontSpace <= pxSocket->u.xTCP.uxLittleSpace  )
 					{
 						pxSocket->u.xTCP.bits.bLowWater = pdTRUE;
@@ -3463,13 +4745,18 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 				xResult = 0;
 			}
 		}
-		else if( pxSocket->u.xTCP.txStream == NULL )
-		{
-			xResult = ( BaseType_t ) pxSocket->u.xTCP.uxTxStreamSize;
-		}
 		else
 		{
-			xResult = ( BaseType_t ) uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream );
+			sockSTREAM_READ_BEGIN();
+			if( pxSocket->u.xTCP.txStream == NULL )
+			{
+				xResult = ( BaseType_t ) pxSocket->u.xTCP.uxTxStreamSize;
+			}
+			else
+			{
+				xResult = ( BaseType_t ) uxStreamBufferGetSpace( pxSocket->u.xTCP.txStream );
+			}
+			sockSTREAM_READ_END();
 		}
 
 		return xResult;
@@ -3491,6 +4778,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		}
 		else
 		{
+			sockSTREAM_READ_BEGIN();
 			if( pxSocket->u.xTCP.txStream != NULL )
 			{
 				xReturn = ( BaseType_t ) uxStreamBufferGetSpace ( pxSocket->u.xTCP.txStream );
@@ -3499,6 +4787,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			{
 				xReturn = ( BaseType_t ) pxSocket->u.xTCP.uxTxStreamSize;
 			}
+			sockSTREAM_READ_END();
 		}
 
 		return xReturn;
@@ -3520,6 +4809,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		}
 		else
 		{
+			sockSTREAM_READ_BEGIN();
 			if( pxSocket->u.xTCP.txStream != NULL )
 			{
 				xReturn = ( BaseType_t ) uxStreamBufferGetSize ( pxSocket->u.xTCP.txStream );
@@ -3528,6 +4818,7 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 			{
 				xReturn = 0;
 			}
+			sockSTREAM_READ_END();
 		}
 
 		return xReturn;
@@ -3629,13 +4920,18 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 		{
 			xReturn = -pdFREERTOS_ERRNO_EINVAL;
 		}
-		else if( pxSocket->u.xTCP.rxStream != NULL )
-		{
-			xReturn = ( BaseType_t ) uxStreamBufferGetSize( pxSocket->u.xTCP.rxStream );
-		}
 		else
 		{
-			xReturn = 0;
+			sockSTREAM_READ_BEGIN();
+			if( pxSocket->u.xTCP.rxStream != NULL )
+			{
+				xReturn = ( BaseType_t ) uxStreamBufferGetSize( pxSocket->u.xTCP.rxStream );
+			}
+			else
+			{
+				xReturn = 0;
+			}
+			sockSTREAM_READ_END();
 		}
 
 		return xReturn;
@@ -3738,9 +5034,24 @@ BaseType_t FreeRTOS_udp_rx_size( Socket_t xSocket )
 				 pxIterator != pxEndUDP;
 				 pxIterator  = listGET_NEXT( pxIterator ) )
 			{
-				/* Local port on this machine */
-				FreeRTOS_printf( ( "UDP Port %5u\n",
-					FreeRTOS_ntohs( listGET_LIST_ITEM_VALUE( pxIterator ) ) ) );
+				#if( ipconfigUSE_BUFFER_QUOTAS == 1 )
+				{
+				const FreeRTOS_Socket_t *pxSocket = ipPOINTER_CAST( const FreeRTOS_Socket_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
+
+					/* Local port, the buffers held and the packets dropped. */
+					FreeRTOS_printf( ( "UDP Port %5u held %lu drops %lu%s\n",
+						FreeRTOS_ntohs( listGET_LIST_ITEM_VALUE( pxIterator ) ),
+						( UBaseType_t ) listCURRENT_LIST_LENGTH( &( pxSocket->u.xUDP.xWaitingPacketsList ) ),
+						pxSocket->u.xUDP.ulBufferDrops,
+						( pxSocket->u.xUDP.xControl != pdFALSE ) ? " (stack)" : "" ) );
+				}
+				#else
+				{
+					/* Local port on this machine */
+					FreeRTOS_printf( ( "UDP Port %5u\n",
+						FreeRTOS_ntohs( listGET_LIST_ITEM_VALUE( pxIterator ) ) ) );
+				}
+				#endif
 				count++;
 			}
 
@@ -3946,15 +5257,10 @@ BaseType_t FreeRTOS_udp_rx_size( Socket_t xSocket )
 		}
 		else
 	#endif /* ipconfigSUPPORT_SELECT_FUNCTION */
-		if( pxSocket->xEventGroup != NULL )
 		{
-			( void ) xEventGroupSetBits( pxSocket->xEventGroup, ( EventBits_t ) eSOCKET_INTR );
+			vSocketSetEvents( pxSocket, ( EventBits_t ) eSOCKET_INTR );
 			xReturn = 0;
 		}
-		else
-		{
-			xReturn = -pdFREERTOS_ERRNO_EINVAL;
-		}
 
 		return xReturn;
 	}
@@ -3970,17 +5276,45 @@ BaseType_t FreeRTOS_udp_rx_size( Socket_t xSocket )
 	FreeRTOS_Socket_t *pxSocket = ( FreeRTOS_Socket_t * ) xSocket;
 	BaseType_t xReturn;
 	IPStackEvent_t xEvent;
+	#if( ipconfigUSE_STACK_LOCK != 0 )
+		UBaseType_t uxSavedInterruptStatus;
+	#endif
 
 		configASSERT( pxSocket != NULL );
 		configASSERT( pxSocket->ucProtocol == ( uint8_t ) FREERTOS_IPPROTO_TCP );
-		configASSERT( pxSocket->xEventGroup != NULL );
+		#if( ipconfigSOCKET_USE_TASK_NOTIFICATIONS == 0 )
+		{
+			configASSERT( pxSocket->xEventGroup != NULL );
+		}
+		#endif
 
 		xEvent.eEventType = eSocketSignalEvent;
 		xEvent.pvData = pxSocket;
 
+		#if( ipconfigUSE_STACK_LOCK != 0 )
+		{
+			/* Counted before the event is queued, so that a close that is
+			run directly by a user task can see it. */
+			uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+			pxSocket->uxSignalsPending++;
+			taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+		}
+		#endif /* ipconfigUSE_STACK_LOCK */
+
 		/* The IP-task will call FreeRTOS_SignalSocket for this socket. */
 		xReturn = xQueueSendToBackFromISR( xNetworkEventQueue, &xEvent, pxHigherPriorityTaskWoken );
 
+		#if( ipconfigUSE_STACK_LOCK != 0 )
+		{
+			if( xReturn != pdPASS )
+			{
+				uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+				pxSocket->uxSignalsPending--;
+				taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+			}
+		}
+		#endif /* ipconfigUSE_STACK_LOCK */
+
 		return xReturn;
 	}
 
@@ -52,6 +52,9 @@
 #include "NetworkInterface.h"
 #include "NetworkBufferManagement.h"
 #include "FreeRTOS_ARP.h"
+#if( ipconfigMULTI_INTERFACE == 1 )
+	#include "FreeRTOS_Routing.h"
+#endif
 
 
 /* Just make sure the contents doesn't get compiled if TCP is not enabled. */
@@ -74,6 +77,13 @@
 /* A mask to filter all protocol flags. */
 #define tcpTCP_FLAG_CTRL			( ( uint8_t ) 0x1FU )
 
+/*
+ * The ECN field: the two lowest bits of the IP type of service.
+ */
+#define tcpECN_MASK					( ( uint8_t ) 0x03U )
+#define tcpECN_ECT0					( ( uint8_t ) 0x02U ) /* ECN-Capable Transport */
+#define tcpECN_CE					( ( uint8_t ) 0x03U ) /* Congestion Experienced */
+
 /*
  * A few values of the TCP options:
  */
@@ -90,6 +100,13 @@
 
 #define tcpTCP_OPT_TIMESTAMP_LEN	10	/* fixed length of the time-stamp option */
 
+#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+	#define tcpTCP_OPT_FASTOPEN			34U  /* TCP Fast Open cookie option ( RFC 7413 ) */
+	#define tcpTCP_OPT_FASTOPEN_REQ_LEN	2U   /* Length of an empty option: a cookie request */
+	#define tcpTCP_OPT_FASTOPEN_LEN		10U  /* Length of the option carrying a cookie */
+	#define tcpFASTOPEN_COOKIE_LENGTH	8U   /* Only cookies of this length are handed out and accepted */
+#endif
+
 #ifndef ipconfigTCP_ACK_EARLIER_PACKET
 	#define ipconfigTCP_ACK_EARLIER_PACKET		1
 #endif
@@ -127,6 +144,19 @@
  */
 #define tcpREDUCED_MSS_THROUGH_INTERNET		( 1400 )
 
+/*
+ * A path MTU learned from an ICMP message will not be lower than this.  It
+ * limits the damage that a forged message can do.
+ */
+#define tcpMINIMUM_PATH_MTU					( 576U )
+
+/*
+ * When a full-size segment has been sent this many times with the DF flag
+ * without being acknowledged, a router may be dropping it without sending an
+ * ICMP message: a path MTU black hole.
+ */
+#define tcpPATH_MTU_BLACK_HOLE_COUNT		( 3U )
+
 /*
  * When there are no TCP options, the TCP offset equals 20 bytes, which is stored as
  * the number 5 (words) in the higher niblle of the TCP-offset byte.
@@ -171,12 +201,54 @@ static int32_t prvTCPSendPacket( FreeRTOS_Socket_t *pxSocket );
  */
 static int32_t prvTCPSendRepeated( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t **ppxNetworkBuffer );
 
+#if( ipconfigTCP_PACING == 1 )
+	/*
+	 * Returns the transmission rate of a paced socket in bytes per second, or
+	 * FREERTOS_TCP_PACING_OFF.
+	 */
+	static uint32_t prvTCPPacingRate( const FreeRTOS_Socket_t *pxSocket );
+
+	/*
+	 * Adds the credit that the socket has earned since the last call, and
+	 * returns pdTRUE when a segment may be sent now.  Otherwise the socket
+	 * timer is set to the moment at which the next segment may be sent.
+	 */
+	static BaseType_t prvTCPPacingAllowed( FreeRTOS_Socket_t *pxSocket );
+#endif /* ipconfigTCP_PACING */
+
 /*
  * Return or send a packet to the other party.
  */
 static void prvTCPReturnPacket( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxDescriptor,
 	uint32_t ulLen, BaseType_t xReleaseAfterSend );
 
+/*
+ * Look up the MAC address of the peer, or of the gateway, in the ARP cache and
+ * store it in the packet and in the socket.
+ */
+static void prvTCPRefreshMACAddress( FreeRTOS_Socket_t *pxSocket, const NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+/*
+ * The local IP address of a connection, in network byte order.  With
+ * ipconfigMULTI_INTERFACE, this is the address of the socket's end-point.
+ */
+static uint32_t prvTCPLocalAddress( const FreeRTOS_Socket_t *pxSocket );
+
+/*
+ * The IP address, in network byte order, whose MAC address is needed to reach
+ * the peer.  With ipconfigMULTI_INTERFACE, an off-link peer is reached through
+ * the gateway of the socket's end-point.
+ */
+static uint32_t prvTCPNextHopAddress( const FreeRTOS_Socket_t *pxSocket );
+
+#if( ( ipconfigUSE_HEADER_TEMPLATES != 0 ) && ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 ) )
+	/*
+	 * Calculate the sums of the header fields that are the same in every
+	 * packet of the connection.
+	 */
+	static void prvTCPSetTemplateSums( FreeRTOS_Socket_t *pxSocket, const IPHeader_t *pxIPHeader );
+#endif
+
 /*
  * Initialise the data structures which keep track of the TCP windowing system.
  */
@@ -228,6 +300,60 @@ static size_t prvSingleStepTCPHeaderOptions( const uint8_t * const pucPtr,
  */
 static UBaseType_t prvSetSynAckOptions( FreeRTOS_Socket_t *pxSocket, TCPHeader_t *pxTCPHeader );
 
+#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+	/*
+	 * Calculate the Fast Open cookie that a listening socket hands out to the
+	 * host with the given IP-address.
+	 */
+	static void prvTCPFastOpenCookie( uint32_t ulRemoteIP, uint8_t *pucCookie );
+
+	/*
+	 * Handle the Fast Open option of a SYN or SYN+ACK: check the cookie of a
+	 * client, or store the cookie given by a server.
+	 */
+	static void prvReadFastOpenOption( FreeRTOS_Socket_t * const pxSocket, const uint8_t * const pucPtr, uint8_t ucLen );
+
+	/*
+	 * Client: find the cookie that was given by a server, or store it.
+	 */
+	static const uint8_t *pucTCPFastOpenCacheLookup( uint32_t ulRemoteIP );
+	static void prvTCPFastOpenCacheStore( uint32_t ulRemoteIP, const uint8_t *pucCookie );
+
+	/*
+	 * Client: send the SYN, along with the first data in case the server's
+	 * cookie is known.  Returns the number of data bytes sent.
+	 */
+	static int32_t prvTCPFastOpenSendSyn( FreeRTOS_Socket_t *pxSocket, UBaseType_t uxOptionsLength );
+
+	/*
+	 * Server: store the data of a SYN that showed a valid cookie, and let the
+	 * connection be established before the SYN+ACK has been acknowledged.
+	 */
+	static BaseType_t prvTCPFastOpenAccept( FreeRTOS_Socket_t *pxSocket, const uint8_t *pucRecvData,
+		uint32_t ulSequenceNumber, uint32_t ulReceiveLength );
+
+	/*
+	 * Server: the client repeated its SYN, it has not seen the SYN+ACK of a
+	 * connection that was established by a Fast Open.  Send it again.
+	 */
+	static void prvTCPFastOpenRepeatSynAck( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer );
+#endif /* ipconfigUSE_TCP_FAST_OPEN */
+
+#if( ipconfigUSE_TCP_ECN == 1 )
+	/*
+	 * Look at the ECN bits of a received packet: negotiate ECN in the SYN
+	 * phase, remember a congestion mark, and reduce the Tx window when the
+	 * peer echoes one.
+	 */
+	static void prvTCPEcnReceive( FreeRTOS_Socket_t *pxSocket, const NetworkBufferDescriptor_t *pxNetworkBuffer );
+
+	/*
+	 * Set the ECN flags of an outgoing segment, and mark new data as
+	 * ECN-capable.
+	 */
+	static void prvTCPEcnSend( FreeRTOS_Socket_t *pxSocket, TCPPacket_t *pxTCPPacket, uint32_t ulLen );
+#endif /* ipconfigUSE_TCP_ECN */
+
 /*
  * For anti-hang protection and TCP keep-alive messages.  Called in two places:
  * after receiving a packet and after a state change.  The socket's alive timer
@@ -325,6 +451,19 @@ static BaseType_t prvTCPSendReset( NetworkBufferDescriptor_t *pxNetworkBuffer );
  */
 static void prvSocketSetMSS( FreeRTOS_Socket_t *pxSocket );
 
+#if( ipconfigUSE_PATH_MTU_DISCOVERY != 0 )
+	/*
+	 * Return the path MTU that was learned for a destination, or 0 when it is
+	 * not known.
+	 */
+	static uint16_t prvPathMTUGet( uint32_t ulIPAddress );
+
+	/*
+	 * Remember the path MTU of a destination.
+	 */
+	static void prvPathMTUSet( uint32_t ulIPAddress, uint16_t usMTU );
+#endif
+
 /*
  * Return either a newly created socket, or the current socket in a connected
  * state (depends on the 'bReuseSocket' flag).
@@ -355,6 +494,39 @@ static NetworkBufferDescriptor_t *prvTCPBufferResize( const FreeRTOS_Socket_t *p
 
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_PATH_MTU_DISCOVERY != 0 )
+	/* A path MTU that was learned from an ICMP "fragmentation needed"
+	message. */
+	typedef struct xPATH_MTU_ENTRY
+	{
+		uint32_t ulIPAddress;		/* The destination, in network byte order, or 0 when unused. */
+		TickType_t xTimeLearned;
+		uint16_t usMTU;
+	} PathMTUEntry_t;
+
+	static PathMTUEntry_t xPathMTUCache[ ipconfigPATH_MTU_CACHE_ENTRIES ];
+#endif
+
+#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+	/* A Fast Open cookie that a client received from a server. */
+	typedef struct xTCP_FAST_OPEN_COOKIE
+	{
+		uint32_t ulIPAddress;		/* The server, in host byte order, or 0 when unused. */
+		uint8_t ucCookie[ tcpFASTOPEN_COOKIE_LENGTH ];
+	} TCPFastOpenCookie_t;
+
+	static TCPFastOpenCookie_t xFastOpenCache[ ipconfigTCP_FAST_OPEN_CACHE_SIZE ];
+
+	/* The entry that will be replaced when a cookie of a new server comes in. */
+	static UBaseType_t uxFastOpenCacheNext = 0U;
+
+	/* The key of the cookies handed out by listening sockets, chosen when the
+	first cookie is calculated. */
+	static uint32_t ulFastOpenSecret[ 2 ];
+#endif
+
+/*-----------------------------------------------------------*/
+
 /* prvTCPSocketIsActive() returns true if the socket must be checked.
  * Non-active sockets are waiting for user action, either connect()
  * or close(). */
@@ -638,7 +810,18 @@ NetworkBufferDescriptor_t *pxNetworkBuffer;
 			/* Send the SYN message to make a connection.  The messages is
 			stored in the socket field 'xPacket'.  It will be wrapped in a
 			pseudo network buffer descriptor before it will be sent. */
-			prvTCPReturnPacket( pxSocket, NULL, ( uint32_t ) lResult, pdFALSE );
+			#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+			if( pxSocket->u.xTCP.bits.bFastOpen != pdFALSE_UNSIGNED )
+			{
+				/* A Fast Open SYN may carry data, it needs a network buffer
+				of its own. */
+				lResult += prvTCPFastOpenSendSyn( pxSocket, uxOptionsLength );
+			}
+			else
+			#endif /* ipconfigUSE_TCP_FAST_OPEN */
+			{
+				prvTCPReturnPacket( pxSocket, NULL, ( uint32_t ) lResult, pdFALSE );
+			}
 		}
 		else
 		{
@@ -664,6 +847,17 @@ int32_t xSendLength;
 
 	for( uxIndex = 0U; uxIndex < ( UBaseType_t ) SEND_REPEATED_COUNT; uxIndex++ )
 	{
+		#if( ipconfigTCP_PACING == 1 )
+		{
+			/* A paced socket sends the rest of the series when the timer set
+			by prvTCPPacingAllowed() expires. */
+			if( prvTCPPacingAllowed( pxSocket ) == pdFALSE )
+			{
+				break;
+			}
+		}
+		#endif /* ipconfigTCP_PACING */
+
 		/* prvTCPPrepareSend() might allocate a network buffer if there is data
 		to be sent. */
 		xSendLength = prvTCPPrepareSend( pxSocket, ppxNetworkBuffer, uxOptionsLength );
@@ -681,6 +875,15 @@ int32_t xSendLength;
 		}
 		#endif /* ipconfigZERO_COPY_TX_DRIVER */
 
+		#if( ipconfigTCP_PACING == 1 )
+		{
+			if( pxSocket->u.xTCP.ulPacingRate != FREERTOS_TCP_PACING_OFF )
+			{
+				pxSocket->u.xTCP.lPacingCredit -= xSendLength;
+			}
+		}
+		#endif /* ipconfigTCP_PACING */
+
 		lResult += xSendLength;
 	}
 
@@ -689,6 +892,103 @@ int32_t xSendLength;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigTCP_PACING == 1 )
+
+	static uint32_t prvTCPPacingRate( const FreeRTOS_Socket_t *pxSocket )
+	{
+	uint32_t ulRate = pxSocket->u.xTCP.ulPacingRate;
+	uint32_t ulWindow, ulSRTT;
+	uint64_t ullRate;
+
+		if( ulRate == FREERTOS_TCP_PACING_AUTO )
+		{
+			/* Allow twice the window per round-trip: the window still limits
+			the throughput as before, pacing only spreads the segments over the
+			round-trip.  Note that the sliding window keeps lSRTT at 50 ms or
+			more, so on a LAN an explicit rate should be used.  A zero window
+			of the peer is not taken into account, nothing can be sent anyway. */
+			ulWindow = pxSocket->u.xTCP.xTCPWindow.xSize.ulTxWindowLength;
+			if( pxSocket->u.xTCP.ulWindowSize != 0U )
+			{
+				ulWindow = FreeRTOS_min_uint32( ulWindow, pxSocket->u.xTCP.ulWindowSize );
+			}
+			ulSRTT = ( uint32_t ) FreeRTOS_max_int32( pxSocket->u.xTCP.xTCPWindow.lSRTT, 1 );
+			ullRate = ( 2ULL * ( uint64_t ) ulWindow * 1000ULL ) / ( uint64_t ) ulSRTT;
+
+			if( ullRate >= ( uint64_t ) FREERTOS_TCP_PACING_AUTO )
+			{
+				ullRate = ( uint64_t ) FREERTOS_TCP_PACING_AUTO - 1U;
+			}
+			else if( ullRate == 0U )
+			{
+				ullRate = 1U;
+			}
+			else
+			{
+				/* The rate is within range. */
+			}
+			ulRate = ( uint32_t ) ullRate;
+		}
+
+		return ulRate;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvTCPPacingAllowed( FreeRTOS_Socket_t *pxSocket )
+	{
+	uint32_t ulRate = prvTCPPacingRate( pxSocket );
+	uint32_t ulBurst;
+	uint64_t ullCredit, ullWait;
+	TickType_t xNow, xElapsed;
+	BaseType_t xReturn = pdTRUE;
+
+		if( ulRate != FREERTOS_TCP_PACING_OFF )
+		{
+			xNow = xTaskGetTickCount();
+			xElapsed = xNow - pxSocket->u.xTCP.xPacingTime;
+			pxSocket->u.xTCP.xPacingTime = xNow;
+
+			/* The credit is limited to a small burst after an idle period.  The
+			limit must hold at least the credit of one clock tick, otherwise the
+			rate can not be reached. */
+			ulBurst = FreeRTOS_max_uint32( ( uint32_t ) ipconfigTCP_PACING_BURST * ( uint32_t ) pxSocket->u.xTCP.usCurMSS,
+										   ulRate / ( uint32_t ) configTICK_RATE_HZ );
+			ulBurst = FreeRTOS_min_uint32( ulBurst, 0x7FFFFFFFUL );
+
+			ullCredit = ( ( uint64_t ) xElapsed * ( uint64_t ) ulRate ) / ( uint64_t ) configTICK_RATE_HZ;
+			if( ( ullCredit >= ( uint64_t ) ulBurst ) ||
+				( ( ( int64_t ) pxSocket->u.xTCP.lPacingCredit + ( int64_t ) ullCredit ) >= ( int64_t ) ulBurst ) )
+			{
+				pxSocket->u.xTCP.lPacingCredit = ( int32_t ) ulBurst;
+			}
+			else
+			{
+				pxSocket->u.xTCP.lPacingCredit += ( int32_t ) ullCredit;
+			}
+
+			if( pxSocket->u.xTCP.lPacingCredit <= 0 )
+			{
+				/* Wait until the debt has been paid, at least one clock tick. */
+				ullWait = ( ( ( uint64_t ) ( 1 - ( int64_t ) pxSocket->u.xTCP.lPacingCredit ) * ( uint64_t ) configTICK_RATE_HZ ) + ( uint64_t ) ulRate - 1U ) / ( uint64_t ) ulRate;
+				if( ullWait > 0xFFFFU )
+				{
+					ullWait = 0xFFFFU;
+				}
+
+				if( ( pxSocket->u.xTCP.usTimeout == 0U ) || ( ( uint64_t ) pxSocket->u.xTCP.usTimeout > ullWait ) )
+				{
+					pxSocket->u.xTCP.usTimeout = ( uint16_t ) ullWait;
+				}
+				xReturn = pdFALSE;
+			}
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigTCP_PACING */
+
 /*
  * Return (or send) a packet the the peer.  The data is stored in pxBuffer,
  * which may either point to a real network buffer or to a TCP socket field
@@ -702,6 +1002,7 @@ IPHeader_t *pxIPHeader;
 BaseType_t xDoRelease = xReleaseAfterSend;
 EthernetHeader_t *pxEthernetHeader;
 uint32_t ulFrontSpace, ulSpace, ulSourceAddress, ulWinSize;
+uint32_t ulLocalAddress = 0UL;
 const TCPWindow_t *pxTCPWindow;
 NetworkBufferDescriptor_t *pxNetworkBuffer = pxDescriptor;	/* To avoid error: "function parameter modified [MISRA 2012 Rule 17.8, advisory]" */
 NetworkBufferDescriptor_t xTempBuffer;
@@ -746,22 +1047,22 @@ NetworkBufferDescriptor_t xTempBuffer;
 		/* Fill the packet, using hton translations. */
 		if( pxSocket != NULL )
 		{
+			ulLocalAddress = prvTCPLocalAddress( pxSocket );
+
+			#if( ipconfigMULTI_INTERFACE == 1 )
+			{
+				/* The packet leaves through the end-point of the connection.
+				A reset without a socket re-uses the received packet, which
+				already refers to the end-point that received it. */
+				pxNetworkBuffer->pxEndPoint = pxSocket->u.xTCP.pxEndPoint;
+			}
+			#endif /* ipconfigMULTI_INTERFACE */
+
 			/* Calculate the space in the RX buffer in order to advertise the
 			size of this socket's reception window. */
 			pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
 
-			if( pxSocket->u.xTCP.rxStream != NULL )
-			{
-				/* An RX stream was created already, see how much space is
-				available. */
-				ulFrontSpace = ( uint32_t ) uxStreamBufferFrontSpace( pxSocket->u.xTCP.rxStream );
-			}
-			else
-			{
-				/* No RX stream has been created, the full stream size is
-				available. */
-				ulFrontSpace = ( uint32_t ) pxSocket->u.xTCP.uxRxStreamSize;
-			}
+			ulFrontSpace = ( uint32_t ) uxTCPRxSpace( pxSocket, pdTRUE );
 
 			/* Take the minimum of the RX buffer space and the RX window size. */
 			ulSpace = FreeRTOS_min_uint32( pxTCPWindow->xSize.ulRxWindowLength, ulFrontSpace );
@@ -843,6 +1144,19 @@ NetworkBufferDescriptor_t xTempBuffer;
 
 			/* Tell which sequence number is expected next time */
 			pxTCPPacket->xTCPHeader.ulAckNr = FreeRTOS_htonl( pxTCPWindow->rx.ulCurrentSequenceNumber );
+
+			#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+			{
+				/* The packet may be a received packet that is re-used. */
+				pxIPHeader->ucDifferentiatedServicesCode = pxSocket->ucTypeOfService;
+			}
+			#endif
+
+			#if( ipconfigUSE_TCP_ECN == 1 )
+			{
+				prvTCPEcnSend( pxSocket, pxTCPPacket, ulLen );
+			}
+			#endif
 		}
 		else
 		{
@@ -853,7 +1167,7 @@ NetworkBufferDescriptor_t xTempBuffer;
 
 		pxIPHeader->ucTimeToLive		   = ( uint8_t ) ipconfigTCP_TIME_TO_LIVE;
 		pxIPHeader->usLength			   = FreeRTOS_htons( ulLen );
-		if( ( pxSocket == NULL ) || ( *ipLOCAL_IP_ADDRESS_POINTER == 0UL ) )
+		if( ulLocalAddress == 0UL )
 		{
 			/* When pxSocket is NULL, this function is called by prvTCPSendReset()
 			and the IP-addresses must be swapped.
@@ -863,7 +1177,7 @@ NetworkBufferDescriptor_t xTempBuffer;
 		}
 		else
 		{
-			ulSourceAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+			ulSourceAddress = ulLocalAddress;
 		}
 		pxIPHeader->ulDestinationIPAddress = pxIPHeader->ulSourceIPAddress;
 		pxIPHeader->ulSourceIPAddress = ulSourceAddress;
@@ -874,18 +1188,70 @@ NetworkBufferDescriptor_t xTempBuffer;
 		usPacketIdentifier++;
 		pxIPHeader->usFragmentOffset = 0U;
 
+		#if( ipconfigUSE_PATH_MTU_DISCOVERY != 0 )
+		{
+		/* The TCP header length, including the options, is stored in the
+		high nibble of ucTCPOffset as a number of 32-bit words. */
+		uint32_t ulPayloadLength = ulLen - ( ipSIZE_OF_IPv4_HEADER +
+			( ( uint32_t ) ( pxTCPPacket->xTCPHeader.ucTCPOffset & tcpTCP_OFFSET_LENGTH_BITS ) >> 2 ) );
+
+			/* A segment that was made before the MSS was lowered may be
+			retransmitted: it is sent without DF, and routers may fragment
+			it. */
+			if( ( pxSocket != NULL ) &&
+				( pxSocket->u.xTCP.bits.bNoDontFragment == pdFALSE_UNSIGNED ) &&
+				( ulPayloadLength <= ( uint32_t ) pxSocket->u.xTCP.usCurMSS ) )
+			{
+				pxIPHeader->usFragmentOffset = ipFRAGMENT_FLAGS_DONT_FRAGMENT;
+			}
+		}
+		#endif
+
 		/* Important: tell NIC driver how many bytes must be sent. */
 		pxNetworkBuffer->xDataLength = ulLen + ipSIZE_OF_ETH_HEADER;
 
 		#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
 		{
-			/* calculate the IP header checksum, in case the driver won't do that. */
-			pxIPHeader->usHeaderChecksum = 0x00U;
-			pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0U, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
-			pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+		#if( ipconfigUSE_HEADER_TEMPLATES != 0 )
+			if( ( pxSocket != NULL ) && ( ulSourceAddress == ulLocalAddress ) && ( ulSourceAddress != 0UL ) )
+			{
+			uint16_t usSum;
+			uint32_t ulTCPLength = ulLen - ipSIZE_OF_IPv4_HEADER;
 
-			/* calculate the TCP checksum for an outgoing packet. */
-			( void ) usGenerateProtocolChecksum( ( uint8_t * ) pxTCPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+				if( pxSocket->u.xTCP.ulTemplateSourceIP != ulSourceAddress )
+				{
+					prvTCPSetTemplateSums( pxSocket, pxIPHeader );
+				}
+
+				/* Only the first word, the length, the identification and
+				the fragmentation flags may differ from the socket's
+				template.  The first word is added here because a received
+				packet may be used to send the reply. */
+				usSum = usFoldChecksum( ( uint32_t ) pxSocket->u.xTCP.usTemplateIPSum +
+										( ( ( uint32_t ) pxIPHeader->ucVersionHeaderLength ) << 8 ) +
+										( uint32_t ) pxIPHeader->ucDifferentiatedServicesCode +
+										FreeRTOS_ntohs( pxIPHeader->usFragmentOffset ) +
+										ulLen +
+										FreeRTOS_ntohs( pxIPHeader->usIdentification ) );
+				pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( usSum );
+
+				/* Continue the pseudo header sum with the TCP header and data. */
+				pxTCPPacket->xTCPHeader.usChecksum = 0U;
+				usSum = usFoldChecksum( ( uint32_t ) pxSocket->u.xTCP.usTemplatePseudoSum + ulTCPLength );
+				usSum = ( uint16_t ) ~usGenerateChecksum( usSum, ( uint8_t * ) &( pxTCPPacket->xTCPHeader ), ( size_t ) ulTCPLength );
+				pxTCPPacket->xTCPHeader.usChecksum = FreeRTOS_htons( usSum );
+			}
+			else
+		#endif /* ipconfigUSE_HEADER_TEMPLATES */
+			{
+				/* calculate the IP header checksum, in case the driver won't do that. */
+				pxIPHeader->usHeaderChecksum = 0x00U;
+				pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0U, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+				pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+
+				/* calculate the TCP checksum for an outgoing packet. */
+				( void ) usGenerateProtocolChecksum( ( uint8_t * ) pxTCPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+			}
 
 			/* A calculated checksum of 0 must be inverted as 0 means the checksum
 			is disabled. */
@@ -907,6 +1273,15 @@ NetworkBufferDescriptor_t xTempBuffer;
 						 &( pxEthernetHeader->xSourceAddress ),
 						 sizeof( pxEthernetHeader->xDestinationAddress ) );
 
+		if( ( pxSocket != NULL ) && ( pxSocket->u.xTCP.ulARPGeneration != ulARPGeneration ) )
+		{
+			/* The socket's copy of the peer's MAC address was made before
+			the ARP cache or the network addressing changed: look it up again.
+			As long as ulARPGeneration does not change, the copy is used
+			without a lookup. */
+			prvTCPRefreshMACAddress( pxSocket, pxNetworkBuffer );
+		}
+
 		/* The source MAC addresses is fixed to 'ipLOCAL_MAC_ADDRESS'. */
 		( void ) memcpy( &( pxEthernetHeader->xSourceAddress ), ipLOCAL_MAC_ADDRESS, ( size_t ) ipMAC_ADDRESS_LENGTH_BYTES );
  
@@ -926,7 +1301,7 @@ NetworkBufferDescriptor_t xTempBuffer;
 		#endif
 
 		/* Send! */
-		( void ) xNetworkInterfaceOutput( pxNetworkBuffer, xDoRelease );
+		( void ) ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xDoRelease );
 
 		if( xDoRelease == pdFALSE )
 		{
@@ -944,6 +1319,117 @@ NetworkBufferDescriptor_t xTempBuffer;
 }
 /*-----------------------------------------------------------*/
 
+#if( ( ipconfigUSE_HEADER_TEMPLATES != 0 ) && ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 ) )
+
+	static void prvTCPSetTemplateSums( FreeRTOS_Socket_t *pxSocket, const IPHeader_t *pxIPHeader )
+	{
+	IPHeader_t xTemplate;
+
+		/* The sums are kept until the local IP address changes, or until the
+		socket connects again. */
+		( void ) memcpy( &( xTemplate ), pxIPHeader, sizeof( xTemplate ) );
+		xTemplate.ucVersionHeaderLength = 0U;
+		xTemplate.ucDifferentiatedServicesCode = 0U;
+		xTemplate.usLength = 0U;
+		xTemplate.usIdentification = 0U;
+		xTemplate.usFragmentOffset = 0U;
+		xTemplate.usHeaderChecksum = 0U;
+
+		pxSocket->u.xTCP.usTemplateIPSum = usGenerateChecksum( 0U, ( uint8_t * ) &( xTemplate.ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+		pxSocket->u.xTCP.usTemplatePseudoSum = usGenerateChecksum( ( uint16_t ) ipPROTOCOL_TCP,
+																   ( uint8_t * ) &( xTemplate.ulSourceIPAddress ),
+																   2U * ipSIZE_OF_IPv4_ADDRESS );
+		pxSocket->u.xTCP.ulTemplateSourceIP = pxIPHeader->ulSourceIPAddress;
+	}
+
+#endif /* ipconfigUSE_HEADER_TEMPLATES */
+/*-----------------------------------------------------------*/
+
+static uint32_t prvTCPLocalAddress( const FreeRTOS_Socket_t *pxSocket )
+{
+uint32_t ulAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+
+	#if( ipconfigMULTI_INTERFACE == 1 )
+	{
+		/* The primary end-point follows *ipLOCAL_IP_ADDRESS_POINTER, which DHCP
+		may change at any time. */
+		if( ( pxSocket->u.xTCP.pxEndPoint != NULL ) && ( pxSocket->u.xTCP.pxEndPoint != FreeRTOS_FirstEndPoint() ) )
+		{
+			ulAddress = pxSocket->u.xTCP.pxEndPoint->ulIPAddress;
+		}
+	}
+	#else
+	{
+		( void ) pxSocket;
+	}
+	#endif /* ipconfigMULTI_INTERFACE */
+
+	return ulAddress;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvTCPNextHopAddress( const FreeRTOS_Socket_t *pxSocket )
+{
+uint32_t ulAddress = FreeRTOS_htonl( pxSocket->u.xTCP.ulRemoteIP );
+
+	#if( ipconfigMULTI_INTERFACE == 1 )
+	{
+	const NetworkEndPoint_t *pxEndPoint = pxSocket->u.xTCP.pxEndPoint;
+
+		/* eARPGetCacheEntry() would use the first gateway that it finds.  A
+		connection on a secondary end-point must use the gateway of that
+		end-point. */
+		if( ( pxEndPoint != NULL ) &&
+			( pxEndPoint != FreeRTOS_FirstEndPoint() ) &&
+			( pxEndPoint->ulGatewayAddress != 0UL ) &&
+			( ( ( ulAddress ^ pxEndPoint->ulIPAddress ) & pxEndPoint->ulNetMask ) != 0UL ) )
+		{
+			ulAddress = pxEndPoint->ulGatewayAddress;
+		}
+	}
+	#endif /* ipconfigMULTI_INTERFACE */
+
+	return ulAddress;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTCPRefreshMACAddress( FreeRTOS_Socket_t *pxSocket, const NetworkBufferDescriptor_t *pxNetworkBuffer )
+{
+EthernetHeader_t *pxEthernetHeader = ipPOINTER_CAST( EthernetHeader_t *, pxNetworkBuffer->pucEthernetBuffer );
+EthernetHeader_t *pxLastHeader = ipPOINTER_CAST( EthernetHeader_t *, pxSocket->u.xTCP.xPacket.u.ucLastPacket );
+uint32_t ulIPAddress = prvTCPNextHopAddress( pxSocket );
+MACAddress_t xEthAddress;
+eARPLookupResult_t eResult;
+
+	eResult = eARPGetCacheEntry( &( ulIPAddress ), &( xEthAddress ) );
+
+	if( eResult == eARPCacheHit )
+	{
+		( void ) memcpy( &( pxEthernetHeader->xDestinationAddress ), &( xEthAddress ), sizeof( xEthAddress ) );
+
+		if( pxNetworkBuffer->pucEthernetBuffer != pxSocket->u.xTCP.xPacket.u.ucLastPacket )
+		{
+			/* The socket's header is stored swapped, see prvTCPPrepareConnect().
+			When the packet is the socket's header, the swap-back in
+			prvTCPReturnPacket() stores the new address. */
+			( void ) memcpy( &( pxLastHeader->xSourceAddress ), &( xEthAddress ), sizeof( xEthAddress ) );
+		}
+	}
+	else if( eResult == eARPCacheMiss )
+	{
+		/* The entry has expired.  The old MAC address is the best guess until
+		the reply comes in, which will change ulARPGeneration again. */
+		FreeRTOS_OutputARPRequest( ulIPAddress );
+	}
+	else
+	{
+		/* eCantSendPacket: keep the old MAC address. */
+	}
+
+	pxSocket->u.xTCP.ulARPGeneration = ulARPGeneration;
+}
+/*-----------------------------------------------------------*/
+
 /*
  * The SYN event is very important: the sequence numbers, which have a kind of
  * random starting value, are being synchronised.  The sliding window manager
@@ -993,7 +1479,15 @@ uint32_t ulInitialSequenceNumber = 0;
 	}
 	#endif /* ipconfigHAS_PRINTF != 0 */
 
-	ulRemoteIP = FreeRTOS_htonl( pxSocket->u.xTCP.ulRemoteIP );
+	#if( ipconfigMULTI_INTERFACE == 1 )
+	{
+		/* The connection is made through the end-point that routes to the
+		peer, and stays on that end-point. */
+		pxSocket->u.xTCP.pxEndPoint = FreeRTOS_FindEndPointForRoute( FreeRTOS_htonl( pxSocket->u.xTCP.ulRemoteIP ) );
+	}
+	#endif /* ipconfigMULTI_INTERFACE */
+
+	ulRemoteIP = prvTCPNextHopAddress( pxSocket );
 
 	/* Determine the ARP cache status for the requested IP address. */
 	eReturned = eARPGetCacheEntry( &( ulRemoteIP ), &( xEthAddress ) );
@@ -1028,7 +1522,7 @@ uint32_t ulInitialSequenceNumber = 0;
 	if( xReturn != pdFALSE )
 	{
 		/* Get a difficult-to-predict initial sequence number for this 4-tuple. */
-		ulInitialSequenceNumber = ulApplicationGetNextSequenceNumber( *ipLOCAL_IP_ADDRESS_POINTER,
+		ulInitialSequenceNumber = ulApplicationGetNextSequenceNumber( prvTCPLocalAddress( pxSocket ),
 																	  pxSocket->usLocalPort,
 																	  pxSocket->u.xTCP.ulRemoteIP,
 																	  pxSocket->u.xTCP.usRemotePort );
@@ -1062,6 +1556,14 @@ uint32_t ulInitialSequenceNumber = 0;
 		/* Write the Ethernet address in Source, because it will be swapped by
 		prvTCPReturnPacket(). */
 		( void ) memcpy( &pxTCPPacket->xEthernetHeader.xSourceAddress, &xEthAddress, sizeof( xEthAddress ) );
+		pxSocket->u.xTCP.ulARPGeneration = ulARPGeneration;
+
+		#if( ipconfigUSE_HEADER_TEMPLATES != 0 )
+		{
+			/* The header changes, the template sums must be calculated again. */
+			pxSocket->u.xTCP.ulTemplateSourceIP = 0UL;
+		}
+		#endif
 
 		/* 'ipIPv4_FRAME_TYPE' is already in network-byte-order. */
 		pxTCPPacket->xEthernetHeader.usFrameType = ipIPv4_FRAME_TYPE;
@@ -1075,7 +1577,7 @@ uint32_t ulInitialSequenceNumber = 0;
 
 		/* Addresses and ports will be stored swapped because prvTCPReturnPacket
 		will swap them back while replying. */
-		pxIPHeader->ulDestinationIPAddress = *ipLOCAL_IP_ADDRESS_POINTER;
+		pxIPHeader->ulDestinationIPAddress = prvTCPLocalAddress( pxSocket );
 		pxIPHeader->ulSourceIPAddress = FreeRTOS_htonl( pxSocket->u.xTCP.ulRemoteIP );
 
 		pxTCPPacket->xTCPHeader.usSourcePort = FreeRTOS_htons( pxSocket->u.xTCP.usRemotePort );
@@ -1324,6 +1826,16 @@ TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
 		}
 		#endif	/* ipconfigUSE_TCP_WIN == 1 */
 
+		#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+		{
+			/* The Fast Open option is only valid in the SYN phase. */
+			if( ( pucPtr[ 0U ] == tcpTCP_OPT_FASTOPEN ) && ( xHasSYNFlag != 0 ) )
+			{
+				prvReadFastOpenOption( pxSocket, pucPtr, ucLen );
+			}
+		}
+		#endif	/* ipconfigUSE_TCP_FAST_OPEN */
+
 		uxIndex += ( size_t ) ucLen;
 	}
 	return uxIndex;
@@ -1348,107 +1860,521 @@ TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
 			( void ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, 0, NULL, ( size_t ) ulCount, pdFALSE );
 			pxSocket->xEventBits |= ( EventBits_t ) eSOCKET_SEND;
 
-			#if ipconfigSUPPORT_SELECT_FUNCTION == 1
+			#if ipconfigSUPPORT_SELECT_FUNCTION == 1
+			{
+				if( ( pxSocket->xSelectBits & ( EventBits_t ) eSELECT_WRITE ) != 0U )
+				{
+					/* The field 'xEventBits' is used to store regular socket events
+					 * (at most 8), as well as 'select events', which will be left-shifted.
+					 */
+					pxSocket->xEventBits |= ( ( EventBits_t ) eSELECT_WRITE ) << SOCKET_EVENT_BIT_COUNT;
+				}
+			}
+			#endif
+
+			/* In case the socket owner has installed an OnSent handler,
+			call it now. */
+			#if( ipconfigUSE_CALLBACKS == 1 )
+			{
+				if( ipconfigIS_VALID_PROG_ADDRESS( pxSocket->u.xTCP.pxHandleSent ) )
+				{
+					pxSocket->u.xTCP.pxHandleSent( pxSocket, ulCount );
+				}
+			}
+			#endif /* ipconfigUSE_CALLBACKS == 1  */
+		}
+	}
+
+#endif	/* ( ipconfigUSE_TCP_WIN != 0 ) */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_WIN != 0 )
+
+	static uint8_t prvWinScaleFactor( const FreeRTOS_Socket_t *pxSocket )
+	{
+	size_t uxWinSize;
+	uint8_t ucFactor;
+
+		/* 'xTCP.uxRxWinSize' is the size of the reception window in units of MSS. */
+		uxWinSize = pxSocket->u.xTCP.uxRxWinSize * ( size_t ) pxSocket->u.xTCP.usInitMSS;
+		ucFactor = 0U;
+		while( uxWinSize > 0xffffUL )
+		{
+			/* Divide by two and increase the binary factor by 1. */
+			uxWinSize >>= 1;
+			ucFactor++;
+		}
+
+		FreeRTOS_debug_printf( ( "prvWinScaleFactor: uxRxWinSize %u MSS %u Factor %u\n",
+			( unsigned ) pxSocket->u.xTCP.uxRxWinSize,
+			( unsigned ) pxSocket->u.xTCP.usInitMSS,
+			ucFactor ) );
+
+		return ucFactor;
+	}
+
+#endif
+/*-----------------------------------------------------------*/
+
+/*
+ * When opening a TCP connection, while SYN's are being sent, the  parties may
+ * communicate what MSS (Maximum Segment Size) they intend to use.   MSS is the
+ * nett size of the payload, always smaller than MTU.
+*/
+static UBaseType_t prvSetSynAckOptions( FreeRTOS_Socket_t *pxSocket, TCPHeader_t * pxTCPHeader )
+{
+uint16_t usMSS = pxSocket->u.xTCP.usInitMSS;
+UBaseType_t uxOptionsLength;
+
+	/* We send out the TCP Maximum Segment Size option with our SYN[+ACK]. */
+
+	pxTCPHeader->ucOptdata[ 0 ] = ( uint8_t ) tcpTCP_OPT_MSS;
+	pxTCPHeader->ucOptdata[ 1 ] = ( uint8_t ) tcpTCP_OPT_MSS_LEN;
+	pxTCPHeader->ucOptdata[ 2 ] = ( uint8_t ) ( usMSS >> 8 );
+	pxTCPHeader->ucOptdata[ 3 ] = ( uint8_t ) ( usMSS & 0xffU );
+
+	#if( ipconfigUSE_TCP_WIN != 0 )
+	{
+		pxSocket->u.xTCP.ucMyWinScaleFactor = prvWinScaleFactor( pxSocket );
+
+		pxTCPHeader->ucOptdata[ 4 ] = tcpTCP_OPT_NOOP;
+		pxTCPHeader->ucOptdata[ 5 ] = ( uint8_t ) ( tcpTCP_OPT_WSOPT );
+		pxTCPHeader->ucOptdata[ 6 ] = ( uint8_t ) ( tcpTCP_OPT_WSOPT_LEN );
+		pxTCPHeader->ucOptdata[ 7 ] = ( uint8_t ) pxSocket->u.xTCP.ucMyWinScaleFactor;
+		uxOptionsLength = 8U;
+	}
+	#else
+	{
+		uxOptionsLength = 4U;
+	}
+	#endif
+
+	#if( ipconfigUSE_TCP_WIN != 0 )
+	{
+		pxTCPHeader->ucOptdata[ uxOptionsLength      ] = tcpTCP_OPT_NOOP;
+		pxTCPHeader->ucOptdata[ uxOptionsLength + 1U ] = tcpTCP_OPT_NOOP;
+		pxTCPHeader->ucOptdata[ uxOptionsLength + 2U ] = tcpTCP_OPT_SACK_P;	/* 4: Sack-Permitted Option. */
+		pxTCPHeader->ucOptdata[ uxOptionsLength + 3U ] = 2U;	/* 2: length of this option. */
+		uxOptionsLength += 4U;
+
+	}
+	#endif	/* ipconfigUSE_TCP_WIN == 0 */
+
+	#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+	{
+	uint8_t ucCookie[ tcpFASTOPEN_COOKIE_LENGTH ];
+	const uint8_t *pucCookie = NULL;
+	BaseType_t xAddOption = pdFALSE;
+
+		if( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eCONNECT_SYN )
+		{
+			/* A client shows the server's cookie, or asks for one. */
+			if( pxSocket->u.xTCP.bits.bFastOpen != pdFALSE_UNSIGNED )
+			{
+				pucCookie = pucTCPFastOpenCacheLookup( pxSocket->u.xTCP.ulRemoteIP );
+				xAddOption = pdTRUE;
+			}
+		}
+		else if( pxSocket->u.xTCP.bits.bFastOpenCookie != pdFALSE_UNSIGNED )
+		{
+			/* A server hands out a cookie in its SYN+ACK. */
+			prvTCPFastOpenCookie( pxSocket->u.xTCP.ulRemoteIP, ucCookie );
+			pucCookie = ucCookie;
+			xAddOption = pdTRUE;
+		}
+		else
+		{
+			/* No Fast Open option. */
+		}
+
+		if( xAddOption != pdFALSE )
+		{
+			pxTCPHeader->ucOptdata[ uxOptionsLength      ] = tcpTCP_OPT_NOOP;
+			pxTCPHeader->ucOptdata[ uxOptionsLength + 1U ] = tcpTCP_OPT_NOOP;
+			pxTCPHeader->ucOptdata[ uxOptionsLength + 2U ] = ( uint8_t ) tcpTCP_OPT_FASTOPEN;
+			if( pucCookie != NULL )
+			{
+				pxTCPHeader->ucOptdata[ uxOptionsLength + 3U ] = ( uint8_t ) tcpTCP_OPT_FASTOPEN_LEN;
+				( void ) memcpy( &( pxTCPHeader->ucOptdata[ uxOptionsLength + 4U ] ), pucCookie, tcpFASTOPEN_COOKIE_LENGTH );
+				uxOptionsLength += 4U + tcpFASTOPEN_COOKIE_LENGTH;
+			}
+			else
+			{
+				pxTCPHeader->ucOptdata[ uxOptionsLength + 3U ] = ( uint8_t ) tcpTCP_OPT_FASTOPEN_REQ_LEN;
+				uxOptionsLength += 4U;
+			}
+		}
+	}
+	#endif /* ipconfigUSE_TCP_FAST_OPEN */
+
+	return uxOptionsLength; /* bytes, not words. */
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+
+	static void prvTCPFastOpenCookie( uint32_t ulRemoteIP, uint8_t *pucCookie )
+	{
+	uint32_t ulHash = ulRemoteIP;
+	BaseType_t xIndex;
+	BaseType_t xByte;
+
+		if( ( ulFastOpenSecret[ 0 ] | ulFastOpenSecret[ 1 ] ) == 0U )
+		{
+			( void ) xApplicationGetRandomNumber( &( ulFastOpenSecret[ 0 ] ) );
+			( void ) xApplicationGetRandomNumber( &( ulFastOpenSecret[ 1 ] ) );
+		}
+
+		/* Two rounds of a 32-bit mixing function, each keyed with one half of
+		the secret.  This is a keyed hash, not a cryptographic MAC: it keeps
+		hosts from making up cookies for addresses that they can not receive
+		on, which is what RFC 7413 asks for. */
+		for( xIndex = 0; xIndex < 2; xIndex++ )
+		{
+			ulHash ^= ulFastOpenSecret[ xIndex ];
+			ulHash ^= ulHash >> 16;
+			ulHash *= 0x85ebca6bUL;
+			ulHash ^= ulHash >> 13;
+			ulHash *= 0xc2b2ae35UL;
+			ulHash ^= ulHash >> 16;
+
+			for( xByte = 0; xByte < 4; xByte++ )
+			{
+				pucCookie[ ( 4 * xIndex ) + xByte ] = ( uint8_t ) ( ulHash >> ( 24 - ( 8 * xByte ) ) );
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvReadFastOpenOption( FreeRTOS_Socket_t * const pxSocket, const uint8_t * const pucPtr, uint8_t ucLen )
+	{
+	uint8_t ucCookie[ tcpFASTOPEN_COOKIE_LENGTH ];
+	uint8_t ucState = pxSocket->u.xTCP.ucTCPState;
+
+		if( pxSocket->u.xTCP.bits.bFastOpen == pdFALSE_UNSIGNED )
+		{
+			/* Fast Open was not enabled for this socket, ignore the option. */
+		}
+		else if( ( ucState == ( uint8_t ) eSYN_FIRST ) || ( ucState == ( uint8_t ) eSYN_RECEIVED ) )
+		{
+			/* A client asks for a cookie, or shows one.  Unless the cookie is
+			valid, a new one will be sent in the SYN+ACK. */
+			pxSocket->u.xTCP.bits.bFastOpenValid = pdFALSE_UNSIGNED;
+			pxSocket->u.xTCP.bits.bFastOpenCookie = pdTRUE_UNSIGNED;
+
+			if( ucLen == ( uint8_t ) tcpTCP_OPT_FASTOPEN_LEN )
+			{
+				prvTCPFastOpenCookie( pxSocket->u.xTCP.ulRemoteIP, ucCookie );
+
+				if( memcmp( ucCookie, &( pucPtr[ 2 ] ), sizeof( ucCookie ) ) == 0 )
+				{
+					pxSocket->u.xTCP.bits.bFastOpenValid = pdTRUE_UNSIGNED;
+					pxSocket->u.xTCP.bits.bFastOpenCookie = pdFALSE_UNSIGNED;
+				}
+			}
+		}
+		else if( ( ucState == ( uint8_t ) eCONNECT_SYN ) && ( ucLen == ( uint8_t ) tcpTCP_OPT_FASTOPEN_LEN ) )
+		{
+			/* The server has handed out a cookie, to be used in the next
+			connection. */
+			prvTCPFastOpenCacheStore( pxSocket->u.xTCP.ulRemoteIP, &( pucPtr[ 2 ] ) );
+		}
+		else
+		{
+			/* A cookie of an unsupported length. */
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static const uint8_t *pucTCPFastOpenCacheLookup( uint32_t ulRemoteIP )
+	{
+	const uint8_t *pucCookie = NULL;
+	BaseType_t xIndex;
+
+		for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigTCP_FAST_OPEN_CACHE_SIZE; xIndex++ )
+		{
+			if( xFastOpenCache[ xIndex ].ulIPAddress == ulRemoteIP )
+			{
+				pucCookie = xFastOpenCache[ xIndex ].ucCookie;
+				break;
+			}
+		}
+
+		return pucCookie;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPFastOpenCacheStore( uint32_t ulRemoteIP, const uint8_t *pucCookie )
+	{
+	BaseType_t xIndex;
+	BaseType_t xFound = -1;
+
+		for( xIndex = 0; xIndex < ( BaseType_t ) ipconfigTCP_FAST_OPEN_CACHE_SIZE; xIndex++ )
+		{
+			if( xFastOpenCache[ xIndex ].ulIPAddress == ulRemoteIP )
+			{
+				xFound = xIndex;
+				break;
+			}
+		}
+
+		if( xFound < 0 )
+		{
+			/* A new server: replace the entries in a round-robin way. */
+			xFound = ( BaseType_t ) uxFastOpenCacheNext;
+			uxFastOpenCacheNext = ( uxFastOpenCacheNext + 1U ) % ( UBaseType_t ) ipconfigTCP_FAST_OPEN_CACHE_SIZE;
+			xFastOpenCache[ xFound ].ulIPAddress = ulRemoteIP;
+		}
+
+		( void ) memcpy( xFastOpenCache[ xFound ].ucCookie, pucCookie, tcpFASTOPEN_COOKIE_LENGTH );
+	}
+	/*-----------------------------------------------------------*/
+
+	static int32_t prvTCPFastOpenSendSyn( FreeRTOS_Socket_t *pxSocket, UBaseType_t uxOptionsLength )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer = NULL;
+	const size_t uxHeaderLength = uxIPHeaderSizeSocket( pxSocket ) + ipSIZE_OF_TCP_HEADER + uxOptionsLength;
+	int32_t lDataLength = 0;
+
+		if( ( pxSocket->u.xTCP.txStream != NULL ) &&
+			( pucTCPFastOpenCacheLookup( pxSocket->u.xTCP.ulRemoteIP ) != NULL ) )
+		{
+			/* The server knows this client: send as much as fits in a single
+			segment along with the SYN.  The data stays in the stream until
+			the SYN+ACK acknowledges it. */
+			lDataLength = ( int32_t ) FreeRTOS_min_uint32( ( uint32_t ) uxStreamBufferGetSize( pxSocket->u.xTCP.txStream ),
+														   ( uint32_t ) pxSocket->u.xTCP.usCurMSS - ( uint32_t ) uxOptionsLength );
+		}
+
+		if( lDataLength > 0 )
+		{
+			pxNetworkBuffer = prvTCPBufferResize( pxSocket, NULL, lDataLength, uxOptionsLength );
+		}
+
+		if( pxNetworkBuffer != NULL )
+		{
+			( void ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, 0U,
+										&( pxNetworkBuffer->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER + uxHeaderLength ] ),
+										( size_t ) lDataLength, pdTRUE );
+			prvTCPReturnPacket( pxSocket, pxNetworkBuffer, ( uint32_t ) ( uxHeaderLength + ( size_t ) lDataLength ), pdTRUE );
+		}
+		else
+		{
+			/* No cookie, no data, or no network buffer: a plain SYN. */
+			lDataLength = 0;
+			prvTCPReturnPacket( pxSocket, NULL, ( uint32_t ) uxHeaderLength, pdFALSE );
+		}
+
+		pxSocket->u.xTCP.usFastOpenLength = ( uint16_t ) lDataLength;
+
+		return lDataLength;
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvTCPFastOpenAccept( FreeRTOS_Socket_t *pxSocket, const uint8_t *pucRecvData,
+		uint32_t ulSequenceNumber, uint32_t ulReceiveLength )
+	{
+	TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
+	uint32_t ulSpace;
+	int32_t lOffset;
+	BaseType_t xResult = pdFALSE;
+
+		#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+		{
+			vTCPRxStreamReserve( pxSocket, 0U, ( size_t ) ulReceiveLength );
+		}
+		#endif /* ipconfigTCP_ELASTIC_STREAMS */
+
+		ulSpace = ( uint32_t ) uxTCPRxSpace( pxSocket, pdFALSE );
+		lOffset = lTCPWindowRxCheck( pxTCPWindow, ulSequenceNumber, ulReceiveLength, ulSpace );
+
+		if( lOffset == 0 )
+		{
+			if( lTCPAddRxdata( pxSocket, 0U, pucRecvData, ulReceiveLength ) == ( int32_t ) ulReceiveLength )
+			{
+				/* The SYN+ACK will acknowledge the data.  The connection
+				is established right now, so that accept() returns it, and
+				the application can answer before the final ACK arrives. */
+				pxTCPWindow->usPeerPortNumber = pxSocket->u.xTCP.usRemotePort;
+				pxTCPWindow->usOurPortNumber = pxSocket->usLocalPort;
+
+				#if( ipconfigUSE_TCP_WIN != 0 )
+				{
+					if( pxSocket->u.xTCP.bits.bWinScaling == pdFALSE_UNSIGNED )
+					{
+						pxSocket->u.xTCP.ucMyWinScaleFactor = 0;
+						pxSocket->u.xTCP.ucPeerWinScaleFactor = 0;
+					}
+				}
+				#endif /* ipconfigUSE_TCP_WIN */
+
+				pxSocket->u.xTCP.bits.bFastOpenSynAck = pdTRUE_UNSIGNED;
+				vTCPStateChange( pxSocket, eESTABLISHED );
+				xResult = pdTRUE;
+			}
+			else
+			{
+				/* The data could not be stored, do not acknowledge it. */
+				pxTCPWindow->rx.ulCurrentSequenceNumber = ulSequenceNumber;
+			}
+		}
+
+		return xResult;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPFastOpenRepeatSynAck( FreeRTOS_Socket_t *pxSocket, NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	ProtocolHeaders_t *pxProtocolHeaders = ipPOINTER_CAST( ProtocolHeaders_t *,
+		&( pxNetworkBuffer->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER + xIPHeaderSize( pxNetworkBuffer ) ] ) );
+	TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
+	uint32_t ulOurSequenceNumber = pxTCPWindow->ulOurSequenceNumber;
+	UBaseType_t uxOptionsLength;
+	#if( ipconfigUSE_TCP_WIN != 0 )
+		uint8_t ucMyWinScaleFactor = pxSocket->u.xTCP.ucMyWinScaleFactor;
+	#endif
+
+		/* The received SYN is turned into the SYN+ACK.  It carries the
+		initial sequence number, and acknowledges the data received. */
+		uxOptionsLength = prvSetSynAckOptions( pxSocket, &( pxProtocolHeaders->xTCPHeader ) );
+		pxProtocolHeaders->xTCPHeader.ucTCPFlags = ( uint8_t ) tcpTCP_FLAG_SYN | ( uint8_t ) tcpTCP_FLAG_ACK;
+		pxProtocolHeaders->xTCPHeader.ucTCPOffset = ( uint8_t )( ( ipSIZE_OF_TCP_HEADER + uxOptionsLength ) << 2 );
+
+		pxTCPWindow->ulOurSequenceNumber = pxTCPWindow->tx.ulFirstSequenceNumber;
+		prvTCPReturnPacket( pxSocket, pxNetworkBuffer, ( uint32_t ) ( uxIPHeaderSizeSocket( pxSocket ) + ipSIZE_OF_TCP_HEADER + uxOptionsLength ), pdFALSE );
+		pxTCPWindow->ulOurSequenceNumber = ulOurSequenceNumber;
+
+		#if( ipconfigUSE_TCP_WIN != 0 )
+		{
+			/* prvSetSynAckOptions() has calculated the factor again. */
+			pxSocket->u.xTCP.ucMyWinScaleFactor = ucMyWinScaleFactor;
+		}
+		#endif
+	}
+
+#endif /* ipconfigUSE_TCP_FAST_OPEN */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_ECN == 1 )
+
+	static void prvTCPEcnReceive( FreeRTOS_Socket_t *pxSocket, const NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	const IPHeader_t *pxIPHeader = ipPOINTER_CAST( const IPHeader_t *, &( pxNetworkBuffer->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER ] ) );
+	const ProtocolHeaders_t *pxProtocolHeaders = ipPOINTER_CAST( const ProtocolHeaders_t *,
+		&( pxNetworkBuffer->pucEthernetBuffer[ ipSIZE_OF_ETH_HEADER + xIPHeaderSize( pxNetworkBuffer ) ] ) );
+	uint8_t ucTCPFlags = pxProtocolHeaders->xTCPHeader.ucTCPFlags;
+	uint8_t ucEcnFlags = ucTCPFlags & ( uint8_t ) ( tcpTCP_FLAG_ECN | tcpTCP_FLAG_CWR );
+
+		if( ( ucTCPFlags & tcpTCP_FLAG_SYN ) != 0U )
+		{
+			if( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eSYN_FIRST )
 			{
-				if( ( pxSocket->xSelectBits & ( EventBits_t ) eSELECT_WRITE ) != 0U )
+				/* Server: a client asks for ECN by setting both ECE and CWR
+				in its SYN. */
+				if( ucEcnFlags == ( uint8_t ) ( tcpTCP_FLAG_ECN | tcpTCP_FLAG_CWR ) )
 				{
-					/* The field 'xEventBits' is used to store regular socket events
-					 * (at most 8), as well as 'select events', which will be left-shifted.
-					 */
-					pxSocket->xEventBits |= ( ( EventBits_t ) eSELECT_WRITE ) << SOCKET_EVENT_BIT_COUNT;
+					pxSocket->u.xTCP.bits.bEcnOk = pdTRUE_UNSIGNED;
 				}
 			}
-			#endif
+			else if( ( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eCONNECT_SYN ) && ( ( ucTCPFlags & tcpTCP_FLAG_ACK ) != 0U ) )
+			{
+				/* Client: the server agrees by setting ECE only in its
+				SYN+ACK. */
+				pxSocket->u.xTCP.bits.bEcnOk = ( ucEcnFlags == tcpTCP_FLAG_ECN ) ? pdTRUE_UNSIGNED : pdFALSE_UNSIGNED;
+			}
+			else
+			{
+				/* A repeated SYN, ECN was negotiated already. */
+			}
+		}
+		else if( pxSocket->u.xTCP.bits.bEcnOk != pdFALSE_UNSIGNED )
+		{
+			/* The peer has reduced its window, stop echoing, unless this
+			segment carries a new mark. */
+			if( ( ucTCPFlags & tcpTCP_FLAG_CWR ) != 0U )
+			{
+				pxSocket->u.xTCP.bits.bEcnEcho = pdFALSE_UNSIGNED;
+			}
 
-			/* In case the socket owner has installed an OnSent handler,
-			call it now. */
-			#if( ipconfigUSE_CALLBACKS == 1 )
+			if( ( pxIPHeader->ucDifferentiatedServicesCode & tcpECN_MASK ) == tcpECN_CE )
 			{
-				if( ipconfigIS_VALID_PROG_ADDRESS( pxSocket->u.xTCP.pxHandleSent ) )
+				pxSocket->u.xTCP.bits.bEcnEcho = pdTRUE_UNSIGNED;
+			}
+
+			if( ( ( ucTCPFlags & tcpTCP_FLAG_ECN ) != 0U ) && ( ( ucTCPFlags & tcpTCP_FLAG_ACK ) != 0U ) )
+			{
+				if( xTCPWindowTxCongestion( &( pxSocket->u.xTCP.xTCPWindow ) ) != pdFALSE )
 				{
-					pxSocket->u.xTCP.pxHandleSent( pxSocket, ulCount );
+					pxSocket->u.xTCP.bits.bEcnCwr = pdTRUE_UNSIGNED;
 				}
 			}
-			#endif /* ipconfigUSE_CALLBACKS == 1  */
+		}
+		else
+		{
+			/* ECN is not used on this connection. */
 		}
 	}
+	/*-----------------------------------------------------------*/
 
-#endif	/* ( ipconfigUSE_TCP_WIN != 0 ) */
-/*-----------------------------------------------------------*/
-
-#if( ipconfigUSE_TCP_WIN != 0 )
-
-	static uint8_t prvWinScaleFactor( const FreeRTOS_Socket_t *pxSocket )
+	static void prvTCPEcnSend( FreeRTOS_Socket_t *pxSocket, TCPPacket_t *pxTCPPacket, uint32_t ulLen )
 	{
-	size_t uxWinSize;
-	uint8_t ucFactor;
+	uint8_t ucTCPFlags = ( uint8_t ) ( pxTCPPacket->xTCPHeader.ucTCPFlags & ( uint8_t ) ~( tcpTCP_FLAG_ECN | tcpTCP_FLAG_CWR ) );
+	uint8_t ucECN = 0U;
+	uint32_t ulHeaderLength = ipSIZE_OF_IPv4_HEADER + ( ( uint32_t ) ( pxTCPPacket->xTCPHeader.ucTCPOffset >> 4 ) << 2 );
 
-		/* 'xTCP.uxRxWinSize' is the size of the reception window in units of MSS. */
-		uxWinSize = pxSocket->u.xTCP.uxRxWinSize * ( size_t ) pxSocket->u.xTCP.usInitMSS;
-		ucFactor = 0U;
-		while( uxWinSize > 0xffffUL )
+		/* The packet may be a received packet that is re-used, the flags of
+		the peer are cleared first. */
+		if( ( ucTCPFlags & tcpTCP_FLAG_SYN ) != 0U )
 		{
-			/* Divide by two and increase the binary factor by 1. */
-			uxWinSize >>= 1;
-			ucFactor++;
+			/* A SYN asks for ECN with ECE and CWR, a SYN+ACK agrees with ECE
+			only.  Segments with SYN are never sent as ECN-capable. */
+			if( ( ucTCPFlags & tcpTCP_FLAG_ACK ) == 0U )
+			{
+				ucTCPFlags |= ( uint8_t ) ( tcpTCP_FLAG_ECN | tcpTCP_FLAG_CWR );
+			}
+			else if( pxSocket->u.xTCP.bits.bEcnOk != pdFALSE_UNSIGNED )
+			{
+				ucTCPFlags |= tcpTCP_FLAG_ECN;
+			}
+			else
+			{
+				/* The client did not ask for ECN. */
+			}
 		}
+		else if( pxSocket->u.xTCP.bits.bEcnOk != pdFALSE_UNSIGNED )
+		{
+			if( pxSocket->u.xTCP.bits.bEcnEcho != pdFALSE_UNSIGNED )
+			{
+				ucTCPFlags |= tcpTCP_FLAG_ECN;
+			}
 
-		FreeRTOS_debug_printf( ( "prvWinScaleFactor: uxRxWinSize %u MSS %u Factor %u\n",
-			( unsigned ) pxSocket->u.xTCP.uxRxWinSize,
-			( unsigned ) pxSocket->u.xTCP.usInitMSS,
-			ucFactor ) );
-
-		return ucFactor;
-	}
-
-#endif
-/*-----------------------------------------------------------*/
-
-/*
- * When opening a TCP connection, while SYN's are being sent, the  parties may
- * communicate what MSS (Maximum Segment Size) they intend to use.   MSS is the
- * nett size of the payload, always smaller than MTU.
-*/
-static UBaseType_t prvSetSynAckOptions( FreeRTOS_Socket_t *pxSocket, TCPHeader_t * pxTCPHeader )
-{
-uint16_t usMSS = pxSocket->u.xTCP.usInitMSS;
-UBaseType_t uxOptionsLength;
-
-	/* We send out the TCP Maximum Segment Size option with our SYN[+ACK]. */
-
-	pxTCPHeader->ucOptdata[ 0 ] = ( uint8_t ) tcpTCP_OPT_MSS;
-	pxTCPHeader->ucOptdata[ 1 ] = ( uint8_t ) tcpTCP_OPT_MSS_LEN;
-	pxTCPHeader->ucOptdata[ 2 ] = ( uint8_t ) ( usMSS >> 8 );
-	pxTCPHeader->ucOptdata[ 3 ] = ( uint8_t ) ( usMSS & 0xffU );
+			/* Only new data is ECN-capable: pure ACK's and retransmissions
+			are not. */
+			if( ( ulLen > ulHeaderLength ) &&
+				( ( ucTCPFlags & tcpTCP_FLAG_RST ) == 0U ) &&
+				( pxSocket->u.xTCP.xTCPWindow.u.bits.bTxRetransmit == pdFALSE_UNSIGNED ) )
+			{
+				ucECN = tcpECN_ECT0;
 
-	#if( ipconfigUSE_TCP_WIN != 0 )
-	{
-		pxSocket->u.xTCP.ucMyWinScaleFactor = prvWinScaleFactor( pxSocket );
+				if( pxSocket->u.xTCP.bits.bEcnCwr != pdFALSE_UNSIGNED )
+				{
+					pxSocket->u.xTCP.bits.bEcnCwr = pdFALSE_UNSIGNED;
+					ucTCPFlags |= tcpTCP_FLAG_CWR;
+				}
+			}
+		}
+		else
+		{
+			/* ECN is not used on this connection. */
+		}
 
-		pxTCPHeader->ucOptdata[ 4 ] = tcpTCP_OPT_NOOP;
-		pxTCPHeader->ucOptdata[ 5 ] = ( uint8_t ) ( tcpTCP_OPT_WSOPT );
-		pxTCPHeader->ucOptdata[ 6 ] = ( uint8_t ) ( tcpTCP_OPT_WSOPT_LEN );
-		pxTCPHeader->ucOptdata[ 7 ] = ( uint8_t ) pxSocket->u.xTCP.ucMyWinScaleFactor;
-		uxOptionsLength = 8U;
-	}
-	#else
-	{
-		uxOptionsLength = 4U;
+		pxTCPPacket->xTCPHeader.ucTCPFlags = ucTCPFlags;
+		pxTCPPacket->xIPHeader.ucDifferentiatedServicesCode =
+			( uint8_t ) ( ( pxTCPPacket->xIPHeader.ucDifferentiatedServicesCode & ( uint8_t ) ~tcpECN_MASK ) | ucECN );
 	}
-	#endif
-
-	#if( ipconfigUSE_TCP_WIN != 0 )
-	{
-		pxTCPHeader->ucOptdata[ uxOptionsLength      ] = tcpTCP_OPT_NOOP;
-		pxTCPHeader->ucOptdata[ uxOptionsLength + 1U ] = tcpTCP_OPT_NOOP;
-		pxTCPHeader->ucOptdata[ uxOptionsLength + 2U ] = tcpTCP_OPT_SACK_P;	/* 4: Sack-Permitted Option. */
-		pxTCPHeader->ucOptdata[ uxOptionsLength + 3U ] = 2U;	/* 2: length of this option. */
-		uxOptionsLength += 4U;
+	/*-----------------------------------------------------------*/
 
-	}
-	#endif	/* ipconfigUSE_TCP_WIN == 0 */
-	return uxOptionsLength; /* bytes, not words. */
-}
+#endif /* ipconfigUSE_TCP_ECN */
 
 /*
  * For anti-hanging protection and TCP keep-alive messages.  Called in two
@@ -1782,6 +2708,28 @@ int32_t lStreamPos;
 			lDataLen = ( int32_t ) ulTCPWindowTxGet( pxTCPWindow, pxSocket->u.xTCP.ulWindowSize, &lStreamPos );
 		}
 
+		#if( ipconfigUSE_PATH_MTU_DISCOVERY != 0 )
+		{
+			/* A full-size segment that keeps getting lost may be dropped by a
+			router whose ICMP messages do not arrive.  Lower the MSS and stop
+			setting DF, so that the path can fragment the packets. */
+			if( ( lDataLen >= ( int32_t ) pxSocket->u.xTCP.usCurMSS ) &&
+				( pxTCPWindow->ucTxTransmitCount >= tcpPATH_MTU_BLACK_HOLE_COUNT ) &&
+				( pxSocket->u.xTCP.bits.bNoDontFragment == pdFALSE_UNSIGNED ) )
+			{
+				FreeRTOS_debug_printf( ( "prvTCPPrepareSend: %lxip:%u black hole, mss %u, no DF\n",
+					pxSocket->u.xTCP.ulRemoteIP, pxSocket->u.xTCP.usRemotePort, pxSocket->u.xTCP.usCurMSS ) );
+
+				pxSocket->u.xTCP.bits.bNoDontFragment = pdTRUE_UNSIGNED;
+				if( pxSocket->u.xTCP.usCurMSS > ( uint16_t ) tcpREDUCED_MSS_THROUGH_INTERNET )
+				{
+					pxSocket->u.xTCP.usCurMSS = ( uint16_t ) tcpREDUCED_MSS_THROUGH_INTERNET;
+					pxTCPWindow->usMSS = ( uint16_t ) tcpREDUCED_MSS_THROUGH_INTERNET;
+				}
+			}
+		}
+		#endif /* ipconfigUSE_PATH_MTU_DISCOVERY */
+
 		if( lDataLen > 0 )
 		{
 			/* Check if the current network buffer is big enough, if not,
@@ -2023,6 +2971,12 @@ int32_t lCount, lLength;
 		if( lCount > 0 )
 		{
 			vStreamBufferMoveMid( pxSocket->u.xTCP.txStream, ( size_t ) lCount );
+
+			#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+			{
+				pxSocket->u.xTCP.xStreamLastUse = xTaskGetTickCount();
+			}
+			#endif
 		}
 	}
 }
@@ -2224,14 +3178,27 @@ BaseType_t xResult = 0;
 		ack (SACK) option to confirm it.  In that case, lTCPAddRxdata() will be
 		called later to store an out-of-order packet (in case lOffset is
 		negative). */
-		if ( pxSocket->u.xTCP.rxStream != NULL )
+		#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
 		{
-			ulSpace = ( uint32_t )uxStreamBufferGetSpace ( pxSocket->u.xTCP.rxStream );
+		int32_t lDistance = ( int32_t ) ( ulSequenceNumber - pxTCPWindow->rx.ulCurrentSequenceNumber );
+
+			/* Let the rxStream grow if the data would not fit in it. */
+			vTCPRxStreamReserve( pxSocket, ( lDistance > 0 ) ? ( size_t ) lDistance : 0U, ( size_t ) ulReceiveLength );
+
+			if( pxSocket->u.xTCP.rxStream != NULL )
+			{
+				ulSpace = ( uint32_t ) uxStreamBufferGetSpace( pxSocket->u.xTCP.rxStream );
+			}
+			else
+			{
+				ulSpace = 0U;
+			}
 		}
-		else
+		#else
 		{
-			ulSpace = ( uint32_t )pxSocket->u.xTCP.uxRxStreamSize;
+			ulSpace = ( uint32_t ) uxTCPRxSpace( pxSocket, pdFALSE );
 		}
+		#endif /* ipconfigTCP_ELASTIC_STREAMS */
 
 		lOffset = lTCPWindowRxCheck( pxTCPWindow, ulSequenceNumber, ulReceiveLength, ulSpace );
 
@@ -2351,6 +3318,9 @@ TCPWindow_t *pxTCPWindow = &pxSocket->u.xTCP.xTCPWindow;
 uint8_t ucTCPFlags = pxTCPHeader->ucTCPFlags;
 uint32_t ulSequenceNumber = FreeRTOS_ntohl( pxTCPHeader->ulSequenceNumber );
 BaseType_t xSendLength = 0;
+#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+	uint32_t ulFastOpenAcked = 0U;
+#endif
 
 	/* Either expect a ACK or a SYN+ACK. */
 	uint16_t usExpect = ( uint16_t ) tcpTCP_FLAG_ACK;
@@ -2359,6 +3329,16 @@ BaseType_t xSendLength = 0;
 		usExpect |= ( uint16_t ) tcpTCP_FLAG_SYN;
 	}
 
+	#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+	if( ( pxSocket->u.xTCP.ucTCPState == ( uint8_t ) eCONNECT_SYN ) &&
+		( pxSocket->u.xTCP.usFastOpenLength != 0U ) &&
+		( ( ucTCPFlags & tcpTCP_FLAG_SYN ) == 0U ) )
+	{
+		/* A server that accepted the data of the SYN may send its answer
+		before the SYN+ACK is seen.  Ignore it, it will be repeated. */
+	}
+	else
+	#endif /* ipconfigUSE_TCP_FAST_OPEN */
 	if( ipNUMERIC_CAST( uint16_t, ucTCPFlags & 0x17U ) != usExpect )
 	{
 		/* eSYN_RECEIVED: flags 0010 expected, not 0002. */
@@ -2398,6 +3378,25 @@ BaseType_t xSendLength = 0;
 			pxTCPWindow->rx.ulCurrentSequenceNumber = ulSequenceNumber + 1U;
 			pxTCPWindow->tx.ulCurrentSequenceNumber++; /* because we send a TCP_SYN [ | TCP_ACK ]; */
 			pxTCPWindow->ulNextTxSequenceNumber++;
+
+			#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+			if( pxSocket->u.xTCP.usFastOpenLength != 0U )
+			{
+				/* The SYN carried data.  If the server accepted it, the data
+				is acknowledged along with the SYN and can be removed from the
+				stream.  If not, it will be sent again as normal data. */
+				if( ( FreeRTOS_ntohl( pxTCPHeader->ulAckNr ) - pxTCPWindow->tx.ulCurrentSequenceNumber ) == ( uint32_t ) pxSocket->u.xTCP.usFastOpenLength )
+				{
+					ulFastOpenAcked = ( uint32_t ) pxSocket->u.xTCP.usFastOpenLength;
+					vStreamBufferMoveMid( pxSocket->u.xTCP.txStream, ( size_t ) ulFastOpenAcked );
+					( void ) uxStreamBufferGet( pxSocket->u.xTCP.txStream, 0U, NULL, ( size_t ) ulFastOpenAcked, pdFALSE );
+					pxTCPWindow->tx.ulCurrentSequenceNumber += ulFastOpenAcked;
+					pxTCPWindow->tx.ulHighestSequenceNumber += ulFastOpenAcked;
+					pxTCPWindow->ulNextTxSequenceNumber += ulFastOpenAcked;
+				}
+				pxSocket->u.xTCP.usFastOpenLength = 0U;
+			}
+			#endif /* ipconfigUSE_TCP_FAST_OPEN */
 		}
 		else if( ulReceiveLength == 0U )
 		{
@@ -2411,6 +3410,12 @@ BaseType_t xSendLength = 0;
 		/* The SYN+ACK has been confirmed, increase the next sequence number by
 		1. */
 		pxTCPWindow->ulOurSequenceNumber = pxTCPWindow->tx.ulFirstSequenceNumber + 1U;
+		#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+		{
+			/* The data sent along with the SYN has been confirmed as well. */
+			pxTCPWindow->ulOurSequenceNumber += ulFastOpenAcked;
+		}
+		#endif
 
 		#if( ipconfigUSE_TCP_WIN == 1 )
 		{
@@ -2783,6 +3788,9 @@ uint32_t ulSequenceNumber = FreeRTOS_ntohl (pxTCPHeader->ulSequenceNumber);
 UBaseType_t uxOptionsLength = 0U;
 uint8_t ucTCPFlags = pxTCPHeader->ucTCPFlags;
 TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
+#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+	BaseType_t xFastOpenSynAck = pdFALSE;
+#endif
 
 	/* First get the length and the position of the received data, if any.
 	pucRecvData will point to the first byte of the TCP payload. */
@@ -2875,6 +3883,19 @@ TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
 				pxTCPWindow->rx.ulCurrentSequenceNumber = ulSequenceNumber + 1UL;
 				pxTCPWindow->ulNextTxSequenceNumber     = pxTCPWindow->tx.ulFirstSequenceNumber + 1UL;
 				pxTCPWindow->tx.ulCurrentSequenceNumber = pxTCPWindow->tx.ulFirstSequenceNumber + 1UL; /* because we send a TCP_SYN. */
+
+				#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+				{
+					if( ( pxSocket->u.xTCP.bits.bFastOpenValid != pdFALSE_UNSIGNED ) && ( ulReceiveLength > 0U ) )
+					{
+						/* The client showed a valid cookie: accept the data
+						that follows the SYN. */
+						xFastOpenSynAck = prvTCPFastOpenAccept( pxSocket, pucRecvData, ulSequenceNumber + 1UL, ulReceiveLength );
+					}
+					pxSocket->u.xTCP.bits.bFastOpenValid = pdFALSE_UNSIGNED;
+					pxSocket->u.xTCP.bits.bFastOpenCookie = pdFALSE_UNSIGNED;
+				}
+				#endif /* ipconfigUSE_TCP_FAST_OPEN */
 			}
 			break;
 
@@ -2938,6 +3959,17 @@ TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
 		xSendLength = prvSendData( pxSocket, ppxNetworkBuffer, ulReceiveLength, xSendLength );
 	}
 
+	#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+	{
+		if( xFastOpenSynAck != pdFALSE )
+		{
+			/* The SYN+ACK has been sent with the initial sequence number, the
+			next packets follow the SYN. */
+			pxTCPWindow->ulOurSequenceNumber = pxTCPWindow->tx.ulFirstSequenceNumber + 1UL;
+		}
+	}
+	#endif /* ipconfigUSE_TCP_FAST_OPEN */
+
 	return xSendLength;
 }
 /*-----------------------------------------------------------*/
@@ -2991,6 +4023,18 @@ uint32_t ulMSS = ipconfigTCP_MSS;
 		ulMSS = FreeRTOS_min_uint32( ( uint32_t ) tcpREDUCED_MSS_THROUGH_INTERNET, ulMSS );
 	}
 
+	#if( ipconfigUSE_PATH_MTU_DISCOVERY != 0 )
+	{
+	uint16_t usMTU = prvPathMTUGet( FreeRTOS_htonl( pxSocket->u.xTCP.ulRemoteIP ) );
+
+		/* A smaller path MTU may have been learned for this peer. */
+		if( usMTU != 0U )
+		{
+			ulMSS = FreeRTOS_min_uint32( ( uint32_t ) usMTU - ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER ), ulMSS );
+		}
+	}
+	#endif /* ipconfigUSE_PATH_MTU_DISCOVERY */
+
 	FreeRTOS_debug_printf( ( "prvSocketSetMSS: %lu bytes for %lxip:%u\n", ulMSS, pxSocket->u.xTCP.ulRemoteIP, pxSocket->u.xTCP.usRemotePort ) );
 
 	pxSocket->u.xTCP.usInitMSS = ( uint16_t ) ulMSS;
@@ -2998,6 +4042,139 @@ uint32_t ulMSS = ipconfigTCP_MSS;
 }
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_PATH_MTU_DISCOVERY != 0 )
+
+	static uint16_t prvPathMTUGet( uint32_t ulIPAddress )
+	{
+	uint16_t usReturn = 0U;
+	BaseType_t x;
+
+		for( x = 0; x < ipconfigPATH_MTU_CACHE_ENTRIES; x++ )
+		{
+			if( ( xPathMTUCache[ x ].ulIPAddress == ulIPAddress ) && ( ulIPAddress != 0UL ) )
+			{
+				if( ( xTaskGetTickCount() - xPathMTUCache[ x ].xTimeLearned ) >= pdMS_TO_TICKS( ipconfigPATH_MTU_AGE_MS ) )
+				{
+					/* The path may have changed, try the full MTU again. */
+					xPathMTUCache[ x ].ulIPAddress = 0UL;
+				}
+				else
+				{
+					usReturn = xPathMTUCache[ x ].usMTU;
+				}
+				break;
+			}
+		}
+
+		return usReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvPathMTUSet( uint32_t ulIPAddress, uint16_t usMTU )
+	{
+	TickType_t xNow = xTaskGetTickCount();
+	BaseType_t x, xUseEntry = 0;
+
+		for( x = 0; x < ipconfigPATH_MTU_CACHE_ENTRIES; x++ )
+		{
+			if( xPathMTUCache[ x ].ulIPAddress == ulIPAddress )
+			{
+				xUseEntry = x;
+				break;
+			}
+
+			/* Otherwise replace an unused entry, or the oldest one. */
+			if( ( xPathMTUCache[ x ].ulIPAddress == 0UL ) ||
+				( ( xPathMTUCache[ xUseEntry ].ulIPAddress != 0UL ) &&
+				  ( ( xNow - xPathMTUCache[ x ].xTimeLearned ) > ( xNow - xPathMTUCache[ xUseEntry ].xTimeLearned ) ) ) )
+			{
+				xUseEntry = x;
+			}
+		}
+
+		xPathMTUCache[ xUseEntry ].ulIPAddress = ulIPAddress;
+		xPathMTUCache[ xUseEntry ].usMTU = usMTU;
+		xPathMTUCache[ xUseEntry ].xTimeLearned = xNow;
+	}
+	/*-----------------------------------------------------------*/
+
+	void vTCPFragmentationNeeded( const NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	const ICMPPacket_t *pxICMPPacket = ipPOINTER_CAST( const ICMPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+	const IPHeader_t *pxOriginalIP = NULL;
+	const TCPHeader_t *pxOriginalTCP = NULL;
+	FreeRTOS_Socket_t *pxSocket = NULL;
+	size_t uxIPHeaderLength;
+	uint32_t ulMTU = 0UL, ulMSS;
+	BaseType_t xUseMessage = pdFALSE;
+
+		/* The message carries the IP header of the packet that was too big,
+		followed by at least 8 bytes of its TCP header: the ports. */
+		if( pxNetworkBuffer->xDataLength >= ( sizeof( ICMPPacket_t ) + ipSIZE_OF_IPv4_HEADER + 8U ) )
+		{
+			pxOriginalIP = ipPOINTER_CAST( const IPHeader_t *, &( pxNetworkBuffer->pucEthernetBuffer[ sizeof( ICMPPacket_t ) ] ) );
+			uxIPHeaderLength = ( size_t ) ( ( pxOriginalIP->ucVersionHeaderLength & 0x0FU ) << 2 );
+
+			if( ( pxOriginalIP->ucProtocol == ( uint8_t ) ipPROTOCOL_TCP ) &&
+				( uxIPHeaderLength >= ipSIZE_OF_IPv4_HEADER ) &&
+				( pxNetworkBuffer->xDataLength >= ( sizeof( ICMPPacket_t ) + uxIPHeaderLength + 8U ) ) )
+			{
+				pxOriginalTCP = ipPOINTER_CAST( const TCPHeader_t *, &( pxNetworkBuffer->pucEthernetBuffer[ sizeof( ICMPPacket_t ) + uxIPHeaderLength ] ) );
+			}
+		}
+
+		if( pxOriginalTCP != NULL )
+		{
+			/* The next-hop MTU is stored in the second half of the ICMP 'rest of
+			header' field.  Old routers leave it zero: then take the size of the
+			packet minus 1, and let the next message lower it further. */
+			ulMTU = ( uint32_t ) FreeRTOS_ntohs( pxICMPPacket->xICMPHeader.usSequenceNumber );
+			if( ulMTU == 0UL )
+			{
+				ulMTU = ( uint32_t ) FreeRTOS_ntohs( pxOriginalIP->usLength ) - 1UL;
+			}
+			ulMTU = FreeRTOS_max_uint32( ulMTU, tcpMINIMUM_PATH_MTU );
+
+			/* The message can not make the MTU larger. */
+			if( ulMTU < ( uint32_t ) ipconfigNETWORK_MTU )
+			{
+				/* Only believe the message when it is about an existing
+				connection. */
+				pxSocket = pxTCPSocketLookup( 0UL,
+											  ( UBaseType_t ) FreeRTOS_ntohs( pxOriginalTCP->usSourcePort ),
+											  FreeRTOS_ntohl( pxOriginalIP->ulDestinationIPAddress ),
+											  ( UBaseType_t ) FreeRTOS_ntohs( pxOriginalTCP->usDestinationPort ) );
+
+				if( ( pxSocket != NULL ) &&
+					( pxSocket->u.xTCP.ucTCPState != ( uint8_t ) eTCP_LISTEN ) &&
+					( pxSocket->u.xTCP.ulRemoteIP == FreeRTOS_ntohl( pxOriginalIP->ulDestinationIPAddress ) ) )
+				{
+					xUseMessage = pdTRUE;
+				}
+			}
+		}
+
+		if( xUseMessage != pdFALSE )
+		{
+			prvPathMTUSet( pxOriginalIP->ulDestinationIPAddress, ( uint16_t ) ulMTU );
+
+			ulMSS = ulMTU - ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER );
+			if( ulMSS < ( uint32_t ) pxSocket->u.xTCP.usCurMSS )
+			{
+				FreeRTOS_debug_printf( ( "vTCPFragmentationNeeded: %lxip MTU %lu: mss %u => %lu\n",
+					pxSocket->u.xTCP.ulRemoteIP, ulMTU, pxSocket->u.xTCP.usCurMSS, ulMSS ) );
+
+				/* New segments will have the smaller size.  Segments that were
+				made already will be sent without the DF flag. */
+				pxSocket->u.xTCP.usCurMSS = ( uint16_t ) ulMSS;
+				pxSocket->u.xTCP.xTCPWindow.usMSS = ( uint16_t ) ulMSS;
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_PATH_MTU_DISCOVERY */
+
 /*
  *	FreeRTOS_TCP_IP has only 2 public functions, this is the second one:
  *	xProcessReceivedTCPPacket()
@@ -3152,11 +4329,33 @@ const IPHeader_t *pxIPHeader;
 				/* SYN flag while this socket is already connected. */
 				FreeRTOS_debug_printf( ( "TCP: SYN unexpected from %lxip:%u\n", ulRemoteIP, xRemotePort ) );
 
+				#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+				{
+					/* A Fast Open client that missed the SYN+ACK repeats its
+					SYN.  The packet must be big enough to hold the options. */
+					if( ( pxSocket->u.xTCP.bits.bFastOpenSynAck != pdFALSE_UNSIGNED ) &&
+						( pxNetworkBuffer->xDataLength >= ( ipSIZE_OF_ETH_HEADER + xIPHeaderSize( pxNetworkBuffer ) + ipSIZE_OF_TCP_HEADER + ipSIZE_TCP_OPTIONS ) ) )
+					{
+						prvTCPFastOpenRepeatSynAck( pxSocket, pxNetworkBuffer );
+					}
+				}
+				#endif /* ipconfigUSE_TCP_FAST_OPEN */
+
 				/* The packet cannot be handled. */
 				xResult = pdFAIL;
 			}
 			else
 			{
+				#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+				{
+					if( ( ucTCPFlags & tcpTCP_FLAG_ACK ) != 0U )
+					{
+						/* The SYN+ACK of a Fast Open connection has been seen. */
+						pxSocket->u.xTCP.bits.bFastOpenSynAck = pdFALSE_UNSIGNED;
+					}
+				}
+				#endif /* ipconfigUSE_TCP_FAST_OPEN */
+
 				/* Update the copy of the TCP header only (skipping eth and IP
 				headers).  It might be used later on, whenever data must be sent
 				to the peer. */
@@ -3203,6 +4402,12 @@ const IPHeader_t *pxIPHeader;
 		}
 		#endif /* ipconfigUSE_TCP_WIN */
 
+		#if( ipconfigUSE_TCP_ECN == 1 )
+		{
+			prvTCPEcnReceive( pxSocket, pxNetworkBuffer );
+		}
+		#endif
+
 		/* In prvTCPHandleState() the incoming messages will be handled
 		depending on the current state of the connection. */
 		if( prvTCPHandleState( pxSocket, &pxNetworkBuffer ) > 0 )
@@ -3312,6 +4517,12 @@ uint32_t ulInitialSequenceNumber;
 
 		pxReturn->u.xTCP.usRemotePort = FreeRTOS_htons( pxTCPPacket->xTCPHeader.usSourcePort );
 		pxReturn->u.xTCP.ulRemoteIP = FreeRTOS_htonl( pxTCPPacket->xIPHeader.ulSourceIPAddress );
+		#if( ipconfigMULTI_INTERFACE == 1 )
+		{
+			/* The connection stays on the end-point that received the SYN. */
+			pxReturn->u.xTCP.pxEndPoint = pxNetworkBuffer->pxEndPoint;
+		}
+		#endif /* ipconfigMULTI_INTERFACE */
 		pxReturn->u.xTCP.xTCPWindow.ulOurSequenceNumber = ulInitialSequenceNumber;
 
 		/* Here is the SYN action. */
@@ -3325,6 +4536,15 @@ uint32_t ulInitialSequenceNumber;
 		/* Make a copy of the header up to the TCP header.  It is needed later
 		on, whenever data must be sent to the peer. */
 		( void ) memcpy( pxReturn->u.xTCP.xPacket.u.ucLastPacket, pxNetworkBuffer->pucEthernetBuffer, sizeof( pxReturn->u.xTCP.xPacket.u.ucLastPacket ) );
+
+		/* The peer's MAC address is taken from the SYN packet. */
+		pxReturn->u.xTCP.ulARPGeneration = ulARPGeneration;
+
+		#if( ipconfigUSE_HEADER_TEMPLATES != 0 )
+		{
+			pxReturn->u.xTCP.ulTemplateSourceIP = 0UL;
+		}
+		#endif
 	}
 	return pxReturn;
 }
@@ -3341,6 +4561,11 @@ BaseType_t xResult;
 	pxNewSocket->xReceiveBlockTime = pxSocket->xReceiveBlockTime;
 	pxNewSocket->xSendBlockTime = pxSocket->xSendBlockTime;
 	pxNewSocket->ucSocketOptions = pxSocket->ucSocketOptions;
+	#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+	{
+		pxNewSocket->ucTypeOfService = pxSocket->ucTypeOfService;
+	}
+	#endif
 	pxNewSocket->u.xTCP.uxRxStreamSize = pxSocket->u.xTCP.uxRxStreamSize;
 	pxNewSocket->u.xTCP.uxTxStreamSize = pxSocket->u.xTCP.uxTxStreamSize;
 	pxNewSocket->u.xTCP.uxLittleSpace = pxSocket->u.xTCP.uxLittleSpace;
@@ -3348,6 +4573,18 @@ BaseType_t xResult;
 	pxNewSocket->u.xTCP.uxRxWinSize  = pxSocket->u.xTCP.uxRxWinSize;
 	pxNewSocket->u.xTCP.uxTxWinSize  = pxSocket->u.xTCP.uxTxWinSize;
 
+	#if( ipconfigTCP_PACING == 1 )
+	{
+		pxNewSocket->u.xTCP.ulPacingRate = pxSocket->u.xTCP.ulPacingRate;
+	}
+	#endif /* ipconfigTCP_PACING */
+
+	#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+	{
+		pxNewSocket->u.xTCP.bits.bFastOpen = pxSocket->u.xTCP.bits.bFastOpen;
+	}
+	#endif /* ipconfigUSE_TCP_FAST_OPEN */
+
 	#if( ipconfigSOCKET_HAS_USER_SEMAPHORE == 1 )
 	{
 		pxNewSocket->pxUserSemaphore = pxSocket->pxUserSemaphore;
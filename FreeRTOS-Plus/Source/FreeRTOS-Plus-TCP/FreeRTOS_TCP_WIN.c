@@ -59,14 +59,14 @@
 
 	#define xTCPWindowTxNew( pxWindow, ulSequenceNumber, lCount ) xTCPWindowNew( pxWindow, ulSequenceNumber, lCount, pdFALSE )
 
-	/* The code to send a single Selective ACK (SACK):
-	 * NOP (0x01), NOP (0x01), SACK (0x05), LEN (0x0a),
-	 * followed by a lower and a higher sequence number,
-	 * where LEN is 2 + 2*4 = 10 bytes. */
+	/* The code to start a Selective ACK (SACK) option:
+	 * NOP (0x01), NOP (0x01), SACK (0x05), LEN,
+	 * followed by a lower and a higher sequence number per block,
+	 * where LEN is 2 + 2*4 = 10 bytes for a single block. */
 	#if( ipconfigBYTE_ORDER == pdFREERTOS_BIG_ENDIAN )
-		#define OPTION_CODE_SINGLE_SACK		( 0x0101050aUL )
+		#define OPTION_CODE_SACK( ulBlocks )	( 0x01010500UL | ( 2UL + ( 8UL * ( ulBlocks ) ) ) )
 	#else
-		#define OPTION_CODE_SINGLE_SACK		( 0x0a050101UL )
+		#define OPTION_CODE_SACK( ulBlocks )	( 0x00050101UL | ( ( 2UL + ( 8UL * ( ulBlocks ) ) ) << 24 ) )
 	#endif
 
 	/* Normal retransmission:
@@ -83,6 +83,12 @@
 	 */
 	#define MAX_TRANSMIT_COUNT_USING_LARGE_WINDOW		( 4U )
 
+	/* Tail loss probe: when only one segment is outstanding, the peer may
+	delay its ACK, so the probe time-out is extended by this time.  The probe
+	time-out is never shorter than winTLP_MINIMUM_MS. */
+	#define winTLP_DELAYED_ACK_MS		40U
+	#define winTLP_MINIMUM_MS			10U
+
 #endif /* configUSE_TCP_WIN */
 /*-----------------------------------------------------------*/
 
@@ -108,6 +114,15 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 	static TCPSegment_t *xTCPWindowRxFind( const TCPWindow_t *pxWindow, uint32_t ulSequenceNumber );
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
+/*
+ * Prepare the SACK option that reports the out-of-order data stored in
+ * 'pxWindow->xRxSegments': at most ipconfigTCP_SACK_BLOCKS contiguous blocks,
+ * the one holding 'pxNewest' first, followed by the most recent arrivals.
+ */
+#if( ipconfigUSE_TCP_WIN == 1 )
+	static void prvTCPWindowRxSack( TCPWindow_t *pxWindow, const TCPSegment_t *pxNewest );
+#endif /* ipconfigUSE_TCP_WIN == 1 */
+
 /*
  * Allocate a new segment
  * The socket will borrow all segments from a common pool: 'xSegmentList',
@@ -176,13 +191,58 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
 /*
- * A higher Tx block has been acknowledged.  Now iterate through the xWaitQueue
- * to find a possible condition for a FAST retransmission.
+ * A higher Tx block has been acknowledged.  Use the SACK scoreboard to find
+ * all the segments in the xWaitQueue that qualify for a FAST retransmission.
  */
 #if( ipconfigUSE_TCP_WIN == 1 )
-	static uint32_t prvTCPWindowFastRetransmit( TCPWindow_t *pxWindow, uint32_t ulFirst );
+	static uint32_t prvTCPWindowFastRetransmit( TCPWindow_t *pxWindow );
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
+/*
+ * Time based loss detection.  RACK: outstanding segments that were sent
+ * before the most recently sent segment that has been acknowledged are
+ * retransmitted once they are older than that segment's RTT plus a reordering
+ * window.  TLP: when the flight has been silent for the probe time-out, the
+ * highest outstanding segment is retransmitted, so the peer's (S)ACK reveals
+ * losses at the tail of the flight.
+ */
+#if( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigUSE_TCP_RACK_TLP == 1 )
+	static void prvTCPWindowLossDetect( TCPWindow_t *pxWindow );
+#endif
+
+/*
+ * Returns the number of ms before prvTCPWindowLossDetect() may retransmit a
+ * segment, or ~0U when no segment is waiting.
+ */
+#if( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigUSE_TCP_RACK_TLP == 1 )
+	static uint32_t prvTCPWindowLossTimer( const TCPWindow_t *pxWindow );
+#endif
+
+/*
+ * Returns pdTRUE if the segment was sent before the segment that set the RACK
+ * time.
+ */
+#if( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigUSE_TCP_RACK_TLP == 1 )
+	static BaseType_t prvTCPWindowSentBeforeRack( const TCPWindow_t *pxWindow, const TCPSegment_t *pxSegment );
+#endif
+
+/*
+ * The probe time-out of TLP, and the RACK reordering window, in ms.
+ */
+#if( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigUSE_TCP_RACK_TLP == 1 )
+	static uint32_t prvTCPWindowProbeTimeout( const TCPWindow_t *pxWindow );
+	static uint32_t prvTCPWindowReorderWindow( const TCPWindow_t *pxWindow );
+#endif
+
+/*
+ * Data has been acknowledged: once the data that was outstanding at the last
+ * reduction of the Tx window has been acknowledged, let the window grow back
+ * by one MSS per round-trip.
+ */
+#if( ipconfigUSE_TCP_ECN == 1 )
+	static void prvTCPWindowCongestionAck( TCPWindow_t *pxWindow );
+#endif
+
 /*-----------------------------------------------------------*/
 
 /* TCP segment pool. */
@@ -677,6 +737,13 @@ const int32_t l500ms = 500;
 	/*Start with a timeout of 2 * 500 ms (1 sec). */
 	pxWindow->lSRTT = l500ms;
 
+	#if( ipconfigUSE_TCP_RACK_TLP == 1 )
+	{
+		pxWindow->lProbeSRTT = l500ms;
+		pxWindow->lRackRTT = -1;
+	}
+	#endif
+
 	/* Just for logging, to print relative sequence numbers. */
 	pxWindow->rx.ulFirstSequenceNumber = ulAckNumber;
 
@@ -790,6 +857,110 @@ const int32_t l500ms = 500;
 #endif /* ipconfgiUSE_TCP_WIN == 1 */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_WIN == 1 )
+
+	static void prvTCPWindowRxSack( TCPWindow_t *pxWindow, const TCPSegment_t *pxNewest )
+	{
+	const ListItem_t *pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &pxWindow->xRxSegments ) );
+	const ListItem_t *pxIterator = pxEnd->pxPrevious;
+	const ListItem_t *pxItem;
+	const TCPSegment_t *pxSegment = pxNewest;
+	const TCPSegment_t *pxFound;
+	uint32_t ulFirst[ ipconfigTCP_SACK_BLOCKS ], ulLast[ ipconfigTCP_SACK_BLOCKS ];
+	uint32_t ulBlocks = 0UL, ulIndex;
+	BaseType_t xCovered;
+
+		/* The segments are stored in xRxSegments in order of arrival, so
+		walking the list backward visits the most recent arrivals first
+		( RFC 2018 ). */
+		if( ( pxSegment == NULL ) && ( pxIterator != pxEnd ) )
+		{
+			pxSegment = ipPOINTER_CAST( const TCPSegment_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
+			pxIterator = pxIterator->pxPrevious;
+		}
+
+		while( ( pxSegment != NULL ) && ( ulBlocks < ( uint32_t ) ipconfigTCP_SACK_BLOCKS ) )
+		{
+			xCovered = pdFALSE;
+
+			for( ulIndex = 0UL; ulIndex < ulBlocks; ulIndex++ )
+			{
+				if( ( xSequenceGreaterThanOrEqual( pxSegment->ulSequenceNumber, ulFirst[ ulIndex ] ) != pdFALSE ) &&
+					( xSequenceLessThan( pxSegment->ulSequenceNumber, ulLast[ ulIndex ] ) != pdFALSE ) )
+				{
+					xCovered = pdTRUE;
+					break;
+				}
+			}
+
+			if( xCovered == pdFALSE )
+			{
+				/* Let the block describe the longest contiguous range of data,
+				in both directions. */
+				ulFirst[ ulBlocks ] = pxSegment->ulSequenceNumber;
+				ulLast[ ulBlocks ] = pxSegment->ulSequenceNumber + ( uint32_t ) pxSegment->lDataLength;
+
+				for( ;; )
+				{
+					pxFound = xTCPWindowRxFind( pxWindow, ulLast[ ulBlocks ] );
+					if( pxFound == NULL )
+					{
+						break;
+					}
+					ulLast[ ulBlocks ] += ( uint32_t ) pxFound->lDataLength;
+				}
+
+				pxItem = listGET_NEXT( pxEnd );
+				while( pxItem != pxEnd )
+				{
+					pxFound = ipPOINTER_CAST( const TCPSegment_t *, listGET_LIST_ITEM_OWNER( pxItem ) );
+					if( ( pxFound->lDataLength > 0 ) &&
+						( ( pxFound->ulSequenceNumber + ( uint32_t ) pxFound->lDataLength ) == ulFirst[ ulBlocks ] ) )
+					{
+						/* Found the preceding segment, start looking again. */
+						ulFirst[ ulBlocks ] = pxFound->ulSequenceNumber;
+						pxItem = listGET_NEXT( pxEnd );
+					}
+					else
+					{
+						pxItem = listGET_NEXT( pxItem );
+					}
+				}
+
+				/* Both sequence numbers in network byte order. */
+				pxWindow->ulOptionsData[ 1UL + ( 2UL * ulBlocks ) ] = FreeRTOS_htonl( ulFirst[ ulBlocks ] );
+				pxWindow->ulOptionsData[ 2UL + ( 2UL * ulBlocks ) ] = FreeRTOS_htonl( ulLast[ ulBlocks ] );
+				ulBlocks++;
+			}
+
+			if( pxIterator != pxEnd )
+			{
+				pxSegment = ipPOINTER_CAST( const TCPSegment_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
+				pxIterator = pxIterator->pxPrevious;
+			}
+			else
+			{
+				pxSegment = NULL;
+			}
+		}
+
+		if( ulBlocks != 0UL )
+		{
+			/* Code OPTION_CODE_SACK() already in network byte order. */
+			pxWindow->ulOptionsData[ 0 ] = OPTION_CODE_SACK( ulBlocks );
+
+			/* 4 bytes, plus 8 bytes for every block. */
+			pxWindow->ucOptionLength = ( uint8_t ) ( ( 1UL + ( 2UL * ulBlocks ) ) * sizeof( pxWindow->ulOptionsData[ 0 ] ) );
+		}
+		else
+		{
+			pxWindow->ucOptionLength = 0U;
+		}
+	}
+
+#endif /* ipconfgiUSE_TCP_WIN == 1 */
+/*-----------------------------------------------------------*/
+
 #if( ipconfigUSE_TCP_WIN == 1 )
 
 	int32_t lTCPWindowRxCheck( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber, uint32_t ulLength, uint32_t ulSpace )
@@ -883,6 +1054,13 @@ const int32_t l500ms = 500;
 
 				pxWindow->rx.ulCurrentSequenceNumber = ulCurrentSequenceNumber;
 
+				if( listCURRENT_LIST_LENGTH( &( pxWindow->xRxSegments ) ) != 0U )
+				{
+					/* There is still a gap: keep reporting the data beyond it
+					in the ACK of this packet. */
+					prvTCPWindowRxSack( pxWindow, NULL );
+				}
+
 				/* Packet was expected, may be passed directly to the socket
 				buffer or application.  Store the packet at offset 0. */
 				lReturn = 0;
@@ -922,47 +1100,10 @@ const int32_t l500ms = 500;
 			}
 			else
 			{
-				/* See if there is more data in a contiguous block to make the
-				SACK describe a longer range of data. */
-
 				/* TODO: SACK's may also be delayed for a short period
 				 * This is useful because subsequent packets will be SACK'd with
 				 * single one message
 				 */
-				for( ;; )
-				{
-					pxFound = xTCPWindowRxFind( pxWindow, ulLast );
-					if( pxFound == NULL )
-					{
-						break;
-					}
-					ulLast += ( uint32_t ) pxFound->lDataLength;
-				}
-
-				if( xTCPWindowLoggingLevel >= 1 )
-				{
-					FreeRTOS_debug_printf( ( "lTCPWindowRxCheck[%d,%d]: seqnr %u exp %u (dist %d) SACK to %u\n",
-						( int ) pxWindow->usPeerPortNumber,
-						( int ) pxWindow->usOurPortNumber,
-						( unsigned ) ulSequenceNumber - pxWindow->rx.ulFirstSequenceNumber,
-						( unsigned ) ulCurrentSequenceNumber - pxWindow->rx.ulFirstSequenceNumber,
-						( unsigned ) ( ulSequenceNumber - ulCurrentSequenceNumber ),	/* want this signed */
-						( unsigned ) ( ulLast - pxWindow->rx.ulFirstSequenceNumber ) ) );
-				}
-
-				/* Now prepare the SACK message.
-				Code OPTION_CODE_SINGLE_SACK already in network byte order. */
-				pxWindow->ulOptionsData[0] = OPTION_CODE_SINGLE_SACK;
-
-				/* First sequence number that we received. */
-				pxWindow->ulOptionsData[1] = FreeRTOS_htonl( ulSequenceNumber );
-
-				/* Last + 1 */
-				pxWindow->ulOptionsData[2] = FreeRTOS_htonl( ulLast );
-
-				/* Which make 12 (3*4) option bytes. */
-				pxWindow->ucOptionLength = ( uint8_t ) ( 3U * sizeof( pxWindow->ulOptionsData[ 0 ] ) );
-
 				pxFound = xTCPWindowRxFind( pxWindow, ulSequenceNumber );
 
 				if( pxFound != NULL )
@@ -980,7 +1121,6 @@ const int32_t l500ms = 500;
 					{
 						/* Can not send a SACK, because the segment cannot be
 						stored. */
-						pxWindow->ucOptionLength = 0U;
 
 						/* Needs to be stored but there is no segment
 						available. */
@@ -1001,6 +1141,25 @@ const int32_t l500ms = 500;
 						lReturn = ipNUMERIC_CAST( int32_t, ulSequenceNumber - ulCurrentSequenceNumber );
 					}
 				}
+
+				if( pxFound != NULL )
+				{
+					/* Now prepare the SACK message, the first block contains
+					this packet. */
+					prvTCPWindowRxSack( pxWindow, pxFound );
+
+					if( xTCPWindowLoggingLevel >= 1 )
+					{
+						FreeRTOS_debug_printf( ( "lTCPWindowRxCheck[%d,%d]: seqnr %u exp %u (dist %d) SACK to %u (%u blocks)\n",
+							( int ) pxWindow->usPeerPortNumber,
+							( int ) pxWindow->usOurPortNumber,
+							( unsigned ) ulSequenceNumber - pxWindow->rx.ulFirstSequenceNumber,
+							( unsigned ) ulCurrentSequenceNumber - pxWindow->rx.ulFirstSequenceNumber,
+							( unsigned ) ( ulSequenceNumber - ulCurrentSequenceNumber ),	/* want this signed */
+							( unsigned ) ( FreeRTOS_ntohl( pxWindow->ulOptionsData[ 2 ] ) - pxWindow->rx.ulFirstSequenceNumber ),
+							( unsigned ) ( ( pxWindow->ucOptionLength - 4U ) / 8U ) ) );
+					}
+				}
 			}
 		}
 
@@ -1275,6 +1434,14 @@ const int32_t l500ms = 500;
 				{
 					/* A segment must be sent after this amount of msecs */
 					*pulDelay = ulMaxAge - ulAge;
+
+					#if( ipconfigUSE_TCP_RACK_TLP == 1 )
+					{
+						/* A segment may be found lost, or a probe may be sent,
+						before the retransmission timer expires. */
+						*pulDelay = FreeRTOS_min_uint32( *pulDelay, prvTCPWindowLossTimer( pxWindow ) );
+					}
+					#endif
 				}
 
 				xReturn = pdTRUE;
@@ -1328,6 +1495,13 @@ const int32_t l500ms = 500;
 
 		Priority messages: segments with a resend need no check current sliding
 		window size. */
+		#if( ipconfigUSE_TCP_RACK_TLP == 1 )
+		{
+			/* Segments that are found lost are moved to the priority queue. */
+			prvTCPWindowLossDetect( pxWindow );
+		}
+		#endif
+
 		pxSegment = xTCPWindowGetHead( &( pxWindow->xPriorityQueue ) );
 		pxWindow->ulOurSequenceNumber = pxWindow->tx.ulHighestSequenceNumber;
 
@@ -1406,6 +1580,13 @@ const int32_t l500ms = 500;
 					number in our transmission window. */
 					pxWindow->tx.ulHighestSequenceNumber = pxSegment->ulSequenceNumber + ( ( uint32_t ) pxSegment->lDataLength );
 
+					#if( ipconfigUSE_TCP_RACK_TLP == 1 )
+					{
+						/* New data can be probed again. */
+						pxWindow->u.bits.bProbeSent = pdFALSE_UNSIGNED;
+					}
+					#endif
+
 					/* ...and more detailed logging */
 					if( ( xTCPWindowLoggingLevel >= 2 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) ) )
 					{
@@ -1454,6 +1635,19 @@ const int32_t l500ms = 500;
 			retransmissions. */
 			( pxSegment->u.bits.ucTransmitCount )++;
 
+			#if( ipconfigUSE_TCP_ECN == 1 )
+			{
+				/* Retransmissions are not sent as ECN-capable. */
+				pxWindow->u.bits.bTxRetransmit = ( pxSegment->u.bits.ucTransmitCount > 1U ) ? pdTRUE_UNSIGNED : pdFALSE_UNSIGNED;
+			}
+			#endif
+
+			#if( ipconfigUSE_PATH_MTU_DISCOVERY != 0 )
+			{
+				pxWindow->ucTxTransmitCount = pxSegment->u.bits.ucTransmitCount;
+			}
+			#endif
+
 			/* If there have been several retransmissions (4), decrease the
 			size of the transmission window to at most 2 times MSS. */
 			if( pxSegment->u.bits.ucTransmitCount == MAX_TRANSMIT_COUNT_USING_LARGE_WINDOW )
@@ -1472,6 +1666,13 @@ const int32_t l500ms = 500;
 			/* Clear the transmit timer. */
 			vTCPTimerSet( &( pxSegment->xTransmitTimer ) );
 
+			#if( ipconfigUSE_TCP_RACK_TLP == 1 )
+			{
+				/* The probe time-out starts again. */
+				pxWindow->ulProbeTime = pxSegment->xTransmitTimer.ulBorn;
+			}
+			#endif
+
 			pxWindow->ulOurSequenceNumber = pxSegment->ulSequenceNumber;
 
 			/* Inform the caller where to find the data within the queue. */
@@ -1569,6 +1770,27 @@ const int32_t l500ms = 500;
 				/* This segment is fully ACK'd, set the flag. */
 				pxSegment->u.bits.bAcked = pdTRUE;
 
+				#if( ipconfigUSE_TCP_RACK_TLP == 1 )
+				{
+					/* Remember the most recently sent segment that has been
+					acknowledged, segments sent before it may be lost. */
+					if( ( pxWindow->lRackRTT < 0 ) ||
+						( ( int32_t ) ( pxSegment->xTransmitTimer.ulBorn - pxWindow->ulRackXmitTime ) > 0 ) ||
+						( ( pxSegment->xTransmitTimer.ulBorn == pxWindow->ulRackXmitTime ) &&
+						  ( xSequenceGreaterThan( pxSegment->ulSequenceNumber + ulDataLength, pxWindow->ulRackEndSequence ) != pdFALSE ) ) )
+					{
+						pxWindow->ulRackXmitTime = pxSegment->xTransmitTimer.ulBorn;
+						pxWindow->ulRackEndSequence = pxSegment->ulSequenceNumber + ulDataLength;
+						pxWindow->lRackRTT = ( int32_t ) ulTimerGetAge( &( pxSegment->xTransmitTimer ) );
+					}
+
+					/* The peer is responding, the probe time-out starts
+					again. */
+					pxWindow->ulProbeTime = ( uint32_t ) xTaskGetTickCount();
+					pxWindow->u.bits.bProbeSent = pdFALSE_UNSIGNED;
+				}
+				#endif
+
 				/* Calculate the RTT only if the segment was sent-out for the
 				first time and if this is the last ACK'd segment in a range. */
 				if( ( pxSegment->u.bits.ucTransmitCount == 1U ) && ( ( pxSegment->ulSequenceNumber + ulDataLength ) == ulLast ) )
@@ -1586,6 +1808,20 @@ const int32_t l500ms = 500;
 						pxWindow->lSRTT = ( ( winSRTT_INCREMENT_NEW * mS ) + ( winSRTT_INCREMENT_CURRENT * pxWindow->lSRTT ) ) / ( winSRTT_INCREMENT_NEW + winSRTT_INCREMENT_CURRENT );
 					}
 
+					#if( ipconfigUSE_TCP_RACK_TLP == 1 )
+					{
+						/* The same average, without the minimum. */
+						if( pxWindow->lProbeSRTT >= mS )
+						{
+							pxWindow->lProbeSRTT = ( ( winSRTT_DECREMENT_NEW * mS ) + ( winSRTT_DECREMENT_CURRENT * pxWindow->lProbeSRTT ) ) / ( winSRTT_DECREMENT_NEW + winSRTT_DECREMENT_CURRENT );
+						}
+						else
+						{
+							pxWindow->lProbeSRTT = ( ( winSRTT_INCREMENT_NEW * mS ) + ( winSRTT_INCREMENT_CURRENT * pxWindow->lProbeSRTT ) ) / ( winSRTT_INCREMENT_NEW + winSRTT_INCREMENT_CURRENT );
+						}
+					}
+					#endif
+
 					/* Cap to the minimum of 50ms. */
 					if( pxWindow->lSRTT < winSRTT_CAP_mS )
 					{
@@ -1639,58 +1875,84 @@ const int32_t l500ms = 500;
 
 #if( ipconfigUSE_TCP_WIN == 1 )
 
-	static uint32_t prvTCPWindowFastRetransmit( TCPWindow_t *pxWindow, uint32_t ulFirst )
+	static uint32_t prvTCPWindowFastRetransmit( TCPWindow_t *pxWindow )
 	{
 	const ListItem_t * pxIterator;
 	const ListItem_t * pxEnd;
 	TCPSegment_t *pxSegment;
 	uint32_t ulCount = 0UL;
+	uint32_t ulSacked = 0UL;
+	uint32_t ulFirst = 0UL;
+
+		/* The scoreboard: xTxSegments is sorted by sequence number and still
+		holds the segments that were SACK'd.  Walk it from the highest segment
+		down, until DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT SACK'd segments have
+		been counted.  Every hole below that point is considered lost
+		( RFC 6675 ), so all of them can be retransmitted in one pass, instead
+		of one hole per round-trip. */
+		pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &( pxWindow->xTxSegments ) ) );
+
+		for( pxIterator  = pxEnd->pxPrevious;
+			 pxIterator != pxEnd;
+			 pxIterator  = pxIterator->pxPrevious )
+		{
+			pxSegment = ipPOINTER_CAST( TCPSegment_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
 
-		/* A higher Tx block has been acknowledged.  Now iterate through the
-		 xWaitQueue to find a possible condition for a FAST retransmission. */
-
-		pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &( pxWindow->xWaitQueue ) ) );
-
-		pxIterator  = listGET_NEXT( pxEnd );
+			if( pxSegment->u.bits.bAcked != pdFALSE_UNSIGNED )
+			{
+				ulSacked++;
+				if( ulSacked == DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT )
+				{
+					ulFirst = pxSegment->ulSequenceNumber;
+					break;
+				}
+			}
+		}
 
-		while( pxIterator != pxEnd )
+		if( ulSacked == DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT )
 		{
-			/* Get the owner, which is a TCP segment. */
-			pxSegment = ipPOINTER_CAST( TCPSegment_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
+			/* Now iterate through the xWaitQueue to find the holes below
+			'ulFirst'. */
+			pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &( pxWindow->xWaitQueue ) ) );
 
-			/* Hop to the next item before the current gets unlinked. */
-			pxIterator  = listGET_NEXT( pxIterator );
+			pxIterator  = listGET_NEXT( pxEnd );
 
-			/* Fast retransmission:
-			When 3 packets with a higher sequence number have been acknowledged
-			by the peer, it is very unlikely a current packet will ever arrive.
-			It will be retransmitted far before the RTO. */
-			if( pxSegment->u.bits.bAcked == pdFALSE_UNSIGNED )
+			while( pxIterator != pxEnd )
 			{
-				if( xSequenceLessThan( pxSegment->ulSequenceNumber, ulFirst ) != pdFALSE )
+				/* Get the owner, which is a TCP segment. */
+				pxSegment = ipPOINTER_CAST( TCPSegment_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
+
+				/* Hop to the next item before the current gets unlinked. */
+				pxIterator  = listGET_NEXT( pxIterator );
+
+				/* Fast retransmission:
+				When 3 packets with a higher sequence number have been acknowledged
+				by the peer, it is very unlikely a current packet will ever arrive.
+				It will be retransmitted far before the RTO.
+				'ucDupAckCount' marks a segment that was retransmitted already
+				for this hole.  It gets cleared when the segment is sent again
+				after a time-out. */
+				if( ( pxSegment->u.bits.bAcked == pdFALSE_UNSIGNED ) &&
+					( pxSegment->u.bits.ucDupAckCount < DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT ) &&
+					( xSequenceLessThan( pxSegment->ulSequenceNumber, ulFirst ) != pdFALSE ) )
 				{
-					pxSegment->u.bits.ucDupAckCount++;
-					if( pxSegment->u.bits.ucDupAckCount == DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT )
-					{
-						pxSegment->u.bits.ucTransmitCount = ( uint8_t ) pdFALSE;
+					pxSegment->u.bits.ucDupAckCount = ( uint8_t ) DUPLICATE_ACKS_BEFORE_FAST_RETRANSMIT;
+					pxSegment->u.bits.ucTransmitCount = ( uint8_t ) pdFALSE;
 
-						/* Not clearing 'ucDupAckCount' yet as more SACK's might come in
-						which might lead to a second fast rexmit. */
-						if( ( xTCPWindowLoggingLevel >= 0 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) ) )
-						{
-							FreeRTOS_debug_printf( ( "prvTCPWindowFastRetransmit: Requeue sequence number %lu < %lu\n",
-								pxSegment->ulSequenceNumber - pxWindow->tx.ulFirstSequenceNumber,
-								ulFirst - pxWindow->tx.ulFirstSequenceNumber ) );
-							FreeRTOS_flush_logging( );
-						}
-
-						/* Remove it from xWaitQueue. */
-						( void ) uxListRemove( &pxSegment->xQueueItem );
-						/* Add this segment to the priority queue so it gets
-						retransmitted immediately. */
-						vListInsertFifo( &( pxWindow->xPriorityQueue ), &( pxSegment->xQueueItem ) );
-						ulCount++;
+					if( ( xTCPWindowLoggingLevel >= 0 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) ) )
+					{
+						FreeRTOS_debug_printf( ( "prvTCPWindowFastRetransmit: Requeue sequence number %lu < %lu\n",
+							pxSegment->ulSequenceNumber - pxWindow->tx.ulFirstSequenceNumber,
+							ulFirst - pxWindow->tx.ulFirstSequenceNumber ) );
+						FreeRTOS_flush_logging( );
 					}
+
+					/* Remove it from xWaitQueue. */
+					( void ) uxListRemove( &pxSegment->xQueueItem );
+					/* Add this segment to the priority queue so it gets
+					retransmitted immediately. */
+					vListInsertFifo( &( pxWindow->xPriorityQueue ), &( pxSegment->xQueueItem ) );
+					ulCount++;
 				}
 			}
 		}
@@ -1719,6 +1981,18 @@ const int32_t l500ms = 500;
 			ulReturn = prvTCPWindowTxCheckAck( pxWindow, ulFirstSequence, ulSequenceNumber );
 		}
 
+		#if( ipconfigUSE_TCP_RACK_TLP == 1 )
+		{
+			prvTCPWindowLossDetect( pxWindow );
+		}
+		#endif
+
+		#if( ipconfigUSE_TCP_ECN == 1 )
+		{
+			prvTCPWindowCongestionAck( pxWindow );
+		}
+		#endif
+
 		return ulReturn;
 	}
 
@@ -1734,7 +2008,13 @@ const int32_t l500ms = 500;
 
 		/* Receive a SACK option. */
 		ulAckCount = prvTCPWindowTxCheckAck( pxWindow, ulFirst, ulLast );
-		( void ) prvTCPWindowFastRetransmit( pxWindow, ulFirst );
+		( void ) prvTCPWindowFastRetransmit( pxWindow );
+
+		#if( ipconfigUSE_TCP_RACK_TLP == 1 )
+		{
+			prvTCPWindowLossDetect( pxWindow );
+		}
+		#endif
 
 		if( ( xTCPWindowLoggingLevel >= 1 ) && ( xSequenceGreaterThan( ulFirst, ulCurrentSequenceNumber ) != pdFALSE ) )
 		{
@@ -1753,6 +2033,166 @@ const int32_t l500ms = 500;
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigUSE_TCP_RACK_TLP == 1 )
+
+	static uint32_t prvTCPWindowProbeTimeout( const TCPWindow_t *pxWindow )
+	{
+	uint32_t ulTimeout = 2U * ( uint32_t ) FreeRTOS_max_int32( pxWindow->lProbeSRTT, 0 );
+
+		/* A single segment may not be acknowledged before the peer's delayed
+		ACK timer expires. */
+		if( listCURRENT_LIST_LENGTH( &( pxWindow->xWaitQueue ) ) == 1U )
+		{
+			ulTimeout += winTLP_DELAYED_ACK_MS;
+		}
+
+		return FreeRTOS_max_uint32( ulTimeout, winTLP_MINIMUM_MS );
+	}
+	/*-----------------------------------------------------------*/
+
+	static uint32_t prvTCPWindowReorderWindow( const TCPWindow_t *pxWindow )
+	{
+		/* A quarter of the round-trip, but at least one clock tick, which is
+		the resolution of the transmit timers. */
+		return FreeRTOS_max_uint32( ( uint32_t ) FreeRTOS_max_int32( pxWindow->lProbeSRTT, 0 ) / 4U, portTICK_PERIOD_MS );
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvTCPWindowSentBeforeRack( const TCPWindow_t *pxWindow, const TCPSegment_t *pxSegment )
+	{
+	int32_t lDifference = ( int32_t ) ( pxWindow->ulRackXmitTime - pxSegment->xTransmitTimer.ulBorn );
+	BaseType_t xReturn = pdFALSE;
+
+		if( pxWindow->lRackRTT >= 0 )
+		{
+			/* Segments that were sent within the same clock tick are ordered
+			on their sequence number. */
+			if( ( lDifference > 0 ) ||
+				( ( lDifference == 0 ) && ( xSequenceLessThan( pxSegment->ulSequenceNumber, pxWindow->ulRackEndSequence ) != pdFALSE ) ) )
+			{
+				xReturn = pdTRUE;
+			}
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	static uint32_t prvTCPWindowLossTimer( const TCPWindow_t *pxWindow )
+	{
+	const ListItem_t *pxIterator;
+	const ListItem_t *pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &( pxWindow->xWaitQueue ) ) );
+	const TCPSegment_t *pxSegment;
+	uint32_t ulDelay = ~( ( uint32_t ) 0U ), ulLimit, ulAge;
+
+		if( pxWindow->lRackRTT >= 0 )
+		{
+			ulLimit = ( uint32_t ) pxWindow->lRackRTT + prvTCPWindowReorderWindow( pxWindow );
+
+			for( pxIterator = listGET_NEXT( pxEnd ); pxIterator != pxEnd; pxIterator = listGET_NEXT( pxIterator ) )
+			{
+				pxSegment = ipPOINTER_CAST( const TCPSegment_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
+
+				if( prvTCPWindowSentBeforeRack( pxWindow, pxSegment ) != pdFALSE )
+				{
+					ulAge = ulTimerGetAge( &( pxSegment->xTransmitTimer ) );
+					ulDelay = FreeRTOS_min_uint32( ulDelay, ( ulAge < ulLimit ) ? ( ulLimit - ulAge ) : 0U );
+				}
+			}
+		}
+
+		if( ( pxWindow->u.bits.bProbeSent == pdFALSE_UNSIGNED ) && ( listLIST_IS_EMPTY( &( pxWindow->xWaitQueue ) ) == pdFALSE ) )
+		{
+			ulLimit = prvTCPWindowProbeTimeout( pxWindow );
+			ulAge = ( uint32_t ) ( ( xTaskGetTickCount() - ( TickType_t ) pxWindow->ulProbeTime ) * portTICK_PERIOD_MS );
+			ulDelay = FreeRTOS_min_uint32( ulDelay, ( ulAge < ulLimit ) ? ( ulLimit - ulAge ) : 0U );
+		}
+
+		return ulDelay;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTCPWindowLossDetect( TCPWindow_t *pxWindow )
+	{
+	const ListItem_t *pxIterator;
+	const ListItem_t *pxEnd = ipPOINTER_CAST( const ListItem_t *, listGET_END_MARKER( &( pxWindow->xWaitQueue ) ) );
+	TCPSegment_t *pxSegment, *pxProbe = NULL;
+	const TCPSegment_t *pxHead;
+	uint32_t ulLimit, ulMaxAge;
+
+		/* RACK: a segment that was sent before a segment that has been
+		acknowledged, and which is older than the RTT of that segment plus the
+		reordering window, is considered lost. */
+		if( pxWindow->lRackRTT >= 0 )
+		{
+			ulLimit = ( uint32_t ) pxWindow->lRackRTT + prvTCPWindowReorderWindow( pxWindow );
+			pxIterator = listGET_NEXT( pxEnd );
+
+			while( pxIterator != pxEnd )
+			{
+				pxSegment = ipPOINTER_CAST( TCPSegment_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
+
+				/* Hop to the next item before the current gets unlinked. */
+				pxIterator = listGET_NEXT( pxIterator );
+
+				if( ( prvTCPWindowSentBeforeRack( pxWindow, pxSegment ) != pdFALSE ) &&
+					( ulTimerGetAge( &( pxSegment->xTransmitTimer ) ) >= ulLimit ) )
+				{
+					if( ( xTCPWindowLoggingLevel >= 0 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) ) )
+					{
+						FreeRTOS_debug_printf( ( "prvTCPWindowLossDetect: RACK requeue sequence number %lu\n",
+							pxSegment->ulSequenceNumber - pxWindow->tx.ulFirstSequenceNumber ) );
+					}
+
+					/* As for a fast retransmission. */
+					pxSegment->u.bits.ucTransmitCount = ( uint8_t ) pdFALSE;
+					( void ) uxListRemove( &( pxSegment->xQueueItem ) );
+					vListInsertFifo( &( pxWindow->xPriorityQueue ), &( pxSegment->xQueueItem ) );
+				}
+			}
+		}
+
+		/* TLP: the flight has been silent for the probe time-out, before the
+		retransmission timer of the oldest segment expires.  Send the highest
+		outstanding segment again, once. */
+		pxHead = xTCPWindowPeekHead( &( pxWindow->xWaitQueue ) );
+
+		if( ( pxHead != NULL ) &&
+			( pxWindow->u.bits.bProbeSent == pdFALSE_UNSIGNED ) &&
+			( listLIST_IS_EMPTY( &( pxWindow->xPriorityQueue ) ) != pdFALSE ) )
+		{
+			ulMaxAge = ( 1UL << pxHead->u.bits.ucTransmitCount ) * ( ( uint32_t ) pxWindow->lSRTT );
+
+			if( ( ulTimerGetAge( &( pxHead->xTransmitTimer ) ) <= ulMaxAge ) &&
+				( ( ( xTaskGetTickCount() - ( TickType_t ) pxWindow->ulProbeTime ) * portTICK_PERIOD_MS ) >= prvTCPWindowProbeTimeout( pxWindow ) ) )
+			{
+				for( pxIterator = listGET_NEXT( pxEnd ); pxIterator != pxEnd; pxIterator = listGET_NEXT( pxIterator ) )
+				{
+					pxSegment = ipPOINTER_CAST( TCPSegment_t *, listGET_LIST_ITEM_OWNER( pxIterator ) );
+
+					if( ( pxProbe == NULL ) || ( xSequenceGreaterThan( pxSegment->ulSequenceNumber, pxProbe->ulSequenceNumber ) != pdFALSE ) )
+					{
+						pxProbe = pxSegment;
+					}
+				}
+
+				if( ( xTCPWindowLoggingLevel >= 0 ) && ( ipconfigTCP_MAY_LOG_PORT( pxWindow->usOurPortNumber ) ) )
+				{
+					FreeRTOS_debug_printf( ( "prvTCPWindowLossDetect: TLP sequence number %lu\n",
+						pxProbe->ulSequenceNumber - pxWindow->tx.ulFirstSequenceNumber ) );
+				}
+
+				( void ) uxListRemove( &( pxProbe->xQueueItem ) );
+				vListInsertFifo( &( pxWindow->xPriorityQueue ), &( pxProbe->xQueueItem ) );
+				pxWindow->u.bits.bProbeSent = pdTRUE_UNSIGNED;
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigUSE_TCP_RACK_TLP == 1 ) */
+/*-----------------------------------------------------------*/
+
 /*
 #####   #                      #####   ####  ######
 # # #   #                      # # #  #    #  #    #
@@ -1874,6 +2314,16 @@ const int32_t l500ms = 500;
 			{
 				pxSegment->u.bits.bOutstanding = pdTRUE_UNSIGNED;
 				pxSegment->u.bits.ucTransmitCount++;
+				#if( ipconfigUSE_TCP_ECN == 1 )
+				{
+					pxWindow->u.bits.bTxRetransmit = ( pxSegment->u.bits.ucTransmitCount > 1U ) ? pdTRUE_UNSIGNED : pdFALSE_UNSIGNED;
+				}
+				#endif
+				#if( ipconfigUSE_PATH_MTU_DISCOVERY != 0 )
+				{
+					pxWindow->ucTxTransmitCount = pxSegment->u.bits.ucTransmitCount;
+				}
+				#endif
 				vTCPTimerSet (&pxSegment->xTransmitTimer);
 				pxWindow->ulOurSequenceNumber = pxSegment->ulSequenceNumber;
 				*plPosition = pxSegment->lStreamPos;
@@ -2015,6 +2465,12 @@ const int32_t l500ms = 500;
 			}
 		}
 
+		#if( ipconfigUSE_TCP_ECN == 1 )
+		{
+			prvTCPWindowCongestionAck( pxWindow );
+		}
+		#endif
+
 		return ulDataLength;
 	}
 
@@ -2047,4 +2503,64 @@ const int32_t l500ms = 500;
 #endif /* ipconfigUSE_TCP_WIN == 0 */
 /*-----------------------------------------------------------*/
 
+#if( ipconfigUSE_TCP_ECN == 1 )
+
+	BaseType_t xTCPWindowTxCongestion( TCPWindow_t *pxWindow )
+	{
+	uint32_t ulMinimum = 2UL * ( uint32_t ) pxWindow->usMSS;
+	BaseType_t xReturn = pdFALSE;
+
+		/* The peer keeps echoing the mark until it sees CWR, react only once
+		per window of data. */
+		if( ( pxWindow->u.bits.bCongestion == pdFALSE_UNSIGNED ) ||
+			( xSequenceGreaterThanOrEqual( pxWindow->tx.ulCurrentSequenceNumber, pxWindow->ulCongestionRecover ) != pdFALSE ) )
+		{
+			if( pxWindow->xSize.ulTxWindowLength > pxWindow->ulTxWindowTarget )
+			{
+				pxWindow->ulTxWindowTarget = pxWindow->xSize.ulTxWindowLength;
+			}
+
+			pxWindow->xSize.ulTxWindowLength = FreeRTOS_max_uint32( pxWindow->xSize.ulTxWindowLength / 2UL, ulMinimum );
+			pxWindow->ulCongestionRecover = pxWindow->tx.ulHighestSequenceNumber;
+			pxWindow->u.bits.bCongestion = pdTRUE_UNSIGNED;
+
+			if( xTCPWindowLoggingLevel != 0 )
+			{
+				FreeRTOS_debug_printf( ( "xTCPWindowTxCongestion[%u,%u]: Tx window %lu\n",
+					pxWindow->usPeerPortNumber,
+					pxWindow->usOurPortNumber,
+					pxWindow->xSize.ulTxWindowLength ) );
+			}
+
+			xReturn = pdTRUE;
+		}
+
+		return xReturn;
+	}
+
+#endif /* ipconfigUSE_TCP_ECN == 1 */
+/*-----------------------------------------------------------*/
+
+#if( ipconfigUSE_TCP_ECN == 1 )
+
+	static void prvTCPWindowCongestionAck( TCPWindow_t *pxWindow )
+	{
+		if( ( pxWindow->u.bits.bCongestion != pdFALSE_UNSIGNED ) &&
+			( xSequenceGreaterThanOrEqual( pxWindow->tx.ulCurrentSequenceNumber, pxWindow->ulCongestionRecover ) != pdFALSE ) )
+		{
+			if( pxWindow->xSize.ulTxWindowLength < pxWindow->ulTxWindowTarget )
+			{
+				/* A round-trip without a new mark: one MSS more. */
+				pxWindow->xSize.ulTxWindowLength = FreeRTOS_min_uint32( pxWindow->xSize.ulTxWindowLength + ( uint32_t ) pxWindow->usMSS, pxWindow->ulTxWindowTarget );
+				pxWindow->ulCongestionRecover = pxWindow->tx.ulHighestSequenceNumber;
+			}
+			else
+			{
+				pxWindow->u.bits.bCongestion = pdFALSE_UNSIGNED;
+			}
+		}
+	}
+
+#endif /* ipconfigUSE_TCP_ECN == 1 */
+/*-----------------------------------------------------------*/
 
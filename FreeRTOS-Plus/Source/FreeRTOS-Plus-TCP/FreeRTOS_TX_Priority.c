@@ -0,0 +1,349 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "list.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "NetworkInterface.h"
+#include "NetworkBufferManagement.h"
+
+#if( ipconfigUSE_TX_PRIORITY_QUEUES != 0 )
+
+/*
+ * Initialise the queues, the first time they are used.
+ */
+static void prvTxQueueInit( void );
+
+/*
+ * Take the next frame to send from the queues: first from the classes with
+ * strict priority, then round robin over the weighted classes.  Must only be
+ * called when uxTxQueued is non-zero.
+ */
+static NetworkBufferDescriptor_t *prvTxQueueNext( void );
+
+/*
+ * Give waiting frames to the driver as long as it has room.
+ */
+static void prvTxQueueSend( void );
+
+/*-----------------------------------------------------------*/
+
+/* One queue per priority class, the frames are linked through their
+xBufferListItem, which is not used while a frame is being sent. */
+static List_t xTxQueues[ ipconfigTX_PRIORITY_QUEUES ];
+
+/* The weight and the remaining credit of each class in the current round. */
+static const UBaseType_t uxTxWeights[ ipconfigTX_PRIORITY_QUEUES ] = ipconfigTX_PRIORITY_WEIGHTS;
+static UBaseType_t uxTxCredits[ ipconfigTX_PRIORITY_QUEUES ];
+
+/* The number of frames in all the queues. */
+static UBaseType_t uxTxQueued = 0U;
+
+static BaseType_t xTxQueuesInitialised = pdFALSE;
+
+#if( ipconfigTX_PRIORITY_DRIVER_DEPTH > 0 )
+	/* The frames given to the driver that it has not reported as sent.  Only
+	accessed by the IP-task. */
+	static UBaseType_t uxTxInFlight = 0U;
+
+	/* The frames reported by vNetworkInterfaceTxDone() from other tasks, and
+	whether an eNetworkTxDoneEvent is on its way.  Protected by a critical
+	section. */
+	static volatile UBaseType_t uxTxDoneCount = 0U;
+	static BaseType_t xTxDonePending = pdFALSE;
+
+	#define ipTX_DRIVER_HAS_ROOM()		( uxTxInFlight < ( UBaseType_t ) ipconfigTX_PRIORITY_DRIVER_DEPTH )
+#else
+	#define ipTX_DRIVER_HAS_ROOM()		( pdTRUE )
+#endif
+
+/*-----------------------------------------------------------*/
+
+static void prvTxQueueInit( void )
+{
+UBaseType_t uxClass;
+
+	if( xTxQueuesInitialised == pdFALSE )
+	{
+		for( uxClass = 0U; uxClass < ( UBaseType_t ) ipconfigTX_PRIORITY_QUEUES; uxClass++ )
+		{
+			vListInitialise( &( xTxQueues[ uxClass ] ) );
+			uxTxCredits[ uxClass ] = uxTxWeights[ uxClass ];
+		}
+
+		xTxQueuesInitialised = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxNetworkBufferTxPriority( const NetworkBufferDescriptor_t *pxNetworkBuffer )
+{
+const IPPacket_t *pxIPPacket = ipPOINTER_CAST( const IPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+UBaseType_t uxClass = ( UBaseType_t ) ipconfigTX_PRIORITY_QUEUES - 1U;
+
+	if( pxIPPacket->xEthernetHeader.usFrameType == ipIPv4_FRAME_TYPE )
+	{
+		/* The class selector, the 3 highest bits of the DSCP field, ranges from
+		0 to 7. */
+		uxClass = ( ( UBaseType_t ) ( pxIPPacket->xIPHeader.ucDifferentiatedServicesCode >> 5 ) * ( UBaseType_t ) ipconfigTX_PRIORITY_QUEUES ) / 8U;
+	}
+
+	return uxClass;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIPTxQueueOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend )
+{
+NetworkBufferDescriptor_t *pxQueued = NULL;
+UBaseType_t uxClass;
+BaseType_t xReturn = pdPASS;
+
+	prvTxQueueInit();
+
+	if( ( uxTxQueued == 0U ) && ( ipTX_DRIVER_HAS_ROOM() != pdFALSE ) )
+	{
+		/* Nothing is waiting, the frame does not have to be queued. */
+		#if( ipconfigTX_PRIORITY_DRIVER_DEPTH > 0 )
+		{
+			uxTxInFlight++;
+		}
+		#endif
+		xReturn = xNetworkInterfaceOutput( pxNetworkBuffer, xReleaseAfterSend );
+	}
+	else
+	{
+		uxClass = uxNetworkBufferTxPriority( pxNetworkBuffer );
+
+		if( listCURRENT_LIST_LENGTH( &( xTxQueues[ uxClass ] ) ) < ( UBaseType_t ) ipconfigTX_PRIORITY_QUEUE_LENGTH )
+		{
+			if( xReleaseAfterSend != pdFALSE )
+			{
+				pxQueued = pxNetworkBuffer;
+			}
+			else
+			{
+				/* The caller will reuse the buffer. */
+				pxQueued = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, pxNetworkBuffer->xDataLength );
+			}
+		}
+
+		if( pxQueued != NULL )
+		{
+			vListInsertEnd( &( xTxQueues[ uxClass ] ), &( pxQueued->xBufferListItem ) );
+			uxTxQueued++;
+		}
+		else
+		{
+			/* The queue of this class is full, or there is no buffer for the
+			copy.  TCP will retransmit the frame. */
+			iptraceNETWORK_INTERFACE_OUTPUT_DROPPED( pxNetworkBuffer, uxClass );
+
+			if( xReleaseAfterSend != pdFALSE )
+			{
+				vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+			}
+			xReturn = pdFAIL;
+		}
+
+		prvTxQueueSend();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static NetworkBufferDescriptor_t *prvTxQueueNext( void )
+{
+NetworkBufferDescriptor_t *pxNetworkBuffer = NULL;
+UBaseType_t uxClass;
+BaseType_t xRound;
+
+	/* Strict priority classes first, from the highest. */
+	for( uxClass = ( UBaseType_t ) ipconfigTX_PRIORITY_QUEUES; uxClass > 0U; uxClass-- )
+	{
+		if( ( uxTxWeights[ uxClass - 1U ] == 0U ) && ( listLIST_IS_EMPTY( &( xTxQueues[ uxClass - 1U ] ) ) == pdFALSE ) )
+		{
+			break;
+		}
+	}
+
+	/* Then the highest weighted class with frames that still has credit.
+	When all of those have used their credit, a new round starts. */
+	for( xRound = 0; ( uxClass == 0U ) && ( xRound < 2 ); xRound++ )
+	{
+		for( uxClass = ( UBaseType_t ) ipconfigTX_PRIORITY_QUEUES; uxClass > 0U; uxClass-- )
+		{
+			if( ( uxTxCredits[ uxClass - 1U ] != 0U ) && ( listLIST_IS_EMPTY( &( xTxQueues[ uxClass - 1U ] ) ) == pdFALSE ) )
+			{
+				uxTxCredits[ uxClass - 1U ]--;
+				break;
+			}
+		}
+
+		if( uxClass == 0U )
+		{
+			( void ) memcpy( uxTxCredits, uxTxWeights, sizeof( uxTxCredits ) );
+		}
+	}
+
+	if( uxClass != 0U )
+	{
+		pxNetworkBuffer = ipPOINTER_CAST( NetworkBufferDescriptor_t *, listGET_OWNER_OF_HEAD_ENTRY( &( xTxQueues[ uxClass - 1U ] ) ) );
+		( void ) uxListRemove( &( pxNetworkBuffer->xBufferListItem ) );
+		uxTxQueued--;
+	}
+
+	return pxNetworkBuffer;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTxQueueSend( void )
+{
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+
+	while( ( uxTxQueued != 0U ) && ( ipTX_DRIVER_HAS_ROOM() != pdFALSE ) )
+	{
+		pxNetworkBuffer = prvTxQueueNext();
+		configASSERT( pxNetworkBuffer != NULL );
+
+		#if( ipconfigTX_PRIORITY_DRIVER_DEPTH > 0 )
+		{
+			uxTxInFlight++;
+		}
+		#endif
+
+		/* The driver may call vNetworkInterfaceTxDone() before it returns. */
+		( void ) xNetworkInterfaceOutput( pxNetworkBuffer, pdTRUE );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vNetworkInterfaceTxDone( void )
+{
+	#if( ipconfigTX_PRIORITY_DRIVER_DEPTH > 0 )
+	{
+	BaseType_t xWakeIPTask = pdFALSE;
+
+		if( xIsCallingFromIPTask() != pdFALSE )
+		{
+			/* prvTxQueueSend() or vIPTxQueueProcess() will send the next
+			frame. */
+			if( uxTxInFlight > 0U )
+			{
+				uxTxInFlight--;
+			}
+		}
+		else
+		{
+			taskENTER_CRITICAL();
+			{
+				uxTxDoneCount++;
+
+				/* One event is enough to wake up the IP-task. */
+				if( xTxDonePending == pdFALSE )
+				{
+					xTxDonePending = pdTRUE;
+					xWakeIPTask = pdTRUE;
+				}
+			}
+			taskEXIT_CRITICAL();
+
+			if( xWakeIPTask != pdFALSE )
+			{
+				/* When the event queue is full, the count is picked up after
+				one of the other events. */
+				( void ) xSendEventToIPTask( eNetworkTxDoneEvent );
+			}
+		}
+	}
+	#endif /* ipconfigTX_PRIORITY_DRIVER_DEPTH */
+}
+/*-----------------------------------------------------------*/
+
+void vIPTxQueueProcess( void )
+{
+	#if( ipconfigTX_PRIORITY_DRIVER_DEPTH > 0 )
+	{
+	UBaseType_t uxCount;
+
+		if( uxTxDoneCount != 0U )
+		{
+			taskENTER_CRITICAL();
+			{
+				uxCount = uxTxDoneCount;
+				uxTxDoneCount = 0U;
+				xTxDonePending = pdFALSE;
+			}
+			taskEXIT_CRITICAL();
+
+			if( uxCount < uxTxInFlight )
+			{
+				uxTxInFlight -= uxCount;
+			}
+			else
+			{
+				uxTxInFlight = 0U;
+			}
+		}
+	}
+	#endif /* ipconfigTX_PRIORITY_DRIVER_DEPTH */
+
+	if( uxTxQueued != 0U )
+	{
+		prvTxQueueSend();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vIPTxQueueFlush( void )
+{
+NetworkBufferDescriptor_t *pxNetworkBuffer;
+
+	while( uxTxQueued != 0U )
+	{
+		pxNetworkBuffer = prvTxQueueNext();
+		configASSERT( pxNetworkBuffer != NULL );
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+
+	#if( ipconfigTX_PRIORITY_DRIVER_DEPTH > 0 )
+	{
+		/* The driver is reset as well. */
+		uxTxInFlight = 0U;
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigUSE_TX_PRIORITY_QUEUES */
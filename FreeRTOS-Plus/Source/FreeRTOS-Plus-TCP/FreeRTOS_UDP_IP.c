@@ -71,6 +71,73 @@ UDPPacketHeader_t xDefaultPartUDPPacketHeader =
 		0x00, 0x00, 0x00, 0x00 					/* Source IP address. */
 	}
 };
+
+/* The last destination that was found in the ARP cache.  Consecutive packets
+to the same address use it without a lookup, as long as ulARPGeneration has not
+changed.  Only accessed from the IP-task. */
+static uint32_t ulLastDestinationIP = 0UL;
+static uint32_t ulLastDestinationGeneration = 0UL;
+static MACAddress_t xLastDestinationMAC;
+static BaseType_t xLastDestinationValid = pdFALSE;
+
+#if( ( ipconfigUSE_HEADER_TEMPLATES != 0 ) && ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 ) )
+	/* The sums of the fields of xDefaultPartUDPPacketHeader, calculated for
+	the local IP address ulUDPTemplateSourceIP. */
+	static BaseType_t xUDPTemplateValid = pdFALSE;
+	static uint32_t ulUDPTemplateSourceIP = 0UL;
+	static uint16_t usUDPTemplateIPSum;
+	static uint16_t usUDPTemplatePseudoSum;
+#endif
+/*-----------------------------------------------------------*/
+
+#if( ( ipconfigUSE_HEADER_TEMPLATES != 0 ) && ( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 ) )
+
+	static void prvUDPTemplateChecksums( UDPPacket_t *pxUDPPacket, size_t uxPayloadSize, uint8_t ucSocketOptions )
+	{
+	IPHeader_t *pxIPHeader = &( pxUDPPacket->xIPHeader );
+	uint32_t ulDestination = FreeRTOS_ntohl( pxIPHeader->ulDestinationIPAddress );
+	uint32_t ulDestinationSum = ( ulDestination >> 16 ) + ( ulDestination & 0xffffUL );
+	uint32_t ulUDPLength = ( uint32_t ) ( uxPayloadSize + sizeof( UDPHeader_t ) );
+	uint16_t usSum;
+
+		if( ( xUDPTemplateValid == pdFALSE ) || ( ulUDPTemplateSourceIP != *ipLOCAL_IP_ADDRESS_POINTER ) )
+		{
+		IPHeader_t xTemplate;
+
+			/* The header has just been copied from xDefaultPartUDPPacketHeader,
+			the destination is the only other field that is not constant. */
+			( void ) memcpy( &( xTemplate ), pxIPHeader, sizeof( xTemplate ) );
+			xTemplate.ucDifferentiatedServicesCode = 0U;
+			xTemplate.usLength = 0U;
+			xTemplate.usHeaderChecksum = 0U;
+			xTemplate.ulDestinationIPAddress = 0UL;
+
+			usUDPTemplateIPSum = usGenerateChecksum( 0U, ( uint8_t * ) &( xTemplate.ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+			usUDPTemplatePseudoSum = usGenerateChecksum( ( uint16_t ) ipPROTOCOL_UDP, ( uint8_t * ) &( xTemplate.ulSourceIPAddress ), ipSIZE_OF_IPv4_ADDRESS );
+			ulUDPTemplateSourceIP = *ipLOCAL_IP_ADDRESS_POINTER;
+			xUDPTemplateValid = pdTRUE;
+		}
+
+		/* The type of service is set per socket. */
+		usSum = usFoldChecksum( ( uint32_t ) usUDPTemplateIPSum + ( uint32_t ) pxIPHeader->ucDifferentiatedServicesCode + ulDestinationSum + FreeRTOS_ntohs( pxIPHeader->usLength ) );
+		pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( usSum );
+
+		pxUDPPacket->xUDPHeader.usChecksum = 0U;
+
+		if( ( ucSocketOptions & ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT ) != 0U )
+		{
+			usSum = usFoldChecksum( ( uint32_t ) usUDPTemplatePseudoSum + ulDestinationSum + ulUDPLength );
+			usSum = ( uint16_t ) ~usGenerateChecksum( usSum, ( uint8_t * ) &( pxUDPPacket->xUDPHeader ), ( size_t ) ulUDPLength );
+			if( usSum == 0U )
+			{
+				/* A value of zero would mean that the checksum is not used. */
+				usSum = 0xffffU;
+			}
+			pxUDPPacket->xUDPHeader.usChecksum = FreeRTOS_htons( usSum );
+		}
+	}
+
+#endif /* ipconfigUSE_HEADER_TEMPLATES */
 /*-----------------------------------------------------------*/
 
 void vProcessGeneratedUDPPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer )
@@ -80,6 +147,7 @@ IPHeader_t *pxIPHeader;
 eARPLookupResult_t eReturned;
 uint32_t ulIPAddress = pxNetworkBuffer->ulIPAddress;
 size_t uxPayloadSize;
+BaseType_t xPacketHeld = pdFALSE;
 
 	/* Map the UDP packet onto the start of the frame. */
 	pxUDPPacket = ipPOINTER_CAST( UDPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
@@ -96,7 +164,25 @@ size_t uxPayloadSize;
 	}
 
 	/* Determine the ARP cache status for the requested IP address. */
-	eReturned = eARPGetCacheEntry( &( ulIPAddress ), &( pxUDPPacket->xEthernetHeader.xDestinationAddress ) );
+	if( ( xLastDestinationValid != pdFALSE ) &&
+		( ulLastDestinationIP == ulIPAddress ) &&
+		( ulLastDestinationGeneration == ulARPGeneration ) )
+	{
+		( void ) memcpy( &( pxUDPPacket->xEthernetHeader.xDestinationAddress ), &( xLastDestinationMAC ), sizeof( xLastDestinationMAC ) );
+		eReturned = eARPCacheHit;
+	}
+	else
+	{
+		eReturned = eARPGetCacheEntry( &( ulIPAddress ), &( pxUDPPacket->xEthernetHeader.xDestinationAddress ) );
+
+		if( eReturned == eARPCacheHit )
+		{
+			ulLastDestinationIP = pxNetworkBuffer->ulIPAddress;
+			ulLastDestinationGeneration = ulARPGeneration;
+			( void ) memcpy( &( xLastDestinationMAC ), &( pxUDPPacket->xEthernetHeader.xDestinationAddress ), sizeof( xLastDestinationMAC ) );
+			xLastDestinationValid = pdTRUE;
+		}
+	}
 
 	if( eReturned != eCantSendPacket )
 	{
@@ -105,6 +191,9 @@ size_t uxPayloadSize;
 			#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
 				uint8_t ucSocketOptions;
 			#endif
+			#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+				uint8_t ucTypeOfService;
+			#endif
 			iptraceSENDING_UDP_PACKET( pxNetworkBuffer->ulIPAddress );
 
 			/* Create short cuts to the data within the packet. */
@@ -147,6 +236,11 @@ size_t uxPayloadSize;
 			{
 				ucSocketOptions = pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_OPTIONS_OFFSET ];
 		}
+			#endif
+			#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+			{
+				ucTypeOfService = pxNetworkBuffer->pucEthernetBuffer[ ipSOCKET_TOS_OFFSET ];
+			}
 			#endif
 			/*
 			 * Offset the memcpy by the size of a MAC address to start at the packet's
@@ -171,6 +265,12 @@ size_t uxPayloadSize;
 			pxIPHeader->usLength = FreeRTOS_htons( pxIPHeader->usLength );
 			pxIPHeader->ulDestinationIPAddress = pxNetworkBuffer->ulIPAddress;
 
+			#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+			{
+				pxIPHeader->ucDifferentiatedServicesCode = ucTypeOfService;
+			}
+			#endif
+
 			#if( ipconfigUSE_LLMNR == 1 )
 			{
 				/* LLMNR messages are typically used on a LAN and they're
@@ -184,17 +284,29 @@ size_t uxPayloadSize;
 
 			#if( ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM == 0 )
 			{
-				pxIPHeader->usHeaderChecksum = 0U;
-				pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0U, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
-				pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
-
-				if( ( ucSocketOptions & ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT ) != 0U )
+			#if( ipconfigUSE_HEADER_TEMPLATES != 0 )
+				/* ICMP and LLMNR packets differ from the template in more than
+				the length and the destination. */
+				if( ( pxIPHeader->ucProtocol == ( uint8_t ) ipPROTOCOL_UDP ) &&
+					( pxIPHeader->ucTimeToLive == ( uint8_t ) ipconfigUDP_TIME_TO_LIVE ) )
 				{
-					( void ) usGenerateProtocolChecksum( ( uint8_t * ) pxUDPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+					prvUDPTemplateChecksums( pxUDPPacket, uxPayloadSize, ucSocketOptions );
 				}
 				else
+			#endif /* ipconfigUSE_HEADER_TEMPLATES */
 				{
-					pxUDPPacket->xUDPHeader.usChecksum = 0U;
+					pxIPHeader->usHeaderChecksum = 0U;
+					pxIPHeader->usHeaderChecksum = usGenerateChecksum( 0U, ( uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+					pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( pxIPHeader->usHeaderChecksum );
+
+					if( ( ucSocketOptions & ( uint8_t ) FREERTOS_SO_UDPCKSUM_OUT ) != 0U )
+					{
+						( void ) usGenerateProtocolChecksum( ( uint8_t * ) pxUDPPacket, pxNetworkBuffer->xDataLength, pdTRUE );
+					}
+					else
+					{
+						pxUDPPacket->xUDPHeader.usChecksum = 0U;
+					}
 				}
 			}
 			#endif
@@ -206,10 +318,25 @@ size_t uxPayloadSize;
 			outstanding, and perform retransmissions if necessary. */
 			vARPRefreshCacheEntry( NULL, ulIPAddress );
 
-			/* Generate an ARP for the required IP address. */
-			iptracePACKET_DROPPED_TO_GENERATE_ARP( pxNetworkBuffer->ulIPAddress );
-			pxNetworkBuffer->ulIPAddress = ulIPAddress;
-			vARPGenerateRequestPacket( pxNetworkBuffer );
+			#if( ipconfigARP_PENDING_PACKETS > 0 )
+			{
+				/* Keep the packet until the reply arrives, and send the ARP
+				request in a new buffer. */
+				xPacketHeld = xARPHoldPacket( pxNetworkBuffer, ulIPAddress );
+				if( xPacketHeld != pdFALSE )
+				{
+					FreeRTOS_OutputARPRequest( ulIPAddress );
+				}
+			}
+			#endif /* ipconfigARP_PENDING_PACKETS */
+
+			if( xPacketHeld == pdFALSE )
+			{
+				/* Generate an ARP for the required IP address. */
+				iptracePACKET_DROPPED_TO_GENERATE_ARP( pxNetworkBuffer->ulIPAddress );
+				pxNetworkBuffer->ulIPAddress = ulIPAddress;
+				vARPGenerateRequestPacket( pxNetworkBuffer );
+			}
 		}
 		else
 		{
@@ -219,7 +346,21 @@ size_t uxPayloadSize;
 		}
 	}
 
-	if( eReturned != eCantSendPacket )
+	#if( ipconfigARP_PENDING_PACKETS > 0 )
+	{
+		if( ( eReturned == eCantSendPacket ) && ( xPacketHeld == pdFALSE ) )
+		{
+			/* An ARP request may already be outstanding for ulIPAddress. */
+			xPacketHeld = xARPHoldPacket( pxNetworkBuffer, ulIPAddress );
+		}
+	}
+	#endif /* ipconfigARP_PENDING_PACKETS */
+
+	if( xPacketHeld != pdFALSE )
+	{
+		/* ARP will pass the packet to this function again. */
+	}
+	else if( eReturned != eCantSendPacket )
 	{
 		/* The network driver is responsible for freeing the network buffer
 		after the packet has been sent. */
@@ -239,7 +380,7 @@ size_t uxPayloadSize;
 		}
 		#endif
 
-		( void ) xNetworkInterfaceOutput( pxNetworkBuffer, pdTRUE );
+		( void ) ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, pdTRUE );
 	}
 	else
 	{
@@ -312,7 +453,18 @@ const UDPPacket_t *pxUDPPacket = ipPOINTER_CAST( const UDPPacket_t *, pxNetworkB
 		}
 		#endif
 
-		#if( ipconfigUSE_CALLBACKS == 1 ) || ( ipconfigUDP_MAX_RX_PACKETS > 0U )
+		#if( ipconfigUSE_BUFFER_QUOTAS == 1 )
+		{
+			if( xReturn == pdPASS )
+			{
+				/* Drop the packet early when the socket holds too many
+				buffers. */
+				xReturn = xSocketBufferQuotaCheck( pxSocket );
+			}
+		}
+		#endif
+
+		#if( ipconfigUSE_CALLBACKS == 1 ) || ( ipconfigUDP_MAX_RX_PACKETS > 0U ) || ( ipconfigUSE_BUFFER_QUOTAS == 1 )
 		if( xReturn == pdPASS )	/*lint !e774: Boolean within 'if' always evaluates to True, depending on configuration. [MISRA 2012 Rule 14.3, required. */
 		#else
 		/* xReturn is still pdPASS. */
@@ -325,16 +477,19 @@ const UDPPacket_t *pxUDPPacket = ipPOINTER_CAST( const UDPPacket_t *, pxNetworkB
 					/* Add the network packet to the list of packets to be
 					processed by the socket. */
 					vListInsertEnd( &( pxSocket->u.xUDP.xWaitingPacketsList ), &( pxNetworkBuffer->xBufferListItem ) );
+
+					#if( ipconfigUSE_BUFFER_QUOTAS == 1 )
+					{
+						vSocketBufferQuotaUpdate( pxSocket, pdTRUE );
+					}
+					#endif
 				}
 				taskEXIT_CRITICAL();
 			}
 			( void ) xTaskResumeAll();
 
 			/* Set the socket's receive event */
-			if( pxSocket->xEventGroup != NULL )
-			{
-				( void ) xEventGroupSetBits( pxSocket->xEventGroup, ( EventBits_t ) eSOCKET_RECEIVE );
-			}
+			vSocketSetEvents( pxSocket, ( EventBits_t ) eSOCKET_RECEIVE );
 
 			#if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
 			{
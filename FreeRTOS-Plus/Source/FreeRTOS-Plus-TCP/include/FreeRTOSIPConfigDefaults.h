@@ -289,6 +289,21 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigMAX_ARP_AGE			150U
 #endif
 
+/* When larger than zero, an outgoing UDP or ICMP packet whose destination has
+no ARP cache entry yet is held, in stead of being replaced by an ARP request.
+The held packets are sent as soon as the ARP reply arrives, and released when
+the ARP request expires.  This is the total number of packets that can be
+held.  TCP sockets that are waiting for ARP in connect() are woken up by the
+reply as well. */
+#ifndef ipconfigARP_PENDING_PACKETS
+	#define ipconfigARP_PENDING_PACKETS		0
+#endif
+
+/* The maximum number of packets held for a single IP address. */
+#ifndef ipconfigARP_PENDING_PACKETS_PER_ADDRESS
+	#define ipconfigARP_PENDING_PACKETS_PER_ADDRESS	2
+#endif
+
 #ifndef ipconfigUSE_ARP_REVERSED_LOOKUP
 	#define ipconfigUSE_ARP_REVERSED_LOOKUP		0
 #endif
@@ -356,6 +371,42 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigUDP_MAX_RX_PACKETS		0U
 #endif
 
+#ifndef ipconfigUSE_BUFFER_QUOTAS
+	/* When 1, the network buffers held in the reception lists of UDP sockets
+	 * are counted, and a packet is dropped early when its socket is over its
+	 * quota, so one socket can not take all the buffers of the pool.  The
+	 * sockets of the stack itself (DHCP, DNS) are exempt.  See
+	 * FreeRTOS_GetBufferStats().
+	 */
+	#define ipconfigUSE_BUFFER_QUOTAS		0
+#endif
+
+#ifndef ipconfigSOCKET_BUFFER_QUOTA
+	/* The largest number of network buffers one UDP socket may hold. */
+	#define ipconfigSOCKET_BUFFER_QUOTA		( ( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + 3 ) / 4 )
+#endif
+
+#ifndef ipconfigBUFFER_PRESSURE
+	/* When no more than this number of network buffers is free, a UDP socket
+	 * may not hold more than the average of the sockets that hold buffers, so
+	 * the sockets that hold the most are the first to lose packets.
+	 */
+	#define ipconfigBUFFER_PRESSURE			( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS / 4 )
+#endif
+
+#ifndef ipconfigBUFFER_RESERVE
+	/* The number of network buffers kept for ARP, ICMP, TCP and the sockets of
+	 * the stack itself.  When no more are free, UDP sockets of the application
+	 * can not take new buffers, neither to receive nor to send.  FreeRTOS_sendto()
+	 * waits up to the send timeout for a buffer above the reserve.
+	 */
+	#define ipconfigBUFFER_RESERVE			( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS / 8 )
+#endif
+
+#if( ( ipconfigUSE_BUFFER_QUOTAS == 1 ) && ( ipconfigBUFFER_RESERVE > ipconfigBUFFER_PRESSURE ) )
+	#error ipconfigBUFFER_RESERVE can not be larger than ipconfigBUFFER_PRESSURE
+#endif
+
 #ifndef ipconfigUSE_DHCP
 	#define ipconfigUSE_DHCP				1
 #endif
@@ -389,6 +440,95 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigTCP_MSS		( ipconfigNETWORK_MTU - ( ipSIZE_OF_IPv4_HEADER + ipSIZE_OF_TCP_HEADER  ) )
 #endif
 
+#ifndef ipconfigUSE_PATH_MTU_DISCOVERY
+	/* When 1, TCP segments are sent with the "Don't Fragment" flag, and the MSS
+	of a connection is lowered when a router answers with an ICMP "fragmentation
+	needed" message ( RFC 1191 ).  The path MTU is remembered per destination
+	for new connections.  Connections through a router still start with an
+	MSS of at most 1400 bytes, or less when a smaller path MTU was learned.
+	When a full-size segment is sent 3 times without an answer, e.g. because a
+	firewall drops the ICMP messages, the connection stops setting DF and
+	lowers its MSS to 1400 bytes.  Jumbo frames can be used with peers on the
+	local network by setting ipconfigNETWORK_MTU to e.g. 9000, when the driver
+	supports them. */
+	#define ipconfigUSE_PATH_MTU_DISCOVERY		0
+#endif
+
+#ifndef ipconfigPATH_MTU_CACHE_ENTRIES
+	/* The number of destinations for which a path MTU is remembered. */
+	#define ipconfigPATH_MTU_CACHE_ENTRIES		4
+#endif
+
+#ifndef ipconfigPATH_MTU_AGE_MS
+	/* After this time, a remembered path MTU is forgotten and the full MTU is
+	tried again.  RFC 1191 recommends 10 minutes. */
+	#define ipconfigPATH_MTU_AGE_MS				( 10U * 60U * 1000U )
+#endif
+
+#ifndef ipconfigTCP_PACING
+	/* When 1, a TCP socket can be given a transmission rate with the
+	FREERTOS_SO_TCP_PACING_RATE option.  prvTCPSendRepeated() then spreads the
+	segments of a window over time, in stead of sending them back-to-back,
+	which avoids overflowing shallow buffers in switches and routers. */
+	#define ipconfigTCP_PACING					0
+#endif
+
+#ifndef ipconfigTCP_PACING_BURST
+	/* The number of full-sized segments that a paced socket may send in a row
+	after it has been idle. */
+	#define ipconfigTCP_PACING_BURST			2
+#endif
+
+#ifndef ipconfigUSE_TCP_RACK_TLP
+	/* When 1, the sliding window also detects lost segments by time ( RACK,
+	RFC 8985 ): a segment is retransmitted when a segment that was sent later
+	has been acknowledged, and a reordering window has passed.  When the last
+	segments of a flight get no response, the highest one is sent again after
+	a probe time-out of about 2 round-trips ( Tail Loss Probe ), so the peer's
+	SACK reveals the losses before the retransmission timer expires.  Requires
+	ipconfigUSE_TCP_WIN. */
+	#define ipconfigUSE_TCP_RACK_TLP			0
+#endif
+
+#ifndef ipconfigTCP_SACK_BLOCKS
+	/* The maximum number of blocks in the Selective ACK option that is sent
+	while out-of-order data is stored, 1 to 4.  The block holding the most
+	recently received segment comes first.  The option takes 4 + 8 * N bytes,
+	so the TCP options area of each packet buffer needs 4 more bytes for 2
+	blocks than for 1, and 8 more bytes for every further block.  Requires
+	ipconfigUSE_TCP_WIN. */
+	#define ipconfigTCP_SACK_BLOCKS				1
+#endif
+
+#if ( ipconfigTCP_SACK_BLOCKS < 1 ) || ( ipconfigTCP_SACK_BLOCKS > 4 )
+	#error ipconfigTCP_SACK_BLOCKS must be between 1 and 4.
+#endif
+
+#ifndef ipconfigUSE_TCP_FAST_OPEN
+	/* When 1, TCP Fast Open ( RFC 7413 ) can be enabled per socket with the
+	FREERTOS_SO_TCP_FASTOPEN option.  A listening socket hands out cookies to
+	its clients, and accepts data carried in the SYN of a client that shows a
+	valid cookie.  A client remembers the cookies it received, and
+	FreeRTOS_sendto() with the FREERTOS_MSG_FASTOPEN flag connects and sends
+	the first data in the SYN, saving a round-trip. */
+	#define ipconfigUSE_TCP_FAST_OPEN			0
+#endif
+
+#ifndef ipconfigTCP_FAST_OPEN_CACHE_SIZE
+	/* The number of servers for which a client remembers a Fast Open cookie. */
+	#define ipconfigTCP_FAST_OPEN_CACHE_SIZE	8
+#endif
+
+#ifndef ipconfigUSE_TCP_ECN
+	/* When 1, TCP connections negotiate Explicit Congestion Notification
+	( RFC 3168 ).  New data is sent as ECN-capable ( ECT(0) ), a Congestion
+	Experienced mark on a received segment is echoed to the peer, and an echo
+	from the peer halves the transmission window, like a lost segment would,
+	but without the retransmission.  The window grows back by one MSS per
+	round-trip. */
+	#define ipconfigUSE_TCP_ECN					0
+#endif
+
 /* Each TCP socket has circular stream buffers for Rx and Tx, which
  * have a fixed maximum size.
  * The defaults for these size are defined here, although
@@ -539,6 +679,15 @@ answers on successive calls to FreeRTOS_gethostbyname(). */
 	#define ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM 0
 #endif
 
+#ifndef ipconfigUSE_HEADER_TEMPLATES
+	/* When 1, the part of the IP header checksum and of the pseudo-header
+	checksum that does not change from packet to packet is calculated once:
+	per TCP socket, and once for the UDP header template.  Outgoing packets
+	only add their length and identification to it.  Only used when
+	ipconfigDRIVER_INCLUDED_TX_IP_CHECKSUM is 0. */
+	#define ipconfigUSE_HEADER_TEMPLATES 0
+#endif
+
 #ifndef ipconfigDHCP_REGISTER_HOSTNAME
 	#define ipconfigDHCP_REGISTER_HOSTNAME 0
 #endif
@@ -586,6 +735,159 @@ connections, hang protection can help reduce the impact of SYN floods. */
 	#define ipconfigTCP_IP_SANITY 0
 #endif
 
+/* When set to 1, FreeRTOS_send() adds its socket to a list of sockets with
+pending data and the IP-task only checks the sockets in that list.  When set
+to 0, each call to FreeRTOS_send() makes the IP-task check all TCP sockets. */
+#ifndef ipconfigTCP_TX_WORK_LIST
+	#define ipconfigTCP_TX_WORK_LIST 0
+#endif
+
+/* When set to 1, the stack is protected by a mutex instead of being owned by
+the IP-task alone.  FreeRTOS_sendto() ( UDP ), FreeRTOS_bind(),
+FreeRTOS_closesocket() and FreeRTOS_send() ( with ipconfigTCP_TX_WORK_LIST )
+take the mutex and do the protocol work in the calling task, so they do not
+wait for the IP-task to be scheduled.  The IP-task keeps the timers and the
+reception of packets.  The mutex gives priority inheritance to a task that
+holds it while a higher priority task is waiting. */
+#ifndef ipconfigUSE_STACK_LOCK
+	#define ipconfigUSE_STACK_LOCK 0
+#endif
+
+/* When set to 1, a task that blocks on a socket is woken up with a direct to
+task notification, and sockets do not have an event group.  Only one task may
+block on a socket at any time, and that task must not use its notification
+value for other purposes while it calls the sockets API (see
+xTaskNotifyWait()).  Event groups are still used by socket sets. */
+#ifndef ipconfigSOCKET_USE_TASK_NOTIFICATIONS
+	#define ipconfigSOCKET_USE_TASK_NOTIFICATIONS 0
+#endif
+
+/* When set to 1, sockets and their event groups are taken from a statically
+allocated pool of ipconfigSOCKET_POOL_COUNT entries, and TCP stream buffers
+are taken from two pools of fixed size buffers.  A stream buffer comes from the
+smallest pool with buffers large enough to hold it, only stream buffers larger
+than both pool sizes are allocated with pvPortMallocLarge().  When a pool is
+empty the allocation fails just like a failed malloc() would.  Requires
+configSUPPORT_STATIC_ALLOCATION to be 1, unless
+ipconfigSOCKET_USE_TASK_NOTIFICATIONS is 1. */
+#ifndef ipconfigUSE_SOCKET_POOLS
+	#define ipconfigUSE_SOCKET_POOLS 0
+#endif
+
+/* The number of UDP and TCP sockets that can exist at the same time when
+ipconfigUSE_SOCKET_POOLS is 1.  Must be at least 1. */
+#ifndef ipconfigSOCKET_POOL_COUNT
+	#define ipconfigSOCKET_POOL_COUNT 16
+#endif
+
+/* The stream lengths and the number of buffers in each of the two stream
+buffer pools.  The counts must be at least 1.  By default one pool fits the
+default Rx stream and the other the default Tx stream. */
+#ifndef ipconfigSTREAM_POOL_0_LENGTH
+	#define ipconfigSTREAM_POOL_0_LENGTH ( ipconfigTCP_RX_BUFFER_LENGTH )
+#endif
+
+#ifndef ipconfigSTREAM_POOL_0_COUNT
+	#define ipconfigSTREAM_POOL_0_COUNT ( ipconfigSOCKET_POOL_COUNT )
+#endif
+
+#ifndef ipconfigSTREAM_POOL_1_LENGTH
+	#define ipconfigSTREAM_POOL_1_LENGTH ( ( ( ipconfigTCP_TX_BUFFER_LENGTH + ipconfigTCP_MSS - 1 ) / ipconfigTCP_MSS ) * ipconfigTCP_MSS )
+#endif
+
+#ifndef ipconfigSTREAM_POOL_1_COUNT
+	#define ipconfigSTREAM_POOL_1_COUNT ( ipconfigSOCKET_POOL_COUNT )
+#endif
+
+/* When set to 1, the reception stream of a TCP connection starts small and
+grows on demand, up to the length set with FREERTOS_SO_RCVBUF.  The transmission
+stream can not be resized, because the segments of the sliding window refer to
+positions within it.  It is always created with the full FREERTOS_SO_SNDBUF
+length, and only released when all of its data has been acknowledged.  The
+IP-task releases the empty streams of a connection that has not been used for
+ipconfigTCP_STREAM_IDLE_RELEASE_MS, so an idle connection holds very little RAM.
+Streams that have been handed out with the zero-copy API's are never moved or
+released. */
+#ifndef ipconfigTCP_ELASTIC_STREAMS
+	#define ipconfigTCP_ELASTIC_STREAMS 0
+#endif
+
+/* The length of a new reception stream when ipconfigTCP_ELASTIC_STREAMS is 1.
+The stream doubles in size whenever the incoming data does not fit. */
+#ifndef ipconfigTCP_STREAM_INITIAL_LENGTH
+	#define ipconfigTCP_STREAM_INITIAL_LENGTH ( 2 * ipconfigTCP_MSS )
+#endif
+
+/* The time in ms after which the empty streams of an idle connection are
+released, when ipconfigTCP_ELASTIC_STREAMS is 1. */
+#ifndef ipconfigTCP_STREAM_IDLE_RELEASE_MS
+	#define ipconfigTCP_STREAM_IDLE_RELEASE_MS 10000
+#endif
+
+/* When set to 1, the stack can use more than one network interface, and more
+than one IP address (end-point).  The network drivers describe themselves with
+a NetworkInterface_t, see FreeRTOS_Routing.h, and the stack routes outgoing
+packets to the interface of the end-point whose network contains the
+destination, or to the interface of the first end-point with a gateway.  The
+addresses passed to FreeRTOS_IPInit() belong to the primary end-point, which
+uses the first interface that was added.  When set to 0, the single network
+driver defines xNetworkInterfaceOutput() and xNetworkInterfaceInitialise(). */
+#ifndef ipconfigMULTI_INTERFACE
+	#define ipconfigMULTI_INTERFACE 0
+#endif
+
+#ifndef ipconfigSOCKET_HAS_TYPE_OF_SERVICE
+	/* When 1, FreeRTOS_setsockopt() accepts FREERTOS_SO_IP_TOS, which sets the
+	DSCP field in the IP header of all the packets that a socket sends. */
+	#define ipconfigSOCKET_HAS_TYPE_OF_SERVICE	0
+#endif
+
+#ifndef ipconfigUSE_TX_PRIORITY_QUEUES
+	/* When 1, all outgoing frames pass through ipconfigTX_PRIORITY_QUEUES
+	queues before they are given to the network driver.  The queue is chosen
+	from the DSCP field of the IP header, frames that are not IPv4 ( ARP ) go to
+	the highest queue.  Frames only wait in the queues when the driver has
+	ipconfigTX_PRIORITY_DRIVER_DEPTH frames in progress.  With the default
+	depth of 0 the queues are a pass-through: set a non-zero depth for a driver
+	that calls vNetworkInterfaceTxDone(). */
+	#define ipconfigUSE_TX_PRIORITY_QUEUES		0
+#endif
+
+#ifndef ipconfigTX_PRIORITY_QUEUES
+	/* The number of priority classes, 1 to 8.  The three highest bits of the
+	DSCP field ( the class selector ) are divided evenly over the classes. */
+	#define ipconfigTX_PRIORITY_QUEUES			4
+#endif
+
+#ifndef ipconfigTX_PRIORITY_WEIGHTS
+	/* The number of frames that each class, from the lowest to the highest,
+	may send per round while other classes have frames waiting.  A class with
+	a weight of 0 has strict priority: it is served before all the weighted
+	classes.  Must have ipconfigTX_PRIORITY_QUEUES entries. */
+	#define ipconfigTX_PRIORITY_WEIGHTS			{ 1U, 2U, 4U, 0U }
+#endif
+
+#ifndef ipconfigTX_PRIORITY_QUEUE_LENGTH
+	/* The maximum number of frames waiting in each class, further frames of
+	that class are dropped. */
+	#define ipconfigTX_PRIORITY_QUEUE_LENGTH	8
+#endif
+
+#ifndef ipconfigTX_PRIORITY_DRIVER_DEPTH
+	/* The number of frames that may be given to the driver before it reports
+	them as sent by calling vNetworkInterfaceTxDone(), normally the number of
+	its DMA descriptors.  When 0, the driver does not report, frames are passed
+	on without waiting and the priority scheduling is disabled.  The default is
+	0 because a driver that does not call vNetworkInterfaceTxDone() would stop
+	sending after the first frames.  The class of a frame is still available to
+	a driver with several hardware queues, see uxNetworkBufferTxPriority(). */
+	#define ipconfigTX_PRIORITY_DRIVER_DEPTH	0
+#endif
+
+#if ( ipconfigTX_PRIORITY_QUEUES < 1 ) || ( ipconfigTX_PRIORITY_QUEUES > 8 )
+	#error ipconfigTX_PRIORITY_QUEUES must be between 1 and 8.
+#endif
+
 #ifndef ipconfigARP_STORES_REMOTE_ADDRESSES
 	#define ipconfigARP_STORES_REMOTE_ADDRESSES 0
 #endif
@@ -62,6 +62,11 @@ typedef enum
  */
 void vARPRefreshCacheEntry( const MACAddress_t * pxMACAddress, const uint32_t ulIPAddress );
 
+/* Incremented whenever an ARP cache entry that may be in use changes or is
+removed, or the network addressing changes.  A MAC address that was looked up
+while ulARPGeneration had the same value is still valid. */
+extern uint32_t ulARPGeneration;
+
 #if( ipconfigARP_USE_CLASH_DETECTION != 0 )
 	/* Becomes non-zero if another device responded to a gratuitos ARP message. */
 	extern BaseType_t xARPHadIPClash;
@@ -94,6 +99,22 @@ eARPLookupResult_t eARPGetCacheEntry( uint32_t *pulIPAddress, MACAddress_t * con
 	/* Lookup an IP-address if only the MAC-address is known */
 	eARPLookupResult_t eARPGetCacheEntryByMac( MACAddress_t * const pxMACAddress, uint32_t *pulIPAddress );
 
+#endif
+#if( ipconfigARP_PENDING_PACKETS > 0 )
+
+	/*
+	 * Hold a packet that can not be sent because an ARP request for ulIPAddress
+	 * is outstanding.  The packet is passed to vProcessGeneratedUDPPacket()
+	 * again when the reply arrives, or released when the request expires.
+	 * Returns pdFALSE when the packet can not be held.
+	 */
+	BaseType_t xARPHoldPacket( NetworkBufferDescriptor_t * const pxNetworkBuffer, uint32_t ulIPAddress );
+
+	/*
+	 * Returns the number of packets held by xARPHoldPacket().
+	 */
+	UBaseType_t uxARPPendingPacketCount( void );
+
 #endif
 /*
  * Reduce the age count in each entry within the ARP cache.  An entry is no
@@ -135,6 +135,9 @@ typedef struct xNETWORK_BUFFER
 	#if( ipconfigUSE_LINKED_RX_MESSAGES != 0 )
 		struct xNETWORK_BUFFER *pxNextBuffer; /* Possible optimisation for expert users - requires network driver support. */
 	#endif
+	#if( ipconfigMULTI_INTERFACE == 1 )
+		struct xNetworkEndPoint *pxEndPoint; /* The end-point that received the packet, or through which it must be sent.  NULL when not known. */
+	#endif
 } NetworkBufferDescriptor_t;
 
 #include "pack_struct_start.h"
@@ -242,6 +242,8 @@ typedef enum
 	eSocketCloseEvent,		/*10: Send a message to the IP-task to close a socket. */
 	eSocketSelectEvent,		/*11: Send a message to the IP-task for select(). */
 	eSocketSignalEvent,		/*12: A socket must be signalled. */
+	eTCPTxEvent,			/*13: FreeRTOS_send() has added sockets to the TX work list. */
+	eNetworkTxDoneEvent,	/*14: The network interface has sent frames from the priority queues. */
 } eIPEvent_t;
 
 typedef struct IP_TASK_COMMANDS
@@ -258,6 +260,14 @@ as it is past the location into which the destination address will get placed. *
 #define ipFRAGMENTATION_PARAMETERS_OFFSET		( 6 )
 #define ipSOCKET_OPTIONS_OFFSET					( 6 )
 
+/* Like the socket options, the Type Of Service byte of a UDP socket is passed
+to the IP layer in space that will be overwritten by the Ethernet header. */
+#define ipSOCKET_TOS_OFFSET						( 7 )
+
+/* The "Don't Fragment" flag in the usFragmentOffset field of an IP header, in
+network byte order. */
+#define ipFRAGMENT_FLAGS_DONT_FRAGMENT			( FreeRTOS_htons( ( uint16_t ) 0x4000U ) )
+
 /* Only used when outgoing fragmentation is being used (FreeRTOSIPConfig.h
 setting. */
 #define ipGET_UDP_PAYLOAD_OFFSET_FOR_FRAGMENT( usFragmentOffset ) ( ( ( usFragmentOffset ) == 0 ) ? ipUDP_PAYLOAD_OFFSET_IPv4 : ipIP_PAYLOAD_OFFSET )
@@ -444,6 +454,12 @@ eFrameProcessingResult_t eConsiderFrameForProcessing( const uint8_t * const pucE
  */
 uint16_t usGenerateChecksum( uint16_t usSum, const uint8_t * pucNextData, size_t uxByteCount );
 
+/*
+ * Fold a sum of 16-bit words, in host order, into a 16-bit value that can be
+ * passed to usGenerateChecksum().
+ */
+uint16_t usFoldChecksum( uint32_t ulSum );
+
 /* Socket related private functions. */
 
 /*
@@ -464,6 +480,31 @@ void vNetworkSocketsInit( void );
  */
 BaseType_t xIPIsNetworkTaskReady( void );
 
+#if( ipconfigUSE_TX_PRIORITY_QUEUES != 0 )
+	/*
+	 * Called by the IP-task instead of xNetworkInterfaceOutput(): the frame is
+	 * sent right away when the driver has room and no frames are waiting,
+	 * otherwise it is queued according to its priority class.  A frame that
+	 * the caller keeps ( xReleaseAfterSend == pdFALSE ) is copied when queued.
+	 */
+	BaseType_t xIPTxQueueOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend );
+
+	/*
+	 * Called by the IP-task after every event: account for the frames that
+	 * the driver reported as sent, and pass waiting frames to it.
+	 */
+	void vIPTxQueueProcess( void );
+
+	/*
+	 * Drop all the waiting frames, when the network goes down.
+	 */
+	void vIPTxQueueFlush( void );
+
+	#define ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend )	xIPTxQueueOutput( ( pxNetworkBuffer ), ( xReleaseAfterSend ) )
+#else
+	#define ipNETWORK_INTERFACE_OUTPUT( pxNetworkBuffer, xReleaseAfterSend )	xNetworkInterfaceOutput( ( pxNetworkBuffer ), ( xReleaseAfterSend ) )
+#endif /* ipconfigUSE_TX_PRIORITY_QUEUES */
+
 #if( ipconfigSOCKET_HAS_USER_WAKE_CALLBACK == 1 )
 	struct xSOCKET;
 	typedef void (*SocketWakeupCallback_t)( struct xSOCKET * pxSocket );
@@ -482,6 +523,22 @@ BaseType_t xIPIsNetworkTaskReady( void );
 	 */
 	TickType_t xTCPTimerCheck( BaseType_t xWillSleep );
 
+	#if( ipconfigARP_PENDING_PACKETS > 0 )
+		/*
+		 * Called by ARP when a reply has arrived: sockets that are waiting for
+		 * ARP in connect() will try again right away.
+		 */
+		void vSocketWakeUpConnecting( void );
+	#endif
+
+	#if( ipconfigTCP_TX_WORK_LIST == 1 )
+		/*
+		 * Check the sockets to which FreeRTOS_send() has added data, returning
+		 * the shortest time-out of these sockets, or portMAX_DELAY.
+		 */
+		TickType_t xTCPTxWorkListProcess( void );
+	#endif
+
 	/* Every TCP socket has a buffer space just big enough to store
 	the last TCP header received.
 	As a reference of this field may be passed to DMA, force the
@@ -511,6 +568,15 @@ BaseType_t xIPIsNetworkTaskReady( void );
 	typedef struct TCPSOCKET
 	{
 		uint32_t ulRemoteIP;		/* IP address of remote machine */
+		#if( ipconfigMULTI_INTERFACE == 1 )
+			struct xNetworkEndPoint *pxEndPoint;	/* The end-point through which the connection was accepted or made, NULL before that */
+		#endif
+		uint32_t ulARPGeneration;	/* The value of ulARPGeneration when the peer's MAC address in xPacket was last looked up */
+		#if( ipconfigUSE_HEADER_TEMPLATES != 0 )
+			uint32_t ulTemplateSourceIP;	/* The local IP address for which the two sums below were calculated, or 0 */
+			uint16_t usTemplateIPSum;		/* Sum of the IP header, without the first word, length, identification and checksum */
+			uint16_t usTemplatePseudoSum;	/* Sum of the pseudo header, without the TCP length */
+		#endif
 		uint16_t usRemotePort;		/* Port on remote machine */
 		struct {
 			/* Most compilers do like bit-flags */
@@ -540,6 +606,23 @@ BaseType_t xIPIsNetworkTaskReady( void );
 				bFinLast : 1,		/* The last ACK (after FIN and FIN+ACK) has been sent or will be sent by the peer */
 				bRxStopped : 1,		/* Application asked to temporarily stop reception */
 				bMallocError : 1,	/* There was an error allocating a stream */
+				#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+					bStreamsPinned : 1,	/* The application has a direct pointer into a stream, it may not be moved or released */
+				#endif /* ipconfigTCP_ELASTIC_STREAMS */
+				#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+					bFastOpen : 1,		/* TCP Fast Open was enabled with FREERTOS_SO_TCP_FASTOPEN or FREERTOS_MSG_FASTOPEN */
+					bFastOpenCookie : 1,/* Server: the peer asked for a cookie, or showed an invalid one: send a cookie in the SYN+ACK */
+					bFastOpenValid : 1,	/* Server: the SYN carried a valid cookie, its data may be accepted */
+					bFastOpenSynAck : 1,/* Server: the connection was established by a SYN with data, the SYN+ACK has not been acknowledged yet */
+				#endif /* ipconfigUSE_TCP_FAST_OPEN */
+				#if( ipconfigUSE_TCP_ECN == 1 )
+					bEcnOk : 1,			/* Both parties agreed to use ECN in the SYN phase */
+					bEcnEcho : 1,		/* A segment was received with a CE mark, send ECE until the peer sends CWR */
+					bEcnCwr : 1,		/* The Tx window was reduced after an ECE, send CWR with the next new data */
+				#endif /* ipconfigUSE_TCP_ECN */
+				#if( ipconfigUSE_PATH_MTU_DISCOVERY != 0 )
+					bNoDontFragment : 1,/* Full-size segments were not acknowledged: a path MTU black hole, do not set DF any more */
+				#endif /* ipconfigUSE_PATH_MTU_DISCOVERY */
 				bWinScaling : 1;	/* A TCP-Window Scaling option was offered and accepted in the SYN phase. */
 		} bits;
 		uint32_t ulHighestRxAllowed;
@@ -561,12 +644,25 @@ BaseType_t xIPIsNetworkTaskReady( void );
 		#if( ipconfigTCP_HANG_PROTECTION == 1 )
 			TickType_t xLastActTime;
 		#endif /* ipconfigTCP_HANG_PROTECTION */
+		#if( ipconfigTCP_PACING == 1 )
+			uint32_t ulPacingRate;		/* Set by FREERTOS_SO_TCP_PACING_RATE: bytes per second, FREERTOS_TCP_PACING_OFF or FREERTOS_TCP_PACING_AUTO */
+			int32_t lPacingCredit;		/* The number of bytes that may be sent now, it becomes negative when a segment was larger */
+			TickType_t xPacingTime;		/* The time at which lPacingCredit was last updated */
+		#endif /* ipconfigTCP_PACING */
+		#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+			uint16_t usFastOpenLength;	/* Client: the number of data bytes that were sent along with the SYN */
+		#endif /* ipconfigUSE_TCP_FAST_OPEN */
 		size_t uxLittleSpace;
 		size_t uxEnoughSpace;
 		size_t uxRxStreamSize;
 		size_t uxTxStreamSize;
 		StreamBuffer_t *rxStream;
 		StreamBuffer_t *txStream;
+		#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+			TickType_t xStreamLastUse;				/* Time of the last data movement through the streams */
+			volatile UBaseType_t uxRxStreamUsers;	/* Number of API calls copying from the rxStream right now */
+			volatile UBaseType_t uxTxStreamUsers;	/* Number of API calls using the txStream right now */
+		#endif /* ipconfigTCP_ELASTIC_STREAMS */
 		#if( ipconfigUSE_TCP_WIN == 1 )
 			NetworkBufferDescriptor_t *pxAckMessage;
 		#endif /* ipconfigUSE_TCP_WIN */
@@ -588,6 +684,9 @@ BaseType_t xIPIsNetworkTaskReady( void );
 		uint32_t ulWindowSize;		/* Current Window size advertised by peer */
 		size_t uxRxWinSize;	/* Fixed value: size of the TCP reception window */
 		size_t uxTxWinSize;	/* Fixed value: size of the TCP transmit window */
+		#if( ipconfigTCP_TX_WORK_LIST == 1 )
+			ListItem_t xTxWorkListItem;	/* Used to reference the socket from the TX work list. */
+		#endif
 
 		TCPWindow_t xTCPWindow;
 	} IPTCPSocket_t;
@@ -600,6 +699,10 @@ typedef struct UDPSOCKET
 	#if( ipconfigUDP_MAX_RX_PACKETS > 0 )
 		UBaseType_t uxMaxPackets; /* Protection: limits the number of packets buffered per socket */
 	#endif /* ipconfigUDP_MAX_RX_PACKETS */
+	#if( ipconfigUSE_BUFFER_QUOTAS == 1 )
+		BaseType_t xControl;		/* pdTRUE for the sockets of the stack itself, which have no quota. */
+		uint32_t ulBufferDrops;		/* Packets dropped because the socket was over its quota. */
+	#endif /* ipconfigUSE_BUFFER_QUOTAS */
 	#if( ipconfigUSE_CALLBACKS == 1 )
 		FOnUDPReceive_t pxHandleReceive;	/*
 											 * In case of a UDP socket:
@@ -624,7 +727,12 @@ enum eSOCKET_EVENT {
 typedef struct xSOCKET
 {
 	EventBits_t xEventBits;
-	EventGroupHandle_t xEventGroup;
+	#if( ipconfigSOCKET_USE_TASK_NOTIFICATIONS == 1 )
+		EventBits_t xSocketEvents;	/* Events that were not yet consumed by the user. */
+		TaskHandle_t xWaitingTask;	/* The task that is blocked on this socket, if any. */
+	#else
+		EventGroupHandle_t xEventGroup;
+	#endif
 
 	ListItem_t xBoundSocketListItem; /* Used to reference the socket from a bound sockets list. */
 	TickType_t xReceiveBlockTime; /* if recv[to] is called while no data is available, wait this amount of time. Unit in clock-ticks */
@@ -633,12 +741,18 @@ typedef struct xSOCKET
 	uint16_t usLocalPort;		/* Local port on this machine */
 	uint8_t ucSocketOptions;
 	uint8_t ucProtocol; /* choice of FREERTOS_IPPROTO_UDP/TCP */
+	#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+		uint8_t ucTypeOfService;	/* Set by FREERTOS_SO_IP_TOS, the ECN bits are always 0 here. */
+	#endif /* ipconfigSOCKET_HAS_TYPE_OF_SERVICE */
 	#if( ipconfigSOCKET_HAS_USER_SEMAPHORE == 1 )
 		SemaphoreHandle_t pxUserSemaphore;
 	#endif /* ipconfigSOCKET_HAS_USER_SEMAPHORE */
 	#if( ipconfigSOCKET_HAS_USER_WAKE_CALLBACK == 1 )
 		SocketWakeupCallback_t pxUserWakeCallback;
 	#endif /* ipconfigSOCKET_HAS_USER_WAKE_CALLBACK */
+	#if( ipconfigSUPPORT_SIGNALS != 0 ) && ( ipconfigUSE_STACK_LOCK != 0 )
+		UBaseType_t uxSignalsPending;	/* The eSocketSignalEvent's in the event queue, a close must wait for them. */
+	#endif
 
 	#if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
 		struct xSOCKET_SET *pxSocketSet;
@@ -671,6 +785,15 @@ typedef struct xSOCKET
 	 */
 	FreeRTOS_Socket_t *pxTCPSocketLookup( uint32_t ulLocalIP, UBaseType_t uxLocalPort, uint32_t ulRemoteIP, UBaseType_t uxRemotePort );
 
+	#if( ipconfigUSE_PATH_MTU_DISCOVERY != 0 )
+		/*
+		 * Called by the IP-task when an ICMP "fragmentation needed" message is
+		 * received.  The path MTU to the destination is lowered, as well as the
+		 * MSS of the connection that sent the packet.
+		 */
+		void vTCPFragmentationNeeded( const NetworkBufferDescriptor_t *pxNetworkBuffer );
+	#endif
+
 #endif /* ipconfigUSE_TCP */
 
 /*
@@ -715,11 +838,59 @@ BaseType_t vSocketBind( FreeRTOS_Socket_t *pxSocket, struct freertos_sockaddr *
  */
 int32_t lTCPAddRxdata(FreeRTOS_Socket_t *pxSocket, size_t uxOffset, const uint8_t *pcData, uint32_t ulByteCount);
 
+/*
+ * The number of bytes that can still be stored in the rxStream.  When
+ * 'xFromFront' is true, out-of-order data beyond the head is counted as used.
+ * With elastic streams this is the space of a full size stream, no matter how
+ * large the stream is right now.
+ */
+size_t uxTCPRxSpace( const FreeRTOS_Socket_t *pxSocket, BaseType_t xFromFront );
+
+#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+	/*
+	 * Called by the IP-task before storing 'uxCount' bytes at 'uxOffset' in the
+	 * rxStream: make sure that the stream exists and is large enough.
+	 */
+	void vTCPRxStreamReserve( FreeRTOS_Socket_t *pxSocket, size_t uxOffset, size_t uxCount );
+#endif /* ipconfigTCP_ELASTIC_STREAMS */
+
 /*
  * Currently called for any important event.
  */
 void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket );
 
+/*
+ * Set eSOCKET_ events of a socket, waking up the task that waits for them.
+ */
+void vSocketSetEvents( FreeRTOS_Socket_t *pxSocket, EventBits_t xBitsToSet );
+
+/*
+ * Wait for at least one of the events in xBitsToWaitFor, like
+ * xEventGroupWaitBits() with xClearOnExit set: the events waited for are
+ * cleared and the events that were set are returned.
+ */
+EventBits_t xSocketWaitEvents( FreeRTOS_Socket_t *pxSocket, EventBits_t xBitsToWaitFor, TickType_t xTicksToWait );
+
+#if( ipconfigUSE_BUFFER_QUOTAS == 1 )
+	/*
+	 * Called by the IP-task before a received packet is added to the reception
+	 * list of a UDP socket.  Returns pdFAIL, and counts the drop, when the
+	 * socket is over its quota.
+	 */
+	BaseType_t xSocketBufferQuotaCheck( FreeRTOS_Socket_t *pxSocket );
+
+	/*
+	 * Called just after a network buffer was added to ( xAdded == pdTRUE ) or
+	 * removed from the reception list of a UDP socket.
+	 */
+	void vSocketBufferQuotaUpdate( const FreeRTOS_Socket_t *pxSocket, BaseType_t xAdded );
+
+	/*
+	 * Marks a socket of the stack itself, which is not limited by a quota.
+	 */
+	void vSocketSetControl( Socket_t xSocket );
+#endif /* ipconfigUSE_BUFFER_QUOTAS */
+
 /*
  * Some helping function, their meaning should be clear
  */
@@ -788,7 +959,8 @@ NetworkBufferDescriptor_t *pxUDPPayloadBuffer_to_NetworkBuffer( const void * pvB
 	void vTCPStateChange( FreeRTOS_Socket_t *pxSocket, enum eTCP_STATE eTCPState );
 #endif /* ipconfigUSE_TCP */
 
-/* Returns pdTRUE is this function is called from the IP-task */
+/* Returns pdTRUE is this function is called from the IP-task, or from a task
+that holds the stack lock ( see ipconfigUSE_STACK_LOCK ). */
 BaseType_t xIsCallingFromIPTask( void );
 
 #if( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
@@ -0,0 +1,138 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#ifndef FREERTOS_ROUTING_H
+#define FREERTOS_ROUTING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Application level configuration options. */
+#include "FreeRTOSIPConfig.h"
+#include "FreeRTOSIPConfigDefaults.h"
+#include "FreeRTOS_IP.h"
+
+#if( ipconfigMULTI_INTERFACE == 1 )
+
+struct xNetworkInterface;
+
+/* The functions that a network driver provides for each of its interfaces.
+They have the same meaning as xNetworkInterfaceInitialise(),
+xNetworkInterfaceOutput() and xGetPhyLinkStatus() in a single interface
+build. */
+typedef BaseType_t ( * NetworkInterfaceInitialiseFunction_t ) ( struct xNetworkInterface *pxInterface );
+typedef BaseType_t ( * NetworkInterfaceOutputFunction_t ) ( struct xNetworkInterface *pxInterface, NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend );
+typedef BaseType_t ( * NetworkInterfaceLinkStatusFunction_t ) ( struct xNetworkInterface *pxInterface );
+
+/* A network interface, normally one Ethernet port.  The structure is owned by
+the application or the driver, it must stay valid as long as the stack runs. */
+typedef struct xNetworkInterface
+{
+	const char *pcName;									/* Just for logging. */
+	void *pvArgument;									/* Free for the driver, e.g. the index of the EMAC. */
+	NetworkInterfaceInitialiseFunction_t pfInitialise;
+	NetworkInterfaceOutputFunction_t pfOutput;
+	NetworkInterfaceLinkStatusFunction_t pfGetPhyLinkStatus;	/* May be NULL. */
+	MACAddress_t xMACAddress;
+	BaseType_t xIsUp;									/* pfInitialise() has returned pdPASS. */
+	struct xNetworkInterface *pxNext;
+} NetworkInterface_t;
+
+/* An IP address with its network, bound to an interface.  Addresses are
+stored in network byte order. */
+typedef struct xNetworkEndPoint
+{
+	uint32_t ulIPAddress;
+	uint32_t ulNetMask;
+	uint32_t ulGatewayAddress;		/* Zero when the network has no gateway. */
+	uint32_t ulBroadcastAddress;
+	NetworkInterface_t *pxNetworkInterface;
+	struct xNetworkEndPoint *pxNext;
+} NetworkEndPoint_t;
+
+/*
+ * Add a network interface.  Must be called before FreeRTOS_IPInit().  The
+ * first interface added carries the primary end-point, and gets the MAC
+ * address that is passed to FreeRTOS_IPInit().
+ */
+NetworkInterface_t *FreeRTOS_AddNetworkInterface( NetworkInterface_t *pxInterface );
+
+/*
+ * Add an extra IP address to an interface.  Must be called before
+ * FreeRTOS_IPInit().  The gateway address may be NULL or 0.0.0.0 when the
+ * network has no gateway.
+ */
+NetworkEndPoint_t *FreeRTOS_AddEndPoint( NetworkInterface_t *pxInterface,
+										 NetworkEndPoint_t *pxEndPoint,
+										 const uint8_t ucIPAddress[ ipIP_ADDRESS_LENGTH_BYTES ],
+										 const uint8_t ucNetMask[ ipIP_ADDRESS_LENGTH_BYTES ],
+										 const uint8_t ucGatewayAddress[ ipIP_ADDRESS_LENGTH_BYTES ] );
+
+/*
+ * Iterate through the interfaces, in the order in which they were added.
+ */
+NetworkInterface_t *FreeRTOS_FirstNetworkInterface( void );
+NetworkInterface_t *FreeRTOS_NextNetworkInterface( const NetworkInterface_t *pxInterface );
+
+/*
+ * Iterate through the end-points, starting with the primary end-point.
+ */
+NetworkEndPoint_t *FreeRTOS_FirstEndPoint( void );
+NetworkEndPoint_t *FreeRTOS_NextEndPoint( const NetworkEndPoint_t *pxEndPoint );
+
+/*
+ * Find the end-point that owns the IP address, or NULL.
+ */
+NetworkEndPoint_t *FreeRTOS_FindEndPointOnIP( uint32_t ulIPAddress );
+
+/*
+ * Find the end-point whose directed broadcast address is ulIPAddress, or NULL.
+ */
+NetworkEndPoint_t *FreeRTOS_FindEndPointOnBroadcast( uint32_t ulIPAddress );
+
+/*
+ * Find the end-point on whose network ulIPAddress lives, or NULL.
+ */
+NetworkEndPoint_t *FreeRTOS_FindEndPointOnNetMask( uint32_t ulIPAddress );
+
+/*
+ * The routing decision: the end-point on whose network ulIPAddress lives, or
+ * else the first end-point that has a gateway, or else the primary end-point.
+ */
+NetworkEndPoint_t *FreeRTOS_FindEndPointForRoute( uint32_t ulIPAddress );
+
+/*
+ * Find the interface that has the given MAC address, or NULL.
+ */
+NetworkInterface_t *FreeRTOS_FindInterfaceOnMAC( const MACAddress_t *pxMACAddress );
+
+#endif /* ipconfigMULTI_INTERFACE */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* FREERTOS_ROUTING_H */
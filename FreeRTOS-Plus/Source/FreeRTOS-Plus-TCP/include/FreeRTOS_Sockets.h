@@ -132,6 +132,22 @@ FreeRTOS_setsockopt(). */
 
 #define FREERTOS_SO_SET_LOW_HIGH_WATER	( 18 )
 
+#if( ipconfigTCP_PACING == 1 )
+	#define FREERTOS_SO_TCP_PACING_RATE	( 19 )		/* Limit the transmission rate of a TCP socket, parameter is pointer to uint32_t ( bytes per second ) */
+
+	/* Values for FREERTOS_SO_TCP_PACING_RATE other than a rate. */
+	#define FREERTOS_TCP_PACING_OFF		( 0UL )				/* Send as fast as the window allows */
+	#define FREERTOS_TCP_PACING_AUTO	( 0xFFFFFFFFUL )	/* Derive the rate from the window and the round-trip time */
+#endif
+
+#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+	#define FREERTOS_SO_IP_TOS			( 20 )		/* Set the Type Of Service byte of the IP header, parameter is pointer to uint8_t ( DSCP << 2 ) */
+#endif
+
+#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+	#define FREERTOS_SO_TCP_FASTOPEN	( 21 )		/* Enable TCP Fast Open on a listening or connecting socket, parameter is pointer to BaseType_t */
+#endif
+
 #define FREERTOS_NOT_LAST_IN_FRAGMENTED_PACKET 	( 0x80 )  /* For internal use only, but also part of an 8-bit bitwise value. */
 #define FREERTOS_FRAGMENTED_PACKET				( 0x40 )  /* For internal use only, but also part of an 8-bit bitwise value. */
 
@@ -145,6 +161,9 @@ FreeRTOS_setsockopt(). */
 #define FREERTOS_MSG_PEEK				( 4 )		/* peek at incoming message */
 #define FREERTOS_MSG_DONTROUTE			( 8 )		/* send without using routing tables */
 #define FREERTOS_MSG_DONTWAIT			( 16 )		/* Can be used with recvfrom(), sendto(), recv(), and send(). */
+#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+	#define FREERTOS_MSG_FASTOPEN		( 32 )		/* sendto() on a TCP socket: connect and send the data along with the SYN */
+#endif
 
 typedef struct xWIN_PROPS {
 	/* Properties of the Tx buffer and Tx window */
@@ -386,6 +405,45 @@ const struct xSTREAM_BUFFER *FreeRTOS_get_rx_buf( Socket_t xSocket );
 
 void FreeRTOS_netstat( void );
 
+#if( ipconfigUSE_SOCKET_POOLS == 1 )
+
+	/* The pools that can be passed to FreeRTOS_GetPoolStats(). */
+	#define FREERTOS_POOL_SOCKETS		( 0 )
+	#define FREERTOS_POOL_STREAM_0		( 1 )
+	#define FREERTOS_POOL_STREAM_1		( 2 )
+
+	/*
+	 * Obtain the number of free entries in one of the pools, and the lowest
+	 * number of free entries seen since the pool was created.  Returns pdFAIL
+	 * if xPool is not one of the FREERTOS_POOL_ values above.
+	 */
+	BaseType_t FreeRTOS_GetPoolStats( BaseType_t xPool, UBaseType_t *puxFree, UBaseType_t *puxMinimumFree );
+
+#endif /* ipconfigUSE_SOCKET_POOLS */
+
+#if( ipconfigUSE_BUFFER_QUOTAS == 1 )
+
+	/* Who holds the network buffers, see FreeRTOS_GetBufferStats(). */
+	typedef struct xBUFFER_STATS
+	{
+		UBaseType_t uxFree;			/* The number of network buffers free now. */
+		UBaseType_t uxMinimumFree;	/* The lowest number free since start-up. */
+		UBaseType_t uxUDPHeld;		/* Held in the reception lists of the application's UDP sockets. */
+		UBaseType_t uxControlHeld;	/* Held in the reception lists of the stack's own sockets (DHCP, DNS). */
+		UBaseType_t uxARPHeld;		/* Held until an ARP reply arrives. */
+		uint32_t ulQuotaDrops;		/* Packets dropped because their socket was over its quota. */
+		uint32_t ulReserveDrops;	/* Packets dropped or not sent to keep ipconfigBUFFER_RESERVE buffers free. */
+	} BufferStats_t;
+
+	/*
+	 * Obtain the number of network buffers held by each kind of user, and the
+	 * number of packets dropped by the quotas.  FreeRTOS_netstat() prints the
+	 * buffers held and the drops of each UDP socket.
+	 */
+	void FreeRTOS_GetBufferStats( BufferStats_t *pxStats );
+
+#endif /* ipconfigUSE_BUFFER_QUOTAS */
+
 #if ipconfigSUPPORT_SELECT_FUNCTION == 1
 
 	/* For FD_SET and FD_CLR, a combination of the following bits can be used: */
@@ -78,7 +78,17 @@ typedef struct xTCP_WINSIZE
  * each packet, and thus the message space will become smaller
  */
 /* Keep this as a multiple of 4 */
-#if( ipconfigUSE_TCP_WIN == 1 )
+#if( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigTCP_SACK_BLOCKS > 2 )
+	/* NOP, NOP, SACK, LEN, followed by a pair of sequence numbers per block. */
+	#define ipSIZE_TCP_OPTIONS	( 4U + ( 8U * ( uint32_t ) ipconfigTCP_SACK_BLOCKS ) )
+#elif( ipconfigUSE_TCP_FAST_OPEN == 1 )
+	/* A SYN carries MSS, window scaling and SACK-permitted ( 12 bytes ),
+	followed by NOP, NOP, FASTOPEN, LEN and an 8-byte cookie. */
+	#define ipSIZE_TCP_OPTIONS	24U
+#elif( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigTCP_SACK_BLOCKS > 1 )
+	/* NOP, NOP, SACK, LEN, followed by a pair of sequence numbers per block. */
+	#define ipSIZE_TCP_OPTIONS	( 4U + ( 8U * ( uint32_t ) ipconfigTCP_SACK_BLOCKS ) )
+#elif( ipconfigUSE_TCP_WIN == 1 )
 	#define ipSIZE_TCP_OPTIONS	16U
 #else
 	#define ipSIZE_TCP_OPTIONS	12U
@@ -97,6 +107,13 @@ typedef struct xTCP_WINDOW
 			uint32_t
 				bHasInit : 1,		/* The window structure has been initialised */
 				bSendFullSize : 1,	/* May only send packets with a size equal to MSS (for optimisation) */
+				#if( ipconfigUSE_TCP_RACK_TLP == 1 )
+					bProbeSent : 1,	/* A tail loss probe has been sent, no new one until data has been acknowledged */
+				#endif
+				#if( ipconfigUSE_TCP_ECN == 1 )
+					bCongestion : 1,	/* The Tx window was reduced, ulCongestionRecover is valid */
+					bTxRetransmit : 1,	/* The segment returned by ulTCPWindowTxGet() has been sent before */
+				#endif
 				bTimeStamps : 1;	/* Socket is supposed to use TCP time-stamps. This depends on the */
 		} bits;						/* party which opens the connection */
 		uint32_t ulFlags;
@@ -116,7 +133,21 @@ typedef struct xTCP_WINDOW
 	uint32_t ulUserDataLength;			/* Number of bytes in Rx buffer which may be passed to the user, after having received a 'missing packet' */
 	uint32_t ulNextTxSequenceNumber;	/* The sequence number given to the next byte to be added for transmission */
 	int32_t lSRTT;						/* Smoothed Round Trip Time, it may increment quickly and it decrements slower */
+#if( ipconfigUSE_TCP_RACK_TLP == 1 )
+	int32_t lProbeSRTT;					/* Like lSRTT, but without its 50 ms minimum: used for the probe time-out and the reordering window */
+	int32_t lRackRTT;					/* The RTT of the most recently sent segment that has been acknowledged, or -1 */
+	uint32_t ulRackXmitTime;			/* The time at which that segment was sent */
+	uint32_t ulRackEndSequence;			/* The sequence number following that segment */
+	uint32_t ulProbeTime;				/* The time of the last transmission or acknowledgement, the probe time-out starts here */
+#endif
+#if( ipconfigUSE_TCP_ECN == 1 )
+	uint32_t ulCongestionRecover;		/* No new reduction, nor growth, until this sequence number has been acknowledged */
+	uint32_t ulTxWindowTarget;			/* The largest Tx window length before a reduction, the window grows back to it */
+#endif
 	uint8_t ucOptionLength;				/* Number of valid bytes in ulOptionsData[] */
+#if( ipconfigUSE_PATH_MTU_DISCOVERY != 0 )
+	uint8_t ucTxTransmitCount;			/* The transmit count of the segment returned by ulTCPWindowTxGet(), to detect a path MTU black hole */
+#endif
 #if( ipconfigUSE_TCP_WIN == 1 )
 	List_t xPriorityQueue;				/* Priority queue: segments which must be sent immediately */
 	List_t xTxQueue;					/* Transmit queue: segments queued for transmission */
@@ -197,6 +228,13 @@ uint32_t ulTCPWindowTxAck( TCPWindow_t *pxWindow, uint32_t ulSequenceNumber );
 /* Receive a SACK option */
 uint32_t ulTCPWindowTxSack( TCPWindow_t *pxWindow, uint32_t ulFirst, uint32_t ulLast );
 
+#if( ipconfigUSE_TCP_ECN == 1 )
+	/* The peer echoed a congestion mark: halve the Tx window, at most once per
+	 * window of data.  Returns pdTRUE if the window was reduced, and CWR must be
+	 * sent */
+	BaseType_t xTCPWindowTxCongestion( TCPWindow_t *pxWindow );
+#endif
+
 
 #ifdef __cplusplus
 }	/* extern "C" */
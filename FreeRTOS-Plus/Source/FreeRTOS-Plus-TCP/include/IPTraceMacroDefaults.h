@@ -146,6 +146,10 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Trace.html */
 	#define iptraceNETWORK_INTERFACE_TRANSMIT()
 #endif
 
+#ifndef iptraceNETWORK_INTERFACE_OUTPUT_DROPPED
+	#define iptraceNETWORK_INTERFACE_OUTPUT_DROPPED( pxNetworkBuffer, uxClass )
+#endif
+
 #ifndef iptraceNETWORK_INTERFACE_RECEIVE
 	#define iptraceNETWORK_INTERFACE_RECEIVE()
 #endif
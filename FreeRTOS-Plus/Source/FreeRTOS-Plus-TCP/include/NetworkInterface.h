@@ -42,6 +42,16 @@ void vNetworkInterfaceAllocateRAMToBuffers( NetworkBufferDescriptor_t pxNetworkB
 /* coverity[misra_c_2012_rule_8_6_violation] */
 BaseType_t xGetPhyLinkStatus( void );
 
+#if( ipconfigUSE_TX_PRIORITY_QUEUES != 0 )
+	/* Provided by the IP-stack.  A driver calls vNetworkInterfaceTxDone() from
+	a task ( not from an ISR ) each time it has finished sending a frame, when
+	ipconfigTX_PRIORITY_DRIVER_DEPTH is non-zero.  uxNetworkBufferTxPriority()
+	returns the priority class of an outgoing frame, 0 being the lowest, which
+	a driver may use to select one of its hardware queues. */
+	void vNetworkInterfaceTxDone( void );
+	UBaseType_t uxNetworkBufferTxPriority( const NetworkBufferDescriptor_t *pxNetworkBuffer );
+#endif /* ipconfigUSE_TX_PRIORITY_QUEUES */
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
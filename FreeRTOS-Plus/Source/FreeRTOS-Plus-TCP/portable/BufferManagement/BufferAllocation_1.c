@@ -280,6 +280,13 @@ UBaseType_t uxCount;
 					pxReturn->pxNextBuffer = NULL;
 				}
 				#endif /* ipconfigUSE_LINKED_RX_MESSAGES */
+
+				#if( ipconfigMULTI_INTERFACE == 1 )
+				{
+					/* The end-point is not known yet. */
+					pxReturn->pxEndPoint = NULL;
+				}
+				#endif /* ipconfigMULTI_INTERFACE */
 			}
 			iptraceNETWORK_BUFFER_OBTAINED( pxReturn );
 		}
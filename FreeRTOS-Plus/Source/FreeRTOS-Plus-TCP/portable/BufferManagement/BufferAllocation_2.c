@@ -246,6 +246,13 @@ size_t uxCount;
 				uxMinimumFreeNetworkBuffers = uxCount;
 			}
 
+			#if( ipconfigMULTI_INTERFACE == 1 )
+			{
+				/* The end-point is not known yet. */
+				pxReturn->pxEndPoint = NULL;
+			}
+			#endif /* ipconfigMULTI_INTERFACE */
+
 			/* Allocate storage of exactly the requested size to the buffer. */
 			configASSERT( pxReturn->pucEthernetBuffer == NULL );
 			if( xRequestedSizeBytes > 0 )
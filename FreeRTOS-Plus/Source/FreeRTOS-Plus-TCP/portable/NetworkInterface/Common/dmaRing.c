@@ -0,0 +1,364 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * A DMA descriptor ring, shared by EMAC drivers.
+ * See dmaRing.h for a description.
+ *
+ * RX ring: the descriptors [ uxTail .. uxHead > are empty: their frame has been
+ * taken, and they wait to be refilled.  All others have been given to the DMA,
+ * uxBusy counts them.  An empty descriptor may still hold its old buffer, when
+ * the frame was dropped or copied; the refill will use it again.
+ *
+ * TX ring: the descriptors [ uxTail .. uxHead > have been given to the DMA,
+ * uxBusy counts them.  Only one task shall send, normally the IP-task, and only
+ * one task shall reap, normally the EMAC handler task.
+ *
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "NetworkBufferManagement.h"
+
+#include "dmaRing.h"
+
+/*-----------------------------------------------------------*/
+
+static size_t prvNextIndex( const DMARing_t *pxRing, size_t uxIndex )
+{
+	uxIndex++;
+	if( uxIndex == pxRing->uxCount )
+	{
+		uxIndex = 0U;
+	}
+
+	return uxIndex;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInitRing( DMARing_t *pxRing,
+						 const DMARingOps_t *pxOps,
+						 void *pvDescriptors,
+						 NetworkBufferDescriptor_t **ppxBuffers,
+						 size_t uxCount,
+						 void *pvContext )
+{
+	configASSERT( pxOps != NULL );
+	configASSERT( pxOps->fnOwnedByDMA != NULL );
+	configASSERT( pxOps->fnGiveToDMA != NULL );
+	configASSERT( uxCount > 0U );
+
+	memset( pxRing, '\0', sizeof( *pxRing ) );
+	pxRing->pxOps = pxOps;
+	pxRing->pvDescriptors = pvDescriptors;
+	pxRing->ppxBuffers = ppxBuffers;
+	pxRing->uxCount = uxCount;
+	pxRing->pvContext = pvContext;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDMARingRxInit( DMARing_t *pxRing,
+						   const DMARingOps_t *pxOps,
+						   void *pvDescriptors,
+						   NetworkBufferDescriptor_t **ppxBuffers,
+						   size_t uxCount,
+						   size_t uxBufferSize,
+						   void *pvContext )
+{
+BaseType_t xReturn = pdPASS;
+
+	configASSERT( pxOps->fnRxLength != NULL );
+
+	/* Buffers that are still attached from an earlier initialisation are
+	used again. */
+	prvInitRing( pxRing, pxOps, pvDescriptors, ppxBuffers, uxCount, pvContext );
+	pxRing->uxBufferSize = uxBufferSize;
+
+	/* All descriptors are empty, let the refill do the work. */
+	if( uxDMARingRxRefill( pxRing ) != uxCount )
+	{
+		xReturn = pdFAIL;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t uxDMARingRxRefill( DMARing_t *pxRing )
+{
+const DMARingOps_t *pxOps = pxRing->pxOps;
+NetworkBufferDescriptor_t *pxBuffer;
+size_t uxRefilled = 0U;
+
+	/* Refill in the order of the ring, the DMA will find the descriptors in
+	that order. */
+	while( pxRing->uxBusy < pxRing->uxCount )
+	{
+		pxBuffer = pxRing->ppxBuffers[ pxRing->uxTail ];
+
+		if( pxBuffer == NULL )
+		{
+			pxBuffer = pxGetNetworkBufferWithDescriptor( pxRing->uxBufferSize, ( TickType_t ) 0 );
+
+			if( pxBuffer == NULL )
+			{
+				/* Try again at the next refill.  The DMA will stop at this
+				descriptor until then. */
+				pxRing->ulNoBuffer++;
+				break;
+			}
+
+			pxRing->ppxBuffers[ pxRing->uxTail ] = pxBuffer;
+		}
+
+		if( pxOps->fnCacheInvalidate != NULL )
+		{
+			/* No dirty cache line may be written back over the data that the
+			DMA will store. */
+			pxOps->fnCacheInvalidate( pxBuffer->pucEthernetBuffer, pxRing->uxBufferSize );
+		}
+
+		pxOps->fnGiveToDMA( pxRing->pvDescriptors, pxRing->uxTail, pxRing->uxCount, pxBuffer->pucEthernetBuffer, pxRing->uxBufferSize );
+		pxRing->uxTail = prvNextIndex( pxRing, pxRing->uxTail );
+		pxRing->uxBusy++;
+		uxRefilled++;
+	}
+
+	if( ( uxRefilled != 0U ) && ( pxOps->fnKick != NULL ) )
+	{
+		pxOps->fnKick( pxRing->pvContext );
+	}
+
+	return uxRefilled;
+}
+/*-----------------------------------------------------------*/
+
+NetworkBufferDescriptor_t *pxDMARingRxTake( DMARing_t *pxRing )
+{
+const DMARingOps_t *pxOps = pxRing->pxOps;
+NetworkBufferDescriptor_t *pxReturn = NULL;
+NetworkBufferDescriptor_t *pxBuffer;
+BaseType_t xLength;
+size_t uxIndex;
+
+	while( ( pxReturn == NULL ) && ( pxRing->uxBusy != 0U ) )
+	{
+		uxIndex = pxRing->uxHead;
+
+		if( pxOps->fnOwnedByDMA( pxRing->pvDescriptors, uxIndex ) != pdFALSE )
+		{
+			break;
+		}
+
+		pxBuffer = pxRing->ppxBuffers[ uxIndex ];
+		xLength = pxOps->fnRxLength( pxRing->pvDescriptors, uxIndex );
+
+		pxRing->uxHead = prvNextIndex( pxRing, uxIndex );
+		pxRing->uxBusy--;
+
+		if( ( xLength == dmaringRX_ERROR ) || ( xLength > ( BaseType_t ) pxRing->uxBufferSize ) )
+		{
+			/* Drop the frame, the buffer stays with the descriptor. */
+			pxRing->ulErrors++;
+		}
+		else
+		{
+			if( pxOps->fnCacheInvalidate != NULL )
+			{
+				pxOps->fnCacheInvalidate( pxBuffer->pucEthernetBuffer, ( size_t ) xLength );
+			}
+
+			#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
+			{
+				/* Pass on the buffer itself, the descriptor will get a new
+				one. */
+				pxRing->ppxBuffers[ uxIndex ] = NULL;
+				pxReturn = pxBuffer;
+			}
+			#else
+			{
+				/* Copy the frame, the buffer stays with the descriptor. */
+				pxReturn = pxGetNetworkBufferWithDescriptor( ( size_t ) xLength, ( TickType_t ) 0 );
+				if( pxReturn != NULL )
+				{
+					memcpy( pxReturn->pucEthernetBuffer, pxBuffer->pucEthernetBuffer, ( size_t ) xLength );
+				}
+				else
+				{
+					pxRing->ulNoBuffer++;
+				}
+			}
+			#endif /* ipconfigZERO_COPY_RX_DRIVER */
+
+			if( pxReturn != NULL )
+			{
+				pxReturn->xDataLength = ( size_t ) xLength;
+				pxRing->ulFrames++;
+			}
+		}
+
+		if( ( pxRing->uxCount - pxRing->uxBusy ) >= ( size_t ) ipconfigDMA_RX_REFILL_BATCH )
+		{
+			( void ) uxDMARingRxRefill( pxRing );
+		}
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vDMARingTxInit( DMARing_t *pxRing,
+					 const DMARingOps_t *pxOps,
+					 void *pvDescriptors,
+					 NetworkBufferDescriptor_t **ppxBuffers,
+					 size_t uxCount,
+					 void *pvContext )
+{
+size_t uxIndex;
+
+	prvInitRing( pxRing, pxOps, pvDescriptors, ppxBuffers, uxCount, pvContext );
+
+	for( uxIndex = 0U; uxIndex < uxCount; uxIndex++ )
+	{
+		if( ppxBuffers[ uxIndex ] != NULL )
+		{
+			/* Left over from an earlier initialisation. */
+			vReleaseNetworkBufferAndDescriptor( ppxBuffers[ uxIndex ] );
+			ppxBuffers[ uxIndex ] = NULL;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xDMARingTxSend( DMARing_t *pxRing, NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend )
+{
+const DMARingOps_t *pxOps = pxRing->pxOps;
+NetworkBufferDescriptor_t *pxBuffer = pxNetworkBuffer;
+BaseType_t xReturn = pdFAIL;
+size_t uxIndex;
+
+	if( uxDMARingTxSpace( pxRing ) == 0U )
+	{
+		/* The caller may reap and try again. */
+		pxRing->ulNoBuffer++;
+	}
+	else
+	{
+		if( xReleaseAfterSend == pdFALSE )
+		{
+			/* The caller keeps its buffer, the DMA needs its own. */
+			pxBuffer = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, pxNetworkBuffer->xDataLength );
+		}
+
+		if( pxBuffer != NULL )
+		{
+			uxIndex = pxRing->uxHead;
+			pxRing->ppxBuffers[ uxIndex ] = pxBuffer;
+
+			if( pxOps->fnCacheClean != NULL )
+			{
+				pxOps->fnCacheClean( pxBuffer->pucEthernetBuffer, pxBuffer->xDataLength );
+			}
+
+			pxOps->fnGiveToDMA( pxRing->pvDescriptors, uxIndex, pxRing->uxCount, pxBuffer->pucEthernetBuffer, pxBuffer->xDataLength );
+			pxRing->uxHead = prvNextIndex( pxRing, uxIndex );
+
+			/* Only now may the reaper look at this descriptor. */
+			taskENTER_CRITICAL();
+			{
+				pxRing->uxBusy++;
+			}
+			taskEXIT_CRITICAL();
+
+			if( pxOps->fnKick != NULL )
+			{
+				pxOps->fnKick( pxRing->pvContext );
+			}
+
+			pxRing->ulFrames++;
+			pxBuffer = NULL;
+			xReturn = pdPASS;
+		}
+	}
+
+	if( ( xReleaseAfterSend != pdFALSE ) && ( pxBuffer != NULL ) )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxBuffer );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t uxDMARingTxReap( DMARing_t *pxRing )
+{
+const DMARingOps_t *pxOps = pxRing->pxOps;
+size_t uxReaped = 0U;
+size_t uxIndex;
+
+	while( pxRing->uxBusy != 0U )
+	{
+		uxIndex = pxRing->uxTail;
+
+		if( pxOps->fnOwnedByDMA( pxRing->pvDescriptors, uxIndex ) != pdFALSE )
+		{
+			break;
+		}
+
+		if( pxRing->ppxBuffers[ uxIndex ] != NULL )
+		{
+			vReleaseNetworkBufferAndDescriptor( pxRing->ppxBuffers[ uxIndex ] );
+			pxRing->ppxBuffers[ uxIndex ] = NULL;
+		}
+
+		pxRing->uxTail = prvNextIndex( pxRing, uxIndex );
+
+		taskENTER_CRITICAL();
+		{
+			pxRing->uxBusy--;
+		}
+		taskEXIT_CRITICAL();
+
+		uxReaped++;
+	}
+
+	return uxReaped;
+}
+/*-----------------------------------------------------------*/
+
+size_t uxDMARingTxSpace( const DMARing_t *pxRing )
+{
+	return pxRing->uxCount - pxRing->uxBusy;
+}
+/*-----------------------------------------------------------*/
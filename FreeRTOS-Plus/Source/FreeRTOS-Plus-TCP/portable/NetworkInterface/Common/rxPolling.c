@@ -0,0 +1,148 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Budgeted polling of an EMAC's reception DMA ring.
+ * See rxPolling.h for a description.
+ *
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+
+#include "rxPolling.h"
+
+/*-----------------------------------------------------------*/
+
+void vRxPollInit( RxPoll_t *pxPoll,
+				  xRxPollFunction_t fnPoll,
+				  xRxPendingFunction_t fnPending,
+				  xRxInterruptFunction_t fnMaskInterrupt,
+				  xRxInterruptFunction_t fnUnmaskInterrupt,
+				  void *pvContext,
+				  BaseType_t xBudget )
+{
+	configASSERT( fnPoll != NULL );
+	configASSERT( fnPending != NULL );
+	configASSERT( xBudget > 0 );
+
+	memset( pxPoll, '\0', sizeof( *pxPoll ) );
+	pxPoll->fnPoll = fnPoll;
+	pxPoll->fnPending = fnPending;
+	pxPoll->fnMaskInterrupt = fnMaskInterrupt;
+	pxPoll->fnUnmaskInterrupt = fnUnmaskInterrupt;
+	pxPoll->pvContext = pvContext;
+	pxPoll->xBudget = xBudget;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRxPollScheduleFromISR( RxPoll_t *pxPoll )
+{
+BaseType_t xReturn = pdFALSE;
+
+	pxPoll->ulInterruptCount++;
+
+	if( pxPoll->xScheduled == pdFALSE )
+	{
+		/* No more reception interrupts until the ring has been emptied. */
+		if( pxPoll->fnMaskInterrupt != NULL )
+		{
+			pxPoll->fnMaskInterrupt( pxPoll->pvContext );
+		}
+		pxPoll->xScheduled = pdTRUE;
+		xReturn = pdTRUE;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRxPollRun( RxPoll_t *pxPoll, BaseType_t *pxFrameCount )
+{
+BaseType_t xCount;
+BaseType_t xReturn;
+
+	xCount = pxPoll->fnPoll( pxPoll->pvContext, pxPoll->xBudget );
+
+	pxPoll->ulBatchCount++;
+	pxPoll->ulFrameCount += ( uint32_t ) xCount;
+	if( pxFrameCount != NULL )
+	{
+		*pxFrameCount += xCount;
+	}
+
+	if( xCount >= pxPoll->xBudget )
+	{
+		/* The budget is used up, there may be more frames. */
+		pxPoll->ulBudgetExhaustedCount++;
+		xReturn = pdTRUE;
+	}
+	else
+	{
+		/* The ring is empty: unmask the interrupts.  A frame that arrived
+		between the last poll and the unmasking would not cause an interrupt,
+		so look at the ring once more. */
+		pxPoll->xScheduled = pdFALSE;
+		if( pxPoll->fnUnmaskInterrupt != NULL )
+		{
+			pxPoll->fnUnmaskInterrupt( pxPoll->pvContext );
+		}
+
+		if( pxPoll->fnPending( pxPoll->pvContext ) != pdFALSE )
+		{
+			/* The interrupt may have been handled already, in which case
+			xScheduled is set again. */
+			portENTER_CRITICAL();
+			{
+				if( pxPoll->xScheduled == pdFALSE )
+				{
+					if( pxPoll->fnMaskInterrupt != NULL )
+					{
+						pxPoll->fnMaskInterrupt( pxPoll->pvContext );
+					}
+					pxPoll->xScheduled = pdTRUE;
+				}
+			}
+			portEXIT_CRITICAL();
+			xReturn = pdTRUE;
+		}
+		else
+		{
+			xReturn = pdFALSE;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
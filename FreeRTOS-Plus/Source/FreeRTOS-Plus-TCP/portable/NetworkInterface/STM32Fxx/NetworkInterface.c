@@ -48,6 +48,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "NetworkBufferManagement.h"
 #include "NetworkInterface.h"
 #include "phyHandling.h"
+#include "rxPolling.h"
 
 /* ST includes. */
 #if defined( STM32F7xx )
@@ -89,6 +90,15 @@ expansion. */
 	#define niDESCRIPTOR_WAIT_TIME_MS		250uL
 #endif
 
+/* The number of frames that prvNetworkInterfaceInput() may take from the DMA
+ring when polling is not used: in practice until the ring is empty. */
+#define niRX_NO_BUDGET					( ( BaseType_t ) 0x7fffffff )
+
+/* The EMAC can hold back the reception interrupt: when RDES1.DIC is set in
+a descriptor, the Receive Watchdog timer is started in stead, counting in
+units of 256 HCLK cycles. */
+#define niRX_WATCHDOG_MAX				255uL
+
 /*
  * Most users will want a PHY that negotiates about
  * the connection properties: speed, dmix and duplex.
@@ -168,9 +178,25 @@ static void prvEMACHandlerTask( void *pvParameters );
 static void prvEthernetUpdateConfig( BaseType_t xForce );
 
 /*
- * See if there is a new packet and forward it to the IP-task.
+ * Forward at most xBudget received packets to the IP-task.  Returns the number
+ * of packets taken from the DMA ring.
+ */
+static BaseType_t prvNetworkInterfaceInput( BaseType_t xBudget );
+
+#if( ipconfigNIC_RX_POLLING != 0 )
+	/*
+	 * The functions that let rxPolling.c access the reception ring.
+	 */
+	static BaseType_t prvRxPoll( void *pvContext, BaseType_t xBudget );
+	static BaseType_t prvRxPending( void *pvContext );
+	static void prvRxMaskInterrupt( void *pvContext );
+	static void prvRxUnmaskInterrupt( void *pvContext );
+#endif
+
+/*
+ * Return the value of RDES1.DIC for the RX descriptor at xIndex.
  */
-static BaseType_t prvNetworkInterfaceInput( void );
+static uint32_t prvRxDescriptorDIC( BaseType_t xIndex );
 
 #if( ipconfigUSE_LLMNR != 0 )
 	/*
@@ -212,6 +238,10 @@ static volatile uint32_t ulISREvents;
 
 static EthernetPhy_t xPhyObject;
 
+#if( ipconfigNIC_RX_POLLING != 0 )
+	static RxPoll_t xRxPoll;
+#endif
+
 /* Ethernet handle. */
 static ETH_HandleTypeDef xETH;
 
@@ -306,13 +336,22 @@ const PhyProperties_t xPHYProperties =
 void HAL_ETH_RxCpltCallback( ETH_HandleTypeDef *heth )
 {
 BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+BaseType_t xWakeTask = pdTRUE;
 
 	( void ) heth;
 
+	#if( ipconfigNIC_RX_POLLING != 0 )
+	{
+		/* Only the first interrupt of a burst wakes up the task, the RX
+		interrupt stays masked until the task has emptied the ring. */
+		xWakeTask = xRxPollScheduleFromISR( &xRxPoll );
+	}
+	#endif
+
 	/* Ethernet RX-Complete callback function, elsewhere declared as weak. */
     ulISREvents |= EMAC_IF_RX_EVENT;
 	/* Wakeup the prvEMACHandlerTask. */
-	if( xEMACTaskHandle != NULL )
+	if( ( xEMACTaskHandle != NULL ) && ( xWakeTask != pdFALSE ) )
 	{
 		vTaskNotifyGiveFromISR( xEMACTaskHandle, &xHigherPriorityTaskWoken );
 		portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
@@ -454,6 +493,12 @@ BaseType_t xResult;
 			/* Initialise RX-descriptors. */
 			prvDMARxDescListInit();
 
+			#if( ipconfigNIC_RX_POLLING != 0 )
+			{
+				vRxPollInit( &xRxPoll, prvRxPoll, prvRxPending, prvRxMaskInterrupt, prvRxUnmaskInterrupt, NULL, ipconfigNIC_RX_POLL_BUDGET );
+			}
+			#endif
+
 			#if( ipconfigUSE_LLMNR != 0 )
 			{
 				/* Program the LLMNR address at index 1. */
@@ -489,7 +534,35 @@ BaseType_t xResult;
 	{
 		if( xPhyObject.ulLinkStatusMask != 0uL )
 		{
+			#if( ipconfigNIC_RX_COALESCE_FRAMES > 1 )
+			{
+			uint32_t ulWatchdog = ( HAL_RCC_GetHCLKFreq() / 1000000uL ) * ipconfigNIC_RX_COALESCE_USEC / 256uL;
+
+				/* Frames whose descriptor has the DIC bit set raise the RX
+				interrupt when the watchdog expires. */
+				if( ulWatchdog > niRX_WATCHDOG_MAX )
+				{
+					ulWatchdog = niRX_WATCHDOG_MAX;
+				}
+				else if( ulWatchdog == 0uL )
+				{
+					ulWatchdog = 1uL;
+				}
+				__HAL_ETH_SET_RECEIVE_WATCHDOG_TIMER( &xETH, ulWatchdog );
+			}
+			#endif /* ipconfigNIC_RX_COALESCE_FRAMES */
+
 			xETH.Instance->DMAIER |= ETH_DMA_ALL_INTS;
+			#if( ipconfigNIC_RX_POLLING != 0 )
+			{
+				if( xRxPoll.xScheduled != pdFALSE )
+				{
+					/* The task is still polling, it will unmask the RX
+					interrupt. */
+					__HAL_ETH_DMA_DISABLE_IT( &xETH, ETH_DMA_IT_R );
+				}
+			}
+			#endif
 			xResult = pdPASS;
 			FreeRTOS_printf( ( "Link Status is high\n" ) ) ;
 		}
@@ -571,7 +644,7 @@ BaseType_t xIndex;
 	{
 
 		/* Set Buffer1 size and Second Address Chained bit */
-		pxDMADescriptor->ControlBufferSize = ETH_DMARXDESC_RCH | (uint32_t)ETH_RX_BUF_SIZE;  
+		pxDMADescriptor->ControlBufferSize = ETH_DMARXDESC_RCH | (uint32_t)ETH_RX_BUF_SIZE | prvRxDescriptorDIC( xIndex );
 
 		#if( ipconfigZERO_COPY_RX_DRIVER != 0 )
 		{
@@ -873,7 +946,62 @@ IPStackEvent_t xRxEvent;
 	}
 }
 
-static BaseType_t prvNetworkInterfaceInput( void )
+static uint32_t prvRxDescriptorDIC( BaseType_t xIndex )
+{
+uint32_t ulReturn = 0uL;
+
+	#if( ipconfigNIC_RX_COALESCE_FRAMES > 1 )
+	{
+		/* Only every N-th descriptor raises the interrupt immediately, the
+		others wait for the receive watchdog. */
+		if( ( xIndex % ipconfigNIC_RX_COALESCE_FRAMES ) != ( ipconfigNIC_RX_COALESCE_FRAMES - 1 ) )
+		{
+			ulReturn = ETH_DMARXDESC_DIC;
+		}
+	}
+	#else
+	{
+		( void ) xIndex;
+	}
+	#endif
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigNIC_RX_POLLING != 0 )
+
+	static BaseType_t prvRxPoll( void *pvContext, BaseType_t xBudget )
+	{
+		( void ) pvContext;
+		return prvNetworkInterfaceInput( xBudget );
+	}
+	/*-----------------------------------------------------------*/
+
+	static BaseType_t prvRxPending( void *pvContext )
+	{
+		( void ) pvContext;
+		return ( ( xETH.RxDesc->Status & ETH_DMARXDESC_OWN ) == 0u ) ? pdTRUE : pdFALSE;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvRxMaskInterrupt( void *pvContext )
+	{
+		( void ) pvContext;
+		__HAL_ETH_DMA_DISABLE_IT( &xETH, ETH_DMA_IT_R );
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvRxUnmaskInterrupt( void *pvContext )
+	{
+		( void ) pvContext;
+		__HAL_ETH_DMA_ENABLE_IT( &xETH, ETH_DMA_IT_R );
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigNIC_RX_POLLING */
+
+static BaseType_t prvNetworkInterfaceInput( BaseType_t xBudget )
 {
 NetworkBufferDescriptor_t *pxCurDescriptor;
 NetworkBufferDescriptor_t *pxNewDescriptor = NULL;
@@ -882,15 +1010,18 @@ NetworkBufferDescriptor_t *pxNewDescriptor = NULL;
 	NetworkBufferDescriptor_t *pxLastDescriptor = NULL;
 #endif
 BaseType_t xReceivedLength = 0;
+BaseType_t xFrameCount = 0;
 __IO ETH_DMADescTypeDef *pxDMARxDescriptor;
 const TickType_t xDescriptorWaitTime = pdMS_TO_TICKS( niDESCRIPTOR_WAIT_TIME_MS );
 uint8_t *pucBuffer;
 
 	pxDMARxDescriptor = xETH.RxDesc;
 
-	while( ( pxDMARxDescriptor->Status & ETH_DMARXDESC_OWN ) == 0u )
+	while( ( ( pxDMARxDescriptor->Status & ETH_DMARXDESC_OWN ) == 0u ) && ( xFrameCount < xBudget ) )
 	{
 	BaseType_t xAccepted = pdTRUE;
+
+		xFrameCount++;
 		/* Get the Frame Length of the received packet: substruct 4 bytes of the CRC */
 		xReceivedLength = ( ( pxDMARxDescriptor->Status & ETH_DMARXDESC_FL ) >> ETH_DMARXDESC_FRAMELENGTHSHIFT ) - 4;
 
@@ -992,8 +1123,9 @@ uint8_t *pucBuffer;
 		}
 		#endif /* ipconfigZERO_COPY_RX_DRIVER */
 
-		/* Set Buffer1 size and Second Address Chained bit */
-		pxDMARxDescriptor->ControlBufferSize = ETH_DMARXDESC_RCH | (uint32_t)ETH_RX_BUF_SIZE;  
+		/* Set Buffer1 size and Second Address Chained bit.  Keep the DIC bit
+		that prvDMARxDescListInit() has set. */
+		pxDMARxDescriptor->ControlBufferSize = ETH_DMARXDESC_RCH | (uint32_t)ETH_RX_BUF_SIZE | ( pxDMARxDescriptor->ControlBufferSize & ETH_DMARXDESC_DIC );
 		pxDMARxDescriptor->Status = ETH_DMARXDESC_OWN;
 
 		/* Ensure completion of memory access */
@@ -1020,7 +1152,7 @@ uint8_t *pucBuffer;
 	}
 	#endif	/* ipconfigUSE_LINKED_RX_MESSAGES */
 
-	return ( xReceivedLength > 0 );
+	return xFrameCount;
 }
 /*-----------------------------------------------------------*/
 
@@ -1202,6 +1334,7 @@ UBaseType_t uxLastMinQueueSpace = 0;
 #endif
 UBaseType_t uxCurrentCount;
 BaseType_t xResult;
+BaseType_t xRxPollMore = pdFALSE;	/* Only used when ipconfigNIC_RX_POLLING is 1. */
 const TickType_t ulMaxBlockTime = pdMS_TO_TICKS( 100UL );
 
 	/* Remove compiler warnings about unused parameters. */
@@ -1246,17 +1379,31 @@ const TickType_t ulMaxBlockTime = pdMS_TO_TICKS( 100UL );
 		}
 		#endif /* ipconfigCHECK_IP_QUEUE_SPACE */
 
-		if( ( ulISREvents & EMAC_IF_ALL_EVENT ) == 0 )
+		if( ( ( ulISREvents & EMAC_IF_ALL_EVENT ) == 0 ) && ( xRxPollMore == pdFALSE ) )
 		{
 			/* No events to process now, wait for the next. */
 			ulTaskNotifyTake( pdFALSE, ulMaxBlockTime );
 		}
 
-		if( ( ulISREvents & EMAC_IF_RX_EVENT ) != 0 )
+		if( ( ( ulISREvents & EMAC_IF_RX_EVENT ) != 0 ) || ( xRxPollMore != pdFALSE ) )
 		{
 			ulISREvents &= ~EMAC_IF_RX_EVENT;
 
-			xResult = prvNetworkInterfaceInput();
+			#if( ipconfigNIC_RX_POLLING != 0 )
+			{
+				/* Take one batch, the RX interrupt stays masked as long as
+				there is more. */
+				xRxPollMore = xRxPollRun( &xRxPoll, &xResult );
+				if( xRxPollMore != pdFALSE )
+				{
+					taskYIELD();
+				}
+			}
+			#else
+			{
+				xResult = prvNetworkInterfaceInput( niRX_NO_BUDGET );
+			}
+			#endif
 		}
 
 		if( ( ulISREvents & EMAC_IF_TX_EVENT ) != 0 )
@@ -380,6 +380,7 @@ TimeOut_t xPhyTime;
 TickType_t xPhyRemTime;
 BaseType_t xResult = 0;
 uint32_t xStatus;
+BaseType_t xRxPollMore = pdFALSE;	/* Only used when ipconfigNIC_RX_POLLING is 1. */
 const TickType_t ulMaxBlockTime = pdMS_TO_TICKS( 100UL );
 
 	/* Remove compiler warnings about unused parameters. */
@@ -400,16 +401,30 @@ const TickType_t ulMaxBlockTime = pdMS_TO_TICKS( 100UL );
 			}
 		#endif /* ipconfigHAS_PRINTF != 0 ) */
 
-		if( ( xEMACpsif.isr_events & EMAC_IF_ALL_EVENT ) == 0 )
+		if( ( ( xEMACpsif.isr_events & EMAC_IF_ALL_EVENT ) == 0 ) && ( xRxPollMore == pdFALSE ) )
 		{
 			/* No events to process now, wait for the next. */
 			ulTaskNotifyTake( pdFALSE, ulMaxBlockTime );
 		}
 
-		if( ( xEMACpsif.isr_events & EMAC_IF_RX_EVENT ) != 0 )
+		if( ( ( xEMACpsif.isr_events & EMAC_IF_RX_EVENT ) != 0 ) || ( xRxPollMore != pdFALSE ) )
 		{
 			xEMACpsif.isr_events &= ~EMAC_IF_RX_EVENT;
-			xResult = emacps_check_rx( &xEMACpsif );
+			#if( ipconfigNIC_RX_POLLING != 0 )
+			{
+				/* Take one batch, FRAMERX stays masked as long as there is
+				more. */
+				xRxPollMore = emacps_rx_poll( &xEMACpsif, &xResult );
+				if( xRxPollMore != pdFALSE )
+				{
+					taskYIELD();
+				}
+			}
+			#else
+			{
+				xResult = emacps_check_rx( &xEMACpsif, EMACPS_RX_NO_BUDGET );
+			}
+			#endif
 		}
 
 		if( ( xEMACpsif.isr_events & EMAC_IF_TX_EVENT ) != 0 )
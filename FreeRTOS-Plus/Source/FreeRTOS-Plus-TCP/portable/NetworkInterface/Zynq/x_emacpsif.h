@@ -38,6 +38,8 @@ extern "C" {
 #include "xscugic.h"
 #include "xemacps.h"		/* defines XEmacPs API */
 
+#include "rxPolling.h"
+
 //#include "netif/xpqueue.h"
 //#include "xlwipconfig.h"
 
@@ -109,7 +111,16 @@ int	is_tx_space_available(xemacpsif_s *emac);
 
 struct xNETWORK_BUFFER;
 
-int emacps_check_rx( xemacpsif_s *xemacpsif );
+/* Take at most 'xBudget' frames from the RX ring, returns the number of
+descriptors taken.  That includes the frames that were dropped because no
+Network Buffer was available to replace theirs. */
+int emacps_check_rx( xemacpsif_s *xemacpsif, BaseType_t xBudget );
+#define EMACPS_RX_NO_BUDGET		( ( BaseType_t ) 0x7fffffff )
+
+#if( ipconfigNIC_RX_POLLING != 0 )
+	/* Take one batch of frames from the RX ring, see xRxPollRun(). */
+	BaseType_t emacps_rx_poll( xemacpsif_s *xemacpsif, BaseType_t *pxFrameCount );
+#endif
 void emacps_check_tx( xemacpsif_s *xemacpsif );
 int emacps_check_errors( xemacpsif_s *xemacps );
 void emacps_set_rx_buffers( xemacpsif_s *xemacpsif, u32 ulCount );
@@ -82,6 +82,18 @@ extern struct xtopology_t xXTopology;
 
 static SemaphoreHandle_t xTXDescriptorSemaphore = NULL;
 
+#if( ipconfigNIC_RX_POLLING != 0 )
+	/* The GEM of the Zynq-7000 has no interrupt moderation, so
+	ipconfigNIC_RX_COALESCE_FRAMES and ipconfigNIC_RX_COALESCE_USEC are not
+	used.  Masking FRAMERX while polling is what limits the interrupts. */
+	static RxPoll_t xRxPoll;
+
+	static BaseType_t prvRxPoll( void *pvContext, BaseType_t xBudget );
+	static BaseType_t prvRxPending( void *pvContext );
+	static void prvRxMaskInterrupt( void *pvContext );
+	static void prvRxUnmaskInterrupt( void *pvContext );
+#endif
+
 /*
 	The FreeRTOS+TCP port does not make use of "src/xemacps_bdring.c".
 	In stead 'struct xemacpsif_s' has a "head" and a "tail" index.
@@ -302,6 +314,13 @@ void emacps_recv_handler(void *arg)
 	But it forgets to do a read-back. Do so now. */
 	( void ) XEmacPs_ReadReg(xemacpsif->emacps.Config.BaseAddress, XEMACPS_RXSR_OFFSET);
 
+	#if( ipconfigNIC_RX_POLLING != 0 )
+	if( xRxPollScheduleFromISR( &xRxPoll ) == pdFALSE )
+	{
+		/* The task is already polling the RX ring. */
+	}
+	else
+	#endif
 	if( xEMACTaskHandle != NULL )
 	{
 		vTaskNotifyGiveFromISR( xEMACTaskHandle, &xHigherPriorityTaskWoken );
@@ -341,7 +360,7 @@ IPStackEvent_t xRxEvent;
 	}
 }
 
-int emacps_check_rx( xemacpsif_s *xemacpsif )
+int emacps_check_rx( xemacpsif_s *xemacpsif, BaseType_t xBudget )
 {
 NetworkBufferDescriptor_t *pxBuffer, *pxNewBuffer;
 int rx_bytes;
@@ -361,10 +380,16 @@ int head = xemacpsif->rxHead;
 	for( ;; )
 	{
 		if( ( ( xemacpsif->rxSegments[ head ].address & XEMACPS_RXBUF_NEW_MASK ) == 0 ) ||
-			( pxDMA_rx_buffers[ head ] == NULL ) )
+			( pxDMA_rx_buffers[ head ] == NULL ) ||
+			( xBudget <= 0 ) )
 		{
 			break;
 		}
+		xBudget--;
+
+		/* Count every descriptor that is taken, also when its frame is
+		dropped below, so that the caller can compare it with the budget. */
+		msgCount++;
 
 		pxNewBuffer = pxGetNetworkBufferWithDescriptor( dmaRX_TX_BUFFER_SIZE, ( TickType_t ) 0 );
 		if( pxNewBuffer == NULL )
@@ -418,8 +443,6 @@ int head = xemacpsif->rxHead;
 				prvPassEthMessages( pxBuffer );
 			}
 			#endif	/* ipconfigUSE_LINKED_RX_MESSAGES */
-
-			msgCount++;
 		}
 		{
 			if( ucIsCachedMemory( pxNewBuffer->pucEthernetBuffer ) != 0 )
@@ -459,6 +482,53 @@ int head = xemacpsif->rxHead;
 	return msgCount;
 }
 
+#if( ipconfigNIC_RX_POLLING != 0 )
+
+	BaseType_t emacps_rx_poll( xemacpsif_s *xemacpsif, BaseType_t *pxFrameCount )
+	{
+		configASSERT( xRxPoll.pvContext == ( void * ) xemacpsif );
+		return xRxPollRun( &xRxPoll, pxFrameCount );
+	}
+
+	static BaseType_t prvRxPoll( void *pvContext, BaseType_t xBudget )
+	{
+		return ( BaseType_t ) emacps_check_rx( ( xemacpsif_s * ) pvContext, xBudget );
+	}
+
+	static BaseType_t prvRxPending( void *pvContext )
+	{
+	xemacpsif_s *xemacpsif = ( xemacpsif_s * ) pvContext;
+	int head = xemacpsif->rxHead;
+	BaseType_t xReturn = pdFALSE;
+
+		/* Use the same conditions as the loop in emacps_check_rx(): a slot
+		without a buffer would never be taken, and reporting it as pending
+		would keep the EMAC task spinning. */
+		if( ( ( xemacpsif->rxSegments[ head ].address & XEMACPS_RXBUF_NEW_MASK ) != 0 ) &&
+			( pxDMA_rx_buffers[ head ] != NULL ) )
+		{
+			xReturn = pdTRUE;
+		}
+
+		return xReturn;
+	}
+
+	static void prvRxMaskInterrupt( void *pvContext )
+	{
+	xemacpsif_s *xemacpsif = ( xemacpsif_s * ) pvContext;
+
+		XEmacPs_WriteReg( xemacpsif->emacps.Config.BaseAddress, XEMACPS_IDR_OFFSET, XEMACPS_IXR_FRAMERX_MASK );
+	}
+
+	static void prvRxUnmaskInterrupt( void *pvContext )
+	{
+	xemacpsif_s *xemacpsif = ( xemacpsif_s * ) pvContext;
+
+		XEmacPs_WriteReg( xemacpsif->emacps.Config.BaseAddress, XEMACPS_IER_OFFSET, XEMACPS_IXR_FRAMERX_MASK );
+	}
+
+#endif /* ipconfigNIC_RX_POLLING */
+
 void clean_dma_txdescs(xemacpsif_s *xemacpsif)
 {
 int index;
@@ -545,6 +615,12 @@ XStatus init_dma(xemacpsif_s *xemacpsif)
 
 	clean_dma_txdescs( xemacpsif );
 
+	#if( ipconfigNIC_RX_POLLING != 0 )
+	{
+		vRxPollInit( &xRxPoll, prvRxPoll, prvRxPending, prvRxMaskInterrupt, prvRxUnmaskInterrupt, ( void * ) xemacpsif, ipconfigNIC_RX_POLL_BUDGET );
+	}
+	#endif
+
 	{
 		uint32_t value;
 		value = XEmacPs_ReadReg( xemacpsif->emacps.Config.BaseAddress, XEMACPS_DMACR_OFFSET );
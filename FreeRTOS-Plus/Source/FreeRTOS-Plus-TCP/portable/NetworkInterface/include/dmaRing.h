@@ -0,0 +1,179 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * A DMA descriptor ring, shared by EMAC drivers.
+ * The library keeps the indexes of an RX or a TX ring, and the Network Buffer
+ * that belongs to each descriptor.  The layout of a descriptor differs for
+ * every EMAC, so the driver provides a few small functions that read and
+ * write a descriptor (see DMARingOps_t).
+ *
+ * RX: every descriptor owns a Network Buffer.  A received frame is passed to
+ * the IP-task in that same buffer, the descriptor gets a new buffer in return
+ * ( zero-copy, when ipconfigZERO_COPY_RX_DRIVER is 1 ).  Emptied descriptors
+ * are refilled in batches, not one by one.
+ *
+ * TX: a Network Buffer stays attached to its descriptor until the DMA has
+ * sent it.  Reaping releases the buffers of all completed descriptors in one
+ * go.
+ *
+ */
+
+#ifndef DMARING_H
+
+#define DMARING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#ifndef ipconfigDMA_CACHE_LINE_SIZE
+	/* Descriptors and buffers are aligned to a cache line, so that cache
+	maintenance on one of them never touches another. */
+	#define ipconfigDMA_CACHE_LINE_SIZE		32
+#endif
+
+#ifndef ipconfigDMA_RX_REFILL_BATCH
+	/* The number of emptied RX descriptors that are refilled together. */
+	#define ipconfigDMA_RX_REFILL_BATCH		4
+#endif
+
+/* Use this to declare an array of descriptors, e.g.:
+	static ETH_DMADescTypeDef dmaringDESCRIPTORS( xRxDescriptors, ETH_RXBUFNB ); */
+#ifndef dmaringDESCRIPTORS
+	#define dmaringDESCRIPTORS( xName, xCount ) \
+		xName[ xCount ] __attribute__ ( ( aligned( ipconfigDMA_CACHE_LINE_SIZE ) ) )
+#endif
+
+/* Returned by fnRxLength() for a frame that has errors. */
+#define dmaringRX_ERROR					( -1 )
+
+typedef struct xDMA_RING_OPS
+{
+	/* Return pdTRUE when the DMA still owns the descriptor. */
+	BaseType_t ( *fnOwnedByDMA )( void *pvDescriptors, size_t uxIndex );
+
+	/* RX only: return the length of the received frame, or dmaringRX_ERROR. */
+	BaseType_t ( *fnRxLength )( void *pvDescriptors, size_t uxIndex );
+
+	/* Attach a buffer to the descriptor and give it to the DMA.  For RX
+	uxLength is the size of the buffer, for TX the length of the frame.  The
+	descriptor at the end of the ring must also get the wrap bit, if the EMAC
+	uses one. */
+	void ( *fnGiveToDMA )( void *pvDescriptors, size_t uxIndex, size_t uxCount, uint8_t *pucBuffer, size_t uxLength );
+
+	/* Optional: tell the DMA that there are new descriptors, e.g. by writing
+	to a poll demand register.  Called once per batch. */
+	void ( *fnKick )( void *pvContext );
+
+	/* Optional: write data back from the cache before the DMA reads it, and
+	invalidate the cache before the CPU reads what the DMA has written. */
+	void ( *fnCacheClean )( const void *pvAddress, size_t uxLength );
+	void ( *fnCacheInvalidate )( const void *pvAddress, size_t uxLength );
+} DMARingOps_t;
+
+typedef struct xDMA_RING
+{
+	const DMARingOps_t *pxOps;
+	void *pvDescriptors;
+	void *pvContext;						/* Passed to fnKick(). */
+	NetworkBufferDescriptor_t **ppxBuffers;	/* One per descriptor. */
+	size_t uxCount;
+	size_t uxBufferSize;					/* RX only. */
+	size_t uxHead;		/* RX: the next descriptor to be received.  TX: the next descriptor to be filled. */
+	size_t uxTail;		/* RX: the next descriptor to be refilled.  TX: the next descriptor to be reaped. */
+	size_t uxBusy;		/* The number of descriptors given to the DMA. */
+
+	/* Statistics, for inspection only. */
+	uint32_t ulFrames;
+	uint32_t ulErrors;
+	uint32_t ulNoBuffer;	/* RX: a refill failed.  TX: the ring was full. */
+} DMARing_t;
+
+/*
+ * Attach a Network Buffer of uxBufferSize bytes to each of the uxCount RX
+ * descriptors and give them to the DMA.  ppxBuffers must point to an array of
+ * uxCount pointers.  Returns pdFAIL when not all buffers could be obtained;
+ * the ring can still be used.
+ */
+BaseType_t xDMARingRxInit( DMARing_t *pxRing,
+						   const DMARingOps_t *pxOps,
+						   void *pvDescriptors,
+						   NetworkBufferDescriptor_t **ppxBuffers,
+						   size_t uxCount,
+						   size_t uxBufferSize,
+						   void *pvContext );
+
+/*
+ * Take the next received frame from the ring, or return NULL when there is
+ * none.  The frame is returned in the Network Buffer of the descriptor, with
+ * xDataLength set.  Frames with errors are skipped.  Call uxDMARingRxRefill()
+ * when done taking frames; it is also called when ipconfigDMA_RX_REFILL_BATCH
+ * descriptors are waiting.
+ */
+NetworkBufferDescriptor_t *pxDMARingRxTake( DMARing_t *pxRing );
+
+/*
+ * Give new buffers to all emptied descriptors.  Returns the number of
+ * descriptors that were refilled.
+ */
+size_t uxDMARingRxRefill( DMARing_t *pxRing );
+
+/*
+ * Initialise an empty TX ring.  ppxBuffers must point to an array of uxCount
+ * pointers.
+ */
+void vDMARingTxInit( DMARing_t *pxRing,
+					 const DMARingOps_t *pxOps,
+					 void *pvDescriptors,
+					 NetworkBufferDescriptor_t **ppxBuffers,
+					 size_t uxCount,
+					 void *pvContext );
+
+/*
+ * Give a frame to the DMA.  When xReleaseAfterSend is pdFALSE, the frame is
+ * copied to a new Network Buffer first.  Returns pdFAIL when the ring is full.
+ * When xReleaseAfterSend is pdTRUE, the buffer belongs to the ring, even if
+ * pdFAIL is returned.
+ */
+BaseType_t xDMARingTxSend( DMARing_t *pxRing, NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t xReleaseAfterSend );
+
+/*
+ * Release the buffers of all descriptors that the DMA has sent.  Returns the
+ * number of descriptors released.
+ */
+size_t uxDMARingTxReap( DMARing_t *pxRing );
+
+/*
+ * Return the number of TX descriptors that can be filled.
+ */
+size_t uxDMARingTxSpace( const DMARing_t *pxRing );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* DMARING_H */
@@ -0,0 +1,123 @@
+/*
+ * FreeRTOS+TCP V2.2.1
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Budgeted polling of an EMAC's reception DMA ring.
+ * The first reception interrupt masks further reception interrupts and wakes
+ * up the deferred handler task.  That task takes the received frames from the
+ * DMA ring in batches of at most 'ipconfigNIC_RX_POLL_BUDGET' frames, until
+ * the ring is empty.  Only then are reception interrupts unmasked again.  At
+ * high packet rates there is about one interrupt per batch in stead of one
+ * per frame.
+ *
+ */
+
+#ifndef RXPOLLING_H
+
+#define RXPOLLING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#ifndef ipconfigNIC_RX_POLLING
+	/* When 1, the drivers that support it use budgeted polling. */
+	#define ipconfigNIC_RX_POLLING				0
+#endif
+
+#ifndef ipconfigNIC_RX_POLL_BUDGET
+	/* The maximum number of frames taken from the DMA ring in one batch.  Between
+	two batches the handler task also checks TX completion and the PHY, and it
+	yields to other tasks of the same priority. */
+	#define ipconfigNIC_RX_POLL_BUDGET			16
+#endif
+
+#ifndef ipconfigNIC_RX_COALESCE_FRAMES
+	/* Ask the EMAC for one reception interrupt per this many frames.  1 means an
+	interrupt for every frame.  Only used by an EMAC that supports it. */
+	#define ipconfigNIC_RX_COALESCE_FRAMES		1
+#endif
+
+#ifndef ipconfigNIC_RX_COALESCE_USEC
+	/* When frames are coalesced, the maximum time in micro seconds between the
+	reception of a frame and the interrupt.  Only used by an EMAC that supports
+	it. */
+	#define ipconfigNIC_RX_COALESCE_USEC		100
+#endif
+
+/* Take at most 'xBudget' frames from the DMA ring, and return the number of
+frames taken. */
+typedef BaseType_t ( *xRxPollFunction_t )( void *pvContext, BaseType_t xBudget );
+
+/* Return non-zero if the DMA ring holds a received frame. */
+typedef BaseType_t ( *xRxPendingFunction_t )( void *pvContext );
+
+/* Mask or unmask the reception interrupt of the EMAC.  The mask function is
+called from the ISR. */
+typedef void ( *xRxInterruptFunction_t )( void *pvContext );
+
+typedef struct xRxPoll
+{
+	xRxPollFunction_t fnPoll;
+	xRxPendingFunction_t fnPending;
+	xRxInterruptFunction_t fnMaskInterrupt;
+	xRxInterruptFunction_t fnUnmaskInterrupt;
+	void *pvContext;
+	BaseType_t xBudget;
+	volatile BaseType_t xScheduled;		/* Reception interrupts are masked. */
+
+	/* Statistics, for inspection only. */
+	uint32_t ulInterruptCount;
+	uint32_t ulBatchCount;
+	uint32_t ulFrameCount;
+	uint32_t ulBudgetExhaustedCount;
+} RxPoll_t;
+
+/* Initialise the object before the EMAC interrupts are enabled. */
+void vRxPollInit( RxPoll_t *pxPoll,
+				  xRxPollFunction_t fnPoll,
+				  xRxPendingFunction_t fnPending,
+				  xRxInterruptFunction_t fnMaskInterrupt,
+				  xRxInterruptFunction_t fnUnmaskInterrupt,
+				  void *pvContext,
+				  BaseType_t xBudget );
+
+/* Called from the reception ISR.  It masks reception interrupts, and returns
+pdTRUE when the handler task must be woken up. */
+BaseType_t xRxPollScheduleFromISR( RxPoll_t *pxPoll );
+
+/* Called from the handler task.  Takes one batch of frames from the ring.
+Returns pdTRUE when the ring may hold more frames, and the function must be
+called again without waiting for an interrupt.  Returns pdFALSE when the ring
+is empty and the interrupts have been unmasked.  The number of frames taken
+is added to '*pxFrameCount' when it is not NULL. */
+BaseType_t xRxPollRun( RxPoll_t *pxPoll, BaseType_t *pxFrameCount );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* RXPOLLING_H */
@@ -0,0 +1,577 @@
+/*
+FreeRTOS+TCP V2.2.1
+Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ http://aws.amazon.com/freertos
+ http://www.FreeRTOS.org
+*/
+
+/*
+ * An in-process "virtual link" network interface.  Every frame that the stack
+ * sends to its own MAC address is handed straight back to the IP task as if it
+ * had just been received, so TCP clients and servers running on the same
+ * FreeRTOS+TCP instance can talk to each other without any hardware, pcap
+ * library or host network configuration.  The driver answers ARP requests for
+ * the local IP address itself, all other frames have no destination on the
+ * link and are dropped.
+ *
+ * The driver is intended for reproducible performance measurements of the
+ * stack itself (see the TCP echo benchmark in the Posix_GCC demo).  Frames
+ * never leave the process, so no checksums are verified on reception and
+ * ipconfigDRIVER_INCLUDED_RX_IP_CHECKSUM may be set to 1.
+ *
+ * When ipconfigMULTI_INTERFACE is 1 the driver does not define the single
+ * interface functions.  Instead pxLoopback_FillInterfaceDescriptor() fills in
+ * a NetworkInterface_t, which can be added several times.  All of them share
+ * the same link: a frame sent to the MAC address of any loopback interface is
+ * received by that interface.
+ *
+ * When ipconfigLOOPBACK_BOTTLENECK_RATE is not 0, the link simulates a
+ * bottleneck with a shallow buffer: frames are queued and passed to the IP task
+ * at that rate ( bytes per second ) by a separate task, and frames that find
+ * the queue full are dropped.  This shows the effect of bursts, e.g. of TCP
+ * pacing ( ipconfigTCP_PACING ), on the number of losses.
+ *
+ * When ipconfigLOOPBACK_ECN_MARK_DEPTH is not 0 as well, the bottleneck acts
+ * like a router with active queue management: an ECN-capable packet that finds
+ * at least that number of frames waiting is marked Congestion Experienced, so
+ * a TCP sender that uses ECN ( ipconfigUSE_TCP_ECN ) slows down before the
+ * queue overflows.
+ *
+ * When ipconfigLOOPBACK_LOSS_PER_MILLE is not 0, that number out of every 1000
+ * TCP segments that carry data is dropped, to test the loss recovery of TCP.
+ * The losses follow a fixed pseudo random sequence, so runs are repeatable.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_IP_Private.h"
+#include "FreeRTOS_ARP.h"
+#include "NetworkBufferManagement.h"
+#include "NetworkInterface.h"
+#if( ipconfigMULTI_INTERFACE == 1 )
+	#include "FreeRTOS_Routing.h"
+#endif
+
+/* The rate of the simulated bottleneck in bytes per second, or 0 to pass
+frames to the IP task immediately. */
+#ifndef ipconfigLOOPBACK_BOTTLENECK_RATE
+	#define ipconfigLOOPBACK_BOTTLENECK_RATE	0
+#endif
+
+/* The number of frames that the bottleneck can hold. */
+#ifndef ipconfigLOOPBACK_BOTTLENECK_DEPTH
+	#define ipconfigLOOPBACK_BOTTLENECK_DEPTH	8
+#endif
+
+/* The number of frames waiting in the bottleneck above which ECN-capable
+packets are marked, or 0 to never mark them. */
+#ifndef ipconfigLOOPBACK_ECN_MARK_DEPTH
+	#define ipconfigLOOPBACK_ECN_MARK_DEPTH		0
+#endif
+
+/* The number of TCP data segments out of every 1000 that are lost. */
+#ifndef ipconfigLOOPBACK_LOSS_PER_MILLE
+	#define ipconfigLOOPBACK_LOSS_PER_MILLE		0
+#endif
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Returns pdTRUE if the frame is an ARP request for ulIPAddress.
+ */
+static BaseType_t prvIsARPRequestFor( const uint8_t *pucEthernetBuffer, uint32_t ulIPAddress );
+
+/*
+ * Loops back the frame, or a copy of it when the caller keeps the ownership.
+ * Returns pdTRUE if the frame waits in the bottleneck.
+ */
+static BaseType_t prvLoopbackOrCopy( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t bReleaseAfterSend );
+
+/*
+ * Passes a frame back to the IP task as a received frame.
+ */
+static void prvLoopbackFrame( NetworkBufferDescriptor_t * pxNetworkBuffer );
+
+#if( ipconfigLOOPBACK_LOSS_PER_MILLE != 0 )
+	/*
+	 * Returns pdTRUE if the frame is a TCP segment with data that must be lost.
+	 */
+	static BaseType_t prvLoseSegment( const NetworkBufferDescriptor_t *pxNetworkBuffer );
+#endif
+
+#if( ipconfigLOOPBACK_BOTTLENECK_RATE != 0 )
+	/*
+	 * Creates the bottleneck queue and the task that drains it.
+	 */
+	static void prvBottleneckInit( void );
+
+	/*
+	 * Passes the queued frames to the IP task at the rate of the bottleneck.
+	 */
+	static void prvBottleneckTask( void *pvParameters );
+#endif
+
+#if( ipconfigLOOPBACK_BOTTLENECK_RATE != 0 ) && ( ipconfigLOOPBACK_ECN_MARK_DEPTH != 0 )
+	/*
+	 * Changes the ECN field of an ECN-capable IPv4 packet to Congestion
+	 * Experienced.
+	 */
+	static void prvMarkCongestion( NetworkBufferDescriptor_t *pxNetworkBuffer );
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* Counters for inspection only, see vLoopbackGetCounters(). */
+static uint32_t ulLoopbackFrameCount = 0UL;
+static uint32_t ulLoopbackDropCount = 0UL;
+
+#if( ipconfigLOOPBACK_BOTTLENECK_RATE != 0 )
+	static QueueHandle_t xBottleneckQueue = NULL;
+#endif
+
+/*-----------------------------------------------------------*/
+
+#if( ipconfigMULTI_INTERFACE == 0 )
+
+BaseType_t xNetworkInterfaceInitialise( void )
+{
+	/* The link is always up.  The IP address and MAC address have been set
+	by FreeRTOS_IPInit() before the IP task calls this function, so the ARP
+	cache can be primed with the only station on the link. */
+	if( *ipLOCAL_IP_ADDRESS_POINTER != 0UL )
+	{
+		vARPRefreshCacheEntry( ipPOINTER_CAST( const MACAddress_t *, ipLOCAL_MAC_ADDRESS ), *ipLOCAL_IP_ADDRESS_POINTER );
+	}
+
+	#if( ipconfigLOOPBACK_BOTTLENECK_RATE != 0 )
+	{
+		prvBottleneckInit();
+	}
+	#endif
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t bReleaseAfterSend )
+{
+const EthernetHeader_t *pxEthernetHeader;
+BaseType_t xQueued = pdFALSE;
+
+	iptraceNETWORK_INTERFACE_TRANSMIT();
+	configASSERT( xIsCallingFromIPTask() == pdTRUE );
+
+	pxEthernetHeader = ipPOINTER_CAST( const EthernetHeader_t *, pxNetworkBuffer->pucEthernetBuffer );
+
+	if( prvIsARPRequestFor( pxNetworkBuffer->pucEthernetBuffer, *ipLOCAL_IP_ADDRESS_POINTER ) != pdFALSE )
+	{
+		/* The only station that can answer is this node.  Refresh the entry
+		directly rather than looping back a request that would look like an
+		IP address clash. */
+		vARPRefreshCacheEntry( ipPOINTER_CAST( const MACAddress_t *, ipLOCAL_MAC_ADDRESS ), *ipLOCAL_IP_ADDRESS_POINTER );
+	}
+	else if( memcmp( pxEthernetHeader->xDestinationAddress.ucBytes, ipLOCAL_MAC_ADDRESS, sizeof( MACAddress_t ) ) == 0 )
+	{
+		xQueued = prvLoopbackOrCopy( pxNetworkBuffer, bReleaseAfterSend );
+		bReleaseAfterSend = pdFALSE;
+	}
+	else
+	{
+		/* Broadcast and multicast frames have no other receiver on this
+		link. */
+	}
+
+	if( bReleaseAfterSend != pdFALSE )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+
+	#if( ipconfigUSE_TX_PRIORITY_QUEUES != 0 )
+	{
+		/* Frames in the bottleneck are reported when they leave it. */
+		if( xQueued == pdFALSE )
+		{
+			vNetworkInterfaceTxDone();
+		}
+	}
+	#else
+	{
+		( void ) xQueued;
+	}
+	#endif
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+#else /* ipconfigMULTI_INTERFACE */
+
+static BaseType_t prvLoopback_Initialise( NetworkInterface_t *pxInterface )
+{
+NetworkEndPoint_t *pxEndPoint;
+
+	/* Prime the ARP cache with all addresses of this interface, as in the
+	single interface build. */
+	for( pxEndPoint = FreeRTOS_FirstEndPoint(); pxEndPoint != NULL; pxEndPoint = FreeRTOS_NextEndPoint( pxEndPoint ) )
+	{
+		if( ( pxEndPoint->pxNetworkInterface == pxInterface ) && ( pxEndPoint->ulIPAddress != 0UL ) )
+		{
+			vARPRefreshCacheEntry( &( pxInterface->xMACAddress ), pxEndPoint->ulIPAddress );
+		}
+	}
+
+	#if( ipconfigLOOPBACK_BOTTLENECK_RATE != 0 )
+	{
+		/* All interfaces share the link, and so the bottleneck. */
+		prvBottleneckInit();
+	}
+	#endif
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvLoopback_Output( NetworkInterface_t *pxInterface, NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t bReleaseAfterSend )
+{
+const EthernetHeader_t *pxEthernetHeader;
+const ARPPacket_t *pxARPFrame;
+NetworkEndPoint_t *pxEndPoint = NULL;
+BaseType_t xQueued = pdFALSE;
+
+	( void ) pxInterface;
+	iptraceNETWORK_INTERFACE_TRANSMIT();
+	configASSERT( xIsCallingFromIPTask() == pdTRUE );
+
+	pxEthernetHeader = ipPOINTER_CAST( const EthernetHeader_t *, pxNetworkBuffer->pucEthernetBuffer );
+	pxARPFrame = ipPOINTER_CAST( const ARPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+
+	if( pxEthernetHeader->usFrameType == ipARP_FRAME_TYPE )
+	{
+		pxEndPoint = FreeRTOS_FindEndPointOnIP( pxARPFrame->xARPHeader.ulTargetProtocolAddress );
+	}
+
+	if( ( pxEndPoint != NULL ) &&
+		( prvIsARPRequestFor( pxNetworkBuffer->pucEthernetBuffer, pxEndPoint->ulIPAddress ) != pdFALSE ) )
+	{
+		/* The address belongs to one of the interfaces on the link, answer
+		with the MAC address of that interface. */
+		vARPRefreshCacheEntry( &( pxEndPoint->pxNetworkInterface->xMACAddress ), pxEndPoint->ulIPAddress );
+	}
+	else if( FreeRTOS_FindInterfaceOnMAC( &( pxEthernetHeader->xDestinationAddress ) ) != NULL )
+	{
+		xQueued = prvLoopbackOrCopy( pxNetworkBuffer, bReleaseAfterSend );
+		bReleaseAfterSend = pdFALSE;
+	}
+	else
+	{
+		/* Broadcast and multicast frames have no other receiver on this
+		link. */
+	}
+
+	if( bReleaseAfterSend != pdFALSE )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+	}
+
+	#if( ipconfigUSE_TX_PRIORITY_QUEUES != 0 )
+	{
+		/* Frames in the bottleneck are reported when they leave it. */
+		if( xQueued == pdFALSE )
+		{
+			vNetworkInterfaceTxDone();
+		}
+	}
+	#else
+	{
+		( void ) xQueued;
+	}
+	#endif
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+NetworkInterface_t *pxLoopback_FillInterfaceDescriptor( NetworkInterface_t *pxInterface, const char *pcName )
+{
+	( void ) memset( pxInterface, 0, sizeof( *pxInterface ) );
+	pxInterface->pcName = pcName;
+	pxInterface->pfInitialise = prvLoopback_Initialise;
+	pxInterface->pfOutput = prvLoopback_Output;
+	pxInterface->pfGetPhyLinkStatus = NULL;
+
+	return pxInterface;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* ipconfigMULTI_INTERFACE */
+
+static BaseType_t prvLoopbackOrCopy( NetworkBufferDescriptor_t * const pxNetworkBuffer, BaseType_t bReleaseAfterSend )
+{
+NetworkBufferDescriptor_t *pxLoopBuffer = NULL;
+BaseType_t xQueued = pdFALSE;
+
+	#if( ipconfigLOOPBACK_LOSS_PER_MILLE != 0 )
+	if( prvLoseSegment( pxNetworkBuffer ) != pdFALSE )
+	{
+		if( bReleaseAfterSend != pdFALSE )
+		{
+			vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+		}
+		ulLoopbackDropCount++;
+	}
+	else
+	#endif /* ipconfigLOOPBACK_LOSS_PER_MILLE */
+	if( bReleaseAfterSend != pdFALSE )
+	{
+		/* The descriptor is owned by the driver now, it can be passed on to
+		the IP task without copying. */
+		pxLoopBuffer = pxNetworkBuffer;
+	}
+	else
+	{
+		pxLoopBuffer = pxDuplicateNetworkBufferWithDescriptor( pxNetworkBuffer, pxNetworkBuffer->xDataLength );
+
+		if( pxLoopBuffer == NULL )
+		{
+			ulLoopbackDropCount++;
+			iptraceETHERNET_RX_EVENT_LOST();
+		}
+	}
+
+	if( pxLoopBuffer != NULL )
+	{
+		#if( ipconfigLOOPBACK_BOTTLENECK_RATE != 0 )
+		{
+			#if( ipconfigLOOPBACK_ECN_MARK_DEPTH != 0 )
+			{
+				if( uxQueueMessagesWaiting( xBottleneckQueue ) >= ( UBaseType_t ) ipconfigLOOPBACK_ECN_MARK_DEPTH )
+				{
+					prvMarkCongestion( pxLoopBuffer );
+				}
+			}
+			#endif
+
+			/* A full bottleneck drops the frame, like a switch with a shallow
+			buffer would. */
+			if( xQueueSendToBack( xBottleneckQueue, &pxLoopBuffer, ( TickType_t ) 0 ) != pdPASS )
+			{
+				vReleaseNetworkBufferAndDescriptor( pxLoopBuffer );
+				ulLoopbackDropCount++;
+				iptraceETHERNET_RX_EVENT_LOST();
+			}
+			else
+			{
+				xQueued = pdTRUE;
+			}
+		}
+		#else
+		{
+			prvLoopbackFrame( pxLoopBuffer );
+		}
+		#endif
+	}
+
+	return xQueued;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIsARPRequestFor( const uint8_t *pucEthernetBuffer, uint32_t ulIPAddress )
+{
+const ARPPacket_t *pxARPFrame = ipPOINTER_CAST( const ARPPacket_t *, pucEthernetBuffer );
+BaseType_t xReturn = pdFALSE;
+
+	if( ( pxARPFrame->xEthernetHeader.usFrameType == ipARP_FRAME_TYPE ) &&
+		( pxARPFrame->xARPHeader.usOperation == ( uint16_t ) ipARP_REQUEST ) &&
+		( pxARPFrame->xARPHeader.ulTargetProtocolAddress == ulIPAddress ) )
+	{
+		xReturn = pdTRUE;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvLoopbackFrame( NetworkBufferDescriptor_t * pxNetworkBuffer )
+{
+IPStackEvent_t xRxEvent = { eNetworkRxEvent, NULL };
+
+	iptraceNETWORK_INTERFACE_RECEIVE();
+
+	xRxEvent.pvData = ( void * ) pxNetworkBuffer;
+
+	/* This function may be called from the IP task, which must never block
+	on its own queue. */
+	if( xSendEventStructToIPTask( &xRxEvent, ( TickType_t ) 0 ) == pdFAIL )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxNetworkBuffer );
+		ulLoopbackDropCount++;
+		iptraceETHERNET_RX_EVENT_LOST();
+	}
+	else
+	{
+		ulLoopbackFrameCount++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+#if( ipconfigLOOPBACK_LOSS_PER_MILLE != 0 )
+
+	static BaseType_t prvLoseSegment( const NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	const TCPPacket_t *pxTCPPacket = ipPOINTER_CAST( const TCPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+	static uint32_t ulRandom = 1UL;
+	size_t uxHeaderLength;
+	BaseType_t xReturn = pdFALSE;
+
+		if( ( pxTCPPacket->xEthernetHeader.usFrameType == ipIPv4_FRAME_TYPE ) &&
+			( pxTCPPacket->xIPHeader.ucProtocol == ( uint8_t ) ipPROTOCOL_TCP ) )
+		{
+			uxHeaderLength = ( ( size_t ) ( pxTCPPacket->xIPHeader.ucVersionHeaderLength & 0x0FU ) << 2 ) +
+							 ( ( size_t ) ( pxTCPPacket->xTCPHeader.ucTCPOffset >> 4 ) << 2 );
+
+			/* Only segments with data, so connections are set up and closed
+			normally. */
+			if( ( size_t ) FreeRTOS_ntohs( pxTCPPacket->xIPHeader.usLength ) > uxHeaderLength )
+			{
+				/* A linear congruential generator with a fixed seed. */
+				ulRandom = ( ulRandom * 1103515245UL ) + 12345UL;
+
+				if( ( ( ulRandom >> 16 ) % 1000UL ) < ( uint32_t ) ipconfigLOOPBACK_LOSS_PER_MILLE )
+				{
+					xReturn = pdTRUE;
+				}
+			}
+		}
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigLOOPBACK_LOSS_PER_MILLE */
+
+#if( ipconfigLOOPBACK_BOTTLENECK_RATE != 0 )
+
+	static void prvBottleneckInit( void )
+	{
+		if( xBottleneckQueue == NULL )
+		{
+			xBottleneckQueue = xQueueCreate( ( UBaseType_t ) ipconfigLOOPBACK_BOTTLENECK_DEPTH, sizeof( NetworkBufferDescriptor_t * ) );
+			configASSERT( xBottleneckQueue != NULL );
+
+			/* The task runs above the IP task, so frames leave the bottleneck
+			on time. */
+			xTaskCreate( prvBottleneckTask, "Bottleneck", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1, NULL );
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvBottleneckTask( void *pvParameters )
+	{
+	NetworkBufferDescriptor_t *pxNetworkBuffer;
+	TickType_t xLastTime, xNow;
+	uint64_t ullCredit = 0U;
+	const uint64_t ullMaximumCredit = ( uint64_t ) ipconfigNETWORK_MTU + ipSIZE_OF_ETH_HEADER;
+
+		( void ) pvParameters;
+
+		xLastTime = xTaskGetTickCount();
+
+		for( ;; )
+		{
+			( void ) xQueueReceive( xBottleneckQueue, &pxNetworkBuffer, portMAX_DELAY );
+
+			/* The credit is counted in bytes times configTICK_RATE_HZ, so it
+			does not lose the fractions of a byte per clock tick.  An idle link
+			does not gain more credit than one frame. */
+			for( ;; )
+			{
+				xNow = xTaskGetTickCount();
+				ullCredit += ( uint64_t ) ( xNow - xLastTime ) * ( uint64_t ) ipconfigLOOPBACK_BOTTLENECK_RATE;
+				xLastTime = xNow;
+
+				if( ullCredit > ( ullMaximumCredit * configTICK_RATE_HZ ) )
+				{
+					ullCredit = ullMaximumCredit * configTICK_RATE_HZ;
+				}
+
+				if( ullCredit >= ( ( uint64_t ) pxNetworkBuffer->xDataLength * configTICK_RATE_HZ ) )
+				{
+					break;
+				}
+
+				vTaskDelay( 1U );
+			}
+
+			ullCredit -= ( uint64_t ) pxNetworkBuffer->xDataLength * configTICK_RATE_HZ;
+			prvLoopbackFrame( pxNetworkBuffer );
+
+			#if( ipconfigUSE_TX_PRIORITY_QUEUES != 0 )
+			{
+				/* The link has room for the next frame. */
+				vNetworkInterfaceTxDone();
+			}
+			#endif
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigLOOPBACK_BOTTLENECK_RATE */
+
+#if( ipconfigLOOPBACK_BOTTLENECK_RATE != 0 ) && ( ipconfigLOOPBACK_ECN_MARK_DEPTH != 0 )
+
+	static void prvMarkCongestion( NetworkBufferDescriptor_t *pxNetworkBuffer )
+	{
+	IPPacket_t *pxIPPacket = ipPOINTER_CAST( IPPacket_t *, pxNetworkBuffer->pucEthernetBuffer );
+	IPHeader_t *pxIPHeader = &( pxIPPacket->xIPHeader );
+	uint16_t usSum;
+
+		/* ECT(0) and ECT(1) become CE, packets that are not ECN-capable are
+		left alone. */
+		if( ( pxIPPacket->xEthernetHeader.usFrameType == ipIPv4_FRAME_TYPE ) &&
+			( ( pxIPHeader->ucDifferentiatedServicesCode & 0x03U ) != 0U ) )
+		{
+			pxIPHeader->ucDifferentiatedServicesCode |= 0x03U;
+
+			/* A router would update the header checksum as well. */
+			pxIPHeader->usHeaderChecksum = 0U;
+			usSum = usGenerateChecksum( 0U, ( const uint8_t * ) &( pxIPHeader->ucVersionHeaderLength ), ipSIZE_OF_IPv4_HEADER );
+			pxIPHeader->usHeaderChecksum = ~FreeRTOS_htons( usSum );
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigLOOPBACK_ECN_MARK_DEPTH */
+
+void vLoopbackGetCounters( uint32_t *pulFrames, uint32_t *pulDrops )
+{
+	*pulFrames = ulLoopbackFrameCount;
+	*pulDrops = ulLoopbackDropCount;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,337 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * A lock-free single-producer / single-consumer channel through shared
+ * memory, as an alternative to the message buffers of MessageBufferAMP.c for
+ * passing data from one core to another.
+ *
+ * The shared memory holds the index of the producer, the indexes of the
+ * consumer, and a ring of fixed size slots, each on cache lines of their own.
+ * Each index is written by one core only, so no locks or atomic
+ * read-modify-write instructions are needed, only memory barriers.  Indexes
+ * count messages and are never wrapped; the slot is found by masking, which is
+ * why the number of slots must be a power of 2.
+ *
+ * Messages are written and read in place: the producer reserves a slot, fills
+ * it and commits it; the consumer peeks at the oldest slot and releases it when
+ * done.  Neither end copies the data.
+ *
+ * Each end keeps a private copy of the other end's index, and only reads the
+ * shared index again when the private copy says that the channel is full or
+ * empty.  Committed messages become visible when the producer flushes, and
+ * released slots are given back in batches, so the cache lines that hold the
+ * indexes move between the cores once per batch, not once per message.
+ *
+ * The doorbell, e.g. an inter-core interrupt, is only rung when the consumer
+ * has said that it is going to wait, and then only once per wait.  A consumer
+ * that keeps up with the messages without waiting is never interrupted.  With
+ * MessageBufferAMP.c every message generates an interrupt through
+ * sbSEND_COMPLETED().
+ *
+ * When the shared memory is cached, the fnCacheClean() and fnCacheInvalidate()
+ * operations are called for the indexes and the slots, so the memory does not
+ * have to be coherent between the cores.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/* Demo app includes. */
+#include "AMPChannel.h"
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Return the start of the slot of the message with the given index.
+ */
+static uint8_t *prvSlot( const AMPChannel_t *pxChannel, uint32_t ulIndex );
+
+/*
+ * Call the cache operations, if any.
+ */
+static void prvCacheClean( const AMPChannel_t *pxChannel, const void *pvAddress, size_t uxLength );
+static void prvCacheInvalidate( const AMPChannel_t *pxChannel, const void *pvAddress, size_t uxLength );
+
+/*
+ * Consumer: give the released slots back to the producer.
+ */
+static void prvPublishTail( AMPChannel_t *pxChannel );
+
+/*-----------------------------------------------------------*/
+
+static uint8_t *prvSlot( const AMPChannel_t *pxChannel, uint32_t ulIndex )
+{
+	return &( pxChannel->pucSlots[ ( size_t ) ( ulIndex & ( pxChannel->ulSlotCount - 1UL ) ) * pxChannel->uxSlotStride ] );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCacheClean( const AMPChannel_t *pxChannel, const void *pvAddress, size_t uxLength )
+{
+	if( ( pxChannel->pxOps != NULL ) && ( pxChannel->pxOps->fnCacheClean != NULL ) )
+	{
+		pxChannel->pxOps->fnCacheClean( pvAddress, uxLength );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCacheInvalidate( const AMPChannel_t *pxChannel, const void *pvAddress, size_t uxLength )
+{
+	if( ( pxChannel->pxOps != NULL ) && ( pxChannel->pxOps->fnCacheInvalidate != NULL ) )
+	{
+		pxChannel->pxOps->fnCacheInvalidate( pvAddress, uxLength );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vAMPChannelReset( void *pvSharedMemory, const AMPChannelOps_t *pxOps )
+{
+	memset( pvSharedMemory, 0, sizeof( AMPChannelShared_t ) );
+
+	if( ( pxOps != NULL ) && ( pxOps->fnCacheClean != NULL ) )
+	{
+		pxOps->fnCacheClean( pvSharedMemory, sizeof( AMPChannelShared_t ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xAMPChannelOpen( AMPChannel_t *pxChannel,
+							void *pvSharedMemory,
+							uint32_t ulSlotCount,
+							size_t uxMessageSize,
+							const AMPChannelOps_t *pxOps,
+							void *pvContext )
+{
+BaseType_t xReturn = pdFAIL;
+
+	if( ( pvSharedMemory != NULL ) &&
+		( ( ( size_t ) pvSharedMemory & ( ( size_t ) ampconfigCACHE_LINE_SIZE - 1U ) ) == 0U ) &&
+		( ulSlotCount != 0UL ) &&
+		( ( ulSlotCount & ( ulSlotCount - 1UL ) ) == 0UL ) &&
+		( uxMessageSize <= ( size_t ) UINT32_MAX ) )
+	{
+		memset( pxChannel, 0, sizeof( *pxChannel ) );
+		pxChannel->pxShared = ( AMPChannelShared_t * ) pvSharedMemory;
+		pxChannel->pucSlots = ( uint8_t * ) pvSharedMemory + sizeof( AMPChannelShared_t );
+		pxChannel->pxOps = pxOps;
+		pxChannel->pvContext = pvContext;
+		pxChannel->ulSlotCount = ulSlotCount;
+		pxChannel->uxSlotStride = ampchannelSLOT_STRIDE( uxMessageSize );
+		pxChannel->uxMessageSize = uxMessageSize;
+
+		/* Both ends start at the indexes cleared by vAMPChannelReset(), so
+		the private copies start at zero as well. */
+		xReturn = pdPASS;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void *pvAMPChannelReserve( AMPChannel_t *pxChannel )
+{
+AMPChannelShared_t *pxShared = pxChannel->pxShared;
+void *pvReturn = NULL;
+
+	if( ( pxChannel->ulIndex - pxChannel->ulOther ) >= pxChannel->ulSlotCount )
+	{
+		/* Full as far as known, see how far the consumer has come. */
+		prvCacheInvalidate( pxChannel, &( pxShared->xConsumer ), sizeof( pxShared->xConsumer ) );
+		pxChannel->ulOther = pxShared->xConsumer.ulTail;
+
+		/* The consumer had finished reading the slots before it released
+		them, do not write them any earlier. */
+		ampconfigMEMORY_BARRIER();
+	}
+
+	if( ( pxChannel->ulIndex - pxChannel->ulOther ) < pxChannel->ulSlotCount )
+	{
+		pvReturn = ( void * ) &( prvSlot( pxChannel, pxChannel->ulIndex )[ ampchannelSLOT_HEADER_SIZE ] );
+	}
+	else
+	{
+		/* Really full: make sure that the consumer sees all messages, so it
+		can make room. */
+		vAMPChannelFlush( pxChannel );
+		pxChannel->ulFull++;
+	}
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vAMPChannelCommit( AMPChannel_t *pxChannel, size_t uxLength )
+{
+uint8_t *pucSlot = prvSlot( pxChannel, pxChannel->ulIndex );
+
+	configASSERT( uxLength <= pxChannel->uxMessageSize );
+	configASSERT( ( pxChannel->ulIndex - pxChannel->ulOther ) < pxChannel->ulSlotCount );
+
+	*( ( uint32_t * ) pucSlot ) = ( uint32_t ) uxLength;
+	prvCacheClean( pxChannel, pucSlot, ampchannelSLOT_HEADER_SIZE + uxLength );
+
+	pxChannel->ulIndex++;
+}
+/*-----------------------------------------------------------*/
+
+void vAMPChannelFlush( AMPChannel_t *pxChannel )
+{
+AMPChannelShared_t *pxShared = pxChannel->pxShared;
+uint32_t ulSleeps;
+
+	if( pxChannel->ulIndex != pxChannel->ulPublished )
+	{
+		/* The messages must be visible before the head that covers them. */
+		ampconfigMEMORY_BARRIER();
+		pxShared->xProducer.ulHead = pxChannel->ulIndex;
+		prvCacheClean( pxChannel, &( pxShared->xProducer ), sizeof( pxShared->xProducer ) );
+		pxChannel->ulPublished = pxChannel->ulIndex;
+
+		/* The head must be written before the consumer's sleep count is read.
+		xAMPChannelPrepareToWait() does the opposite, so either the consumer
+		sees the new head, or this sees that the consumer is going to wait. */
+		ampconfigMEMORY_BARRIER();
+		prvCacheInvalidate( pxChannel, &( pxShared->xConsumer ), sizeof( pxShared->xConsumer ) );
+		ulSleeps = pxShared->xConsumer.ulSleeps;
+
+		if( ulSleeps != pxChannel->ulSleeps )
+		{
+			/* Ring once per wait. */
+			pxChannel->ulSleeps = ulSleeps;
+			pxChannel->ulDoorbells++;
+
+			if( ( pxChannel->pxOps != NULL ) && ( pxChannel->pxOps->fnDoorbell != NULL ) )
+			{
+				pxChannel->pxOps->fnDoorbell( pxChannel->pvContext );
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+const void *pvAMPChannelPeek( AMPChannel_t *pxChannel, size_t *puxLength )
+{
+AMPChannelShared_t *pxShared = pxChannel->pxShared;
+const uint8_t *pucSlot;
+const void *pvReturn = NULL;
+size_t uxLength;
+
+	if( pxChannel->ulIndex == pxChannel->ulOther )
+	{
+		/* Empty as far as known, see if the producer has published more. */
+		prvCacheInvalidate( pxChannel, &( pxShared->xProducer ), sizeof( pxShared->xProducer ) );
+		pxChannel->ulOther = pxShared->xProducer.ulHead;
+
+		/* Do not read the slots before the head that covers them. */
+		ampconfigMEMORY_BARRIER();
+	}
+
+	if( pxChannel->ulIndex != pxChannel->ulOther )
+	{
+		pucSlot = prvSlot( pxChannel, pxChannel->ulIndex );
+		prvCacheInvalidate( pxChannel, pucSlot, ampchannelSLOT_HEADER_SIZE );
+		uxLength = ( size_t ) *( ( const uint32_t * ) pucSlot );
+		configASSERT( uxLength <= pxChannel->uxMessageSize );
+		prvCacheInvalidate( pxChannel, pucSlot, ampchannelSLOT_HEADER_SIZE + uxLength );
+
+		*puxLength = uxLength;
+		pvReturn = ( const void * ) &( pucSlot[ ampchannelSLOT_HEADER_SIZE ] );
+	}
+	else
+	{
+		/* Empty: give all slots back, the producer may be waiting for
+		them. */
+		prvPublishTail( pxChannel );
+	}
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vAMPChannelRelease( AMPChannel_t *pxChannel )
+{
+	configASSERT( pxChannel->ulIndex != pxChannel->ulOther );
+
+	pxChannel->ulIndex++;
+
+	if( ( pxChannel->ulIndex - pxChannel->ulPublished ) >= ( pxChannel->ulSlotCount / 4UL ) )
+	{
+		prvPublishTail( pxChannel );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvPublishTail( AMPChannel_t *pxChannel )
+{
+AMPChannelShared_t *pxShared = pxChannel->pxShared;
+
+	if( pxChannel->ulIndex != pxChannel->ulPublished )
+	{
+		/* The slots must have been read before they are given back. */
+		ampconfigMEMORY_BARRIER();
+		pxShared->xConsumer.ulTail = pxChannel->ulIndex;
+		prvCacheClean( pxChannel, &( pxShared->xConsumer ), sizeof( pxShared->xConsumer ) );
+		pxChannel->ulPublished = pxChannel->ulIndex;
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xAMPChannelPrepareToWait( AMPChannel_t *pxChannel )
+{
+AMPChannelShared_t *pxShared = pxChannel->pxShared;
+BaseType_t xReturn;
+
+	prvPublishTail( pxChannel );
+
+	/* Tell the producer that a doorbell is wanted, then look at the head
+	again, see vAMPChannelFlush(). */
+	pxChannel->ulSleeps++;
+	pxShared->xConsumer.ulSleeps = pxChannel->ulSleeps;
+	prvCacheClean( pxChannel, &( pxShared->xConsumer ), sizeof( pxShared->xConsumer ) );
+	ampconfigMEMORY_BARRIER();
+
+	prvCacheInvalidate( pxChannel, &( pxShared->xProducer ), sizeof( pxShared->xProducer ) );
+	pxChannel->ulOther = pxShared->xProducer.ulHead;
+	ampconfigMEMORY_BARRIER();
+
+	if( pxChannel->ulIndex == pxChannel->ulOther )
+	{
+		pxChannel->ulDoorbells++;
+		xReturn = pdTRUE;
+	}
+	else
+	{
+		xReturn = pdFALSE;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
@@ -37,11 +37,34 @@
 #include "queue.h"
 #include "semphr.h"
 
+/* Set sysarchUSE_TASK_NOTIFICATIONS to 1 in lwipopts.h to implement the lwIP
+semaphores with direct to task notifications instead of binary semaphores.
+The semaphore then only holds a count and the handle of the task waiting for
+it, and the waiting task is woken by a notification.  Each netconn or socket
+call that is passed to tcpip_thread then costs one queue operation instead of
+two.  Tasks that call the netconn or socket API must not use their
+notification value for anything else. */
+#ifndef sysarchUSE_TASK_NOTIFICATIONS
+	#define sysarchUSE_TASK_NOTIFICATIONS	0
+#endif
+
+#if( sysarchUSE_TASK_NOTIFICATIONS == 1 )
+	typedef struct xSYS_ARCH_SEM
+	{
+		TaskHandle_t xWaitingTask;	/* The task blocked on the semaphore, if any. */
+		UBaseType_t uxCount;			/* 0 or 1, like the binary semaphore it replaces. */
+	} SysArchSem_t;
+
+	typedef SysArchSem_t * sys_sem_t;
+	#define SYS_SEM_NULL				( ( sys_sem_t ) NULL )
+#else
+	typedef SemaphoreHandle_t sys_sem_t;
+	#define SYS_SEM_NULL				( ( SemaphoreHandle_t ) NULL )
+#endif
+
 #define SYS_MBOX_NULL					( ( QueueHandle_t ) NULL )
-#define SYS_SEM_NULL					( ( SemaphoreHandle_t ) NULL )
 #define SYS_DEFAULT_THREAD_STACK_DEPTH	configMINIMAL_STACK_SIZE
 
-typedef SemaphoreHandle_t sys_sem_t;
 typedef SemaphoreHandle_t sys_mutex_t;
 typedef QueueHandle_t sys_mbox_t;
 typedef TaskHandle_t sys_thread_t;
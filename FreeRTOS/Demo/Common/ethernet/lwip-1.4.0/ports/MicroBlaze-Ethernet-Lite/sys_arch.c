@@ -36,12 +36,14 @@
 //
 //*****************************************************************************
 
-/* ------------------------ System architecture includes ----------------------------- */
-#include "arch/sys_arch.h"
-
 /* ------------------------ lwIP includes --------------------------------- */
+/* lwip/opt.h includes lwipopts.h, which may set sysarchUSE_TASK_NOTIFICATIONS,
+so must come before arch/sys_arch.h. */
 #include "lwip/opt.h"
 
+/* ------------------------ System architecture includes ----------------------------- */
+#include "arch/sys_arch.h"
+
 #include "lwip/debug.h"
 #include "lwip/def.h"
 #include "lwip/sys.h"
@@ -300,6 +302,32 @@ portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
  * Outputs:
  *      sys_sem_t               -- Created semaphore or 0 if could not create.
  *---------------------------------------------------------------------------*/
+#if( sysarchUSE_TASK_NOTIFICATIONS == 1 )
+
+err_t sys_sem_new( sys_sem_t *pxSemaphore, u8_t ucCount )
+{
+err_t xReturn = ERR_MEM;
+
+	*pxSemaphore = ( sys_sem_t ) pvPortMalloc( sizeof( SysArchSem_t ) );
+
+	if( *pxSemaphore != NULL )
+	{
+		( *pxSemaphore )->xWaitingTask = NULL;
+		( *pxSemaphore )->uxCount = ( UBaseType_t ) ucCount;
+
+		xReturn = ERR_OK;
+		SYS_STATS_INC_USED( sem );
+	}
+	else
+	{
+		SYS_STATS_INC( sem.err );
+	}
+
+	return xReturn;
+}
+
+#else /* sysarchUSE_TASK_NOTIFICATIONS */
+
 err_t sys_sem_new( sys_sem_t *pxSemaphore, u8_t ucCount )
 {
 err_t xReturn = ERR_MEM;
@@ -324,6 +352,8 @@ err_t xReturn = ERR_MEM;
 	return xReturn;
 }
 
+#endif /* sysarchUSE_TASK_NOTIFICATIONS */
+
 /*---------------------------------------------------------------------------*
  * Routine:  sys_arch_sem_wait
  *---------------------------------------------------------------------------*
@@ -347,6 +377,83 @@ err_t xReturn = ERR_MEM;
  * Outputs:
  *      u32_t                   -- Time elapsed or SYS_ARCH_TIMEOUT.
  *---------------------------------------------------------------------------*/
+#if( sysarchUSE_TASK_NOTIFICATIONS == 1 )
+
+u32_t sys_arch_sem_wait( sys_sem_t *pxSemaphore, u32_t ulTimeout )
+{
+SysArchSem_t *pxSem = *pxSemaphore;
+TaskHandle_t xCurrentTask = xTaskGetCurrentTaskHandle();
+TickType_t xStartTime, xElapsed, xTicksToWait;
+TimeOut_t xTimeOut;
+BaseType_t xTaken = pdFALSE;
+unsigned long ulReturn;
+
+	configASSERT( xInsideISR == ( portBASE_TYPE ) 0 );
+
+	xStartTime = xTaskGetTickCount();
+	xTicksToWait = ( ulTimeout != 0UL ) ? ( ulTimeout / portTICK_PERIOD_MS ) : portMAX_DELAY;
+	vTaskSetTimeOutState( &xTimeOut );
+
+	for( ;; )
+	{
+		taskENTER_CRITICAL();
+		{
+			if( pxSem->uxCount != ( UBaseType_t ) 0 )
+			{
+				pxSem->uxCount--;
+				pxSem->xWaitingTask = NULL;
+				xTaken = pdTRUE;
+			}
+			else
+			{
+				/* Only one task at a time waits for an lwIP semaphore. */
+				configASSERT( ( pxSem->xWaitingTask == NULL ) || ( pxSem->xWaitingTask == xCurrentTask ) );
+				pxSem->xWaitingTask = xCurrentTask;
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		if( xTaken != pdFALSE )
+		{
+			break;
+		}
+
+		if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+		{
+			taskENTER_CRITICAL();
+			{
+				pxSem->xWaitingTask = NULL;
+			}
+			taskEXIT_CRITICAL();
+			break;
+		}
+
+		/* A notification may be left over from a signal that raced with an
+		earlier wait, so the count is checked again after waking. */
+		( void ) ulTaskNotifyTake( pdTRUE, xTicksToWait );
+	}
+
+	if( xTaken != pdFALSE )
+	{
+		xElapsed = ( xTaskGetTickCount() - xStartTime ) * portTICK_PERIOD_MS;
+
+		if( ( ulTimeout == 0UL ) && ( xElapsed == 0UL ) )
+		{
+			xElapsed = 1UL;
+		}
+
+		ulReturn = xElapsed;
+	}
+	else
+	{
+		ulReturn = SYS_ARCH_TIMEOUT;
+	}
+
+	return ulReturn;
+}
+
+#else /* sysarchUSE_TASK_NOTIFICATIONS */
+
 u32_t sys_arch_sem_wait( sys_sem_t *pxSemaphore, u32_t ulTimeout )
 {
 TickType_t xStartTime, xEndTime, xElapsed;
@@ -384,6 +491,8 @@ unsigned long ulReturn;
 	return ulReturn;
 }
 
+#endif /* sysarchUSE_TASK_NOTIFICATIONS */
+
 /** Create a new mutex
  * @param mutex pointer to the mutex to create
  * @return a new mutex */
@@ -438,6 +547,44 @@ void sys_mutex_free( sys_mutex_t *pxMutex )
  * Inputs:
  *      sys_sem_t sem           -- Semaphore to signal
  *---------------------------------------------------------------------------*/
+#if( sysarchUSE_TASK_NOTIFICATIONS == 1 )
+
+void sys_sem_signal( sys_sem_t *pxSemaphore )
+{
+SysArchSem_t *pxSem = *pxSemaphore;
+TaskHandle_t xTaskToNotify;
+portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+
+	if( xInsideISR != pdFALSE )
+	{
+		/* Interrupts do not nest, so no critical section is needed.  Like the
+		binary semaphore it replaces, the count does not go above 1. */
+		pxSem->uxCount = ( UBaseType_t ) 1;
+		xTaskToNotify = pxSem->xWaitingTask;
+
+		if( xTaskToNotify != NULL )
+		{
+			vTaskNotifyGiveFromISR( xTaskToNotify, &xHigherPriorityTaskWoken );
+		}
+	}
+	else
+	{
+		taskENTER_CRITICAL();
+		{
+			pxSem->uxCount = ( UBaseType_t ) 1;
+			xTaskToNotify = pxSem->xWaitingTask;
+		}
+		taskEXIT_CRITICAL();
+
+		if( xTaskToNotify != NULL )
+		{
+			xTaskNotifyGive( xTaskToNotify );
+		}
+	}
+}
+
+#else /* sysarchUSE_TASK_NOTIFICATIONS */
+
 void sys_sem_signal( sys_sem_t *pxSemaphore )
 {
 portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
@@ -452,6 +599,8 @@ portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
 	}
 }
 
+#endif /* sysarchUSE_TASK_NOTIFICATIONS */
+
 /*---------------------------------------------------------------------------*
  * Routine:  sys_sem_free
  *---------------------------------------------------------------------------*
@@ -463,7 +612,17 @@ portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
 void sys_sem_free( sys_sem_t *pxSemaphore )
 {
 	SYS_STATS_DEC(sem.used);
-	vQueueDelete( *pxSemaphore );
+
+	#if( sysarchUSE_TASK_NOTIFICATIONS == 1 )
+	{
+		configASSERT( ( *pxSemaphore )->xWaitingTask == NULL );
+		vPortFree( *pxSemaphore );
+	}
+	#else
+	{
+		vQueueDelete( *pxSemaphore );
+	}
+	#endif
 }
 
 /*---------------------------------------------------------------------------*
@@ -97,6 +97,16 @@ struct tcp_pcb ** const tcp_pcb_lists[] = {&tcp_listen_pcbs.pcbs, &tcp_bound_pcb
 /** Only used for temporary storage. */
 struct tcp_pcb *tcp_tmp_pcb;
 
+#if TCP_PCB_HASH_SIZE
+#if (TCP_PCB_HASH_SIZE & (TCP_PCB_HASH_SIZE - 1)) != 0
+#error "TCP_PCB_HASH_SIZE must be a power of 2"
+#endif
+/** Active and TIME-WAIT PCBs, hashed on addresses and ports */
+struct tcp_pcb *tcp_conn_hash[TCP_PCB_HASH_SIZE];
+/** Listening PCBs, hashed on the local port */
+struct tcp_pcb_listen *tcp_listen_hash[TCP_PCB_HASH_SIZE];
+#endif /* TCP_PCB_HASH_SIZE */
+
 /** Timer counter to handle calling slow-timer from tcp_tmr() */ 
 static u8_t tcp_timer;
 static u16_t tcp_new_port(void);
@@ -916,6 +926,7 @@ tcp_slowtmr(void)
         LWIP_ASSERT("tcp_slowtmr: first pcb == tcp_active_pcbs", tcp_active_pcbs == pcb);
         tcp_active_pcbs = pcb->next;
       }
+      TCP_HASH_RMV(&tcp_active_pcbs, pcb);
 
       TCP_EVENT_ERR(pcb->errf, pcb->callback_arg, ERR_ABRT);
       if (pcb_reset) {
@@ -973,6 +984,7 @@ tcp_slowtmr(void)
         LWIP_ASSERT("tcp_slowtmr: first pcb == tcp_tw_pcbs", tcp_tw_pcbs == pcb);
         tcp_tw_pcbs = pcb->next;
       }
+      TCP_HASH_RMV(&tcp_tw_pcbs, pcb);
       pcb2 = pcb;
       pcb = pcb->next;
       memp_free(MEMP_TCP_PCB, pcb2);
@@ -1455,6 +1467,138 @@ tcp_pcb_remove(struct tcp_pcb **pcblist, struct tcp_pcb *pcb)
   LWIP_ASSERT("tcp_pcb_remove: tcp_pcbs_sane()", tcp_pcbs_sane());
 }
 
+#if TCP_PCB_HASH_SIZE
+/**
+ * Returns the bucket of tcp_conn_hash for a connection.
+ */
+static u32_t
+tcp_hash_index(ip_addr_t *local_ip, u16_t local_port,
+               ip_addr_t *remote_ip, u16_t remote_port)
+{
+  u32_t hash;
+
+  hash = ip4_addr_get_u32(local_ip) ^ ip4_addr_get_u32(remote_ip) ^
+    (((u32_t)remote_port << 16) | local_port);
+  /* Multiplicative hashing: the high bits depend on all input bits. */
+  hash *= 0x9E3779B1UL;
+  return (hash >> 16) & (TCP_PCB_HASH_SIZE - 1);
+}
+
+/**
+ * Returns the bucket of tcp_listen_hash for a local port.
+ */
+#define TCP_LISTEN_HASH_INDEX(port) (((port) ^ ((port) >> 8)) & (TCP_PCB_HASH_SIZE - 1))
+
+/**
+ * Adds a PCB to the hash table that mirrors the list it is registered with.
+ * Called from TCP_REG.
+ *
+ * @param pcbs the PCB list the pcb is registered with
+ * @param pcb the tcp_pcb to add
+ */
+void
+tcp_hash_add(struct tcp_pcb **pcbs, struct tcp_pcb *pcb)
+{
+  struct tcp_pcb **bucket;
+
+  if ((pcbs == &tcp_active_pcbs) || (pcbs == &tcp_tw_pcbs)) {
+    bucket = &tcp_conn_hash[tcp_hash_index(&pcb->local_ip, pcb->local_port,
+      &pcb->remote_ip, pcb->remote_port)];
+  } else if (pcbs == &tcp_listen_pcbs.pcbs) {
+    /* listening PCBs share the leading members with tcp_pcb, as in
+       tcp_listen_pcbs */
+    bucket = (struct tcp_pcb **)&tcp_listen_hash[TCP_LISTEN_HASH_INDEX(pcb->local_port)];
+  } else {
+    /* bound PCBs do not receive segments */
+    return;
+  }
+  pcb->hash_next = *bucket;
+  *bucket = pcb;
+}
+
+/**
+ * Removes a PCB from the hash table that mirrors the list it is removed from.
+ * Called from TCP_RMV.
+ *
+ * @param pcbs the PCB list the pcb is removed from
+ * @param pcb the tcp_pcb to remove
+ */
+void
+tcp_hash_remove(struct tcp_pcb **pcbs, struct tcp_pcb *pcb)
+{
+  struct tcp_pcb **bucket;
+
+  if ((pcbs == &tcp_active_pcbs) || (pcbs == &tcp_tw_pcbs)) {
+    bucket = &tcp_conn_hash[tcp_hash_index(&pcb->local_ip, pcb->local_port,
+      &pcb->remote_ip, pcb->remote_port)];
+  } else if (pcbs == &tcp_listen_pcbs.pcbs) {
+    bucket = (struct tcp_pcb **)&tcp_listen_hash[TCP_LISTEN_HASH_INDEX(pcb->local_port)];
+  } else {
+    return;
+  }
+  for (; *bucket != NULL; bucket = &(*bucket)->hash_next) {
+    if (*bucket == pcb) {
+      *bucket = pcb->hash_next;
+      break;
+    }
+  }
+  pcb->hash_next = NULL;
+}
+
+/**
+ * Finds the active or TIME-WAIT PCB of a connection. An active PCB is
+ * preferred over a TIME-WAIT PCB with the same addresses and ports.
+ *
+ * @return the tcp_pcb of the connection, NULL if there is none
+ */
+struct tcp_pcb *
+tcp_hash_lookup(ip_addr_t *local_ip, u16_t local_port,
+                ip_addr_t *remote_ip, u16_t remote_port)
+{
+  struct tcp_pcb *pcb;
+  struct tcp_pcb *tw_pcb = NULL;
+
+  for (pcb = tcp_conn_hash[tcp_hash_index(local_ip, local_port, remote_ip, remote_port)];
+       pcb != NULL; pcb = pcb->hash_next) {
+    if (pcb->remote_port == remote_port &&
+       pcb->local_port == local_port &&
+       ip_addr_cmp(&(pcb->remote_ip), remote_ip) &&
+       ip_addr_cmp(&(pcb->local_ip), local_ip)) {
+      if (pcb->state != TIME_WAIT) {
+        return pcb;
+      }
+      tw_pcb = pcb;
+    }
+  }
+  return tw_pcb;
+}
+
+/**
+ * Finds the listening PCB for a local address and port. A PCB listening on
+ * the address is preferred over one listening on any address.
+ *
+ * @return the tcp_pcb_listen for the port, NULL if there is none
+ */
+struct tcp_pcb_listen *
+tcp_hash_lookup_listen(ip_addr_t *local_ip, u16_t local_port)
+{
+  struct tcp_pcb_listen *lpcb;
+  struct tcp_pcb_listen *lpcb_any = NULL;
+
+  for (lpcb = tcp_listen_hash[TCP_LISTEN_HASH_INDEX(local_port)];
+       lpcb != NULL; lpcb = lpcb->hash_next) {
+    if (lpcb->local_port == local_port) {
+      if (ip_addr_cmp(&(lpcb->local_ip), local_ip)) {
+        return lpcb;
+      } else if (ip_addr_isany(&(lpcb->local_ip))) {
+        lpcb_any = lpcb;
+      }
+    }
+  }
+  return lpcb_any;
+}
+#endif /* TCP_PCB_HASH_SIZE */
+
 /**
  * Calculates a new initial sequence number for new connections.
  *
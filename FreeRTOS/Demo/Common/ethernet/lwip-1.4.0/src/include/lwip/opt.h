@@ -985,6 +985,17 @@
 #define TCP_LISTEN_BACKLOG              0
 #endif
 
+/**
+ * TCP_PCB_HASH_SIZE: when > 0, tcp_input() finds the PCB of an incoming
+ * segment in hash tables of this many buckets (must be a power of 2) instead
+ * of walking the PCB lists. Active and TIME-WAIT PCBs are hashed on their
+ * addresses and ports, listening PCBs on their local port. This costs one
+ * pointer per PCB and two pointers per bucket.
+ */
+#ifndef TCP_PCB_HASH_SIZE
+#define TCP_PCB_HASH_SIZE               0
+#endif
+
 /**
  * The maximum allowed backlog for TCP listen netconns.
  * This backlog is used unless another is explicitly specified.
@@ -154,8 +154,15 @@ enum tcp_state {
 /**
  * members common to struct tcp_pcb and struct tcp_listen_pcb
  */
+#if TCP_PCB_HASH_SIZE
+#define TCP_PCB_HASH_NEXT(type) type *hash_next; /* for the hash bucket */
+#else /* TCP_PCB_HASH_SIZE */
+#define TCP_PCB_HASH_NEXT(type)
+#endif /* TCP_PCB_HASH_SIZE */
+
 #define TCP_PCB_COMMON(type) \
   type *next; /* for the linked list */ \
+  TCP_PCB_HASH_NEXT(type) \
   enum tcp_state state; /* TCP state */ \
   u8_t prio; \
   void *callback_arg; \
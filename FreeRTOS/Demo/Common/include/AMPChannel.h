@@ -0,0 +1,202 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * A lock-free single-producer / single-consumer channel for passing messages
+ * between two cores, or two processes, through shared memory.  See
+ * AMPChannel.c.
+ */
+
+#ifndef AMP_CHANNEL_H
+#define AMP_CHANNEL_H
+
+#ifndef INC_FREERTOS_H
+	#error "include FreeRTOS.h must appear in source files before include AMPChannel.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef ampconfigCACHE_LINE_SIZE
+	/* The indexes of the producer and of the consumer, and every slot, start
+	on a cache line of their own, so that a core never writes to a line that
+	the other core writes to, and cache maintenance of one never touches the
+	other. */
+	#define ampconfigCACHE_LINE_SIZE		32
+#endif
+
+#ifndef ampconfigMEMORY_BARRIER
+	/* Orders the accesses to shared memory as seen by the other core, e.g.
+	__DMB() on a Cortex-M. */
+	#if defined( __GNUC__ )
+		#define ampconfigMEMORY_BARRIER()	__sync_synchronize()
+	#else
+		#error Define ampconfigMEMORY_BARRIER() for this compiler.
+	#endif
+#endif
+
+/* The size of the slot header, which holds the length of the message.  It
+keeps the message 8-byte aligned. */
+#define ampchannelSLOT_HEADER_SIZE			( ( size_t ) 8U )
+
+/* The distance between two slots that hold messages of up to xMessageSize
+bytes. */
+#define ampchannelSLOT_STRIDE( xMessageSize ) \
+	( ( ampchannelSLOT_HEADER_SIZE + ( size_t ) ( xMessageSize ) + ampconfigCACHE_LINE_SIZE - 1U ) & ~( ( size_t ) ampconfigCACHE_LINE_SIZE - 1U ) )
+
+/* The number of bytes of shared memory needed by a channel of xSlotCount
+messages of up to xMessageSize bytes. */
+#define ampchannelSHARED_SIZE( xSlotCount, xMessageSize ) \
+	( sizeof( AMPChannelShared_t ) + ( ( size_t ) ( xSlotCount ) * ampchannelSLOT_STRIDE( xMessageSize ) ) )
+
+/* Written by the producer only. */
+typedef struct xAMP_CHANNEL_PRODUCER
+{
+	volatile uint32_t ulHead;		/* The number of messages published. */
+	uint8_t ucPadding[ ampconfigCACHE_LINE_SIZE - sizeof( uint32_t ) ];
+} AMPChannelProducer_t;
+
+/* Written by the consumer only. */
+typedef struct xAMP_CHANNEL_CONSUMER
+{
+	volatile uint32_t ulTail;		/* The number of messages released. */
+	volatile uint32_t ulSleeps;		/* Incremented each time the consumer waits for the doorbell. */
+	uint8_t ucPadding[ ampconfigCACHE_LINE_SIZE - ( 2U * sizeof( uint32_t ) ) ];
+} AMPChannelConsumer_t;
+
+/* The start of the shared memory, followed by the slots.  It must be aligned
+to a cache line. */
+typedef struct xAMP_CHANNEL_SHARED
+{
+	AMPChannelProducer_t xProducer;
+	AMPChannelConsumer_t xConsumer;
+} AMPChannelShared_t;
+
+typedef struct xAMP_CHANNEL_OPS
+{
+	/* Producer: interrupt the consumer, which waits for new messages.  On a
+	dual core device this triggers the inter-core interrupt, whose handler
+	wakes the consumer task, e.g. with vTaskNotifyGiveFromISR(). */
+	void ( *fnDoorbell )( void *pvContext );
+
+	/* Optional: write data back from the cache before the other core reads
+	it, and invalidate the cache before reading what the other core has
+	written.  Not needed when the shared memory is not cached. */
+	void ( *fnCacheClean )( const void *pvAddress, size_t uxLength );
+	void ( *fnCacheInvalidate )( const void *pvAddress, size_t uxLength );
+} AMPChannelOps_t;
+
+/* The private state of one end of a channel. */
+typedef struct xAMP_CHANNEL
+{
+	AMPChannelShared_t *pxShared;
+	uint8_t *pucSlots;
+	const AMPChannelOps_t *pxOps;
+	void *pvContext;				/* Passed to fnDoorbell(). */
+	uint32_t ulSlotCount;			/* A power of 2. */
+	size_t uxSlotStride;
+	size_t uxMessageSize;
+	uint32_t ulIndex;		/* Producer: the number of messages committed.  Consumer: the number of messages taken. */
+	uint32_t ulPublished;	/* The index as last written to the shared memory. */
+	uint32_t ulOther;		/* Producer: the consumer's tail, as last read.  Consumer: the producer's head, as last read. */
+	uint32_t ulSleeps;		/* Producer: the sleep of the consumer that has been rung for. */
+
+	/* Statistics, for inspection only. */
+	uint32_t ulDoorbells;	/* Producer: the number of doorbells rung.  Consumer: the number of waits. */
+	uint32_t ulFull;		/* Producer: the number of times a slot could not be reserved. */
+} AMPChannel_t;
+
+/*
+ * Clear the indexes of a channel in shared memory.  Called once, by one of
+ * the two cores, before either end is opened.  pxOps may be NULL.
+ */
+void vAMPChannelReset( void *pvSharedMemory, const AMPChannelOps_t *pxOps );
+
+/*
+ * Attach one end of a channel to its shared memory, which holds ulSlotCount
+ * messages of up to uxMessageSize bytes, see ampchannelSHARED_SIZE().
+ * ulSlotCount must be a power of 2, and both ends must use the same values.
+ * pxOps may be NULL for a consumer that does not wait for the doorbell, and
+ * for shared memory that is not cached.  Returns pdFAIL when the parameters
+ * are not valid.
+ */
+BaseType_t xAMPChannelOpen( AMPChannel_t *pxChannel,
+							void *pvSharedMemory,
+							uint32_t ulSlotCount,
+							size_t uxMessageSize,
+							const AMPChannelOps_t *pxOps,
+							void *pvContext );
+
+/*
+ * Producer: return a free slot of uxMessageSize bytes, in which the next
+ * message can be written in place, or NULL when the channel is full.  When
+ * full, the committed messages are published first.
+ */
+void *pvAMPChannelReserve( AMPChannel_t *pxChannel );
+
+/*
+ * Producer: the message of uxLength bytes in the slot returned by
+ * pvAMPChannelReserve() is complete.  It becomes visible to the consumer with
+ * the next call to vAMPChannelFlush().
+ */
+void vAMPChannelCommit( AMPChannel_t *pxChannel, size_t uxLength );
+
+/*
+ * Producer: publish all committed messages, and ring the doorbell when the
+ * consumer is waiting for them.  Committing a batch of messages, then
+ * flushing once, rings the doorbell at most once per batch.
+ */
+void vAMPChannelFlush( AMPChannel_t *pxChannel );
+
+/*
+ * Consumer: return the oldest message in place, and its length, or NULL when
+ * the channel is empty.  The same message is returned until it is released.
+ */
+const void *pvAMPChannelPeek( AMPChannel_t *pxChannel, size_t *puxLength );
+
+/*
+ * Consumer: the message returned by pvAMPChannelPeek() has been handled, its
+ * slot may be reused.  Slots are given back to the producer in batches of a
+ * quarter of the channel, or when the channel is empty.
+ */
+void vAMPChannelRelease( AMPChannel_t *pxChannel );
+
+/*
+ * Consumer: call before waiting for the doorbell.  Returns pdTRUE when the
+ * channel is still empty, and the producer will ring the doorbell for the
+ * next message; pdFALSE when a message has arrived, and the consumer must not
+ * wait.  A doorbell may be rung after pdFALSE was returned, so a wait may end
+ * without a new message.
+ */
+BaseType_t xAMPChannelPrepareToWait( AMPChannel_t *pxChannel );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* AMP_CHANNEL_H */
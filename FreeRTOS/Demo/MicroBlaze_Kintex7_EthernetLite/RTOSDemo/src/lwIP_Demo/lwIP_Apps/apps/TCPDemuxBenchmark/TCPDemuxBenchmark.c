@@ -0,0 +1,243 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * Measures how long tcp_input() takes to find the connection of a segment,
+ * as a function of the number of connections.
+ *
+ * For each number of connections in the sweep, that many established PCBs
+ * are created, as if connected to peers on the local subnet.  Then
+ * demuxSEGMENTS pure ACK segments are passed to tcp_input(), cycling through
+ * the connections, so every segment is for a different connection than the
+ * one before.  That is the worst case for the move-to-front lookup of the PCB
+ * lists, and the case that the hash tables of TCP_PCB_HASH_SIZE are for.  The
+ * ACKs acknowledge nothing new and carry no data, so they change nothing and
+ * cause nothing to be sent.  The time per segment includes allocating and
+ * filling the pbuf, which does not depend on the number of connections.
+ *
+ * The number of connections is limited by MEMP_NUM_TCP_PCB in lwipopts.h.
+ *
+ * vTCPDemuxBenchmark() must run in the TCP/IP thread, so start it with
+ * tcpip_callback(), passing the netif.  It blocks the thread while it runs.
+ */
+
+/* Standard includes. */
+#include <string.h>
+#include <stdio.h>
+
+/* lwIP core includes */
+#include "lwip/opt.h"
+#include "lwip/tcp_impl.h"
+#include "lwip/ip.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/pbuf.h"
+#include "lwip/netif.h"
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* The number of segments timed per number of connections. */
+#define demuxSEGMENTS			20000UL
+
+/* The most connections that are created. */
+#define demuxMAX_CONNECTIONS	256
+
+/* The local port of all connections, and the first remote port. */
+#define demuxLOCAL_PORT			5002
+#define demuxFIRST_REMOTE_PORT	30000
+
+/* The length of the IP and TCP headers of each segment. */
+#define demuxHEADER_LENGTH		( IP_HLEN + TCP_HLEN )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Create an established PCB for a connection from the peer at pxRemoteIP.
+ */
+static struct tcp_pcb *prvCreateConnection( struct netif *pxNetIf, ip_addr_t *pxRemoteIP, u16_t usRemotePort );
+
+/*
+ * Fill in the IP and TCP headers of an ACK for pxPCB.
+ */
+static void prvBuildACK( struct tcp_pcb *pxPCB, u8_t *pucHeaders );
+
+/*-----------------------------------------------------------*/
+
+/* The connections, and the headers of the segments sent to them. */
+static struct tcp_pcb *pxConnections[ demuxMAX_CONNECTIONS ];
+static u8_t ucHeaders[ demuxMAX_CONNECTIONS ][ demuxHEADER_LENGTH ];
+
+/*-----------------------------------------------------------*/
+
+static struct tcp_pcb *prvCreateConnection( struct netif *pxNetIf, ip_addr_t *pxRemoteIP, u16_t usRemotePort )
+{
+struct tcp_pcb *pxPCB;
+const u32_t ulISN = 0x10000UL;
+
+	pxPCB = tcp_new();
+
+	if( pxPCB != NULL )
+	{
+		ip_addr_copy( pxPCB->local_ip, pxNetIf->ip_addr );
+		pxPCB->local_port = demuxLOCAL_PORT;
+		ip_addr_copy( pxPCB->remote_ip, *pxRemoteIP );
+		pxPCB->remote_port = usRemotePort;
+		pxPCB->state = ESTABLISHED;
+
+		/* Nothing sent or received yet. */
+		pxPCB->lastack = ulISN;
+		pxPCB->snd_nxt = ulISN;
+		pxPCB->snd_lbb = ulISN;
+		pxPCB->snd_wl2 = ulISN;
+		pxPCB->rcv_nxt = ulISN;
+
+		TCP_REG( &tcp_active_pcbs, pxPCB );
+	}
+
+	return pxPCB;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBuildACK( struct tcp_pcb *pxPCB, u8_t *pucHeaders )
+{
+struct ip_hdr *pxIPHeader = ( struct ip_hdr * ) pucHeaders;
+struct tcp_hdr *pxTCPHeader = ( struct tcp_hdr * ) ( pucHeaders + IP_HLEN );
+struct pbuf xPbuf;
+
+	memset( pucHeaders, 0, demuxHEADER_LENGTH );
+
+	IPH_VHLTOS_SET( pxIPHeader, 4, IP_HLEN / 4, 0 );
+	IPH_LEN_SET( pxIPHeader, htons( demuxHEADER_LENGTH ) );
+	IPH_TTL_SET( pxIPHeader, 64 );
+	IPH_PROTO_SET( pxIPHeader, IP_PROTO_TCP );
+	ip_addr_copy( pxIPHeader->src, pxPCB->remote_ip );
+	ip_addr_copy( pxIPHeader->dest, pxPCB->local_ip );
+	IPH_CHKSUM_SET( pxIPHeader, inet_chksum( pxIPHeader, IP_HLEN ) );
+
+	pxTCPHeader->src = htons( pxPCB->remote_port );
+	pxTCPHeader->dest = htons( pxPCB->local_port );
+	pxTCPHeader->seqno = htonl( pxPCB->rcv_nxt );
+	pxTCPHeader->ackno = htonl( pxPCB->snd_nxt );
+	TCPH_HDRLEN_FLAGS_SET( pxTCPHeader, TCP_HLEN / 4, TCP_ACK );
+	pxTCPHeader->wnd = htons( TCP_WND );
+
+	/* A pbuf on the stack, only to compute the checksum. */
+	memset( &xPbuf, 0, sizeof( xPbuf ) );
+	xPbuf.payload = pxTCPHeader;
+	xPbuf.len = TCP_HLEN;
+	xPbuf.tot_len = TCP_HLEN;
+	pxTCPHeader->chksum = inet_chksum_pseudo( &xPbuf, &( pxPCB->remote_ip ), &( pxPCB->local_ip ), IP_PROTO_TCP, TCP_HLEN );
+}
+/*-----------------------------------------------------------*/
+
+void vTCPDemuxBenchmark( void *pvNetIf )
+{
+struct netif *pxNetIf = ( struct netif * ) pvNetIf;
+ip_addr_t xRemoteIP;
+struct pbuf *pxPbuf;
+TickType_t xStartTime, xElapsed;
+u32_t ulSegment, ulDropped;
+u32_t ulCreated, ulConnection, ulConnections;
+static char cMessage[ 100 ];
+
+	sprintf( cMessage, "\r\ntcp_input() demux, TCP_PCB_HASH_SIZE %d\r\n", TCP_PCB_HASH_SIZE );
+	xil_printf( cMessage );
+
+	ulCreated = 0;
+
+	for( ulConnections = 1; ulConnections <= demuxMAX_CONNECTIONS; ulConnections *= 2 )
+	{
+		/* Add connections from peers on the local subnet. */
+		while( ulCreated < ulConnections )
+		{
+			ip4_addr_set_u32( &xRemoteIP, ( ip4_addr_get_u32( &( pxNetIf->ip_addr ) ) & ip4_addr_get_u32( &( pxNetIf->netmask ) ) ) | htonl( 100UL + ( ulCreated % 100UL ) ) );
+			pxConnections[ ulCreated ] = prvCreateConnection( pxNetIf, &xRemoteIP, ( u16_t ) ( demuxFIRST_REMOTE_PORT + ulCreated ) );
+
+			if( pxConnections[ ulCreated ] == NULL )
+			{
+				break;
+			}
+
+			prvBuildACK( pxConnections[ ulCreated ], ucHeaders[ ulCreated ] );
+			ulCreated++;
+		}
+
+		if( ulCreated < ulConnections )
+		{
+			/* Out of PCBs. */
+			break;
+		}
+
+		ulDropped = 0;
+		ulConnection = 0;
+		xStartTime = xTaskGetTickCount();
+
+		for( ulSegment = 0; ulSegment < demuxSEGMENTS; ulSegment++ )
+		{
+			pxPbuf = pbuf_alloc( PBUF_RAW, demuxHEADER_LENGTH, PBUF_POOL );
+
+			if( pxPbuf == NULL )
+			{
+				ulDropped++;
+				continue;
+			}
+
+			memcpy( pxPbuf->payload, ucHeaders[ ulConnection ], demuxHEADER_LENGTH );
+
+			/* Set by ip_input() for tcp_input(). */
+			ip_addr_copy( current_iphdr_src, pxConnections[ ulConnection ]->remote_ip );
+			ip_addr_copy( current_iphdr_dest, pxConnections[ ulConnection ]->local_ip );
+			current_netif = pxNetIf;
+			current_header = ( const struct ip_hdr * ) pxPbuf->payload;
+
+			tcp_input( pxPbuf, pxNetIf );
+
+			ulConnection++;
+			if( ulConnection == ulConnections )
+			{
+				ulConnection = 0;
+			}
+		}
+
+		xElapsed = xTaskGetTickCount() - xStartTime;
+
+		sprintf( cMessage, "%4lu connections: %lu ns per segment, %lu dropped\r\n",
+				 ( unsigned long ) ulConnections,
+				 ( unsigned long ) ( xElapsed * portTICK_RATE_MS * ( 1000000UL / demuxSEGMENTS ) ),
+				 ( unsigned long ) ulDropped );
+		xil_printf( cMessage );
+	}
+
+	/* Remove the connections without sending resets to the peers, which do
+	not exist. */
+	for( ulConnection = 0; ulConnection < ulCreated; ulConnection++ )
+	{
+		tcp_abandon( pxConnections[ ulConnection ], 0 );
+	}
+}
+/*-----------------------------------------------------------*/
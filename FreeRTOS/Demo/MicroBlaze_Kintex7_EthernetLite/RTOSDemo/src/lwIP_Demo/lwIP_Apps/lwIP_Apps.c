@@ -38,6 +38,7 @@
 #include "lwip/tcpip.h"
 #include "lwip/inet.h"
 #include "lwip/dhcp.h"
+#include "lwip/sockets.h"
 
 /* applications includes */
 #include "apps/httpserver_raw_from_lwIP_download/httpd.h"
@@ -59,14 +60,45 @@ array.  If pccSSITags is updated, then these definitions must also be updated. *
 #define ssiTASK_STATS_INDEX			0
 #define ssiRUN_TIME_STATS_INDEX		1
 
+/* Set lwipappsRUN_SOCKET_BENCHMARK to 1 to time socket calls once the network
+is up.  The result depends on LWIP_TCPIP_CORE_LOCKING in lwipopts.h, and on
+how the lwIP port implements its semaphores. */
+#ifndef lwipappsRUN_SOCKET_BENCHMARK
+	#define lwipappsRUN_SOCKET_BENCHMARK	0
+#endif
+
+/* lwipappsRUN_DEMUX_BENCHMARK is set in lwipopts.h, because the benchmark
+needs more TCP PCBs.  The result depends on TCP_PCB_HASH_SIZE in lwipopts.h. */
+
+/* The number of times each socket call is timed, and the UDP port used. */
+#define lwipappsBENCHMARK_CALLS		10000UL
+#define lwipappsBENCHMARK_PORT		5001
+
 /*-----------------------------------------------------------*/
 
+/*
+ * Times lwipappsBENCHMARK_CALLS calls to lwip_getsockname() and to lwip_bind()
+ * on a UDP socket, then prints the average time per call and deletes itself.
+ * Each call is a round trip into the core of the stack and back.  The batches
+ * are timed with the tick count, so each average is only accurate to one tick
+ * divided by lwipappsBENCHMARK_CALLS, which is printed with the results.  The
+ * run stops at the first call that fails.
+ */
+#if( lwipappsRUN_SOCKET_BENCHMARK == 1 )
+	static void prvSocketBenchmarkTask( void *pvParameters );
+#endif
+
 /*
  * The function that implements the lwIP based sockets command interpreter
  * server.
  */
 extern void vBasicSocketsCommandInterpreterTask( void *pvParameters );
 
+/*
+ * The tcp_input() benchmark, which runs in the TCP/IP thread.
+ */
+extern void vTCPDemuxBenchmark( void *pvNetIf );
+
 /*
  * The SSI handler callback function passed to lwIP.
  */
@@ -172,9 +204,105 @@ static struct netif xNetIf;
 	/* Create the FreeRTOS defined basic command server.  This demonstrates use
 	of the lwIP sockets API. */
 	xTaskCreate( vBasicSocketsCommandInterpreterTask, "CmdInt", configMINIMAL_STACK_SIZE * 5, NULL, configCLI_TASK_PRIORITY, NULL );
+
+	#if( lwipappsRUN_DEMUX_BENCHMARK == 1 )
+	{
+		/* Already in the TCP/IP thread. */
+		vTCPDemuxBenchmark( &xNetIf );
+	}
+	#endif
+
+	#if( lwipappsRUN_SOCKET_BENCHMARK == 1 )
+	{
+		xTaskCreate( prvSocketBenchmarkTask, "SockBench", configMINIMAL_STACK_SIZE * 2, NULL, configCLI_TASK_PRIORITY, NULL );
+	}
+	#endif
 }
 /*-----------------------------------------------------------*/
 
+#if( lwipappsRUN_SOCKET_BENCHMARK == 1 )
+
+	static void prvSocketBenchmarkTask( void *pvParameters )
+	{
+	int iSocket;
+	struct sockaddr_in xAddress;
+	socklen_t xAddressLength;
+	TickType_t xStartTime, xGetNameTime = 0, xBindTime = 0;
+	unsigned long ulCall;
+	int iResult = 0;
+	static char cMessage[ 150 ];
+
+		( void ) pvParameters;
+
+		/* Wait for the network to come up. */
+		while( ( netif_default == NULL ) || ( netif_is_up( netif_default ) == 0 ) )
+		{
+			vTaskDelay( 100 / portTICK_RATE_MS );
+		}
+
+		iSocket = lwip_socket( AF_INET, SOCK_DGRAM, 0 );
+
+		if( iSocket < 0 )
+		{
+			xil_printf( "\r\nSocket benchmark: lwip_socket() failed\r\n" );
+		}
+		else
+		{
+			memset( &xAddress, 0, sizeof( xAddress ) );
+			xAddress.sin_family = AF_INET;
+			xAddress.sin_port = htons( lwipappsBENCHMARK_PORT );
+			xAddress.sin_addr.s_addr = htonl( INADDR_ANY );
+
+			xStartTime = xTaskGetTickCount();
+			for( ulCall = 0; ( ulCall < lwipappsBENCHMARK_CALLS ) && ( iResult == 0 ); ulCall++ )
+			{
+				/* Binding again to the same port is allowed for UDP. */
+				iResult = lwip_bind( iSocket, ( struct sockaddr * ) &xAddress, sizeof( xAddress ) );
+			}
+			xBindTime = xTaskGetTickCount() - xStartTime;
+
+			if( iResult != 0 )
+			{
+				xil_printf( "\r\nSocket benchmark: lwip_bind() failed\r\n" );
+			}
+			else
+			{
+				xStartTime = xTaskGetTickCount();
+				for( ulCall = 0; ( ulCall < lwipappsBENCHMARK_CALLS ) && ( iResult == 0 ); ulCall++ )
+				{
+					xAddressLength = sizeof( xAddress );
+					iResult = lwip_getsockname( iSocket, ( struct sockaddr * ) &xAddress, &xAddressLength );
+				}
+				xGetNameTime = xTaskGetTickCount() - xStartTime;
+
+				if( iResult != 0 )
+				{
+					xil_printf( "\r\nSocket benchmark: lwip_getsockname() failed\r\n" );
+				}
+			}
+
+			lwip_close( iSocket );
+
+			if( iResult == 0 )
+			{
+				/* Nanoseconds per call.  A batch is measured in whole ticks,
+				so each average may be off by one tick per batch. */
+				sprintf( cMessage, "\r\nSocket calls (core locking %d): bind %lu ns, getsockname %lu ns (+/- %lu ns, tick %lu ms)\r\n",
+						 LWIP_TCPIP_CORE_LOCKING,
+						 ( unsigned long ) ( xBindTime * portTICK_RATE_MS * ( 1000000UL / lwipappsBENCHMARK_CALLS ) ),
+						 ( unsigned long ) ( xGetNameTime * portTICK_RATE_MS * ( 1000000UL / lwipappsBENCHMARK_CALLS ) ),
+						 ( unsigned long ) ( portTICK_RATE_MS * ( 1000000UL / lwipappsBENCHMARK_CALLS ) ),
+						 ( unsigned long ) portTICK_RATE_MS );
+				xil_printf( cMessage );
+			}
+		}
+
+		vTaskDelete( NULL );
+	}
+
+#endif /* lwipappsRUN_SOCKET_BENCHMARK */
+/*-----------------------------------------------------------*/
+
 static unsigned short uslwIPAppsSSIHandler( int iIndex, char *pcBuffer, int iBufferLength )
 {
 static unsigned int uiUpdateCount = 0;
@@ -58,6 +58,11 @@ void vLwipAppsReleaseTxBuffer( void );
 #define LWIP_SOCKET						(NO_SYS==0)
 #define LWIP_NETCONN              		1
 
+/* Set LWIP_TCPIP_CORE_LOCKING to 1 to run netconn and socket calls in the
+calling task while it holds the core mutex, instead of passing each call to
+tcpip_thread and waiting for it to complete. */
+#define LWIP_TCPIP_CORE_LOCKING			0
+
 #define LWIP_SNMP						0
 #define LWIP_IGMP						0
 #define LWIP_ICMP						1
@@ -132,9 +137,21 @@ a lot of data that needs to be copied, this should be set high. */
    per active UDP "connection". */
 #define MEMP_NUM_UDP_PCB		8
 
+/* Set lwipappsRUN_DEMUX_BENCHMARK to 1 to time how tcp_input() finds the
+   connection of a segment when the stack starts, see lwIP_Apps.c.  The
+   benchmark opens up to 256 connections. */
+#ifndef lwipappsRUN_DEMUX_BENCHMARK
+	#define lwipappsRUN_DEMUX_BENCHMARK	0
+#endif
+
 /* MEMP_NUM_TCP_PCB: the number of simultaneously active TCP
-   connections. */
-#define MEMP_NUM_TCP_PCB		10
+   connections.  The demultiplexing benchmark needs a PCB for each of its
+   connections, on top of those of the demo. */
+#if( lwipappsRUN_DEMUX_BENCHMARK == 1 )
+	#define MEMP_NUM_TCP_PCB	266
+#else
+	#define MEMP_NUM_TCP_PCB	10
+#endif
 
 /* MEMP_NUM_TCP_PCB_LISTEN: the number of listening TCP
    connections. */
@@ -187,6 +204,11 @@ a lot of data that needs to be copied, this should be set high. */
 #define LWIP_TCP				1
 #define TCP_TTL					255
 
+/* Set TCP_PCB_HASH_SIZE to a power of 2 to find the connection of each
+   incoming segment through a hash table instead of searching the lists of
+   connections. */
+#define TCP_PCB_HASH_SIZE		0
+
 /* Controls if TCP should queue segments that arrive out of
    order. Define to 0 if your device is low on memory. */
 #define TCP_QUEUE_OOSEQ			1
@@ -0,0 +1,376 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * Measures the message rate and the latency of the channel of AMPChannel.c,
+ * with two processes standing in for the two cores of an AMP device.
+ *
+ * The shared memory is an anonymous shared mapping that is inherited through
+ * fork().  The parent is the producer and the child the consumer.  A pipe
+ * stands in for the inter-core interrupt: the doorbell writes a byte to it,
+ * and the consumer blocks reading from it when xAMPChannelPrepareToWait()
+ * says that it may wait.  The memory of the host is coherent, so no cache
+ * operations are given.
+ *
+ * For each batch size in xBatchSizes[] the producer sends
+ * ampbenchMESSAGES messages of ampbenchMESSAGE_SIZE bytes, writing each in
+ * place and flushing after every batch.  Each message holds a sequence number
+ * and the time at which it was written.  The consumer checks the sequence
+ * numbers and adds the time from writing to reading to a histogram in the
+ * shared memory.  One line is printed per batch size with the message rate,
+ * the number of doorbells per thousand messages, the number of times that the
+ * channel was full, and the median, 99th and 99.9th percentile latency.  The
+ * last column, the number of messages out of sequence, must always be zero.
+ *
+ * Build with "scons --amp-channel".
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/* Demo includes. */
+#include "AMPChannel.h"
+#include "AMPChannelBenchmark.h"
+
+/* The shape of the channel. */
+#define ampbenchSLOT_COUNT			256UL
+#define ampbenchMESSAGE_SIZE		64U
+
+/* The number of messages sent per batch size. */
+#define ampbenchMESSAGES			2000000UL
+
+/* The latency histogram has ampbenchSUB_BUCKETS buckets per power of 2
+nanoseconds, up to 2 ^ ampbenchMAX_POWER nanoseconds. */
+#define ampbenchSUB_BITS			4U
+#define ampbenchSUB_BUCKETS			( 1U << ampbenchSUB_BITS )
+#define ampbenchMAX_POWER			36U
+#define ampbenchBUCKETS				( ampbenchMAX_POWER * ampbenchSUB_BUCKETS )
+
+/*-----------------------------------------------------------*/
+
+/* The contents of each message. */
+typedef struct xAMP_BENCH_MESSAGE
+{
+	uint64_t ullSequence;
+	uint64_t ullTimeNs;
+	uint8_t ucPayload[ ampbenchMESSAGE_SIZE - ( 2U * sizeof( uint64_t ) ) ];
+} AMPBenchMessage_t;
+
+/* Written by the consumer, read by the producer once the consumer has
+exited.  Placed in the shared mapping after the channel. */
+typedef struct xAMP_BENCH_RESULTS
+{
+	uint64_t ullEndNs;
+	uint32_t ulOutOfSequence;
+	uint32_t ulHistogram[ ampbenchBUCKETS ];
+} AMPBenchResults_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The time in nanoseconds, as seen by both processes.
+ */
+static uint64_t prvTimeNs( void );
+
+/*
+ * Map a latency to its histogram bucket, and a bucket back to the lowest
+ * latency that it holds.
+ */
+static uint32_t prvBucket( uint64_t ullNs );
+static uint64_t prvBucketNs( uint32_t ulBucket );
+
+/*
+ * Return the latency below which ulPerMille of the messages were received.
+ */
+static uint64_t prvPercentile( const AMPBenchResults_t *pxResults, uint32_t ulPerMille );
+
+/*
+ * The doorbell: write a byte to the pipe whose write end is pvContext.
+ */
+static void prvDoorbell( void *pvContext );
+
+/*
+ * The two ends.  prvConsumer() runs in the child process.
+ */
+static void prvProducer( void *pvShared, int iDoorbell, size_t uxBatchSize, AMPChannel_t *pxChannel );
+static void prvConsumer( void *pvShared, int iDoorbell, AMPBenchResults_t *pxResults );
+
+/*-----------------------------------------------------------*/
+
+/* The number of messages written between flushes. */
+static const size_t xBatchSizes[] = { 1U, 8U, 64U };
+
+static const AMPChannelOps_t xOps =
+{
+	prvDoorbell,
+	NULL,
+	NULL
+};
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvTimeNs( void )
+{
+struct timespec xNow;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvBucket( uint64_t ullNs )
+{
+uint32_t ulPower = 0U;
+uint32_t ulBucket;
+
+	if( ullNs < ampbenchSUB_BUCKETS )
+	{
+		/* Exact below the first full power. */
+		ulBucket = ( uint32_t ) ullNs;
+	}
+	else
+	{
+		while( ( ullNs >> ulPower ) >= ( 2U * ampbenchSUB_BUCKETS ) )
+		{
+			ulPower++;
+		}
+
+		/* ( ullNs >> ulPower ) is in [ SUB_BUCKETS, 2 * SUB_BUCKETS ). */
+		ulBucket = ( ( ulPower + 1U ) * ampbenchSUB_BUCKETS ) + ( uint32_t ) ( ullNs >> ulPower ) - ampbenchSUB_BUCKETS;
+
+		if( ulBucket >= ampbenchBUCKETS )
+		{
+			ulBucket = ampbenchBUCKETS - 1U;
+		}
+	}
+
+	return ulBucket;
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvBucketNs( uint32_t ulBucket )
+{
+uint64_t ullNs;
+uint32_t ulPower;
+
+	if( ulBucket < ampbenchSUB_BUCKETS )
+	{
+		ullNs = ( uint64_t ) ulBucket;
+	}
+	else
+	{
+		ulPower = ( ulBucket / ampbenchSUB_BUCKETS ) - 1U;
+		ullNs = ( uint64_t ) ( ( ulBucket % ampbenchSUB_BUCKETS ) + ampbenchSUB_BUCKETS ) << ulPower;
+	}
+
+	return ullNs;
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvPercentile( const AMPBenchResults_t *pxResults, uint32_t ulPerMille )
+{
+uint64_t ullWanted = ( ( uint64_t ) ampbenchMESSAGES * ulPerMille ) / 1000ULL;
+uint64_t ullSeen = 0ULL;
+uint32_t ulBucket;
+
+	for( ulBucket = 0U; ulBucket < ( ampbenchBUCKETS - 1U ); ulBucket++ )
+	{
+		ullSeen += pxResults->ulHistogram[ ulBucket ];
+
+		if( ullSeen > ullWanted )
+		{
+			break;
+		}
+	}
+
+	return prvBucketNs( ulBucket );
+}
+/*-----------------------------------------------------------*/
+
+static void prvDoorbell( void *pvContext )
+{
+const uint8_t ucByte = 0U;
+
+	( void ) write( *( ( const int * ) pvContext ), &ucByte, sizeof( ucByte ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvProducer( void *pvShared, int iDoorbell, size_t uxBatchSize, AMPChannel_t *pxChannel )
+{
+AMPBenchMessage_t *pxMessage;
+uint64_t ullSequence = 0ULL;
+size_t uxInBatch = 0U;
+BaseType_t xResult;
+
+	xResult = xAMPChannelOpen( pxChannel, pvShared, ampbenchSLOT_COUNT, sizeof( AMPBenchMessage_t ), &xOps, &iDoorbell );
+	configASSERT( xResult == pdPASS );
+	( void ) xResult;
+
+	while( ullSequence < ampbenchMESSAGES )
+	{
+		pxMessage = ( AMPBenchMessage_t * ) pvAMPChannelReserve( pxChannel );
+
+		if( pxMessage == NULL )
+		{
+			/* Full, the reservation published what was committed.  Give the
+			consumer a chance when both share a CPU. */
+			uxInBatch = 0U;
+			sched_yield();
+			continue;
+		}
+
+		pxMessage->ullSequence = ullSequence;
+		pxMessage->ullTimeNs = prvTimeNs();
+		vAMPChannelCommit( pxChannel, sizeof( *pxMessage ) );
+		ullSequence++;
+		uxInBatch++;
+
+		if( uxInBatch >= uxBatchSize )
+		{
+			vAMPChannelFlush( pxChannel );
+			uxInBatch = 0U;
+		}
+	}
+
+	vAMPChannelFlush( pxChannel );
+}
+/*-----------------------------------------------------------*/
+
+static void prvConsumer( void *pvShared, int iDoorbell, AMPBenchResults_t *pxResults )
+{
+AMPChannel_t xChannel;
+const AMPBenchMessage_t *pxMessage;
+uint64_t ullExpected = 0ULL;
+size_t uxLength;
+uint8_t ucByte;
+BaseType_t xResult;
+
+	xResult = xAMPChannelOpen( &xChannel, pvShared, ampbenchSLOT_COUNT, sizeof( AMPBenchMessage_t ), NULL, NULL );
+	configASSERT( xResult == pdPASS );
+	( void ) xResult;
+
+	while( ullExpected < ampbenchMESSAGES )
+	{
+		pxMessage = ( const AMPBenchMessage_t * ) pvAMPChannelPeek( &xChannel, &uxLength );
+
+		if( pxMessage == NULL )
+		{
+			if( xAMPChannelPrepareToWait( &xChannel ) == pdTRUE )
+			{
+				/* Sleep until the doorbell rings, as a task would wait for
+				the notification from the inter-core interrupt. */
+				( void ) read( iDoorbell, &ucByte, sizeof( ucByte ) );
+			}
+
+			continue;
+		}
+
+		pxResults->ulHistogram[ prvBucket( prvTimeNs() - pxMessage->ullTimeNs ) ]++;
+
+		if( ( uxLength != sizeof( *pxMessage ) ) || ( pxMessage->ullSequence != ullExpected ) )
+		{
+			pxResults->ulOutOfSequence++;
+		}
+
+		ullExpected++;
+		vAMPChannelRelease( &xChannel );
+	}
+
+	pxResults->ullEndNs = prvTimeNs();
+}
+/*-----------------------------------------------------------*/
+
+void vRunAMPChannelBenchmark( void )
+{
+const size_t uxChannelSize = ampchannelSHARED_SIZE( ampbenchSLOT_COUNT, sizeof( AMPBenchMessage_t ) );
+AMPBenchResults_t *pxResults;
+AMPChannel_t xProducer;
+uint8_t *pucShared;
+uint64_t ullStartNs, ullElapsedNs;
+size_t uxIndex;
+int iPipe[ 2 ];
+int iResult;
+pid_t xChild;
+
+	pucShared = ( uint8_t * ) mmap( NULL, uxChannelSize + sizeof( AMPBenchResults_t ), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+	configASSERT( pucShared != ( uint8_t * ) MAP_FAILED );
+	pxResults = ( AMPBenchResults_t * ) &( pucShared[ uxChannelSize ] );
+
+	printf( "AMP channel: %lu slots of %u bytes, %lu messages per run\r\n", ampbenchSLOT_COUNT, ( unsigned ) sizeof( AMPBenchMessage_t ), ampbenchMESSAGES );
+	printf( "%6s %12s %14s %10s %9s %9s %9s %6s\r\n", "batch", "msg/s", "doorbells/1k", "full", "p50 ns", "p99 ns", "p99.9 ns", "bad" );
+
+	for( uxIndex = 0U; uxIndex < ( sizeof( xBatchSizes ) / sizeof( xBatchSizes[ 0 ] ) ); uxIndex++ )
+	{
+		vAMPChannelReset( pucShared, NULL );
+		memset( pxResults, 0, sizeof( *pxResults ) );
+		iResult = pipe( iPipe );
+		configASSERT( iResult == 0 );
+		( void ) iResult;
+
+		fflush( stdout );
+		xChild = fork();
+		configASSERT( xChild >= 0 );
+
+		if( xChild == 0 )
+		{
+			close( iPipe[ 1 ] );
+			prvConsumer( pucShared, iPipe[ 0 ], pxResults );
+			_exit( 0 );
+		}
+
+		close( iPipe[ 0 ] );
+		ullStartNs = prvTimeNs();
+		prvProducer( pucShared, iPipe[ 1 ], xBatchSizes[ uxIndex ], &xProducer );
+		( void ) waitpid( xChild, NULL, 0 );
+		close( iPipe[ 1 ] );
+
+		ullElapsedNs = pxResults->ullEndNs - ullStartNs;
+
+		printf( "%6u %12llu %14llu %10lu %9llu %9llu %9llu %6lu\r\n",
+				( unsigned ) xBatchSizes[ uxIndex ],
+				( unsigned long long ) ( ( ( uint64_t ) ampbenchMESSAGES * 1000000000ULL ) / ( ullElapsedNs != 0ULL ? ullElapsedNs : 1ULL ) ),
+				( unsigned long long ) ( ( ( uint64_t ) xProducer.ulDoorbells * 1000ULL ) / ampbenchMESSAGES ),
+				( unsigned long ) xProducer.ulFull,
+				( unsigned long long ) prvPercentile( pxResults, 500U ),
+				( unsigned long long ) prvPercentile( pxResults, 990U ),
+				( unsigned long long ) prvPercentile( pxResults, 999U ),
+				( unsigned long ) pxResults->ulOutOfSequence );
+	}
+
+	( void ) munmap( pucShared, uxChannelSize + sizeof( AMPBenchResults_t ) );
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,402 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * Measures the throughput of the DMA ring library of dmaRing.c, without any
+ * hardware.
+ *
+ * The simulated EMAC has a TX ring and an RX ring of descriptors, laid out
+ * like those of a real EMAC: an ownership bit, an error bit, a length and a
+ * buffer pointer.  Whenever the TX ring is kicked, the EMAC sends every frame
+ * that it owns by copying it into the next RX descriptor that it owns, so all
+ * frames are looped back.  A frame that finds no free RX descriptor is
+ * dropped, like an EMAC does when it runs out of descriptors.  Every
+ * configDMASIM_ERROR_INTERVAL'th frame is received with an error bit, to
+ * exercise the error path.
+ *
+ * For each frame size the task sends configDMASIM_FRAMES frames through the
+ * TX ring.  After every configDMASIM_BATCH frames it does what the deferred
+ * handler task of a driver would do: reap the TX ring, take all frames from
+ * the RX ring, and refill it.  It does the same when the TX ring is full.  Each received frame is checked against the
+ * sequence number and the pattern that was written when it was sent.  One
+ * line is printed per frame size with the frame rate, the throughput, and the
+ * number of frames that were dropped, had errors or were corrupted.  The last
+ * two columns must always be zero for a correct ring.
+ *
+ * Time stamps are taken from ulGetRunTimeCounterValue(), which counts
+ * nanoseconds in this port.
+ *
+ * Build with "scons --dma-ring-sim".
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "NetworkBufferManagement.h"
+#include "dmaRing.h"
+
+/* Demo application includes. */
+#include "DMARingSimulation.h"
+#include "console.h"
+
+/* The number of descriptors in each of the simulated rings. */
+#ifndef configDMASIM_RING_SIZE
+	#define configDMASIM_RING_SIZE		16
+#endif
+
+/* The number of frames that are sent between two services of the rings.  The
+rings are also serviced when the TX ring is full. */
+#ifndef configDMASIM_BATCH
+	#define configDMASIM_BATCH			8
+#endif
+
+/* The number of frames that are sent for each frame size. */
+#ifndef configDMASIM_FRAMES
+	#define configDMASIM_FRAMES			200000UL
+#endif
+
+/* One in this many frames is received with an error. */
+#ifndef configDMASIM_ERROR_INTERVAL
+	#define configDMASIM_ERROR_INTERVAL	1000UL
+#endif
+
+/* The size of the RX buffers. */
+#define dmasimBUFFER_SIZE				1536U
+
+/* The bits in the status of a simulated descriptor. */
+#define dmasimSTATUS_OWN				0x80000000UL
+#define dmasimSTATUS_ERROR				0x00000001UL
+
+/*-----------------------------------------------------------*/
+
+typedef struct xDMASIM_DESCRIPTOR
+{
+	volatile uint32_t ulStatus;
+	uint32_t ulLength;
+	uint8_t *pucBuffer;
+} DMASimDescriptor_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The task that runs the measurements.
+ */
+static void prvDMASimTask( void *pvParameters );
+
+/*
+ * Reap the TX ring, take and check all received frames, and refill the RX
+ * ring.
+ */
+static void prvDMASimService( void );
+
+/*
+ * The simulated EMAC: loop back all frames of the TX ring.
+ */
+static void prvDMASimKickTx( void *pvContext );
+
+/*
+ * The functions that let dmaRing.c access the simulated descriptors.
+ */
+static BaseType_t prvDMASimOwnedByDMA( void *pvDescriptors, size_t uxIndex );
+static BaseType_t prvDMASimRxLength( void *pvDescriptors, size_t uxIndex );
+static void prvDMASimGiveToDMA( void *pvDescriptors, size_t uxIndex, size_t uxCount, uint8_t *pucBuffer, size_t uxLength );
+static void prvDMASimCacheMaintenance( const void *pvAddress, size_t uxLength );
+
+/*-----------------------------------------------------------*/
+
+static DMASimDescriptor_t dmaringDESCRIPTORS( xRxDescriptors, configDMASIM_RING_SIZE );
+static DMASimDescriptor_t dmaringDESCRIPTORS( xTxDescriptors, configDMASIM_RING_SIZE );
+static NetworkBufferDescriptor_t *pxRxBuffers[ configDMASIM_RING_SIZE ];
+static NetworkBufferDescriptor_t *pxTxBuffers[ configDMASIM_RING_SIZE ];
+
+static const DMARingOps_t xRxOps =
+{
+	prvDMASimOwnedByDMA,
+	prvDMASimRxLength,
+	prvDMASimGiveToDMA,
+	NULL,
+	prvDMASimCacheMaintenance,
+	prvDMASimCacheMaintenance
+};
+
+static const DMARingOps_t xTxOps =
+{
+	prvDMASimOwnedByDMA,
+	NULL,
+	prvDMASimGiveToDMA,
+	prvDMASimKickTx,
+	prvDMASimCacheMaintenance,
+	prvDMASimCacheMaintenance
+};
+
+static DMARing_t xRxRing, xTxRing;
+
+/* The next descriptors that the simulated EMAC will use. */
+static size_t uxEMACTxIndex, uxEMACRxIndex;
+
+/* The frame sizes that are measured. */
+static const size_t uxFrameSizes[] = { 64U, 512U, 1514U };
+
+/* Statistics of the current run. */
+static uint32_t ulEMACFrames, ulDropped, ulReceived, ulCorrupted, ulNextSequence, ulCacheOperations;
+
+/*-----------------------------------------------------------*/
+
+void vStartDMARingSimulation( uint16_t usTaskStackSize, UBaseType_t uxTaskPriority )
+{
+	xTaskCreate( prvDMASimTask, "DMASim", usTaskStackSize, NULL, uxTaskPriority, NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvDMASimTask( void *pvParameters )
+{
+NetworkBufferDescriptor_t *pxBuffer;
+size_t uxSize;
+uint32_t ulSent;
+uint64_t ullStartNs, ullElapsedNs;
+
+	( void ) pvParameters;
+
+	console_print( "DMA ring simulation: ring %d, batch %d, %s RX, %lu frames per size\n",
+		configDMASIM_RING_SIZE, configDMASIM_BATCH,
+		( ipconfigZERO_COPY_RX_DRIVER != 0 ) ? "zero-copy" : "copying",
+		( unsigned long ) configDMASIM_FRAMES );
+
+	for( uxSize = 0; uxSize < sizeof( uxFrameSizes ) / sizeof( uxFrameSizes[ 0 ] ); uxSize++ )
+	{
+		memset( xRxDescriptors, 0, sizeof( xRxDescriptors ) );
+		memset( xTxDescriptors, 0, sizeof( xTxDescriptors ) );
+		uxEMACTxIndex = 0;
+		uxEMACRxIndex = 0;
+		ulEMACFrames = 0;
+		ulDropped = 0;
+		ulReceived = 0;
+		ulCorrupted = 0;
+		ulNextSequence = 0;
+		ulCacheOperations = 0;
+
+		if( xDMARingRxInit( &xRxRing, &xRxOps, xRxDescriptors, pxRxBuffers, configDMASIM_RING_SIZE, dmasimBUFFER_SIZE, NULL ) != pdPASS )
+		{
+			console_print( "DMA ring simulation: not enough Network Buffers\n" );
+		}
+		vDMARingTxInit( &xTxRing, &xTxOps, xTxDescriptors, pxTxBuffers, configDMASIM_RING_SIZE, NULL );
+
+		ullStartNs = ( uint64_t ) ulGetRunTimeCounterValue();
+
+		for( ulSent = 0; ulSent < configDMASIM_FRAMES; )
+		{
+			if( uxDMARingTxSpace( &xTxRing ) == 0U )
+			{
+				prvDMASimService();
+				continue;
+			}
+
+			pxBuffer = pxGetNetworkBufferWithDescriptor( uxFrameSizes[ uxSize ], ( TickType_t ) 0 );
+			if( pxBuffer == NULL )
+			{
+				/* The IP-task may hold the other buffers for a while. */
+				prvDMASimService();
+				vTaskDelay( 1 );
+				continue;
+			}
+
+			/* A sequence number, followed by a pattern that depends on it. */
+			memcpy( pxBuffer->pucEthernetBuffer, &ulSent, sizeof( ulSent ) );
+			memset( pxBuffer->pucEthernetBuffer + sizeof( ulSent ), ( int ) ( ulSent & 0xffUL ), uxFrameSizes[ uxSize ] - sizeof( ulSent ) );
+			pxBuffer->xDataLength = uxFrameSizes[ uxSize ];
+
+			if( xDMARingTxSend( &xTxRing, pxBuffer, pdTRUE ) == pdPASS )
+			{
+				ulSent++;
+				if( ( ulSent % configDMASIM_BATCH ) == 0UL )
+				{
+					prvDMASimService();
+				}
+			}
+		}
+
+		prvDMASimService();
+		ullElapsedNs = ( uint64_t ) ulGetRunTimeCounterValue() - ullStartNs;
+		if( ullElapsedNs == 0ULL )
+		{
+			ullElapsedNs = 1ULL;
+		}
+
+		console_print( "%4lu bytes: %9.0f frames/s %8.1f Mbit/s received %8lu dropped %6lu errors %6lu corrupted %lu lost %lu cache ops/frame %.1f\n",
+			( unsigned long ) uxFrameSizes[ uxSize ],
+			( double ) ulReceived * 1e9 / ( double ) ullElapsedNs,
+			( double ) ulReceived * ( double ) uxFrameSizes[ uxSize ] * 8e3 / ( double ) ullElapsedNs,
+			( unsigned long ) ulReceived,
+			( unsigned long ) ulDropped,
+			( unsigned long ) xRxRing.ulErrors,
+			( unsigned long ) ulCorrupted,
+			( unsigned long ) ( configDMASIM_FRAMES - ulReceived - ulDropped - xRxRing.ulErrors ),
+			( double ) ulCacheOperations / ( double ) configDMASIM_FRAMES );
+
+		/* Return the buffers of the RX ring, so that the next run starts
+		with none attached. */
+		for( ulSent = 0; ulSent < configDMASIM_RING_SIZE; ulSent++ )
+		{
+			if( pxRxBuffers[ ulSent ] != NULL )
+			{
+				vReleaseNetworkBufferAndDescriptor( pxRxBuffers[ ulSent ] );
+				pxRxBuffers[ ulSent ] = NULL;
+			}
+		}
+	}
+
+	console_print( "DMA ring simulation complete\n" );
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvDMASimService( void )
+{
+NetworkBufferDescriptor_t *pxBuffer;
+uint32_t ulSequence;
+size_t uxIndex;
+
+	( void ) uxDMARingTxReap( &xTxRing );
+
+	while( ( pxBuffer = pxDMARingRxTake( &xRxRing ) ) != NULL )
+	{
+		memcpy( &ulSequence, pxBuffer->pucEthernetBuffer, sizeof( ulSequence ) );
+
+		/* Frames may be missing, but never out of order. */
+		if( ulSequence < ulNextSequence )
+		{
+			ulCorrupted++;
+		}
+		else
+		{
+			for( uxIndex = sizeof( ulSequence ); uxIndex < pxBuffer->xDataLength; uxIndex++ )
+			{
+				if( pxBuffer->pucEthernetBuffer[ uxIndex ] != ( uint8_t ) ulSequence )
+				{
+					ulCorrupted++;
+					break;
+				}
+			}
+			ulNextSequence = ulSequence + 1UL;
+		}
+
+		ulReceived++;
+		vReleaseNetworkBufferAndDescriptor( pxBuffer );
+	}
+
+	( void ) uxDMARingRxRefill( &xRxRing );
+}
+/*-----------------------------------------------------------*/
+
+static void prvDMASimKickTx( void *pvContext )
+{
+DMASimDescriptor_t *pxTx, *pxRx;
+
+	( void ) pvContext;
+
+	while( ( xTxDescriptors[ uxEMACTxIndex ].ulStatus & dmasimSTATUS_OWN ) != 0UL )
+	{
+		pxTx = &( xTxDescriptors[ uxEMACTxIndex ] );
+		pxRx = &( xRxDescriptors[ uxEMACRxIndex ] );
+
+		if( ( pxRx->ulStatus & dmasimSTATUS_OWN ) == 0UL )
+		{
+			/* No free RX descriptor. */
+			ulDropped++;
+		}
+		else
+		{
+			memcpy( pxRx->pucBuffer, pxTx->pucBuffer, pxTx->ulLength );
+			pxRx->ulLength = pxTx->ulLength;
+			ulEMACFrames++;
+			pxRx->ulStatus = ( ( ulEMACFrames % configDMASIM_ERROR_INTERVAL ) == 0UL ) ? dmasimSTATUS_ERROR : 0UL;
+			uxEMACRxIndex = ( uxEMACRxIndex + 1U ) % configDMASIM_RING_SIZE;
+		}
+
+		pxTx->ulStatus = 0UL;
+		uxEMACTxIndex = ( uxEMACTxIndex + 1U ) % configDMASIM_RING_SIZE;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvDMASimOwnedByDMA( void *pvDescriptors, size_t uxIndex )
+{
+DMASimDescriptor_t *pxDescriptors = ( DMASimDescriptor_t * ) pvDescriptors;
+
+	return ( ( pxDescriptors[ uxIndex ].ulStatus & dmasimSTATUS_OWN ) != 0UL ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvDMASimRxLength( void *pvDescriptors, size_t uxIndex )
+{
+DMASimDescriptor_t *pxDescriptors = ( DMASimDescriptor_t * ) pvDescriptors;
+BaseType_t xReturn;
+
+	if( ( pxDescriptors[ uxIndex ].ulStatus & dmasimSTATUS_ERROR ) != 0UL )
+	{
+		xReturn = dmaringRX_ERROR;
+	}
+	else
+	{
+		xReturn = ( BaseType_t ) pxDescriptors[ uxIndex ].ulLength;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvDMASimGiveToDMA( void *pvDescriptors, size_t uxIndex, size_t uxCount, uint8_t *pucBuffer, size_t uxLength )
+{
+DMASimDescriptor_t *pxDescriptors = ( DMASimDescriptor_t * ) pvDescriptors;
+
+	/* The simulated EMAC does not need a wrap bit. */
+	( void ) uxCount;
+
+	pxDescriptors[ uxIndex ].pucBuffer = pucBuffer;
+	pxDescriptors[ uxIndex ].ulLength = ( uint32_t ) uxLength;
+
+	/* The ownership bit is written last. */
+	pxDescriptors[ uxIndex ].ulStatus = dmasimSTATUS_OWN;
+}
+/*-----------------------------------------------------------*/
+
+static void prvDMASimCacheMaintenance( const void *pvAddress, size_t uxLength )
+{
+	/* The host has coherent caches, only count the calls. */
+	( void ) pvAddress;
+	( void ) uxLength;
+	ulCacheOperations++;
+}
+/*-----------------------------------------------------------*/
@@ -127,6 +127,10 @@ used with multiple project configurations.  If it is
 	#error projCOVERAGE_TEST should be defined to 1 or 0 on the command line.
 #endif
 
+#ifndef projENABLE_SCHED_STATS
+	#define projENABLE_SCHED_STATS	0
+#endif
+
 #if( projCOVERAGE_TEST == 1 )
 	/* Insert NOPs in empty decision paths to ensure both true and false paths
 	are being tested. */
@@ -150,8 +154,17 @@ used with multiple project configurations.  If it is
 
 	#define configUSE_MALLOC_FAILED_HOOK			1
 
-	/* Include the FreeRTOS+Trace FreeRTOS trace macro definitions. */
-	#include "trcRecorder.h"
+	/* Include the FreeRTOS+Trace FreeRTOS trace macro definitions, unless the
+	trace macros are used by the scheduler statistics instead. */
+	#if( projENABLE_SCHED_STATS != 1 )
+		#include "trcRecorder.h"
+	#endif
+#endif
+
+#if( projENABLE_SCHED_STATS == 1 )
+	/* Gather CPU load, wake up latency and tick statistics through the trace
+	macros.  Normally set from the command line with "scons --sched-stats". */
+	#include "SchedStats.h"
 #endif
 
 /* networking definitions */
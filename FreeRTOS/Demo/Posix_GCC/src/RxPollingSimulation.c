@@ -0,0 +1,326 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * Exercises the budgeted polling of rxPolling.c against a simulated EMAC
+ * reception ring, without any hardware.
+ *
+ * A "DMA" task stores frames in a ring of configRXSIM_RING_SIZE descriptors
+ * at a fixed number of frames per tick, and raises the simulated reception
+ * interrupt after every frame, unless the interrupt is masked.  A frame that
+ * finds its descriptor still owned by the CPU is dropped, like an EMAC does
+ * when it runs out of descriptors.  A "handler" task, at a lower priority,
+ * plays the role of the deferred interrupt handler task of a driver.
+ *
+ * Each rate is run twice for configRXSIM_RUN_TIME_MS: once with one wake-up
+ * of the handler task per interrupt, which empties the ring each time, as the
+ * drivers do when ipconfigNIC_RX_POLLING is 0, and once with budgeted polling.
+ * One line is printed per run with the number of frames received and dropped,
+ * the number of interrupts per frame, and the number of batches.
+ *
+ * Build with "scons --rx-poll-sim".
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "rxPolling.h"
+
+/* Demo application includes. */
+#include "RxPollingSimulation.h"
+#include "console.h"
+
+/* The number of descriptors in the simulated reception ring. */
+#ifndef configRXSIM_RING_SIZE
+	#define configRXSIM_RING_SIZE		32
+#endif
+
+/* The duration of each run. */
+#ifndef configRXSIM_RUN_TIME_MS
+	#define configRXSIM_RUN_TIME_MS		2000
+#endif
+
+/* The budget that is used in the polling runs. */
+#ifndef configRXSIM_BUDGET
+	#define configRXSIM_BUDGET			ipconfigNIC_RX_POLL_BUDGET
+#endif
+
+/* The number of frames that the handler task may take in one go when it is not
+polling: until the ring is empty. */
+#define rxsimNO_BUDGET					( ( BaseType_t ) 0x7fffffff )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The control task runs the fixed list of rates in both modes.
+ */
+static void prvRxSimControlTask( void *pvParameters );
+
+/*
+ * Fill the ring at the rate that is set by the control task.
+ */
+static void prvRxSimDMATask( void *pvParameters );
+
+/*
+ * The deferred interrupt handler.
+ */
+static void prvRxSimHandlerTask( void *pvParameters );
+
+/*
+ * The simulated reception interrupt.
+ */
+static void prvRxSimInterrupt( void );
+
+/*
+ * The functions that let rxPolling.c access the simulated ring.
+ */
+static BaseType_t prvRxSimPoll( void *pvContext, BaseType_t xBudget );
+static BaseType_t prvRxSimPending( void *pvContext );
+static void prvRxSimMaskInterrupt( void *pvContext );
+static void prvRxSimUnmaskInterrupt( void *pvContext );
+
+/*-----------------------------------------------------------*/
+
+/* pdTRUE when the descriptor holds a frame, owned by the CPU. */
+static volatile BaseType_t xRing[ configRXSIM_RING_SIZE ];
+static UBaseType_t uxDMAHead, uxCPUTail;
+
+static volatile BaseType_t xInterruptMasked;
+static volatile BaseType_t xPolling;
+static volatile BaseType_t xRunning;
+static volatile UBaseType_t uxFramesPerTick;
+
+static RxPoll_t xRxPoll;
+static TaskHandle_t xHandlerTask;
+
+/* Statistics of the current run. */
+static volatile uint32_t ulFramesReceived, ulFramesDropped, ulInterrupts, ulWakeUps;
+
+/* The rates that are simulated, in frames per tick. */
+static const UBaseType_t uxRates[] = { 1, 4, 16, 64 };
+
+/*-----------------------------------------------------------*/
+
+void vStartRxPollingSimulation( uint16_t usTaskStackSize, UBaseType_t uxTaskPriority )
+{
+	/* The DMA task runs above the handler, as the EMAC does not wait for the
+	CPU.  The control task runs above both to stop a run on time. */
+	xTaskCreate( prvRxSimHandlerTask, "RxSimHandler", usTaskStackSize, NULL, uxTaskPriority, &xHandlerTask );
+	xTaskCreate( prvRxSimDMATask, "RxSimDMA", usTaskStackSize, NULL, uxTaskPriority + 1, NULL );
+	xTaskCreate( prvRxSimControlTask, "RxSimCtrl", usTaskStackSize, NULL, uxTaskPriority + 2, NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRxSimControlTask( void *pvParameters )
+{
+size_t xRate;
+BaseType_t xMode;
+uint32_t ulFrames;
+
+	( void ) pvParameters;
+
+	console_print( "RX polling simulation: ring %d, budget %d, %d ms per run\n", configRXSIM_RING_SIZE, configRXSIM_BUDGET, configRXSIM_RUN_TIME_MS );
+
+	for( xRate = 0; xRate < sizeof( uxRates ) / sizeof( uxRates[ 0 ] ); xRate++ )
+	{
+		for( xMode = 0; xMode < 2; xMode++ )
+		{
+			/* Start from an empty ring, with the interrupt unmasked. */
+			memset( ( void * ) xRing, 0, sizeof( xRing ) );
+			uxDMAHead = 0;
+			uxCPUTail = 0;
+			xInterruptMasked = pdFALSE;
+			xPolling = ( xMode != 0 ) ? pdTRUE : pdFALSE;
+			vRxPollInit( &xRxPoll, prvRxSimPoll, prvRxSimPending, prvRxSimMaskInterrupt, prvRxSimUnmaskInterrupt, NULL, configRXSIM_BUDGET );
+			ulFramesReceived = 0;
+			ulFramesDropped = 0;
+			ulInterrupts = 0;
+			ulWakeUps = 0;
+
+			uxFramesPerTick = uxRates[ xRate ];
+			xRunning = pdTRUE;
+			vTaskDelay( pdMS_TO_TICKS( configRXSIM_RUN_TIME_MS ) );
+			uxFramesPerTick = 0;
+
+			/* Let the handler empty the ring. */
+			vTaskDelay( pdMS_TO_TICKS( 100 ) );
+			xRunning = pdFALSE;
+
+			ulFrames = ( ulFramesReceived != 0UL ) ? ulFramesReceived : 1UL;
+			console_print( "%-5s %3lu frames/tick: received %8lu dropped %8lu interrupts %8lu (%.3f per frame) wake-ups %8lu batches %8lu exhausted %8lu\n",
+				( xMode != 0 ) ? "poll" : "irq",
+				( unsigned long ) uxRates[ xRate ],
+				( unsigned long ) ulFramesReceived,
+				( unsigned long ) ulFramesDropped,
+				( unsigned long ) ulInterrupts,
+				( double ) ulInterrupts / ( double ) ulFrames,
+				( unsigned long ) ulWakeUps,
+				( unsigned long ) ( ( xMode != 0 ) ? xRxPoll.ulBatchCount : ulWakeUps ),
+				( unsigned long ) xRxPoll.ulBudgetExhaustedCount );
+		}
+	}
+
+	console_print( "RX polling simulation complete\n" );
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRxSimDMATask( void *pvParameters )
+{
+UBaseType_t uxFrame;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		for( uxFrame = 0; uxFrame < uxFramesPerTick; uxFrame++ )
+		{
+			if( xRing[ uxDMAHead ] != pdFALSE )
+			{
+				/* The CPU has not returned the descriptor yet. */
+				ulFramesDropped++;
+			}
+			else
+			{
+				xRing[ uxDMAHead ] = pdTRUE;
+				uxDMAHead = ( uxDMAHead + 1 ) % configRXSIM_RING_SIZE;
+
+				if( xInterruptMasked == pdFALSE )
+				{
+					prvRxSimInterrupt();
+				}
+			}
+		}
+
+		vTaskDelay( 1 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRxSimInterrupt( void )
+{
+BaseType_t xWakeTask = pdTRUE;
+
+	ulInterrupts++;
+
+	if( xPolling != pdFALSE )
+	{
+		xWakeTask = xRxPollScheduleFromISR( &xRxPoll );
+	}
+
+	if( xWakeTask != pdFALSE )
+	{
+		xTaskNotifyGive( xHandlerTask );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRxSimHandlerTask( void *pvParameters )
+{
+BaseType_t xMore = pdFALSE;
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		if( xMore == pdFALSE )
+		{
+			if( ulTaskNotifyTake( pdFALSE, pdMS_TO_TICKS( 100 ) ) == 0UL )
+			{
+				continue;
+			}
+			ulWakeUps++;
+		}
+
+		if( xRunning == pdFALSE )
+		{
+			/* Between two runs. */
+			xMore = pdFALSE;
+		}
+		else if( xPolling != pdFALSE )
+		{
+			xMore = xRxPollRun( &xRxPoll, NULL );
+			if( xMore != pdFALSE )
+			{
+				taskYIELD();
+			}
+		}
+		else
+		{
+			( void ) prvRxSimPoll( NULL, rxsimNO_BUDGET );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRxSimPoll( void *pvContext, BaseType_t xBudget )
+{
+BaseType_t xCount = 0;
+
+	( void ) pvContext;
+
+	while( ( xCount < xBudget ) && ( xRing[ uxCPUTail ] != pdFALSE ) )
+	{
+		/* Return the descriptor to the DMA. */
+		xRing[ uxCPUTail ] = pdFALSE;
+		uxCPUTail = ( uxCPUTail + 1 ) % configRXSIM_RING_SIZE;
+		ulFramesReceived++;
+		xCount++;
+	}
+
+	return xCount;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRxSimPending( void *pvContext )
+{
+	( void ) pvContext;
+	return xRing[ uxCPUTail ];
+}
+/*-----------------------------------------------------------*/
+
+static void prvRxSimMaskInterrupt( void *pvContext )
+{
+	( void ) pvContext;
+	xInterruptMasked = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRxSimUnmaskInterrupt( void *pvContext )
+{
+	( void ) pvContext;
+	xInterruptMasked = pdFALSE;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,1485 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * A TCP echo benchmark.  A control task runs a fixed matrix of tests, each for
+ * configBENCHMARK_RUN_TIME_MS milliseconds, using configBENCHMARK_CLIENTS
+ * concurrent client tasks:
+ *
+ * + Request/response: each client sends a message, waits for the complete echo
+ *   and records the round trip time.  Run for message sizes from 64 bytes to
+ *   64 KB.
+ * + Bulk stream: each client keeps sending messages without waiting for the
+ *   echo, and drains the echoed data whenever the Tx stream is full.  Run for
+ *   the same message sizes.
+ * + Connect: each client repeatedly connects, then gracefully closes the
+ *   connection, and records the time taken by FreeRTOS_connect().
+ * + Idle sockets: request/response with small messages while an increasing
+ *   number of other TCP sockets are bound but idle, which shows how the time
+ *   the IP task needs to act on FreeRTOS_send() depends on the number of
+ *   sockets (see ipconfigTCP_TX_WORK_LIST).
+ * + Churn: each client repeatedly connects, exchanges one small message so both
+ *   ends create their stream buffers, then gracefully closes the connection,
+ *   and records the time taken by the whole cycle.  This measures the cost of
+ *   allocating and freeing sockets, event groups and stream buffers on both
+ *   the client and the accepting side (see ipconfigUSE_SOCKET_POOLS).  When
+ *   the socket pools are used, the lowest number of free entries of each pool
+ *   is printed after the test.  When ipconfigUSE_TCP_FAST_OPEN is 1 the test is
+ *   run again with the message sent on the SYN by FreeRTOS_sendto() with
+ *   FREERTOS_MSG_FASTOPEN, printed as "tfo".  With a remote server, Fast Open
+ *   must be enabled on the server as well.
+ * + Pacing: only when ipconfigTCP_PACING is 1.  A bulk stream of
+ *   benchPACING_MESSAGE_SIZE byte messages, run with pacing off, with the rate
+ *   derived from the window and the round-trip time, and with a fixed rate of
+ *   configBENCHMARK_PACING_RATE bytes per second, on both the clients and the
+ *   server.  With the local server, the frames dropped by the loopback
+ *   interface are printed per MB of echoed data.  Each drop costs a
+ *   retransmission, so build with "scons --benchmark --loopback --bottleneck"
+ *   to see how pacing avoids overflowing a shallow buffer.  Add "--ecn" to let
+ *   the bottleneck mark packets before it overflows (see ipconfigUSE_TCP_ECN).
+ * + Memory: after the timed tests, a number of connections is opened, one
+ *   small message is echoed on each, and the heap in use per connection is
+ *   printed.  When ipconfigTCP_ELASTIC_STREAMS is 1 it is printed again after
+ *   the connections have been idle for ipconfigTCP_STREAM_IDLE_RELEASE_MS.
+ *   With the local server the figure covers both ends of a connection,
+ *   including the stack and buffer of the task that serves it, as it is taken
+ *   from the heap_3 (malloc) statistics.  Stream buffers taken from the socket pools are not
+ *   included.
+ * + Priority: only when ipconfigSOCKET_HAS_TYPE_OF_SERVICE is 1.  The first
+ *   client runs request/response with benchPRIORITY_MESSAGE_SIZE byte messages
+ *   while the other clients run a bulk stream of benchPACING_MESSAGE_SIZE byte
+ *   messages.  The test is run with the first client's connection sending with
+ *   a type of service of 0, then of benchPRIORITY_TOS (DSCP EF), and prints the
+ *   latencies of the first client and the throughput of the others.  With the
+ *   local server, the echo server listens on configBENCHMARK_PORT + 1 with the
+ *   same type of service.  Build with "scons --benchmark --loopback
+ *   --bottleneck --tx-priority" to see the small messages overtake the bulk
+ *   data in the priority queues (see ipconfigUSE_TX_PRIORITY_QUEUES).
+ * + System calls: after the memory test, the time taken by the sockets API
+ *   itself is measured configBENCHMARK_SYSCALL_CALLS times for: FreeRTOS_sendto()
+ *   of a benchSYSCALL_MESSAGE_SIZE byte UDP datagram to the discard port of
+ *   the server, creating, binding and closing a UDP socket, and FreeRTOS_send()
+ *   of a benchSYSCALL_MESSAGE_SIZE byte message on an echo connection (the
+ *   echo is received before the next call, outside the measurement).  Build
+ *   with and without "--stack-lock" to compare passing the work to the
+ *   IP-task with doing it in the calling task (see ipconfigUSE_STACK_LOCK).
+ *
+ * One line is printed per test with the transaction (or connection) rate, the
+ * throughput of echoed payload data and the p50/p99/p999 latencies.  To see
+ * how TCP recovers from losses, build with "scons --benchmark --loopback
+ * --loss", with and without "--rack-tlp", and compare the p99 and p999
+ * latencies of the request/response tests.  Latencies
+ * are kept in a histogram with 16 buckets per power of two, so the reported
+ * percentiles are accurate to about 6%.
+ *
+ * When configBENCHMARK_LOCAL_SERVER is 1 an echo server is created on this
+ * node and the clients connect to the node's own IP address, which is intended
+ * to be used with the loopback network interface (build with
+ * "scons --benchmark --loopback").  Otherwise the clients connect to the echo
+ * server set by the configECHO_SERVER_ADDR0 to configECHO_SERVER_ADDR3
+ * constants in FreeRTOSConfig.h, through the pcap network interface.
+ *
+ * Time stamps are taken from ulGetRunTimeCounterValue(), which counts
+ * nanoseconds in this port.
+ */
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <malloc.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* FreeRTOS+TCP includes. */
+#include "FreeRTOS_IP.h"
+#include "FreeRTOS_Sockets.h"
+
+/* Demo application includes. */
+#include "TCPEchoBenchmark.h"
+#include "console.h"
+
+/* Exclude the whole file if FreeRTOSIPConfig.h is configured to use UDP only. */
+#if ( ipconfigUSE_TCP == 1 )
+
+/* The number of client tasks that run concurrently during each test. */
+#ifndef configBENCHMARK_CLIENTS
+	#define configBENCHMARK_CLIENTS		4
+#endif
+
+/* The duration of each test. */
+#ifndef configBENCHMARK_RUN_TIME_MS
+	#define configBENCHMARK_RUN_TIME_MS	5000
+#endif
+
+/* Set to 1 to run the echo server on this node too. */
+#ifndef configBENCHMARK_LOCAL_SERVER
+	#define configBENCHMARK_LOCAL_SERVER	0
+#endif
+
+/* The port the echo server listens on, 7 being the standard echo port. */
+#ifndef configBENCHMARK_PORT
+	#define configBENCHMARK_PORT		7
+#endif
+
+/* The largest number of idle sockets opened by the idle sockets test. */
+#ifndef configBENCHMARK_MAX_IDLE_SOCKETS
+	#define configBENCHMARK_MAX_IDLE_SOCKETS	1024
+#endif
+
+/* The number of connections opened by the memory test. */
+#ifndef configBENCHMARK_MEM_CONNECTIONS
+	#define configBENCHMARK_MEM_CONNECTIONS	32
+#endif
+
+/* The number of calls measured per system call test. */
+#ifndef configBENCHMARK_SYSCALL_CALLS
+	#define configBENCHMARK_SYSCALL_CALLS	10000
+#endif
+
+/* The message size used by the idle sockets test. */
+#define benchIDLE_MESSAGE_SIZE		( 64UL )
+
+/* The message size used by the churn test. */
+#define benchCHURN_MESSAGE_SIZE		( 64UL )
+
+/* The message size used by the pacing test, and by the bulk streams of the
+priority test. */
+#define benchPACING_MESSAGE_SIZE	( 16384UL )
+
+/* The message size and the type of service of the priority client in the
+priority test.  0xB8 is DSCP 46, Expedited Forwarding. */
+#define benchPRIORITY_MESSAGE_SIZE	( 64UL )
+#define benchPRIORITY_TOS			( 0xB8U )
+
+/* The message size of the system call tests, and the UDP port they send to,
+9 being the standard discard port. */
+#define benchSYSCALL_MESSAGE_SIZE	( 64UL )
+#define benchSYSCALL_UDP_PORT		( 9U )
+
+#if( ipconfigTCP_PACING == 1 )
+	/* The fixed rate of the pacing test, in bytes per second.  Preferably
+	the rate of the simulated bottleneck in the loopback interface. */
+	#ifndef configBENCHMARK_PACING_RATE
+		#ifdef ipconfigLOOPBACK_BOTTLENECK_RATE
+			#define configBENCHMARK_PACING_RATE	( ipconfigLOOPBACK_BOTTLENECK_RATE )
+		#else
+			#define configBENCHMARK_PACING_RATE	( 1250000UL )
+		#endif
+	#endif
+
+#endif
+
+#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+	#define benchLAST_MODE			eBenchPriority
+#elif( ipconfigTCP_PACING == 1 )
+	#define benchLAST_MODE			eBenchPacedStream
+#else
+	#define benchLAST_MODE			eBenchChurn
+#endif
+
+/* The buffer and window sizes used by both the clients and the local server.
+The window sizes are expressed in segments. */
+#define benchTCP_BUFFER_SIZE		( 8 * ipconfigTCP_MSS )
+#define benchTCP_WINDOW_SIZE		( 4 )
+
+/* The size of the buffer used by the local echo server to receive data. */
+#define benchSERVER_BUFFER_SIZE		( 4 * ipconfigTCP_MSS )
+
+/* Rx and Tx time outs, so a lost connection does not stop the benchmark. */
+#define benchSOCKET_TIME_OUT		( pdMS_TO_TICKS( 5000 ) )
+
+/* The maximum time to wait for a closing socket to close. */
+#define benchSHUTDOWN_DELAY			( pdMS_TO_TICKS( 5000 ) )
+
+/* The latency histogram holds exact values below 16us, then 16 buckets for
+each power of two up to 2^32us. */
+#define benchHISTOGRAM_SUB_BUCKETS	( 16U )
+#define benchHISTOGRAM_BUCKETS		( ( 29U * benchHISTOGRAM_SUB_BUCKETS ) )
+
+/*-----------------------------------------------------------*/
+
+typedef enum
+{
+	eBenchRequestResponse = 0,	/* Send a message, wait for its echo. */
+	eBenchBulkStream,			/* Send continuously, drain the echo. */
+	eBenchConnect,				/* Connect and close. */
+	eBenchIdleSockets,			/* Request/response next to idle sockets. */
+	eBenchChurn,				/* Connect, one round trip, close. */
+	eBenchPacedStream,			/* Bulk stream with TCP pacing. */
+	eBenchPriority				/* Request/response next to bulk streams. */
+} eBenchMode_t;
+
+/* The results of one client during one test. */
+typedef struct xBENCH_RESULT
+{
+	uint64_t ullRxBytes;		/* Echoed payload bytes received. */
+	uint32_t ulTransactions;	/* Round trips or connections completed. */
+	uint32_t ulErrors;			/* Connections that failed or were lost. */
+	uint32_t ulLatencies[ benchHISTOGRAM_BUCKETS ];
+} BenchResult_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Runs all the tests in turn and prints the results.
+ */
+static void prvBenchmarkControlTask( void *pvParameters );
+
+/*
+ * The client task, one instance is created per client for each test.
+ */
+static void prvBenchmarkClientTask( void *pvParameters );
+
+/*
+ * The client test loops.  The idle sockets test uses prvRequestResponse().
+ */
+static void prvRequestResponse( Socket_t xSocket, BenchResult_t *pxResult, uint8_t *pucTxBuffer, uint8_t *pucRxBuffer, size_t uxMessageSize );
+static void prvBulkStream( Socket_t xSocket, BenchResult_t *pxResult, uint8_t *pucTxBuffer, uint8_t *pucRxBuffer );
+static void prvConnectAndClose( BenchResult_t *pxResult, uint8_t *pucRxBuffer );
+static void prvChurn( BenchResult_t *pxResult, uint8_t *pucTxBuffer, uint8_t *pucRxBuffer );
+
+/*
+ * Opens idle sockets until there are ulCount, or closes them all if ulCount is
+ * 0.  Returns the number of idle sockets that are open.
+ */
+static uint32_t prvSetIdleSockets( uint32_t ulCount );
+
+/*
+ * Open connections that each echo one small message, and print the heap in
+ * use per idle connection.
+ */
+static void prvIdleConnectionMemory( void );
+
+/*
+ * Measure and print the latency of FreeRTOS_sendto(), of a socket(), bind()
+ * and closesocket() cycle, and of FreeRTOS_send().
+ */
+static void prvSyscallLatency( void );
+static void prvPrintSyscallLatency( const char *pcName );
+
+/*
+ * Creates a socket configured for the benchmark, or returns
+ * FREERTOS_INVALID_SOCKET.
+ */
+static Socket_t prvCreateSocket( void );
+
+/*
+ * Shuts the connection down, waits for the peer to close, then closes the
+ * socket.
+ */
+static void prvGracefulClose( Socket_t xSocket, uint8_t *pucBuffer, size_t uxBufferSize );
+
+/*
+ * Latency histogram helpers.
+ */
+static void prvRecordLatency( BenchResult_t *pxResult, uint64_t ullStartNs );
+static uint32_t prvPercentile( const uint32_t *pulHistogram, uint32_t ulCount, uint32_t ulPerMille );
+
+/*
+ * The local echo server.
+ */
+#if( configBENCHMARK_LOCAL_SERVER == 1 )
+	static void prvServerListeningTask( void *pvParameters );
+	static void prvServerConnectionInstance( void *pvParameters );
+#endif
+
+/*
+ * Defined in the loopback network interface, which is used with the local
+ * server.
+ */
+#if( configBENCHMARK_LOCAL_SERVER == 1 ) && ( ipconfigTCP_PACING == 1 )
+	extern void vLoopbackGetCounters( uint32_t *pulFrames, uint32_t *pulDrops );
+#endif
+
+/*-----------------------------------------------------------*/
+
+/* The message sizes tested in the request/response and bulk stream modes. */
+static const uint32_t ulMessageSizes[] = { 64UL, 256UL, 1024UL, 4096UL, 16384UL, 65536UL };
+
+/* The number of idle sockets in the idle sockets test. */
+static const uint32_t ulIdleSocketCounts[] = { 0UL, 16UL, 128UL, 1024UL };
+
+#if( ipconfigTCP_PACING == 1 )
+	/* The pacing rates of the pacing test. */
+	static const uint32_t ulPacingRates[] = { FREERTOS_TCP_PACING_OFF, FREERTOS_TCP_PACING_AUTO, configBENCHMARK_PACING_RATE };
+#endif
+
+#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+	/* The type of service of the priority client in the priority test. */
+	static const uint8_t ucPriorityTypesOfService[] = { 0U, benchPRIORITY_TOS };
+#endif
+
+static const char * const pcModeNames[] = { "rr", "bulk", "conn", "idle", "churn", "pace", "prio" };
+
+/* The parameters of the test in progress, written by the control task before
+the client tasks are created. */
+static eBenchMode_t eCurrentMode;
+static uint32_t ulCurrentMessageSize;
+static TickType_t xTestEndTime;
+#if( ipconfigTCP_PACING == 1 )
+	static uint32_t ulCurrentPacingRate = FREERTOS_TCP_PACING_OFF;
+#endif
+#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+	static uint8_t ucCurrentTypeOfService = 0U;
+#endif
+#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+	static BaseType_t xCurrentFastOpen = pdFALSE;
+#endif
+static struct freertos_sockaddr xServerAddress;
+static TaskHandle_t xControlTask = NULL;
+static uint16_t usUsedStackSize = 0;
+static UBaseType_t uxClientPriority = 0;
+
+/* The sockets opened by the idle sockets test. */
+static Socket_t xIdleSockets[ configBENCHMARK_MAX_IDLE_SOCKETS ];
+static uint32_t ulIdleSocketCount = 0;
+
+/* The per client results, and the sum of them. */
+static BenchResult_t xClientResults[ configBENCHMARK_CLIENTS ];
+static BenchResult_t xTotals;
+
+/* The results of the system call tests, only one runs at a time. */
+static BenchResult_t xSyscallResult;
+
+/* Reused by all the tests. */
+static const WinProperties_t xWinProps =
+{
+	benchTCP_BUFFER_SIZE,	/* lTxBufSize */
+	benchTCP_WINDOW_SIZE,	/* lTxWinSize */
+	benchTCP_BUFFER_SIZE,	/* lRxBufSize */
+	benchTCP_WINDOW_SIZE	/* lRxWinSize */
+};
+
+/*-----------------------------------------------------------*/
+
+void vStartTCPEchoBenchmark( uint16_t usTaskStackSize, UBaseType_t uxTaskPriority )
+{
+	usUsedStackSize = usTaskStackSize;
+	uxClientPriority = uxTaskPriority;
+
+	#if( configBENCHMARK_LOCAL_SERVER == 1 )
+	{
+		xTaskCreate( prvServerListeningTask, "BenchServer", usTaskStackSize, ( void * ) ( BaseType_t ) configBENCHMARK_PORT, uxTaskPriority + 1, NULL );
+
+		#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+		{
+			/* The server of the priority client in the priority test. */
+			xTaskCreate( prvServerListeningTask, "BenchPrioServer", usTaskStackSize, ( void * ) ( BaseType_t ) ( configBENCHMARK_PORT + 1 ), uxTaskPriority + 1, NULL );
+		}
+		#endif
+	}
+	#endif
+
+	/* The control task must be able to print the results as soon as the
+	last client finished, so it runs above the clients. */
+	xTaskCreate( prvBenchmarkControlTask, "BenchCtrl", usTaskStackSize, NULL, uxTaskPriority + 1, &xControlTask );
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchmarkControlTask( void *pvParameters )
+{
+BaseType_t xMode, xSize, xSizeCount, xClient;
+uint64_t ullStartNs, ullElapsedNs;
+uint32_t x, ulColumn;
+double dSeconds;
+#if( configBENCHMARK_LOCAL_SERVER == 1 ) && ( ipconfigTCP_PACING == 1 )
+	uint32_t ulFrames, ulDrops, ulFirstDrops = 0UL;
+#endif
+
+	( void ) pvParameters;
+
+	#if( configBENCHMARK_LOCAL_SERVER == 1 )
+	{
+		xServerAddress.sin_addr = FreeRTOS_GetIPAddress();
+
+		/* Give the server task the time to start listening. */
+		vTaskDelay( pdMS_TO_TICKS( 100 ) );
+	}
+	#else
+	{
+		xServerAddress.sin_addr = FreeRTOS_inet_addr_quick( configECHO_SERVER_ADDR0,
+															configECHO_SERVER_ADDR1,
+															configECHO_SERVER_ADDR2,
+															configECHO_SERVER_ADDR3 );
+	}
+	#endif
+	xServerAddress.sin_port = FreeRTOS_htons( configBENCHMARK_PORT );
+
+	console_print( "TCP echo benchmark: %d clients, %d ms per test\n", configBENCHMARK_CLIENTS, configBENCHMARK_RUN_TIME_MS );
+
+	for( xMode = eBenchRequestResponse; xMode <= benchLAST_MODE; xMode++ )
+	{
+		#if( ipconfigTCP_PACING != 1 )
+		{
+			if( xMode == eBenchPacedStream )
+			{
+				continue;
+			}
+		}
+		#endif
+
+		/* The connect and churn tests do not depend on the message size, the
+		idle sockets test varies the number of idle sockets instead. */
+		if( xMode == eBenchConnect )
+		{
+			xSizeCount = 1;
+		}
+		else if( xMode == eBenchChurn )
+		{
+			#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+			{
+				/* Run without, then with Fast Open. */
+				xSizeCount = 2;
+			}
+			#else
+			{
+				xSizeCount = 1;
+			}
+			#endif
+		}
+		else if( xMode == eBenchIdleSockets )
+		{
+			xSizeCount = ( BaseType_t ) ( sizeof( ulIdleSocketCounts ) / sizeof( ulIdleSocketCounts[ 0 ] ) );
+		}
+		#if( ipconfigTCP_PACING == 1 )
+			else if( xMode == eBenchPacedStream )
+			{
+				/* The pacing test varies the pacing rate instead. */
+				xSizeCount = ( BaseType_t ) ( sizeof( ulPacingRates ) / sizeof( ulPacingRates[ 0 ] ) );
+			}
+		#endif
+		#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+			else if( xMode == eBenchPriority )
+			{
+				/* The priority test varies the type of service instead. */
+				xSizeCount = ( BaseType_t ) ( sizeof( ucPriorityTypesOfService ) / sizeof( ucPriorityTypesOfService[ 0 ] ) );
+			}
+		#endif
+		else
+		{
+			xSizeCount = ( BaseType_t ) ( sizeof( ulMessageSizes ) / sizeof( ulMessageSizes[ 0 ] ) );
+		}
+
+		for( xSize = 0; xSize < xSizeCount; xSize++ )
+		{
+			memset( xClientResults, 0, sizeof( xClientResults ) );
+			memset( &xTotals, 0, sizeof( xTotals ) );
+
+			eCurrentMode = ( eBenchMode_t ) xMode;
+
+			if( eCurrentMode == eBenchIdleSockets )
+			{
+				ulCurrentMessageSize = benchIDLE_MESSAGE_SIZE;
+				ulColumn = prvSetIdleSockets( ulIdleSocketCounts[ xSize ] );
+			}
+			else if( eCurrentMode == eBenchChurn )
+			{
+				/* Close the sockets of the idle sockets test, so the churn
+				test can use all the sockets of the pool. */
+				( void ) prvSetIdleSockets( 0UL );
+				ulCurrentMessageSize = benchCHURN_MESSAGE_SIZE;
+				ulColumn = ulCurrentMessageSize;
+
+				#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+				{
+					xCurrentFastOpen = ( xSize != 0 ) ? pdTRUE : pdFALSE;
+				}
+				#endif
+			}
+			#if( ipconfigTCP_PACING == 1 )
+				else if( eCurrentMode == eBenchPacedStream )
+				{
+					ulCurrentMessageSize = benchPACING_MESSAGE_SIZE;
+					ulCurrentPacingRate = ulPacingRates[ xSize ];
+					ulColumn = ulCurrentPacingRate;
+				}
+			#endif
+			#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+				else if( eCurrentMode == eBenchPriority )
+				{
+					#if( ipconfigTCP_PACING == 1 )
+					{
+						ulCurrentPacingRate = FREERTOS_TCP_PACING_OFF;
+					}
+					#endif
+
+					/* The buffers are large enough for the bulk streams. */
+					ulCurrentMessageSize = benchPACING_MESSAGE_SIZE;
+					ucCurrentTypeOfService = ucPriorityTypesOfService[ xSize ];
+					ulColumn = ucCurrentTypeOfService;
+				}
+			#endif
+			else
+			{
+				ulCurrentMessageSize = ulMessageSizes[ xSize ];
+				ulColumn = ulCurrentMessageSize;
+			}
+
+			#if( configBENCHMARK_LOCAL_SERVER == 1 ) && ( ipconfigTCP_PACING == 1 )
+			{
+				vLoopbackGetCounters( &ulFrames, &ulFirstDrops );
+			}
+			#endif
+
+			xTestEndTime = xTaskGetTickCount() + pdMS_TO_TICKS( configBENCHMARK_RUN_TIME_MS );
+			ullStartNs = ( uint64_t ) ulGetRunTimeCounterValue();
+
+			for( xClient = 0; xClient < configBENCHMARK_CLIENTS; xClient++ )
+			{
+				xTaskCreate( prvBenchmarkClientTask, "BenchClient", usUsedStackSize, ( void * ) xClient, uxClientPriority, NULL );
+			}
+
+			/* Each client notifies this task when it has finished. */
+			for( xClient = 0; xClient < configBENCHMARK_CLIENTS; xClient++ )
+			{
+				ulTaskNotifyTake( pdFALSE, portMAX_DELAY );
+			}
+
+			ullElapsedNs = ( uint64_t ) ulGetRunTimeCounterValue() - ullStartNs;
+			dSeconds = ( double ) ullElapsedNs / 1e9;
+
+			for( xClient = 0; xClient < configBENCHMARK_CLIENTS; xClient++ )
+			{
+				xTotals.ullRxBytes += xClientResults[ xClient ].ullRxBytes;
+				xTotals.ulTransactions += xClientResults[ xClient ].ulTransactions;
+				xTotals.ulErrors += xClientResults[ xClient ].ulErrors;
+
+				for( x = 0; x < benchHISTOGRAM_BUCKETS; x++ )
+				{
+					xTotals.ulLatencies[ x ] += xClientResults[ xClient ].ulLatencies[ x ];
+				}
+			}
+
+			#if( ipconfigTCP_PACING == 1 )
+				if( eCurrentMode == eBenchPacedStream )
+				{
+					/* The second column is the pacing rate in bytes per
+					second. */
+					console_print( "%-5s %8s: %10.2f Mbit/s",
+								   pcModeNames[ xMode ],
+								   ( ulColumn == FREERTOS_TCP_PACING_OFF ) ? "off" :
+								   ( ulColumn == FREERTOS_TCP_PACING_AUTO ) ? "auto" : "fixed",
+								   ( double ) xTotals.ullRxBytes * 8.0 / dSeconds / 1e6 );
+
+					#if( configBENCHMARK_LOCAL_SERVER == 1 )
+					{
+						vLoopbackGetCounters( &ulFrames, &ulDrops );
+						ulDrops -= ulFirstDrops;
+						console_print( " %8.2f drops/MB",
+									   ( xTotals.ullRxBytes != 0U ) ? ( ( double ) ulDrops * 1e6 / ( double ) xTotals.ullRxBytes ) : 0.0 );
+					}
+					#endif
+
+					console_print( " errors %lu\n", ( unsigned long ) xTotals.ulErrors );
+				}
+				else
+			#endif /* ipconfigTCP_PACING */
+			#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+				if( eCurrentMode == eBenchPriority )
+				{
+				const BenchResult_t *pxPriority = &( xClientResults[ 0 ] );
+
+					/* The second column is the type of service of the priority
+					client, the latencies are its own, the throughput is that
+					of the bulk streams. */
+					console_print( "%-5s 0x%02lx TOS: %10.1f txn/s %10.2f Mbit/s p50 %6lu p99 %6lu p999 %6lu us errors %lu\n",
+								   pcModeNames[ xMode ],
+								   ( unsigned long ) ulColumn,
+								   ( double ) pxPriority->ulTransactions / dSeconds,
+								   ( double ) ( xTotals.ullRxBytes - pxPriority->ullRxBytes ) * 8.0 / dSeconds / 1e6,
+								   ( unsigned long ) prvPercentile( pxPriority->ulLatencies, pxPriority->ulTransactions, 500UL ),
+								   ( unsigned long ) prvPercentile( pxPriority->ulLatencies, pxPriority->ulTransactions, 990UL ),
+								   ( unsigned long ) prvPercentile( pxPriority->ulLatencies, pxPriority->ulTransactions, 999UL ),
+								   ( unsigned long ) xTotals.ulErrors );
+				}
+				else
+			#endif /* ipconfigSOCKET_HAS_TYPE_OF_SERVICE */
+			if( eCurrentMode == eBenchBulkStream )
+			{
+				/* No latencies are measured while streaming. */
+				console_print( "%-5s %6lu B: %10.1f msg/s %10.2f Mbit/s %28s errors %lu\n",
+							   pcModeNames[ xMode ],
+							   ( unsigned long ) ulCurrentMessageSize,
+							   ( double ) xTotals.ullRxBytes / ( double ) ulCurrentMessageSize / dSeconds,
+							   ( double ) xTotals.ullRxBytes * 8.0 / dSeconds / 1e6,
+							   "",
+							   ( unsigned long ) xTotals.ulErrors );
+			}
+			else
+			{
+			const char *pcName = pcModeNames[ xMode ];
+
+				#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+				{
+					if( ( eCurrentMode == eBenchChurn ) && ( xCurrentFastOpen != pdFALSE ) )
+					{
+						pcName = "tfo";
+					}
+				}
+				#endif
+
+				/* The second column is the number of idle sockets in the idle
+				sockets test, otherwise the message size. */
+				console_print( "%-5s %6lu %s: %10.1f %s %10.2f Mbit/s p50 %6lu p99 %6lu p999 %6lu us errors %lu\n",
+							   pcName,
+							   ( eCurrentMode == eBenchConnect ) ? 0UL : ( unsigned long ) ulColumn,
+							   ( eCurrentMode == eBenchIdleSockets ) ? "S" : "B",
+							   ( double ) xTotals.ulTransactions / dSeconds,
+							   ( ( eCurrentMode == eBenchRequestResponse ) || ( eCurrentMode == eBenchIdleSockets ) ) ? "txn/s" : "con/s",
+							   ( double ) xTotals.ullRxBytes * 8.0 / dSeconds / 1e6,
+							   ( unsigned long ) prvPercentile( xTotals.ulLatencies, xTotals.ulTransactions, 500UL ),
+							   ( unsigned long ) prvPercentile( xTotals.ulLatencies, xTotals.ulTransactions, 990UL ),
+							   ( unsigned long ) prvPercentile( xTotals.ulLatencies, xTotals.ulTransactions, 999UL ),
+							   ( unsigned long ) xTotals.ulErrors );
+			}
+
+			#if( ipconfigUSE_SOCKET_POOLS == 1 )
+			{
+				if( eCurrentMode == eBenchChurn )
+				{
+				UBaseType_t uxFree, uxMinimumFree;
+				BaseType_t xPool;
+
+					for( xPool = FREERTOS_POOL_SOCKETS; xPool <= FREERTOS_POOL_STREAM_1; xPool++ )
+					{
+						if( FreeRTOS_GetPoolStats( xPool, &uxFree, &uxMinimumFree ) == pdPASS )
+						{
+							console_print( "pool %ld: %lu free, lowest %lu\n", ( long ) xPool, ( unsigned long ) uxFree, ( unsigned long ) uxMinimumFree );
+						}
+					}
+				}
+			}
+			#endif /* ipconfigUSE_SOCKET_POOLS */
+		}
+	}
+
+	#if( ipconfigTCP_PACING == 1 )
+	{
+		ulCurrentPacingRate = FREERTOS_TCP_PACING_OFF;
+	}
+	#endif
+
+	( void ) prvSetIdleSockets( 0UL );
+	prvIdleConnectionMemory();
+	prvSyscallLatency();
+	console_print( "TCP echo benchmark complete\n" );
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchmarkClientTask( void *pvParameters )
+{
+BaseType_t xInstance = ( BaseType_t ) pvParameters;
+BenchResult_t *pxResult = &( xClientResults[ xInstance ] );
+Socket_t xSocket;
+uint8_t *pucTxBuffer, *pucRxBuffer;
+struct freertos_sockaddr xAddress = xServerAddress;
+
+	/* Messages of up to 64 KB are too large for the stack of a task. */
+	pucTxBuffer = ( uint8_t * ) pvPortMalloc( ulCurrentMessageSize );
+	pucRxBuffer = ( uint8_t * ) pvPortMalloc( ulCurrentMessageSize );
+
+	if( ( pucTxBuffer == NULL ) || ( pucRxBuffer == NULL ) )
+	{
+		pxResult->ulErrors++;
+	}
+	else if( eCurrentMode == eBenchConnect )
+	{
+		prvConnectAndClose( pxResult, pucRxBuffer );
+	}
+	else if( eCurrentMode == eBenchChurn )
+	{
+		memset( pucTxBuffer, ( int ) ( 'a' + xInstance ), ulCurrentMessageSize );
+		prvChurn( pxResult, pucTxBuffer, pucRxBuffer );
+	}
+	else
+	{
+		memset( pucTxBuffer, ( int ) ( 'a' + xInstance ), ulCurrentMessageSize );
+		xSocket = prvCreateSocket();
+
+		#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+		{
+			if( ( eCurrentMode == eBenchPriority ) && ( xInstance == 0 ) && ( xSocket != FREERTOS_INVALID_SOCKET ) )
+			{
+				FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_IP_TOS, &ucCurrentTypeOfService, sizeof( ucCurrentTypeOfService ) );
+
+				#if( configBENCHMARK_LOCAL_SERVER == 1 )
+				{
+					/* Let the echo be sent with the same type of service. */
+					if( ucCurrentTypeOfService != 0U )
+					{
+						xAddress.sin_port = FreeRTOS_htons( configBENCHMARK_PORT + 1 );
+					}
+				}
+				#endif
+			}
+		}
+		#endif
+
+		if( xSocket == FREERTOS_INVALID_SOCKET )
+		{
+			pxResult->ulErrors++;
+		}
+		else if( FreeRTOS_connect( xSocket, &xAddress, sizeof( xAddress ) ) != 0 )
+		{
+			pxResult->ulErrors++;
+			FreeRTOS_closesocket( xSocket );
+		}
+		else
+		{
+			if( ( eCurrentMode == eBenchRequestResponse ) || ( eCurrentMode == eBenchIdleSockets ) )
+			{
+				prvRequestResponse( xSocket, pxResult, pucTxBuffer, pucRxBuffer, ulCurrentMessageSize );
+			}
+			else if( ( eCurrentMode == eBenchPriority ) && ( xInstance == 0 ) )
+			{
+				prvRequestResponse( xSocket, pxResult, pucTxBuffer, pucRxBuffer, benchPRIORITY_MESSAGE_SIZE );
+			}
+			else
+			{
+				prvBulkStream( xSocket, pxResult, pucTxBuffer, pucRxBuffer );
+			}
+
+			prvGracefulClose( xSocket, pucRxBuffer, ulCurrentMessageSize );
+		}
+	}
+
+	vPortFree( pucTxBuffer );
+	vPortFree( pucRxBuffer );
+
+	xTaskNotifyGive( xControlTask );
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRequestResponse( Socket_t xSocket, BenchResult_t *pxResult, uint8_t *pucTxBuffer, uint8_t *pucRxBuffer, size_t uxMessageSize )
+{
+uint64_t ullStartNs;
+BaseType_t xCount, xTotal;
+
+	while( ( TickType_t ) ( xTestEndTime - xTaskGetTickCount() ) <= pdMS_TO_TICKS( configBENCHMARK_RUN_TIME_MS ) )
+	{
+		ullStartNs = ( uint64_t ) ulGetRunTimeCounterValue();
+
+		/* Call send() until all the data has been queued. */
+		for( xTotal = 0; xTotal < ( BaseType_t ) uxMessageSize; xTotal += xCount )
+		{
+			xCount = FreeRTOS_send( xSocket, &( pucTxBuffer[ xTotal ] ), uxMessageSize - ( size_t ) xTotal, 0 );
+
+			if( xCount <= 0 )
+			{
+				break;
+			}
+		}
+
+		if( xTotal < ( BaseType_t ) uxMessageSize )
+		{
+			pxResult->ulErrors++;
+			break;
+		}
+
+		/* Then wait for the complete echo. */
+		for( xTotal = 0; xTotal < ( BaseType_t ) uxMessageSize; xTotal += xCount )
+		{
+			xCount = FreeRTOS_recv( xSocket, &( pucRxBuffer[ xTotal ] ), uxMessageSize - ( size_t ) xTotal, 0 );
+
+			if( xCount <= 0 )
+			{
+				break;
+			}
+		}
+
+		pxResult->ullRxBytes += ( uint64_t ) xTotal;
+
+		if( xTotal < ( BaseType_t ) uxMessageSize )
+		{
+			pxResult->ulErrors++;
+			break;
+		}
+
+		prvRecordLatency( pxResult, ullStartNs );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvBulkStream( Socket_t xSocket, BenchResult_t *pxResult, uint8_t *pucTxBuffer, uint8_t *pucRxBuffer )
+{
+BaseType_t xSent, xReceived, xRxFlags;
+size_t uxTxOffset = 0U;
+
+	while( ( TickType_t ) ( xTestEndTime - xTaskGetTickCount() ) <= pdMS_TO_TICKS( configBENCHMARK_RUN_TIME_MS ) )
+	{
+		xSent = FreeRTOS_send( xSocket, &( pucTxBuffer[ uxTxOffset ] ), ulCurrentMessageSize - uxTxOffset, FREERTOS_MSG_DONTWAIT );
+
+		if( xSent > 0 )
+		{
+			uxTxOffset += ( size_t ) xSent;
+
+			if( uxTxOffset >= ulCurrentMessageSize )
+			{
+				uxTxOffset = 0U;
+			}
+
+			/* Don't wait for the echo while more data can be sent. */
+			xRxFlags = FREERTOS_MSG_DONTWAIT;
+		}
+		else if( ( xSent == 0 ) || ( xSent == -pdFREERTOS_ERRNO_ENOSPC ) )
+		{
+			/* The Tx stream is full, so some data is in flight and the echo
+			of it can be waited for. */
+			xRxFlags = 0;
+		}
+		else
+		{
+			pxResult->ulErrors++;
+			break;
+		}
+
+		xReceived = FreeRTOS_recv( xSocket, pucRxBuffer, ulCurrentMessageSize, xRxFlags );
+
+		if( xReceived > 0 )
+		{
+			pxResult->ullRxBytes += ( uint64_t ) xReceived;
+		}
+		else if( ( xReceived == 0 ) || ( xReceived == -pdFREERTOS_ERRNO_EWOULDBLOCK ) )
+		{
+			if( xRxFlags == 0 )
+			{
+				/* Nothing was echoed within the time out. */
+				pxResult->ulErrors++;
+				break;
+			}
+		}
+		else
+		{
+			pxResult->ulErrors++;
+			break;
+		}
+	}
+
+	pxResult->ulTransactions = ( uint32_t ) ( pxResult->ullRxBytes / ulCurrentMessageSize );
+}
+/*-----------------------------------------------------------*/
+
+static void prvConnectAndClose( BenchResult_t *pxResult, uint8_t *pucRxBuffer )
+{
+Socket_t xSocket;
+uint64_t ullStartNs;
+
+	while( ( TickType_t ) ( xTestEndTime - xTaskGetTickCount() ) <= pdMS_TO_TICKS( configBENCHMARK_RUN_TIME_MS ) )
+	{
+		ullStartNs = ( uint64_t ) ulGetRunTimeCounterValue();
+		xSocket = prvCreateSocket();
+
+		if( xSocket == FREERTOS_INVALID_SOCKET )
+		{
+			pxResult->ulErrors++;
+			break;
+		}
+
+		if( FreeRTOS_connect( xSocket, &xServerAddress, sizeof( xServerAddress ) ) != 0 )
+		{
+			pxResult->ulErrors++;
+			FreeRTOS_closesocket( xSocket );
+			break;
+		}
+
+		prvRecordLatency( pxResult, ullStartNs );
+		prvGracefulClose( xSocket, pucRxBuffer, ulCurrentMessageSize );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvChurn( BenchResult_t *pxResult, uint8_t *pucTxBuffer, uint8_t *pucRxBuffer )
+{
+Socket_t xSocket;
+uint64_t ullStartNs;
+BaseType_t xCount, xTotal;
+
+	while( ( TickType_t ) ( xTestEndTime - xTaskGetTickCount() ) <= pdMS_TO_TICKS( configBENCHMARK_RUN_TIME_MS ) )
+	{
+		ullStartNs = ( uint64_t ) ulGetRunTimeCounterValue();
+		xSocket = prvCreateSocket();
+
+		if( xSocket == FREERTOS_INVALID_SOCKET )
+		{
+			pxResult->ulErrors++;
+			break;
+		}
+
+		#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+			if( xCurrentFastOpen != pdFALSE )
+			{
+				/* Connect and queue the message in one call.  The first
+				connection only fetches a cookie from the server, the later
+				ones carry the message on the SYN. */
+				if( FreeRTOS_sendto( xSocket, pucTxBuffer, ulCurrentMessageSize, FREERTOS_MSG_FASTOPEN, &xServerAddress, sizeof( xServerAddress ) ) != ( int32_t ) ulCurrentMessageSize )
+				{
+					pxResult->ulErrors++;
+					FreeRTOS_closesocket( xSocket );
+					break;
+				}
+			}
+			else
+		#endif /* ipconfigUSE_TCP_FAST_OPEN */
+		{
+			if( FreeRTOS_connect( xSocket, &xServerAddress, sizeof( xServerAddress ) ) != 0 )
+			{
+				pxResult->ulErrors++;
+				FreeRTOS_closesocket( xSocket );
+				break;
+			}
+
+			/* The message is small, so is queued by a single call to send(). */
+			if( FreeRTOS_send( xSocket, pucTxBuffer, ulCurrentMessageSize, 0 ) != ( BaseType_t ) ulCurrentMessageSize )
+			{
+				pxResult->ulErrors++;
+				prvGracefulClose( xSocket, pucRxBuffer, ulCurrentMessageSize );
+				break;
+			}
+		}
+
+		for( xTotal = 0; xTotal < ( BaseType_t ) ulCurrentMessageSize; xTotal += xCount )
+		{
+			xCount = FreeRTOS_recv( xSocket, &( pucRxBuffer[ xTotal ] ), ulCurrentMessageSize - ( size_t ) xTotal, 0 );
+
+			if( xCount <= 0 )
+			{
+				break;
+			}
+		}
+
+		pxResult->ullRxBytes += ( uint64_t ) xTotal;
+		prvGracefulClose( xSocket, pucRxBuffer, ulCurrentMessageSize );
+
+		if( xTotal < ( BaseType_t ) ulCurrentMessageSize )
+		{
+			pxResult->ulErrors++;
+			break;
+		}
+
+		prvRecordLatency( pxResult, ullStartNs );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvSetIdleSockets( uint32_t ulCount )
+{
+struct freertos_sockaddr xBindAddress;
+
+	if( ulCount > configBENCHMARK_MAX_IDLE_SOCKETS )
+	{
+		ulCount = configBENCHMARK_MAX_IDLE_SOCKETS;
+	}
+
+	if( ulCount == 0UL )
+	{
+		while( ulIdleSocketCount > 0UL )
+		{
+			ulIdleSocketCount--;
+			FreeRTOS_closesocket( xIdleSockets[ ulIdleSocketCount ] );
+		}
+	}
+
+	while( ulIdleSocketCount < ulCount )
+	{
+		xIdleSockets[ ulIdleSocketCount ] = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+
+		if( xIdleSockets[ ulIdleSocketCount ] == FREERTOS_INVALID_SOCKET )
+		{
+			break;
+		}
+
+		/* A bound socket is in the list of TCP sockets the IP task looks
+		after, port 0 selects a free port. */
+		memset( &xBindAddress, 0, sizeof( xBindAddress ) );
+
+		if( FreeRTOS_bind( xIdleSockets[ ulIdleSocketCount ], &xBindAddress, sizeof( xBindAddress ) ) != 0 )
+		{
+			FreeRTOS_closesocket( xIdleSockets[ ulIdleSocketCount ] );
+			break;
+		}
+
+		ulIdleSocketCount++;
+	}
+
+	return ulIdleSocketCount;
+}
+/*-----------------------------------------------------------*/
+
+static void prvIdleConnectionMemory( void )
+{
+uint8_t ucTxBuffer[ benchIDLE_MESSAGE_SIZE ], ucRxBuffer[ benchIDLE_MESSAGE_SIZE ];
+size_t uxHeapBefore, uxHeapUsed;
+uint32_t ulCount, ulConnections = 0UL;
+BaseType_t xReceived, xTotal;
+
+	memset( ucTxBuffer, 'm', sizeof( ucTxBuffer ) );
+
+	/* The array of the idle sockets test, which is empty now, holds the
+	connections. */
+	uxHeapBefore = mallinfo2().uordblks;
+
+	for( ulCount = 0UL; ( ulCount < configBENCHMARK_MEM_CONNECTIONS ) && ( ulCount < configBENCHMARK_MAX_IDLE_SOCKETS ); ulCount++ )
+	{
+		xIdleSockets[ ulConnections ] = prvCreateSocket();
+
+		if( xIdleSockets[ ulConnections ] == FREERTOS_INVALID_SOCKET )
+		{
+			break;
+		}
+
+		ulConnections++;
+
+		if( FreeRTOS_connect( xIdleSockets[ ulConnections - 1UL ], &xServerAddress, sizeof( xServerAddress ) ) != 0 )
+		{
+			break;
+		}
+
+		/* Exchange one message, so both ends have created their streams. */
+		if( FreeRTOS_send( xIdleSockets[ ulConnections - 1UL ], ucTxBuffer, sizeof( ucTxBuffer ), 0 ) != ( BaseType_t ) sizeof( ucTxBuffer ) )
+		{
+			break;
+		}
+
+		for( xTotal = 0; xTotal < ( BaseType_t ) sizeof( ucRxBuffer ); xTotal += xReceived )
+		{
+			xReceived = FreeRTOS_recv( xIdleSockets[ ulConnections - 1UL ], ucRxBuffer, sizeof( ucRxBuffer ) - ( size_t ) xTotal, 0 );
+
+			if( xReceived <= 0 )
+			{
+				break;
+			}
+		}
+	}
+
+	if( ulConnections > 0UL )
+	{
+		/* Let the last acknowledgements come in. */
+		vTaskDelay( pdMS_TO_TICKS( 1000 ) );
+		uxHeapUsed = mallinfo2().uordblks - uxHeapBefore;
+		console_print( "mem   %6lu C: %8lu bytes per idle connection %s\n",
+					   ( unsigned long ) ulConnections,
+					   ( unsigned long ) ( uxHeapUsed / ulConnections ),
+					   ( configBENCHMARK_LOCAL_SERVER == 1 ) ? "(both ends and the server task)" : "(client end)" );
+
+		#if( ipconfigTCP_ELASTIC_STREAMS == 1 )
+		{
+			/* Wait until the IP-task has released the idle streams, it checks
+			the sockets at least once per second. */
+			vTaskDelay( pdMS_TO_TICKS( ipconfigTCP_STREAM_IDLE_RELEASE_MS + 2000 ) );
+			uxHeapUsed = mallinfo2().uordblks - uxHeapBefore;
+			console_print( "mem   %6lu C: %8lu bytes per idle connection after %lu ms idle\n",
+						   ( unsigned long ) ulConnections,
+						   ( unsigned long ) ( uxHeapUsed / ulConnections ),
+						   ( unsigned long ) ( ipconfigTCP_STREAM_IDLE_RELEASE_MS + 2000 ) );
+		}
+		#endif /* ipconfigTCP_ELASTIC_STREAMS */
+	}
+
+	while( ulConnections > 0UL )
+	{
+		ulConnections--;
+		prvGracefulClose( xIdleSockets[ ulConnections ], ucRxBuffer, sizeof( ucRxBuffer ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvSyscallLatency( void )
+{
+uint8_t ucTxBuffer[ benchSYSCALL_MESSAGE_SIZE ], ucRxBuffer[ benchSYSCALL_MESSAGE_SIZE ];
+struct freertos_sockaddr xDiscardAddress;
+static const TickType_t xTimeOut = benchSOCKET_TIME_OUT;
+Socket_t xSocket;
+uint64_t ullStartNs;
+uint32_t ulCall;
+BaseType_t xReceived, xTotal;
+
+	memset( ucTxBuffer, 's', sizeof( ucTxBuffer ) );
+	xDiscardAddress.sin_addr = xServerAddress.sin_addr;
+	xDiscardAddress.sin_port = FreeRTOS_htons( benchSYSCALL_UDP_PORT );
+
+	/* FreeRTOS_sendto() on a bound UDP socket.  The first datagram may be
+	lost while the address is resolved. */
+	memset( &xSyscallResult, 0, sizeof( xSyscallResult ) );
+	xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+
+	if( xSocket != FREERTOS_INVALID_SOCKET )
+	{
+		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+		( void ) FreeRTOS_bind( xSocket, NULL, 0U );
+
+		for( ulCall = 0UL; ulCall < configBENCHMARK_SYSCALL_CALLS; ulCall++ )
+		{
+			ullStartNs = ( uint64_t ) ulGetRunTimeCounterValue();
+
+			if( FreeRTOS_sendto( xSocket, ucTxBuffer, sizeof( ucTxBuffer ), 0, &xDiscardAddress, sizeof( xDiscardAddress ) ) != ( int32_t ) sizeof( ucTxBuffer ) )
+			{
+				xSyscallResult.ulErrors++;
+			}
+			else
+			{
+				prvRecordLatency( &xSyscallResult, ullStartNs );
+			}
+		}
+
+		FreeRTOS_closesocket( xSocket );
+	}
+
+	prvPrintSyscallLatency( "sendto" );
+
+	/* socket(), bind() to a random port and closesocket(). */
+	memset( &xSyscallResult, 0, sizeof( xSyscallResult ) );
+
+	for( ulCall = 0UL; ulCall < configBENCHMARK_SYSCALL_CALLS; ulCall++ )
+	{
+		ullStartNs = ( uint64_t ) ulGetRunTimeCounterValue();
+		xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_DGRAM, FREERTOS_IPPROTO_UDP );
+
+		if( xSocket == FREERTOS_INVALID_SOCKET )
+		{
+			xSyscallResult.ulErrors++;
+			break;
+		}
+
+		if( FreeRTOS_bind( xSocket, NULL, 0U ) != 0 )
+		{
+			xSyscallResult.ulErrors++;
+		}
+
+		FreeRTOS_closesocket( xSocket );
+		prvRecordLatency( &xSyscallResult, ullStartNs );
+	}
+
+	prvPrintSyscallLatency( "bind" );
+
+	/* FreeRTOS_send() of a small message on an echo connection. */
+	memset( &xSyscallResult, 0, sizeof( xSyscallResult ) );
+	xSocket = prvCreateSocket();
+
+	if( xSocket != FREERTOS_INVALID_SOCKET )
+	{
+		if( FreeRTOS_connect( xSocket, &xServerAddress, sizeof( xServerAddress ) ) == 0 )
+		{
+			for( ulCall = 0UL; ulCall < configBENCHMARK_SYSCALL_CALLS; ulCall++ )
+			{
+				ullStartNs = ( uint64_t ) ulGetRunTimeCounterValue();
+
+				if( FreeRTOS_send( xSocket, ucTxBuffer, sizeof( ucTxBuffer ), 0 ) != ( BaseType_t ) sizeof( ucTxBuffer ) )
+				{
+					xSyscallResult.ulErrors++;
+					break;
+				}
+
+				prvRecordLatency( &xSyscallResult, ullStartNs );
+
+				for( xTotal = 0; xTotal < ( BaseType_t ) sizeof( ucRxBuffer ); xTotal += xReceived )
+				{
+					xReceived = FreeRTOS_recv( xSocket, ucRxBuffer, sizeof( ucRxBuffer ) - ( size_t ) xTotal, 0 );
+
+					if( xReceived <= 0 )
+					{
+						break;
+					}
+				}
+
+				if( xTotal < ( BaseType_t ) sizeof( ucRxBuffer ) )
+				{
+					xSyscallResult.ulErrors++;
+					break;
+				}
+			}
+		}
+		else
+		{
+			xSyscallResult.ulErrors++;
+		}
+
+		prvGracefulClose( xSocket, ucRxBuffer, sizeof( ucRxBuffer ) );
+	}
+
+	prvPrintSyscallLatency( "send" );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintSyscallLatency( const char *pcName )
+{
+	console_print( "sys   %-8s: %8lu calls %s p50 %6lu p99 %6lu p999 %6lu us errors %lu\n",
+				   pcName,
+				   ( unsigned long ) xSyscallResult.ulTransactions,
+				   ( ipconfigUSE_STACK_LOCK != 0 ) ? "(stack lock)" : "(IP-task)   ",
+				   ( unsigned long ) prvPercentile( xSyscallResult.ulLatencies, xSyscallResult.ulTransactions, 500UL ),
+				   ( unsigned long ) prvPercentile( xSyscallResult.ulLatencies, xSyscallResult.ulTransactions, 990UL ),
+				   ( unsigned long ) prvPercentile( xSyscallResult.ulLatencies, xSyscallResult.ulTransactions, 999UL ),
+				   ( unsigned long ) xSyscallResult.ulErrors );
+}
+/*-----------------------------------------------------------*/
+
+static Socket_t prvCreateSocket( void )
+{
+Socket_t xSocket;
+static const TickType_t xTimeOut = benchSOCKET_TIME_OUT;
+
+	xSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+
+	if( xSocket != FREERTOS_INVALID_SOCKET )
+	{
+		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_WIN_PROPERTIES, ( void * ) &xWinProps, sizeof( xWinProps ) );
+
+		#if( ipconfigTCP_PACING == 1 )
+		{
+			FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_TCP_PACING_RATE, &ulCurrentPacingRate, sizeof( ulCurrentPacingRate ) );
+		}
+		#endif
+	}
+
+	return xSocket;
+}
+/*-----------------------------------------------------------*/
+
+static void prvGracefulClose( Socket_t xSocket, uint8_t *pucBuffer, size_t uxBufferSize )
+{
+TickType_t xTimeOnShutdown;
+
+	FreeRTOS_shutdown( xSocket, FREERTOS_SHUT_RDWR );
+
+	/* Wait for the shutdown to take effect, indicated by FreeRTOS_recv()
+	returning an error. */
+	xTimeOnShutdown = xTaskGetTickCount();
+
+	do
+	{
+		if( FreeRTOS_recv( xSocket, pucBuffer, uxBufferSize, 0 ) < 0 )
+		{
+			break;
+		}
+	} while( ( xTaskGetTickCount() - xTimeOnShutdown ) < benchSHUTDOWN_DELAY );
+
+	FreeRTOS_closesocket( xSocket );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecordLatency( BenchResult_t *pxResult, uint64_t ullStartNs )
+{
+uint64_t ullMicroSeconds;
+uint32_t ulValue, ulBucket, ulMSB;
+
+	ullMicroSeconds = ( ( uint64_t ) ulGetRunTimeCounterValue() - ullStartNs ) / 1000ULL;
+
+	if( ullMicroSeconds > 0xffffffffULL )
+	{
+		ulValue = 0xffffffffUL;
+	}
+	else
+	{
+		ulValue = ( uint32_t ) ullMicroSeconds;
+	}
+
+	if( ulValue < benchHISTOGRAM_SUB_BUCKETS )
+	{
+		ulBucket = ulValue;
+	}
+	else
+	{
+		/* Find the most significant bit, then use the next four bits to
+		select one of the 16 buckets of this power of two. */
+		for( ulMSB = 31U; ( ulValue & ( 1UL << ulMSB ) ) == 0U; ulMSB-- )
+		{
+		}
+
+		ulBucket = ( ( ulMSB - 3U ) * benchHISTOGRAM_SUB_BUCKETS ) + ( ( ulValue >> ( ulMSB - 4U ) ) & ( benchHISTOGRAM_SUB_BUCKETS - 1U ) );
+	}
+
+	pxResult->ulLatencies[ ulBucket ]++;
+	pxResult->ulTransactions++;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvPercentile( const uint32_t *pulHistogram, uint32_t ulCount, uint32_t ulPerMille )
+{
+uint64_t ullRank, ullSeen = 0U;
+uint32_t ulBucket, ulShift, ulReturn = 0U;
+
+	if( ulCount != 0U )
+	{
+		/* The rank of the sample being looked for, rounded up. */
+		ullRank = ( ( ( uint64_t ) ulCount * ulPerMille ) + 999U ) / 1000U;
+
+		for( ulBucket = 0U; ulBucket < benchHISTOGRAM_BUCKETS; ulBucket++ )
+		{
+			ullSeen += pulHistogram[ ulBucket ];
+
+			if( ullSeen >= ullRank )
+			{
+				break;
+			}
+		}
+
+		if( ulBucket < benchHISTOGRAM_SUB_BUCKETS )
+		{
+			ulReturn = ulBucket;
+		}
+		else
+		{
+			/* Return the middle of the bucket. */
+			ulShift = ( ulBucket / benchHISTOGRAM_SUB_BUCKETS ) - 1U;
+			ulReturn = ( benchHISTOGRAM_SUB_BUCKETS + ( ulBucket % benchHISTOGRAM_SUB_BUCKETS ) ) << ulShift;
+			ulReturn += ( 1UL << ulShift ) / 2U;
+		}
+	}
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+#if( configBENCHMARK_LOCAL_SERVER == 1 )
+
+	static void prvServerListeningTask( void *pvParameters )
+	{
+	uint16_t usPort = ( uint16_t ) ( BaseType_t ) pvParameters;
+	struct freertos_sockaddr xClient, xBindAddress;
+	Socket_t xListeningSocket, xConnectedSocket;
+	socklen_t xSize = sizeof( xClient );
+	static const TickType_t xReceiveTimeOut = portMAX_DELAY;
+	const BaseType_t xBacklog = 2 * configBENCHMARK_CLIENTS;
+
+		xListeningSocket = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+		configASSERT( xListeningSocket != FREERTOS_INVALID_SOCKET );
+
+		/* Set a time out so accept() will just wait for a connection.  The
+		window properties are inherited by the connected sockets. */
+		FreeRTOS_setsockopt( xListeningSocket, 0, FREERTOS_SO_RCVTIMEO, &xReceiveTimeOut, sizeof( xReceiveTimeOut ) );
+		FreeRTOS_setsockopt( xListeningSocket, 0, FREERTOS_SO_WIN_PROPERTIES, ( void * ) &xWinProps, sizeof( xWinProps ) );
+
+		#if( ipconfigUSE_TCP_FAST_OPEN == 1 )
+		{
+			/* Hand out cookies, and accept the data on the SYN of clients that
+			present one. */
+			const BaseType_t xFastOpen = pdTRUE;
+
+			FreeRTOS_setsockopt( xListeningSocket, 0, FREERTOS_SO_TCP_FASTOPEN, &xFastOpen, sizeof( xFastOpen ) );
+		}
+		#endif
+
+		#if( ipconfigSOCKET_HAS_TYPE_OF_SERVICE == 1 )
+		{
+			/* The connected sockets inherit the type of service as well. */
+			if( usPort != configBENCHMARK_PORT )
+			{
+			const uint8_t ucTypeOfService = benchPRIORITY_TOS;
+
+				FreeRTOS_setsockopt( xListeningSocket, 0, FREERTOS_SO_IP_TOS, &ucTypeOfService, sizeof( ucTypeOfService ) );
+			}
+		}
+		#endif
+
+		xBindAddress.sin_port = FreeRTOS_htons( usPort );
+		FreeRTOS_bind( xListeningSocket, &xBindAddress, sizeof( xBindAddress ) );
+		FreeRTOS_listen( xListeningSocket, xBacklog );
+
+		for( ;; )
+		{
+			xConnectedSocket = FreeRTOS_accept( xListeningSocket, &xClient, &xSize );
+
+			if( xConnectedSocket != FREERTOS_INVALID_SOCKET )
+			{
+				xTaskCreate( prvServerConnectionInstance, "BenchEcho", usUsedStackSize, ( void * ) xConnectedSocket, uxClientPriority, NULL );
+			}
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvServerConnectionInstance( void *pvParameters )
+	{
+	Socket_t xConnectedSocket = ( Socket_t ) pvParameters;
+	static const TickType_t xTimeOut = benchSOCKET_TIME_OUT;
+	BaseType_t xBytes, xSent, xTotalSent;
+	uint8_t *pucRxBuffer;
+
+		pucRxBuffer = ( uint8_t * ) pvPortMalloc( benchSERVER_BUFFER_SIZE );
+
+		if( pucRxBuffer != NULL )
+		{
+			FreeRTOS_setsockopt( xConnectedSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+			FreeRTOS_setsockopt( xConnectedSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+			#if( ipconfigTCP_PACING == 1 )
+			{
+				/* The echo goes through the same bottleneck, so pace it as
+				well. */
+				FreeRTOS_setsockopt( xConnectedSocket, 0, FREERTOS_SO_TCP_PACING_RATE, &ulCurrentPacingRate, sizeof( ulCurrentPacingRate ) );
+			}
+			#endif
+
+			for( ;; )
+			{
+				xBytes = FreeRTOS_recv( xConnectedSocket, pucRxBuffer, benchSERVER_BUFFER_SIZE, 0 );
+
+				if( xBytes < 0 )
+				{
+					/* Socket closed. */
+					break;
+				}
+
+				/* Call send() until all the data has been echoed. */
+				for( xTotalSent = 0; xTotalSent < xBytes; xTotalSent += xSent )
+				{
+					xSent = FreeRTOS_send( xConnectedSocket, &( pucRxBuffer[ xTotalSent ] ), ( size_t ) ( xBytes - xTotalSent ), 0 );
+
+					if( xSent <= 0 )
+					{
+						break;
+					}
+				}
+
+				if( xTotalSent < xBytes )
+				{
+					break;
+				}
+			}
+
+			prvGracefulClose( xConnectedSocket, pucRxBuffer, benchSERVER_BUFFER_SIZE );
+			vPortFree( pucRxBuffer );
+		}
+		else
+		{
+			FreeRTOS_closesocket( xConnectedSocket );
+		}
+
+		vTaskDelete( NULL );
+	}
+
+#endif /* configBENCHMARK_LOCAL_SERVER */
+/*-----------------------------------------------------------*/
+
+/* The whole file is excluded if TCP is not compiled in. */
+#endif /* ipconfigUSE_TCP */
@@ -61,6 +61,8 @@
 
 /* Local includes. */
 #include "console.h"
+#include "profiler.h"
+#include "AMPChannelBenchmark.h"
 
 /* This project provides two demo applications.  A simple blinky style demo
 application, and a more comprehensive test and demo application.  The
@@ -80,6 +82,26 @@ implemented and described in main_full.c. */
 	#define mainCREATE_TCP_ECHO_TASKS_SINGLE    1
 #endif
 
+/* When projENABLE_PROFILER is 1 the sampling profiler implemented in
+profiler.c runs alongside the selected demo and writes the profile to a file
+when it completes.  Normally set from the command line with "scons --profile". */
+#ifndef projENABLE_PROFILER
+	#define projENABLE_PROFILER    0
+#endif
+
+/* When mainRUN_AMP_CHANNEL_BENCHMARK is 1 main() runs the benchmark of the
+shared memory channel of AMPChannel.c between two processes, and returns
+without starting the demo.  Normally set from the command line with
+"scons --amp-channel". */
+#ifndef mainRUN_AMP_CHANNEL_BENCHMARK
+	#define mainRUN_AMP_CHANNEL_BENCHMARK    0
+#endif
+
+/* When projENABLE_SCHED_STATS is 1 (see FreeRTOSConfig.h) the trace macros are
+used by SchedStats.c instead of the trace recorder, and a summary of the
+scheduler statistics is printed every mainSCHED_STATS_REPORT_PERIOD_MS. */
+#define mainSCHED_STATS_REPORT_PERIOD_MS    5000
+
 /* This demo uses heap_3.c (the libc provided malloc() and free()). */
 
 /*-----------------------------------------------------------*/
@@ -121,6 +143,13 @@ void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer,
  */
 static void prvSaveTraceFile( void );
 
+/*
+ * Periodically prints the statistics gathered by SchedStats.c.
+ */
+#if ( projENABLE_SCHED_STATS == 1 )
+	static void prvSchedStatsReportTask( void *pvParameters );
+#endif
+
 /*-----------------------------------------------------------*/
 
 /* When configSUPPORT_STATIC_ALLOCATION is set to 1 the application writer can
@@ -137,8 +166,17 @@ static BaseType_t xTraceRunning = pdTRUE;
 
 int main( void )
 {
-	/* Do not include trace code when performing a code coverage analysis. */
-	#if ( projCOVERAGE_TEST != 1 )
+	#if ( mainRUN_AMP_CHANNEL_BENCHMARK == 1 )
+	{
+		/* Plain processes, no scheduler or trace needed. */
+		vRunAMPChannelBenchmark();
+		return 0;
+	}
+	#endif
+
+	/* Do not include trace code when performing a code coverage analysis, or
+	when the trace macros are used for the scheduler statistics. */
+	#if ( projCOVERAGE_TEST != 1 ) && ( projENABLE_SCHED_STATS != 1 )
 	{
 		/* Initialise the trace recorder.  Use of the trace recorder is optional.
 		See http://www.FreeRTOS.org/trace for more information. */
@@ -153,6 +191,23 @@ int main( void )
 	#endif
 
 	console_init();
+
+	#if ( projENABLE_PROFILER == 1 )
+	{
+		/* The profiler task runs at the highest priority so it stops sampling
+		on time, whatever the load. */
+		vStartProfilerTask( configMAX_PRIORITIES - 1 );
+	}
+	#endif
+
+	#if ( projENABLE_SCHED_STATS == 1 )
+	{
+		/* Also at the highest priority, so the report is printed whatever the
+		load. */
+		xTaskCreate( prvSchedStatsReportTask, "SchedStats", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1, NULL );
+	}
+	#endif
+
 	#if ( mainCREATE_TCP_ECHO_TASKS_SINGLE == 1 )
 	{
 		main_tcp_echo_client_tasks();
@@ -242,6 +297,13 @@ void vApplicationTickHook( void )
 			vFullDemoTickHookFunction();
 		}
 	#endif /* mainCREATE_SIMPLE_BLINKY_DEMO_ONLY */
+
+	#if ( projENABLE_SCHED_STATS == 1 )
+		{
+			/* Marks the end of the tick handler. */
+			vSchedStatsTickHook();
+		}
+	#endif
 }
 
 void vLoggingPrintf( const char *pcFormat,
@@ -306,8 +368,9 @@ volatile uint32_t ulSetToNonZeroInDebuggerToContinue = 0;
 
 static void prvSaveTraceFile( void )
 {
-	/* Tracing is not used when code coverage analysis is being performed. */
-	#if ( projCOVERAGE_TEST != 1 )
+	/* Tracing is not used when code coverage analysis is being performed, or
+	when the trace macros are used for the scheduler statistics. */
+	#if ( projCOVERAGE_TEST != 1 ) && ( projENABLE_SCHED_STATS != 1 )
 	{
 	FILE * pxOutputFile;
 
@@ -326,10 +389,37 @@ static void prvSaveTraceFile( void )
 			printf( "\r\nFailed to create trace dump file\r\n" );
 		}
 	}
-	#endif /* if ( projCOVERAGE_TEST != 1 ) */
+	#endif /* if ( projCOVERAGE_TEST != 1 ) && ( projENABLE_SCHED_STATS != 1 ) */
 }
 /*-----------------------------------------------------------*/
 
+#if ( projENABLE_SCHED_STATS == 1 )
+
+	static void prvSchedStatsReportTask( void *pvParameters )
+	{
+	char cLine[ 128 ];
+	uint32_t ulLine, ulMore;
+
+		( void ) pvParameters;
+
+		for( ; ; )
+		{
+			vTaskDelay( pdMS_TO_TICKS( mainSCHED_STATS_REPORT_PERIOD_MS ) );
+
+			ulLine = 0;
+
+			do
+			{
+				ulMore = ulSchedStatsFormatLine( ulLine, cLine, sizeof( cLine ) );
+				console_print( "%s", cLine );
+				ulLine++;
+			} while( ulMore != 0 );
+		}
+	}
+
+#endif /* projENABLE_SCHED_STATS */
+/*-----------------------------------------------------------*/
+
 /* configUSE_STATIC_ALLOCATION is set to 1, so the application must provide an
 implementation of vApplicationGetIdleTaskMemory() to provide the memory that is
 used by the Idle task. */
@@ -34,6 +34,7 @@
 
 /* Standard includes. */
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -44,11 +45,17 @@
 /* Demo application includes. */
 #include "FreeRTOS_IP.h"
 #include "FreeRTOS_Sockets.h"
+#if( ipconfigMULTI_INTERFACE == 1 )
+	#include "FreeRTOS_Routing.h"
+#endif
 /*#include "SimpleUDPClientAndServer.h" */
 /*#include "SimpleTCPEchoServer.h" */
 /*#include "TCPEchoClient_SingleTasks.h" */
 /*#include "demo_logging.h" */
 #include "TCPEchoClient_SingleTasks.h"
+#include "TCPEchoBenchmark.h"
+#include "RxPollingSimulation.h"
+#include "DMARingSimulation.h"
 
 /* Simple UDP client and server task parameters. */
 #define mainSIMPLE_UDP_CLIENT_SERVER_TASK_PRIORITY	  ( tskIDLE_PRIORITY )
@@ -76,8 +83,34 @@ same RTOS task).  The IP address of the echo server must be configured using the
 configECHO_SERVER_ADDR0 to configECHO_SERVER_ADDR3 constants in
 FreeRTOSConfig.h.
 
+mainCREATE_TCP_ECHO_BENCHMARK:  When set to 1 the TCP echo benchmark described
+in TCPEchoBenchmark.c is run instead of the echo client tasks.  Normally set
+from the command line with "scons --benchmark".
+
 */
-#define mainCREATE_TCP_ECHO_TASKS_SINGLE			  1
+#ifndef mainCREATE_TCP_ECHO_BENCHMARK
+	#define mainCREATE_TCP_ECHO_BENCHMARK			  0
+#endif
+
+/* mainCREATE_RX_POLL_SIMULATION:  When set to 1 the simulation described in
+RxPollingSimulation.c runs as well.  It does not use the network.  Normally set
+from the command line with "scons --rx-poll-sim". */
+#ifndef mainCREATE_RX_POLL_SIMULATION
+	#define mainCREATE_RX_POLL_SIMULATION			  0
+#endif
+
+/* mainCREATE_DMA_RING_SIMULATION:  When set to 1 the simulation described in
+DMARingSimulation.c runs once the network is up.  It uses Network Buffers, but
+no network.  Normally set from the command line with "scons --dma-ring-sim". */
+#ifndef mainCREATE_DMA_RING_SIMULATION
+	#define mainCREATE_DMA_RING_SIMULATION			  0
+#endif
+
+#if ( mainCREATE_TCP_ECHO_BENCHMARK == 1 )
+	#define mainCREATE_TCP_ECHO_TASKS_SINGLE		  0
+#else
+	#define mainCREATE_TCP_ECHO_TASKS_SINGLE		  1
+#endif
 /*-----------------------------------------------------------*/
 
 /*
@@ -119,6 +152,20 @@ const uint8_t ucMACAddress[ 6 ] = { configMAC_ADDR0, configMAC_ADDR1, configMAC_
 /* Use by the pseudo random number generator. */
 static UBaseType_t ulNextRand;
 
+#if( ipconfigMULTI_INTERFACE == 1 )
+
+	/* Defined in the loopback network interface. */
+	extern NetworkInterface_t *pxLoopback_FillInterfaceDescriptor( NetworkInterface_t *pxInterface, const char *pcName );
+
+	/* A second loopback interface with an address on its own network, so
+	traffic between the two addresses is routed through two interfaces. */
+	static NetworkInterface_t xInterfaces[ 2 ];
+	static NetworkEndPoint_t xSecondEndPoint;
+	static const uint8_t ucSecondIPAddress[ 4 ] = { 10, 0, 1, 10 };
+	static const uint8_t ucSecondNetMask[ 4 ] = { 255, 255, 255, 0 };
+
+#endif /* ipconfigMULTI_INTERFACE */
+
 /*-----------------------------------------------------------*/
 
 void  main_tcp_echo_client_tasks( void )
@@ -141,6 +188,23 @@ const uint32_t ulLongTime_ms = pdMS_TO_TICKS( 1000UL );
 	vApplicationIPNetworkEventHook() below).  The address values passed in here
 	are used if ipconfigUSE_DHCP is set to 0, or if ipconfigUSE_DHCP is set to 1
 	but a DHCP server cannot be	contacted. */
+	#if( ipconfigMULTI_INTERFACE == 1 )
+	{
+		/* The first interface gets ucMACAddress from FreeRTOS_IPInit(). */
+		FreeRTOS_AddNetworkInterface( pxLoopback_FillInterfaceDescriptor( &( xInterfaces[ 0 ] ), "lo0" ) );
+		FreeRTOS_AddNetworkInterface( pxLoopback_FillInterfaceDescriptor( &( xInterfaces[ 1 ] ), "lo1" ) );
+		memcpy( xInterfaces[ 1 ].xMACAddress.ucBytes, ucMACAddress, sizeof( ucMACAddress ) );
+		xInterfaces[ 1 ].xMACAddress.ucBytes[ 5 ] ^= 0x01U;
+		FreeRTOS_AddEndPoint( &( xInterfaces[ 1 ] ), &( xSecondEndPoint ), ucSecondIPAddress, ucSecondNetMask, NULL );
+	}
+	#endif /* ipconfigMULTI_INTERFACE */
+
+	#if ( mainCREATE_RX_POLL_SIMULATION == 1 )
+	{
+		vStartRxPollingSimulation( mainECHO_CLIENT_TASK_STACK_SIZE, mainECHO_CLIENT_TASK_PRIORITY );
+	}
+	#endif /* mainCREATE_RX_POLL_SIMULATION */
+
 	FreeRTOS_debug_printf( ( "FreeRTOS_IPInit\n" ) );
 	FreeRTOS_IPInit( ucIPAddress,
 					 ucNetMask,
@@ -191,6 +255,18 @@ static BaseType_t xTasksAlreadyCreated = pdFALSE;
 			}
 			#endif /* mainCREATE_TCP_ECHO_TASKS_SINGLE */
 
+			#if ( mainCREATE_TCP_ECHO_BENCHMARK == 1 )
+			{
+				vStartTCPEchoBenchmark( mainECHO_CLIENT_TASK_STACK_SIZE, mainECHO_CLIENT_TASK_PRIORITY );
+			}
+			#endif /* mainCREATE_TCP_ECHO_BENCHMARK */
+
+			#if ( mainCREATE_DMA_RING_SIMULATION == 1 )
+			{
+				vStartDMARingSimulation( mainECHO_CLIENT_TASK_STACK_SIZE, mainECHO_CLIENT_TASK_PRIORITY );
+			}
+			#endif /* mainCREATE_DMA_RING_SIMULATION */
+
 			xTasksAlreadyCreated = pdTRUE;
 		}
 
@@ -0,0 +1,584 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * A sampling CPU profiler for the Posix port.
+ *
+ * An ITIMER_PROF interval timer raises SIGPROF at the requested rate of
+ * process CPU time.  The Posix port keeps all signals blocked in every thread
+ * except the one running the current FreeRTOS task (the pcap worker threads of
+ * the network interface block them too), so the signal handler always runs in
+ * the context of the task that was using the CPU.  The handler records the
+ * task name and the call stack in a fixed size sample buffer.  A signal that
+ * arrives inside a critical section is held pending until the critical section
+ * ends, so time spent with interrupts disabled is attributed to the code that
+ * re-enables them.
+ *
+ * xProfilerWriteFoldedStacks() aggregates the samples into the folded stack
+ * format ("task;outer;...;inner count"), which flame graph tools read
+ * directly.  Addresses are resolved using the symbol table of the executable
+ * itself, so static functions are named correctly, and dladdr() for shared
+ * libraries.
+ */
+
+/* Standard includes. */
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <elf.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <link.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Demo application includes. */
+#include "profiler.h"
+#include "console.h"
+
+/* The default sample rate.  A prime number avoids sampling in lock step with
+the tick interrupt. */
+#ifndef configPROFILER_SAMPLE_RATE_HZ
+	#define configPROFILER_SAMPLE_RATE_HZ	997
+#endif
+
+/* How long vStartProfilerTask() profiles for. */
+#ifndef configPROFILER_DURATION_MS
+	#define configPROFILER_DURATION_MS		10000
+#endif
+
+/* The maximum number of samples kept, later samples are counted as dropped. */
+#ifndef configPROFILER_MAX_SAMPLES
+	#define configPROFILER_MAX_SAMPLES		20000
+#endif
+
+#ifndef configPROFILER_OUTPUT_FILE
+	#define configPROFILER_OUTPUT_FILE		"profile.folded"
+#endif
+
+/* The maximum number of frames recorded per sample. */
+#define profilerMAX_DEPTH				( 48 )
+
+/* The frames of the signal handler itself and of the signal trampoline, which
+are at the top of every call stack. */
+#define profilerSKIP_FRAMES				( 2 )
+
+/*-----------------------------------------------------------*/
+
+typedef struct xPROFILER_SAMPLE
+{
+	char cTaskName[ configMAX_TASK_NAME_LEN ];
+	uint32_t ulDepth;
+	void *pvFrames[ profilerMAX_DEPTH ];	/* Innermost frame first. */
+} ProfilerSample_t;
+
+typedef struct xPROFILER_SYMBOL
+{
+	uintptr_t uxAddress;
+	size_t uxSize;
+	const char *pcName;
+} ProfilerSymbol_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The SIGPROF handler, records one sample.
+ */
+static void prvSampleHandler( int lSignal );
+
+/*
+ * Load and free the function symbols of the executable.
+ */
+static void prvLoadSymbols( void );
+static void prvFreeSymbols( void );
+
+/*
+ * Returns the start address of the function that contains pvAddress, so all
+ * the samples taken in the same function compare equal.
+ */
+static void *prvFunctionAddress( void *pvAddress );
+
+/*
+ * Write the name of the function that starts at pvAddress.
+ */
+static void prvPrintFrame( FILE *pxFile, void *pvAddress );
+
+/*
+ * Returns the executable's function symbol that contains uxAddress, or NULL.
+ */
+static const ProfilerSymbol_t *prvFindSymbol( uintptr_t uxAddress );
+
+/*
+ * qsort() callbacks.
+ */
+static int prvCompareSamples( const void *pvA, const void *pvB );
+static int prvCompareSymbols( const void *pvA, const void *pvB );
+
+/*
+ * Profiles the application then writes the result, see vStartProfilerTask().
+ */
+static void prvProfilerTask( void *pvParameters );
+
+/*-----------------------------------------------------------*/
+
+static ProfilerSample_t xSamples[ configPROFILER_MAX_SAMPLES ];
+static volatile uint32_t ulSampleCount = 0UL;
+static volatile uint32_t ulDroppedSamples = 0UL;
+static volatile sig_atomic_t xSampling = 0;
+
+/* The number of samples of which the frames have been replaced by function
+addresses. */
+static uint32_t ulResolvedCount = 0UL;
+
+/* The symbols of the executable, valid while the samples are being written.
+The names point into the mapped executable file. */
+static ProfilerSymbol_t *pxSymbols = NULL;
+static size_t uxSymbolCount = 0U;
+static void *pvMappedFile = MAP_FAILED;
+static size_t uxMappedSize = 0U;
+
+/*-----------------------------------------------------------*/
+
+void vProfilerStart( uint32_t ulSampleRateHz )
+{
+struct sigaction xAction;
+struct itimerval xTimer;
+void *pvWarmUp[ 1 ];
+
+	/* The first call to backtrace() loads the unwinder, which allocates
+	memory, so it must not be made from the signal handler. */
+	( void ) backtrace( pvWarmUp, 1 );
+
+	ulSampleCount = 0UL;
+	ulDroppedSamples = 0UL;
+	ulResolvedCount = 0UL;
+
+	memset( &xAction, 0, sizeof( xAction ) );
+	xAction.sa_handler = prvSampleHandler;
+	xAction.sa_flags = SA_RESTART;
+	sigemptyset( &xAction.sa_mask );
+	sigaction( SIGPROF, &xAction, NULL );
+
+	xSampling = 1;
+
+	xTimer.it_interval.tv_sec = 0;
+	xTimer.it_interval.tv_usec = ( suseconds_t ) ( 1000000UL / ulSampleRateHz );
+	xTimer.it_value = xTimer.it_interval;
+	setitimer( ITIMER_PROF, &xTimer, NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vProfilerStop( void )
+{
+struct itimerval xTimer;
+
+	memset( &xTimer, 0, sizeof( xTimer ) );
+	setitimer( ITIMER_PROF, &xTimer, NULL );
+	xSampling = 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSampleHandler( int lSignal )
+{
+void *pvFrames[ profilerMAX_DEPTH + profilerSKIP_FRAMES ];
+ProfilerSample_t *pxSample;
+const char *pcName;
+int lDepth, x;
+int lSavedErrno = errno;
+
+	( void ) lSignal;
+
+	if( xSampling != 0 )
+	{
+		if( ulSampleCount < configPROFILER_MAX_SAMPLES )
+		{
+			/* Only the thread of the running task has signals unblocked, so
+			no other sample can be taken at the same time. */
+			pxSample = &( xSamples[ ulSampleCount ] );
+			lDepth = backtrace( pvFrames, profilerMAX_DEPTH + profilerSKIP_FRAMES ) - profilerSKIP_FRAMES;
+
+			if( lDepth > 0 )
+			{
+				pcName = pcTaskGetName( NULL );
+
+				for( x = 0; ( x < ( configMAX_TASK_NAME_LEN - 1 ) ) && ( pcName[ x ] != '\0' ); x++ )
+				{
+					pxSample->cTaskName[ x ] = pcName[ x ];
+				}
+
+				pxSample->cTaskName[ x ] = '\0';
+				pxSample->ulDepth = ( uint32_t ) lDepth;
+				memcpy( pxSample->pvFrames, &( pvFrames[ profilerSKIP_FRAMES ] ), ( size_t ) lDepth * sizeof( void * ) );
+				ulSampleCount++;
+			}
+		}
+		else
+		{
+			ulDroppedSamples++;
+		}
+	}
+
+	errno = lSavedErrno;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xProfilerWriteFoldedStacks( const char *pcFileName )
+{
+ProfilerSample_t **ppxSorted;
+FILE *pxFile;
+uint32_t ulCount, ulFirst, ulNext, ulFrame;
+BaseType_t xReturn = pdFAIL;
+
+	ulCount = ulSampleCount;
+	ppxSorted = ( ProfilerSample_t ** ) malloc( ( ulCount + 1UL ) * sizeof( ProfilerSample_t * ) );
+	pxFile = fopen( pcFileName, "w" );
+
+	if( ( ppxSorted != NULL ) && ( pxFile != NULL ) )
+	{
+		prvLoadSymbols();
+
+		/* Replace each frame by the address of its function.  All frames but
+		the innermost are return addresses, which can point just beyond the end
+		of the calling function. */
+		for( ; ulResolvedCount < ulCount; ulResolvedCount++ )
+		{
+			xSamples[ ulResolvedCount ].pvFrames[ 0 ] = prvFunctionAddress( xSamples[ ulResolvedCount ].pvFrames[ 0 ] );
+
+			for( ulFrame = 1UL; ulFrame < xSamples[ ulResolvedCount ].ulDepth; ulFrame++ )
+			{
+				xSamples[ ulResolvedCount ].pvFrames[ ulFrame ] = prvFunctionAddress( ( uint8_t * ) xSamples[ ulResolvedCount ].pvFrames[ ulFrame ] - 1 );
+			}
+		}
+
+		/* Sort the samples so identical call stacks are adjacent. */
+		for( ulFirst = 0UL; ulFirst < ulCount; ulFirst++ )
+		{
+			ppxSorted[ ulFirst ] = &( xSamples[ ulFirst ] );
+		}
+
+		qsort( ppxSorted, ulCount, sizeof( ProfilerSample_t * ), prvCompareSamples );
+
+		for( ulFirst = 0UL; ulFirst < ulCount; ulFirst = ulNext )
+		{
+			for( ulNext = ulFirst + 1UL; ulNext < ulCount; ulNext++ )
+			{
+				if( prvCompareSamples( &( ppxSorted[ ulFirst ] ), &( ppxSorted[ ulNext ] ) ) != 0 )
+				{
+					break;
+				}
+			}
+
+			/* The root of each stack is the task, followed by the outermost
+			frame. */
+			fputs( ppxSorted[ ulFirst ]->cTaskName, pxFile );
+
+			for( ulFrame = ppxSorted[ ulFirst ]->ulDepth; ulFrame > 0UL; ulFrame-- )
+			{
+				fputc( ';', pxFile );
+				prvPrintFrame( pxFile, ppxSorted[ ulFirst ]->pvFrames[ ulFrame - 1UL ] );
+			}
+
+			fprintf( pxFile, " %lu\n", ( unsigned long ) ( ulNext - ulFirst ) );
+		}
+
+		prvFreeSymbols();
+		xReturn = pdPASS;
+
+		console_print( "Profiler: %lu samples (%lu dropped) written to %s\n",
+					   ( unsigned long ) ulCount, ( unsigned long ) ulDroppedSamples, pcFileName );
+	}
+
+	if( pxFile != NULL )
+	{
+		fclose( pxFile );
+	}
+
+	free( ppxSorted );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static int prvCompareSamples( const void *pvA, const void *pvB )
+{
+const ProfilerSample_t *pxA = *( ( const ProfilerSample_t * const * ) pvA );
+const ProfilerSample_t *pxB = *( ( const ProfilerSample_t * const * ) pvB );
+int lReturn;
+
+	lReturn = strcmp( pxA->cTaskName, pxB->cTaskName );
+
+	if( lReturn == 0 )
+	{
+		if( pxA->ulDepth != pxB->ulDepth )
+		{
+			lReturn = ( pxA->ulDepth < pxB->ulDepth ) ? -1 : 1;
+		}
+		else
+		{
+			lReturn = memcmp( pxA->pvFrames, pxB->pvFrames, pxA->ulDepth * sizeof( void * ) );
+		}
+	}
+
+	return lReturn;
+}
+/*-----------------------------------------------------------*/
+
+static int prvCompareSymbols( const void *pvA, const void *pvB )
+{
+const ProfilerSymbol_t *pxA = ( const ProfilerSymbol_t * ) pvA;
+const ProfilerSymbol_t *pxB = ( const ProfilerSymbol_t * ) pvB;
+int lReturn = 0;
+
+	if( pxA->uxAddress < pxB->uxAddress )
+	{
+		lReturn = -1;
+	}
+	else if( pxA->uxAddress > pxB->uxAddress )
+	{
+		lReturn = 1;
+	}
+
+	return lReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvLoadSymbols( void )
+{
+const ElfW( Ehdr ) *pxHeader;
+const ElfW( Shdr ) *pxSections, *pxSymbolSection = NULL;
+const ElfW( Sym ) *pxElfSymbols;
+const char *pcStrings;
+struct stat xStat;
+Dl_info xInfo;
+uintptr_t uxBias = 0U;
+size_t uxCount, x;
+int lFile;
+
+	lFile = open( "/proc/self/exe", O_RDONLY );
+
+	if( lFile >= 0 )
+	{
+		if( fstat( lFile, &xStat ) == 0 )
+		{
+			uxMappedSize = ( size_t ) xStat.st_size;
+			pvMappedFile = mmap( NULL, uxMappedSize, PROT_READ, MAP_PRIVATE, lFile, 0 );
+		}
+
+		close( lFile );
+	}
+
+	if( ( pvMappedFile != MAP_FAILED ) && ( uxMappedSize >= sizeof( ElfW( Ehdr ) ) ) )
+	{
+		pxHeader = ( const ElfW( Ehdr ) * ) pvMappedFile;
+
+		if( memcmp( pxHeader->e_ident, ELFMAG, SELFMAG ) == 0 )
+		{
+			pxSections = ( const ElfW( Shdr ) * ) ( ( const uint8_t * ) pvMappedFile + pxHeader->e_shoff );
+
+			/* Prefer the full symbol table, fall back to the dynamic symbols
+			if the executable was stripped. */
+			for( x = 0U; x < pxHeader->e_shnum; x++ )
+			{
+				if( pxSections[ x ].sh_type == SHT_SYMTAB )
+				{
+					pxSymbolSection = &( pxSections[ x ] );
+					break;
+				}
+				else if( pxSections[ x ].sh_type == SHT_DYNSYM )
+				{
+					pxSymbolSection = &( pxSections[ x ] );
+				}
+			}
+
+			/* A position independent executable is loaded at a random
+			address. */
+			if( ( pxHeader->e_type == ET_DYN ) && ( dladdr( ( void * ) prvLoadSymbols, &xInfo ) != 0 ) )
+			{
+				uxBias = ( uintptr_t ) xInfo.dli_fbase;
+			}
+		}
+	}
+
+	if( pxSymbolSection != NULL )
+	{
+		pxElfSymbols = ( const ElfW( Sym ) * ) ( ( const uint8_t * ) pvMappedFile + pxSymbolSection->sh_offset );
+		pcStrings = ( const char * ) pvMappedFile + pxSections[ pxSymbolSection->sh_link ].sh_offset;
+		uxCount = pxSymbolSection->sh_size / sizeof( ElfW( Sym ) );
+		pxSymbols = ( ProfilerSymbol_t * ) malloc( uxCount * sizeof( ProfilerSymbol_t ) );
+
+		if( pxSymbols != NULL )
+		{
+			for( x = 0U; x < uxCount; x++ )
+			{
+				if( ( ELF64_ST_TYPE( pxElfSymbols[ x ].st_info ) == STT_FUNC ) && ( pxElfSymbols[ x ].st_value != 0U ) )
+				{
+					pxSymbols[ uxSymbolCount ].uxAddress = uxBias + ( uintptr_t ) pxElfSymbols[ x ].st_value;
+					pxSymbols[ uxSymbolCount ].uxSize = ( size_t ) pxElfSymbols[ x ].st_size;
+					pxSymbols[ uxSymbolCount ].pcName = &( pcStrings[ pxElfSymbols[ x ].st_name ] );
+					uxSymbolCount++;
+				}
+			}
+
+			qsort( pxSymbols, uxSymbolCount, sizeof( ProfilerSymbol_t ), prvCompareSymbols );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvFreeSymbols( void )
+{
+	free( pxSymbols );
+	pxSymbols = NULL;
+	uxSymbolCount = 0U;
+
+	if( pvMappedFile != MAP_FAILED )
+	{
+		munmap( pvMappedFile, uxMappedSize );
+		pvMappedFile = MAP_FAILED;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static const ProfilerSymbol_t *prvFindSymbol( uintptr_t uxAddress )
+{
+size_t uxLow = 0U, uxHigh = uxSymbolCount, uxMiddle;
+const ProfilerSymbol_t *pxReturn = NULL;
+
+	/* Find the last symbol that starts at or below the address. */
+	while( uxLow < uxHigh )
+	{
+		uxMiddle = ( uxLow + uxHigh ) / 2U;
+
+		if( pxSymbols[ uxMiddle ].uxAddress <= uxAddress )
+		{
+			uxLow = uxMiddle + 1U;
+		}
+		else
+		{
+			uxHigh = uxMiddle;
+		}
+	}
+
+	if( uxLow > 0U )
+	{
+		pxReturn = &( pxSymbols[ uxLow - 1U ] );
+
+		if( uxAddress >= ( pxReturn->uxAddress + pxReturn->uxSize ) )
+		{
+			pxReturn = NULL;
+		}
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvFunctionAddress( void *pvAddress )
+{
+const ProfilerSymbol_t *pxSymbol;
+void *pvReturn = pvAddress;
+Dl_info xInfo;
+
+	pxSymbol = prvFindSymbol( ( uintptr_t ) pvAddress );
+
+	if( pxSymbol != NULL )
+	{
+		pvReturn = ( void * ) pxSymbol->uxAddress;
+	}
+	else if( dladdr( pvAddress, &xInfo ) != 0 )
+	{
+		/* Functions of a shared library that are not exported are all
+		attributed to the library. */
+		pvReturn = ( xInfo.dli_sname != NULL ) ? xInfo.dli_saddr : xInfo.dli_fbase;
+	}
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintFrame( FILE *pxFile, void *pvAddress )
+{
+const ProfilerSymbol_t *pxSymbol;
+const char *pcSlash;
+Dl_info xInfo;
+
+	pxSymbol = prvFindSymbol( ( uintptr_t ) pvAddress );
+
+	if( pxSymbol != NULL )
+	{
+		fputs( pxSymbol->pcName, pxFile );
+	}
+	else if( dladdr( pvAddress, &xInfo ) != 0 )
+	{
+		if( ( xInfo.dli_sname != NULL ) && ( xInfo.dli_saddr == pvAddress ) )
+		{
+			fputs( xInfo.dli_sname, pxFile );
+		}
+		else
+		{
+			pcSlash = strrchr( xInfo.dli_fname, '/' );
+			fprintf( pxFile, "[%s]", ( pcSlash != NULL ) ? ( pcSlash + 1 ) : xInfo.dli_fname );
+		}
+	}
+	else
+	{
+		fprintf( pxFile, "%p", pvAddress );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vStartProfilerTask( UBaseType_t uxPriority )
+{
+	xTaskCreate( prvProfilerTask, "Profiler", configMINIMAL_STACK_SIZE, NULL, uxPriority, NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvProfilerTask( void *pvParameters )
+{
+	( void ) pvParameters;
+
+	console_print( "Profiler: sampling at %d Hz for %d ms\n", configPROFILER_SAMPLE_RATE_HZ, configPROFILER_DURATION_MS );
+
+	vProfilerStart( configPROFILER_SAMPLE_RATE_HZ );
+	vTaskDelay( pdMS_TO_TICKS( configPROFILER_DURATION_MS ) );
+	vProfilerStop();
+
+	xProfilerWriteFoldedStacks( configPROFILER_OUTPUT_FILE );
+
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,55 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/*
+ * Discard any previous samples, then start taking samples of the running task
+ * and its call stack at ulSampleRateHz samples per second of process CPU time.
+ */
+void vProfilerStart( uint32_t ulSampleRateHz );
+
+/*
+ * Stop taking samples.  The samples taken so far are kept.
+ */
+void vProfilerStop( void );
+
+/*
+ * Write the samples taken so far to pcFileName in the folded stack format
+ * used by flame graph tools, one line per distinct call stack, with the name
+ * of the task as the root frame.  Returns pdPASS if the file was written.
+ */
+BaseType_t xProfilerWriteFoldedStacks( const char *pcFileName );
+
+/*
+ * Create a task that profiles the application for configPROFILER_DURATION_MS
+ * milliseconds, then writes the result to configPROFILER_OUTPUT_FILE.
+ */
+void vStartProfilerTask( UBaseType_t uxPriority );
+
+#endif /* PROFILER_H */